@@ -21,6 +21,7 @@
 #include "CFCBindClass.h"
 #include "CFCBindFunction.h"
 #include "CFCBindMethod.h"
+#include "CFCBindSpecs.h"
 #include "CFCBase.h"
 #include "CFCClass.h"
 #include "CFCFunction.h"
@@ -287,14 +288,24 @@ CFCBindClass_to_c_data(CFCBindClass *self) {
 
     char *offsets           = CFCUtil_strdup("");
     char *method_defs       = CFCUtil_strdup("");
+    int   static_vtable     = CFCBindSpecs_has_static_vtable(client);
 
     for (int meth_num = 0; methods[meth_num] != NULL; meth_num++) {
         CFCMethod *method = methods[meth_num];
 
-        // Define method offset variable.
+        // Define method offset variable.  If the vtable layout is known at
+        // compile time, initialize it statically.
         char *full_offset_sym = CFCMethod_full_offset_sym(method, client);
-        offsets = CFCUtil_cat(offsets, "uint32_t ", full_offset_sym, ";\n",
-                              NULL);
+        if (static_vtable) {
+            char *offset = CFCBindSpecs_static_offset(meth_num);
+            offsets = CFCUtil_cat(offsets, "uint32_t ", full_offset_sym,
+                                  " = ", offset, ";\n", NULL);
+            FREEMEM(offset);
+        }
+        else {
+            offsets = CFCUtil_cat(offsets, "uint32_t ", full_offset_sym,
+                                  ";\n", NULL);
+        }
         FREEMEM(full_offset_sym);
 
         int is_fresh = CFCMethod_is_fresh(method, client);
@@ -32,6 +32,7 @@ struct CFCBindSpecs {
     char *overridden_specs;
     char *inherited_specs;
     char *class_specs;
+    char *vtables;
     char *init_code;
 
     int num_novel;
@@ -59,6 +60,12 @@ static void
 S_add_inherited_meth(CFCBindSpecs *self, CFCMethod *method, CFCClass *klass,
                      int meth_index);
 
+static CFCClass*
+S_foreign_base(CFCClass *klass);
+
+static char*
+S_add_static_vtable(CFCBindSpecs *self, CFCClass *klass);
+
 static const CFCMeta CFCBINDSPECS_META = {
     "Clownfish::CFC::Binding::Core::Specs",
     sizeof(CFCBindSpecs),
@@ -77,6 +84,7 @@ CFCBindSpecs_init(CFCBindSpecs *self) {
     self->overridden_specs = CFCUtil_strdup("");
     self->inherited_specs  = CFCUtil_strdup("");
     self->class_specs      = CFCUtil_strdup("");
+    self->vtables          = CFCUtil_strdup("");
     self->init_code        = CFCUtil_strdup("");
 
     return self;
@@ -88,6 +96,7 @@ CFCBindSpecs_destroy(CFCBindSpecs *self) {
     FREEMEM(self->overridden_specs);
     FREEMEM(self->inherited_specs);
     FREEMEM(self->class_specs);
+    FREEMEM(self->vtables);
     FREEMEM(self->init_code);
     CFCBase_destroy((CFCBase*)self);
 }
@@ -121,15 +130,16 @@ CFCBindSpecs_get_typedefs() {
         "} cfish_ClassSpecFlags;\n"
         "\n"
         "typedef struct cfish_ClassSpec {\n"
-        "    cfish_Class **klass;\n"
-        "    cfish_Class **parent;\n"
-        "    const char   *name;\n"
-        "    uint32_t      ivars_size;\n"
-        "    uint32_t     *ivars_offset_ptr;\n"
-        "    uint32_t      num_novel_meths;\n"
-        "    uint32_t      num_overridden_meths;\n"
-        "    uint32_t      num_inherited_meths;\n"
-        "    uint32_t      flags;\n"
+        "    cfish_Class          **klass;\n"
+        "    cfish_Class          **parent;\n"
+        "    const char            *name;\n"
+        "    uint32_t               ivars_size;\n"
+        "    uint32_t              *ivars_offset_ptr;\n"
+        "    uint32_t               num_novel_meths;\n"
+        "    uint32_t               num_overridden_meths;\n"
+        "    uint32_t               num_inherited_meths;\n"
+        "    uint32_t               flags;\n"
+        "    const cfish_method_t  *vtable;\n"
         "} cfish_ClassSpec;\n"
         "\n"
         "typedef struct cfish_ParcelSpec {\n"
@@ -206,6 +216,8 @@ CFCBindSpecs_add_class(CFCBindSpecs *self, CFCClass *klass) {
         }
     }
 
+    char *vtable = S_add_static_vtable(self, klass);
+
     char pattern[] =
         "    {\n"
         "        &%s, /* class */\n"
@@ -216,12 +228,14 @@ CFCBindSpecs_add_class(CFCBindSpecs *self, CFCClass *klass) {
         "        %d, /* num_novel */\n"
         "        %d, /* num_overridden */\n"
         "        %d, /* num_inherited */\n"
-        "        %s /* flags */\n"
+        "        %s, /* flags */\n"
+        "        %s /* vtable */\n"
         "    }";
     char *class_spec
         = CFCUtil_sprintf(pattern, class_var, parent_ptr, class_name,
                           ivars_size, ivars_offset_name, num_new_novel,
-                          num_new_overridden, num_new_inherited, flags);
+                          num_new_overridden, num_new_inherited, flags,
+                          vtable);
 
     const char *sep = self->num_specs == 0 ? "" : ",\n";
     self->class_specs = CFCUtil_cat(self->class_specs, sep, class_spec, NULL);
@@ -232,6 +246,7 @@ CFCBindSpecs_add_class(CFCBindSpecs *self, CFCClass *klass) {
     self->num_specs      += 1;
 
     FREEMEM(class_spec);
+    FREEMEM(vtable);
     FREEMEM(parent_ptr);
     FREEMEM(ivars_size);
 }
@@ -273,6 +288,7 @@ CFCBindSpecs_defs(CFCBindSpecs *self) {
         "%s"
         "%s"
         "%s"
+        "%s"
         "static cfish_ClassSpec class_specs[] = {\n"
         "%s\n"
         "};\n"
@@ -285,7 +301,8 @@ CFCBindSpecs_defs(CFCBindSpecs *self) {
         "    %d\n" // num_classes
         "};\n";
     char *defs = CFCUtil_sprintf(pattern, novel_specs, overridden_specs,
-                                 inherited_specs, self->class_specs,
+                                 inherited_specs, self->vtables,
+                                 self->class_specs,
                                  self->num_specs);
 
     FREEMEM(inherited_specs);
@@ -306,6 +323,75 @@ CFCBindSpecs_init_func_def(CFCBindSpecs *self) {
     return CFCUtil_sprintf(pattern, self->init_code);
 }
 
+int
+CFCBindSpecs_has_static_vtable(CFCClass *klass) {
+    if (CFCClass_inert(klass)) { return 0; }
+    return S_foreign_base(klass) == NULL;
+}
+
+/* Return the nearest ancestor of `klass` from another parcel, or NULL if all
+ * ancestors belong to the parcel of `klass`.
+ */
+static CFCClass*
+S_foreign_base(CFCClass *klass) {
+    CFCParcel *parcel = CFCClass_get_parcel(klass);
+    for (CFCClass *ancestor = CFCClass_get_parent(klass);
+         ancestor != NULL;
+         ancestor = CFCClass_get_parent(ancestor)
+        ) {
+        if (CFCClass_get_parcel(ancestor) != parcel) { return ancestor; }
+    }
+    return NULL;
+}
+
+char*
+CFCBindSpecs_static_offset(int meth_index) {
+    return CFCUtil_sprintf("(uint32_t)(offsetof(cfish_Class, vtable)"
+                           " + %d * sizeof(cfish_method_t))", meth_index);
+}
+
+/* Emit the vtable entries of all methods declared in the parcel of `klass`,
+ * so that Class_bootstrap can copy them in one go.  If all ancestors belong
+ * to the same parcel, this is the complete vtable.  Otherwise, the entries
+ * start after the vtable of the nearest ancestor from another parcel, whose
+ * layout is only known at runtime.  Class_bootstrap copies them to the end
+ * of that ancestor's vtable and patches in overrides of its methods.
+ *
+ * Return the expression used to reference the entries from the ClassSpec.
+ */
+static char*
+S_add_static_vtable(CFCBindSpecs *self, CFCClass *klass) {
+    CFCMethod **methods = CFCClass_methods(klass);
+    CFCClass   *base    = S_foreign_base(klass);
+    size_t      first   = base ? CFCClass_num_methods(base) : 0;
+    if (CFCClass_inert(klass) || methods[first] == NULL) {
+        return CFCUtil_strdup("NULL");
+    }
+
+    const char *class_var = CFCClass_full_class_var(klass);
+    char *entries = CFCUtil_strdup("");
+
+    for (size_t meth_num = first; methods[meth_num] != NULL; meth_num++) {
+        const char *sep = meth_num == first ? "" : ",\n";
+        char *imp_func = CFCMethod_imp_func(methods[meth_num], klass);
+        entries = CFCUtil_cat(entries, sep, "    (cfish_method_t)", imp_func,
+                              NULL);
+        FREEMEM(imp_func);
+    }
+
+    const char pattern[] =
+        "static const cfish_method_t %s_static_vtable[] = {\n"
+        "%s\n"
+        "};\n"
+        "\n";
+    char *vtable = CFCUtil_sprintf(pattern, class_var, entries);
+    self->vtables = CFCUtil_cat(self->vtables, vtable, NULL);
+
+    FREEMEM(vtable);
+    FREEMEM(entries);
+    return CFCUtil_sprintf("%s_static_vtable", class_var);
+}
+
 static char*
 S_ivars_size(CFCClass *klass) {
     CFCParcel *parcel = CFCClass_get_parcel(klass);
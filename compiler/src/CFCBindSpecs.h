@@ -50,6 +50,27 @@ CFCBindSpecs_defs(CFCBindSpecs *self);
 char*
 CFCBindSpecs_init_func_def(CFCBindSpecs *self);
 
+/** Return true if the vtable layout of `klass` is fully known when compiling
+ * its parcel, i.e. if all its ancestors belong to the same parcel.  For such
+ * classes, method offsets are initialized statically and the complete vtable
+ * is emitted as static data.
+ *
+ * The layout of an ancestor from another parcel can change when that parcel
+ * is upgraded without recompiling its dependents.  Classes inheriting across
+ * parcels get static data only for the vtable entries of methods declared in
+ * their own parcel.  Class_bootstrap appends these entries to the vtable of
+ * the foreign ancestor, assigns all method offsets and patches in overrides
+ * of the foreign ancestor's methods.
+ */
+int
+CFCBindSpecs_has_static_vtable(struct CFCClass *klass);
+
+/** Return a constant C expression for the offset of the method at index
+ * `meth_index` in the vtable of a class with a static vtable.
+ */
+char*
+CFCBindSpecs_static_offset(int meth_index);
+
 #ifdef __cplusplus
 }
 #endif
@@ -355,6 +355,7 @@ S_write_host_c(CFCPerl *self, CFCParcel *parcel) {
         "#include \"Clownfish/Class.h\"\n"
         "#include \"Clownfish/Err.h\"\n"
         "#include \"Clownfish/Obj.h\"\n"
+        "#include \"Clownfish/Util/Trace.h\"\n"
         "%s"
         "\n"
         "/* Avoid conflicts with Clownfish bool type. */\n"
@@ -366,7 +367,9 @@ S_write_host_c(CFCPerl *self, CFCParcel *parcel) {
         "\n"
         "static void\n"
         "S_finish_callback_void(pTHX_ const char *meth_name) {\n"
+        "    CFISH_TRACE_BEGIN(\"callback\", meth_name);\n"
         "    int count = call_method(meth_name, G_VOID | G_DISCARD);\n"
+        "    CFISH_TRACE_END(\"callback\", meth_name);\n"
         "    if (count != 0) {\n"
         "        CFISH_THROW(CFISH_ERR, \"Bad callback to '%%s': %%i32\",\n"
         "                    meth_name, (int32_t)count);\n"
@@ -377,7 +380,9 @@ S_write_host_c(CFCPerl *self, CFCParcel *parcel) {
         "\n"
         "static CFISH_INLINE SV*\n"
         "SI_do_callback_sv(pTHX_ const char *meth_name) {\n"
+        "    CFISH_TRACE_BEGIN(\"callback\", meth_name);\n"
         "    int count = call_method(meth_name, G_SCALAR);\n"
+        "    CFISH_TRACE_END(\"callback\", meth_name);\n"
         "    if (count != 1) {\n"
         "        CFISH_THROW(CFISH_ERR, \"Bad callback to '%%s': %%i32\",\n"
         "                    meth_name, (int32_t)count);\n"
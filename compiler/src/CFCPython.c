@@ -171,7 +171,9 @@ S_gen_callbacks(CFCPython *self, CFCParcel *parcel, CFCClass **ordered) {
         "                                  meth_name);\n"
         "        cfish_Err_throw_mess(CFISH_ERR, mess);\n"
         "    }\n"
+        "    CFISH_TRACE_BEGIN(\"callback\", meth_name);\n"
         "    PyObject *result = PyObject_CallObject(callable, args);\n"
+        "    CFISH_TRACE_END(\"callback\", meth_name);\n"
         "    Py_DECREF(args);\n"
         "    if (result == NULL) {\n"
         "        cfish_String *mess\n"
@@ -512,6 +514,7 @@ S_write_module_file(CFCPython *self, CFCParcel *parcel, const char *dest) {
         "#include \"Python.h\"\n"
         "#include \"cfish_parcel.h\"\n"
         "#include \"CFBind.h\"\n"
+        "#include \"Clownfish/Util/Trace.h\"\n"
         "%s\n"
         "\n"
         "%s\n" // callbacks
@@ -172,6 +172,7 @@ CFCTest_set_file_times(const char *path, time_t time);
 
 /* Test batch structs. */
 
+extern const CFCTestBatch CFCTEST_BATCH_BIND_SPECS;
 extern const CFCTestBatch CFCTEST_BATCH_CLASS;
 extern const CFCTestBatch CFCTEST_BATCH_C_BLOCK;
 extern const CFCTestBatch CFCTEST_BATCH_DOCU_COMMENT;
@@ -0,0 +1,187 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "charmony.h"
+
+#include <string.h>
+
+/* For rmdir */
+#ifdef CHY_HAS_UNISTD_H
+  #include <unistd.h>
+#endif
+#ifdef CHY_HAS_DIRECT_H
+  #include <direct.h>
+#endif
+
+#define CFC_USE_TEST_MACROS
+#include "CFCBase.h"
+#include "CFCBindClass.h"
+#include "CFCBindSpecs.h"
+#include "CFCClass.h"
+#include "CFCHierarchy.h"
+#include "CFCParcel.h"
+#include "CFCTest.h"
+#include "CFCUtil.h"
+
+#define AUTOGEN          "autogen"
+#define AUTOGEN_INCLUDE  AUTOGEN CHY_DIR_SEP "include"
+#define AUTOGEN_SOURCE   AUTOGEN CHY_DIR_SEP "source"
+
+static void
+S_run_tests(CFCTest *test);
+
+static void
+S_run_static_tests(CFCTest *test);
+
+static void
+S_run_dynamic_tests(CFCTest *test);
+
+const CFCTestBatch CFCTEST_BATCH_BIND_SPECS = {
+    "Clownfish::CFC::Binding::Core::Specs",
+    15,
+    S_run_tests
+};
+
+static void
+S_run_tests(CFCTest *test) {
+    S_run_static_tests(test);
+    S_run_dynamic_tests(test);
+}
+
+/* Return a copy of the static vtable definition for `class_var` in `defs`,
+ * or NULL if there is none.
+ */
+static char*
+S_vtable_def(const char *defs, const char *class_var) {
+    char *decl = CFCUtil_sprintf("%s_static_vtable[] = {", class_var);
+    const char *start = strstr(defs, decl);
+    FREEMEM(decl);
+    if (!start) { return NULL; }
+    const char *end = strstr(start, "};");
+    return CFCUtil_strndup(start, (size_t)(end - start));
+}
+
+static void
+S_clean_autogen() {
+    rmdir(AUTOGEN_INCLUDE);
+    rmdir(AUTOGEN_SOURCE);
+    rmdir(AUTOGEN);
+}
+
+static void
+S_run_static_tests(CFCTest *test) {
+    char *cfbase_path = CFCTest_path("cfbase");
+
+    // The test parcel "Animal" contains its own root class, so the
+    // ancestry of every class is known when compiling the parcel.
+    CFCHierarchy *hierarchy = CFCHierarchy_new(AUTOGEN);
+    CFCHierarchy_add_source_dir(hierarchy, cfbase_path);
+    CFCHierarchy_build(hierarchy);
+
+    CFCClass *dog  = CFCClass_fetch_singleton("Animal::Dog");
+    CFCClass *util = CFCClass_fetch_singleton("Animal::Util");
+    OK(test, CFCBindSpecs_has_static_vtable(dog),
+       "class with in-parcel ancestry has static vtable");
+    OK(test, !CFCBindSpecs_has_static_vtable(util),
+       "inert class has no static vtable");
+
+    CFCBindSpecs *specs = CFCBindSpecs_new();
+    CFCBindSpecs_add_class(specs, dog);
+    char *defs = CFCBindSpecs_defs(specs);
+    OK(test, strstr(defs, "static const cfish_method_t "
+                          "ANIMAL_DOG_static_vtable[]") != NULL,
+       "static vtable is emitted");
+    OK(test, strstr(defs, "(cfish_method_t)ANIMAL_Dog_Bark_IMP") != NULL,
+       "static vtable contains novel method");
+    OK(test, strstr(defs, "ANIMAL_DOG_static_vtable /* vtable */") != NULL,
+       "class spec references static vtable");
+    FREEMEM(defs);
+    CFCBase_decref((CFCBase*)specs);
+
+    CFCBindClass *binding = CFCBindClass_new(dog);
+    char *c_data = CFCBindClass_to_c_data(binding);
+    char *offset = CFCBindSpecs_static_offset(0);
+    char *expected = CFCUtil_sprintf("ANIMAL_Dog_Bark_OFFSET = %s;", offset);
+    OK(test, strstr(c_data, expected) != NULL,
+       "method offset is initialized statically");
+    FREEMEM(expected);
+    FREEMEM(offset);
+    FREEMEM(c_data);
+    CFCBase_decref((CFCBase*)binding);
+
+    CFCBase_decref((CFCBase*)hierarchy);
+    FREEMEM(cfbase_path);
+    CFCClass_clear_registry();
+    CFCParcel_reap_singletons();
+    S_clean_autogen();
+}
+
+static void
+S_run_dynamic_tests(CFCTest *test) {
+    char *cfext_path = CFCTest_path("cfext");
+    char *cfinc_path = CFCTest_path("cfinc");
+
+    // Animal::Rottweiler in parcel AnimalExtension inherits from
+    // Animal::Dog in parcel Animal.
+    CFCHierarchy *hierarchy = CFCHierarchy_new(AUTOGEN);
+    CFCHierarchy_add_source_dir(hierarchy, cfext_path);
+    CFCHierarchy_add_include_dir(hierarchy, cfinc_path);
+    CFCHierarchy_build(hierarchy);
+
+    CFCClass *dog        = CFCClass_fetch_singleton("Animal::Dog");
+    CFCClass *rottweiler = CFCClass_fetch_singleton("Animal::Rottweiler");
+    OK(test, CFCBindSpecs_has_static_vtable(dog),
+       "included class with in-parcel ancestry has static vtable");
+    OK(test, !CFCBindSpecs_has_static_vtable(rottweiler),
+       "class inheriting across parcels has no complete static vtable");
+
+    CFCBindSpecs *specs = CFCBindSpecs_new();
+    CFCBindSpecs_add_class(specs, rottweiler);
+    char *defs = CFCBindSpecs_defs(specs);
+    char *vtable = S_vtable_def(defs, "ANIEXT_ROTTWEILER");
+    OK(test, vtable != NULL,
+       "static vtable entries of in-parcel methods are emitted");
+    OK(test, vtable && strstr(vtable, "ANIEXT_Rottweiler_Bite_IMP") != NULL,
+       "static vtable entries contain novel method");
+    OK(test, vtable && strstr(vtable, "ANIEXT_Rottweiler_Bark_IMP") == NULL,
+       "static vtable entries skip override of foreign method");
+    FREEMEM(vtable);
+    OK(test, strstr(defs, "ANIEXT_ROTTWEILER_static_vtable /* vtable */")
+             != NULL,
+       "class spec references static vtable entries");
+    OK(test, strstr(defs, "novel_specs[]") != NULL,
+       "novel method offset is initialized at runtime");
+    OK(test, strstr(defs, "overridden_specs[]") != NULL,
+       "override of foreign method is patched at runtime");
+    FREEMEM(defs);
+    CFCBase_decref((CFCBase*)specs);
+
+    CFCBindClass *binding = CFCBindClass_new(rottweiler);
+    char *c_data = CFCBindClass_to_c_data(binding);
+    OK(test,
+       strstr(c_data, "uint32_t ANIEXT_Rottweiler_Bite_OFFSET;") != NULL,
+       "method offset is computed at runtime");
+    FREEMEM(c_data);
+    CFCBase_decref((CFCBase*)binding);
+
+    CFCBase_decref((CFCBase*)hierarchy);
+    FREEMEM(cfinc_path);
+    FREEMEM(cfext_path);
+    CFCClass_clear_registry();
+    CFCParcel_reap_singletons();
+    S_clean_autogen();
+}
+
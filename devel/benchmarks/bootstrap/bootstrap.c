@@ -0,0 +1,81 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Measure the startup cost of bootstrapping the Clownfish parcel and the
+ * TestClownfish parcel, which stands in for a large downstream parcel.
+ *
+ * Allocations are counted by interposing the glibc allocator, so this
+ * benchmark only works on Linux.  Since every process can bootstrap only
+ * once, run it several times to get a stable picture.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "Clownfish/Class.h"
+#include "Clownfish/Test.h"
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static uint64_t num_allocs;
+
+void*
+malloc(size_t size) {
+    num_allocs++;
+    return __libc_malloc(size);
+}
+
+void*
+calloc(size_t count, size_t size) {
+    num_allocs++;
+    return __libc_calloc(count, size);
+}
+
+void*
+realloc(void *ptr, size_t size) {
+    num_allocs++;
+    return __libc_realloc(ptr, size);
+}
+
+static uint64_t
+S_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void
+S_bench(void (*bootstrap)(void), const char *name) {
+    uint64_t allocs_before = num_allocs;
+    uint64_t t0 = S_now_ns();
+
+    bootstrap();
+
+    uint64_t t1 = S_now_ns();
+    printf("%-14s %8.1f usec %8" PRIu64 " allocations\n", name,
+           (t1 - t0) / 1000.0, num_allocs - allocs_before);
+}
+
+int
+main() {
+    S_bench(cfish_bootstrap_parcel, "Clownfish");
+    S_bench(testcfish_bootstrap_parcel, "TestClownfish");
+    return 0;
+}
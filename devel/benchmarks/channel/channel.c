@@ -0,0 +1,255 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Measure the throughput of handing objects between threads through a
+ * Channel, with single and batch operations, against a Vector guarded by
+ * a mutex and condition variables.  Every combination of 1, 2, 4, 8, 16
+ * and 32 producers and consumers transfers NUM_ITEMS Integers.
+ *
+ * Usage: channel [NUM_ITEMS [CAPACITY]]
+ *
+ * NUM_ITEMS defaults to 10^6 and CAPACITY to 1024.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Num.h"
+#include "Clownfish/Vector.h"
+#include "Clownfish/Util/Channel.h"
+
+#define MAX_THREADS 32
+#define BATCH_SIZE  32
+
+enum {
+    MODE_CHANNEL,
+    MODE_CHANNEL_BATCH,
+    MODE_LOCKED_VECTOR,
+    NUM_MODES
+};
+
+typedef struct {
+    pthread_mutex_t  mutex;
+    pthread_cond_t   not_empty;
+    pthread_cond_t   not_full;
+    Vector          *elems;
+    size_t           tick;
+    size_t           capacity;
+    bool             closed;
+} LockedVector;
+
+typedef struct {
+    int            mode;
+    Channel       *chan;
+    LockedVector  *locked;
+    size_t         num_items;
+    int64_t        sum;
+} Worker;
+
+static uint64_t
+S_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+// The baseline: a Vector used as a FIFO, guarded by a mutex.  Popped slots
+// are compacted away once half of the Vector is consumed.
+static void
+S_locked_push(LockedVector *locked, Obj *elem) {
+    pthread_mutex_lock(&locked->mutex);
+    while (Vec_Get_Size(locked->elems) - locked->tick >= locked->capacity) {
+        pthread_cond_wait(&locked->not_full, &locked->mutex);
+    }
+    Vec_Push(locked->elems, elem);
+    pthread_cond_signal(&locked->not_empty);
+    pthread_mutex_unlock(&locked->mutex);
+}
+
+static Obj*
+S_locked_pop(LockedVector *locked) {
+    Obj *elem = NULL;
+    pthread_mutex_lock(&locked->mutex);
+    while (Vec_Get_Size(locked->elems) == locked->tick && !locked->closed) {
+        pthread_cond_wait(&locked->not_empty, &locked->mutex);
+    }
+    if (Vec_Get_Size(locked->elems) > locked->tick) {
+        // Storing NULL decrefs the old element, so take a reference first.
+        elem = INCREF(Vec_Fetch(locked->elems, locked->tick));
+        Vec_Store(locked->elems, locked->tick, NULL);
+        locked->tick++;
+        if (locked->tick * 2 >= Vec_Get_Size(locked->elems)) {
+            Vec_Excise(locked->elems, 0, locked->tick);
+            locked->tick = 0;
+        }
+        pthread_cond_signal(&locked->not_full);
+    }
+    pthread_mutex_unlock(&locked->mutex);
+    return elem;
+}
+
+static void*
+S_produce(void *arg) {
+    Worker *worker = (Worker*)arg;
+    Obj    *batch[BATCH_SIZE];
+    size_t  i = 0;
+
+    while (i < worker->num_items) {
+        if (worker->mode == MODE_CHANNEL_BATCH) {
+            size_t num = worker->num_items - i;
+            if (num > BATCH_SIZE) { num = BATCH_SIZE; }
+            for (size_t j = 0; j < num; j++) {
+                batch[j] = (Obj*)Int_new((int64_t)(i + j));
+            }
+            Chan_Push_Batch(worker->chan, batch, num);
+            i += num;
+        }
+        else if (worker->mode == MODE_CHANNEL) {
+            Chan_Push(worker->chan, (Obj*)Int_new((int64_t)i));
+            i++;
+        }
+        else {
+            S_locked_push(worker->locked, (Obj*)Int_new((int64_t)i));
+            i++;
+        }
+    }
+
+    return NULL;
+}
+
+static void*
+S_consume(void *arg) {
+    Worker *worker = (Worker*)arg;
+    Obj    *batch[BATCH_SIZE];
+
+    while (true) {
+        size_t num;
+        if (worker->mode == MODE_CHANNEL_BATCH) {
+            num = Chan_Pop_Batch(worker->chan, batch, BATCH_SIZE);
+        }
+        else if (worker->mode == MODE_CHANNEL) {
+            batch[0] = Chan_Pop(worker->chan);
+            num = batch[0] ? 1 : 0;
+        }
+        else {
+            batch[0] = S_locked_pop(worker->locked);
+            num = batch[0] ? 1 : 0;
+        }
+        if (num == 0) { break; }
+
+        for (size_t j = 0; j < num; j++) {
+            worker->sum += Int_Get_Value((Integer*)batch[j]);
+            DECREF(batch[j]);
+        }
+    }
+
+    return NULL;
+}
+
+static double
+S_run(int mode, int num_producers, int num_consumers, size_t num_items,
+      size_t capacity) {
+    Channel      *chan = Chan_new(capacity);
+    LockedVector  locked;
+    Worker        producers[MAX_THREADS];
+    Worker        consumers[MAX_THREADS];
+    pthread_t     producer_threads[MAX_THREADS];
+    pthread_t     consumer_threads[MAX_THREADS];
+
+    pthread_mutex_init(&locked.mutex, NULL);
+    pthread_cond_init(&locked.not_empty, NULL);
+    pthread_cond_init(&locked.not_full, NULL);
+    locked.elems    = Vec_new(capacity);
+    locked.tick     = 0;
+    locked.capacity = capacity;
+    locked.closed   = false;
+
+    uint64_t start = S_now_ns();
+
+    for (int i = 0; i < num_consumers; i++) {
+        consumers[i].mode   = mode;
+        consumers[i].chan   = chan;
+        consumers[i].locked = &locked;
+        consumers[i].sum    = 0;
+        pthread_create(consumer_threads + i, NULL, S_consume, consumers + i);
+    }
+    for (int i = 0; i < num_producers; i++) {
+        producers[i].mode      = mode;
+        producers[i].chan      = chan;
+        producers[i].locked    = &locked;
+        producers[i].num_items = num_items * (size_t)(i + 1) / num_producers
+                                 - num_items * (size_t)i / num_producers;
+        pthread_create(producer_threads + i, NULL, S_produce, producers + i);
+    }
+
+    for (int i = 0; i < num_producers; i++) {
+        pthread_join(producer_threads[i], NULL);
+    }
+    Chan_Close(chan);
+    pthread_mutex_lock(&locked.mutex);
+    locked.closed = true;
+    pthread_cond_broadcast(&locked.not_empty);
+    pthread_mutex_unlock(&locked.mutex);
+    for (int i = 0; i < num_consumers; i++) {
+        pthread_join(consumer_threads[i], NULL);
+    }
+
+    uint64_t elapsed = S_now_ns() - start;
+
+    DECREF(chan);
+    DECREF(locked.elems);
+    pthread_cond_destroy(&locked.not_full);
+    pthread_cond_destroy(&locked.not_empty);
+    pthread_mutex_destroy(&locked.mutex);
+
+    return (double)num_items * 1e3 / (double)elapsed;
+}
+
+int
+main(int argc, char **argv) {
+    size_t num_items = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10)
+                                : 1000000;
+    size_t capacity  = argc > 2 ? (size_t)strtoull(argv[2], NULL, 10)
+                                : 1024;
+
+    cfish_bootstrap_parcel();
+
+    printf("%9s %9s %14s %14s %14s\n", "producers", "consumers",
+           "channel Mop/s", "batch Mop/s", "locked Mop/s");
+
+    for (int num_producers = 1; num_producers <= MAX_THREADS;
+         num_producers *= 2
+        ) {
+        for (int num_consumers = 1; num_consumers <= MAX_THREADS;
+             num_consumers *= 2
+            ) {
+            double rates[NUM_MODES];
+            for (int mode = 0; mode < NUM_MODES; mode++) {
+                rates[mode] = S_run(mode, num_producers, num_consumers,
+                                    num_items, capacity);
+            }
+            printf("%9d %9d %14.2f %14.2f %14.2f\n", num_producers,
+                   num_consumers, rates[MODE_CHANNEL],
+                   rates[MODE_CHANNEL_BATCH], rates[MODE_LOCKED_VECTOR]);
+        }
+    }
+
+    return 0;
+}
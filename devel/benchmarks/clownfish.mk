@@ -0,0 +1,42 @@
+# Licensed to the Apache Software Foundation (ASF) under one or more
+# contributor license agreements.  See the NOTICE file distributed with
+# this work for additional information regarding copyright ownership.
+# The ASF licenses this file to You under the Apache License, Version 2.0
+# (the "License"); you may not use this file except in compliance with
+# the License.  You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+# Shared rules for the benchmarks which link against the Clownfish C
+# library.  Build the library in runtime/c first.
+#
+# Before including this file, set PROGRAM to the name of the benchmark.  Its
+# source file is PROGRAM.c.  Optionally set LIBS to the libraries to link
+# against and RUNS to the number of times "make bench" runs the benchmark.
+
+RUNTIME  = ../../../runtime/c
+CFLAGS   = -std=gnu99 -Wextra -O2 -I $(RUNTIME)/autogen/include
+LIBS    ?= -lclownfish
+RUNS    ?= 1
+
+all : bench
+
+$(PROGRAM) : $(PROGRAM).c
+	gcc $(CFLAGS) $(PROGRAM).c -L $(RUNTIME) $(LIBS) -o $@
+
+bench : $(PROGRAM)
+	for i in `seq $(RUNS)`; do \
+	    LD_LIBRARY_PATH=$(RUNTIME) ./$(PROGRAM); \
+	done
+
+clean :
+	rm -f $(PROGRAM)
+
+.PHONY : all bench clean
@@ -0,0 +1,110 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* Measure the throughput of throwing and catching errors with THROW and
+ * Err_trap, as used by parsers rejecting invalid input.  Errors are either
+ * discarded, rethrown through several frames, or have their message
+ * rendered with Err_Get_Mess.
+ *
+ * Usage: err [NUM_ITERATIONS]
+ *
+ * NUM_ITERATIONS defaults to 1000000.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Err.h"
+#include "Clownfish/String.h"
+
+#define NUM_RETHROWS 4
+
+static uint64_t
+S_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void
+S_throw(void *context) {
+    int *pos = (int*)context;
+    THROW(ERR, "Unexpected character '%s' at byte %i32", "}", (int32_t)*pos);
+}
+
+static void
+S_rethrow(void *context) {
+    int *depth = (int*)context;
+    if (*depth == 0) {
+        THROW(ERR, "Unexpected character '%s' at byte %i32", "}",
+              (int32_t)42);
+    }
+    (*depth)--;
+    Err *error = Err_trap(S_rethrow, context);
+    if (error) { RETHROW(error); }
+}
+
+static void
+S_report(const char *name, uint64_t elapsed, int num_iters) {
+    double secs = (double)elapsed / 1e9;
+    printf("%-22s %8.3f M/s %8.1f ns each\n", name, num_iters / secs / 1e6,
+           (double)elapsed / num_iters);
+}
+
+int
+main(int argc, char **argv) {
+    int num_iters = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    cfish_bootstrap_parcel();
+
+    uint64_t start = S_now_ns();
+    for (int i = 0; i < num_iters; i++) {
+        Err *error = Err_trap(S_throw, &i);
+        DECREF(error);
+    }
+    S_report("throw", S_now_ns() - start, num_iters);
+
+    size_t total_len = 0;
+    start = S_now_ns();
+    for (int i = 0; i < num_iters; i++) {
+        Err *error = Err_trap(S_throw, &i);
+        total_len += Str_Get_Size(Err_Get_Mess(error));
+        DECREF(error);
+    }
+    S_report("throw + Get_Mess", S_now_ns() - start, num_iters);
+
+    start = S_now_ns();
+    for (int i = 0; i < num_iters; i++) {
+        int depth = NUM_RETHROWS;
+        Err *error = Err_trap(S_rethrow, &depth);
+        DECREF(error);
+    }
+    S_report("throw + 4 rethrows", S_now_ns() - start, num_iters);
+
+    start = S_now_ns();
+    for (int i = 0; i < num_iters; i++) {
+        int depth = NUM_RETHROWS;
+        Err *error = Err_trap(S_rethrow, &depth);
+        total_len += Str_Get_Size(Err_Get_Mess(error));
+        DECREF(error);
+    }
+    S_report("4 rethrows + Get_Mess", S_now_ns() - start, num_iters);
+
+    if (total_len == 0) { printf("No messages\n"); }
+    return 0;
+}
@@ -0,0 +1,132 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* Measure the throughput of Freezer for a Vector of records resembling
+ * typical documents: Hashes with short and long Strings, Integers, Floats,
+ * Booleans, a Blob and a small nested Vector.  Thawing is measured with and
+ * without zero-copy decoding of Strings and Blobs.
+ *
+ * Usage: freezer [NUM_RECORDS [NUM_ITERATIONS]]
+ *
+ * NUM_RECORDS defaults to 10000 and NUM_ITERATIONS to 20.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Blob.h"
+#include "Clownfish/Boolean.h"
+#include "Clownfish/ByteBuf.h"
+#include "Clownfish/Hash.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Vector.h"
+#include "Clownfish/Util/Freezer.h"
+
+static uint64_t
+S_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static Vector*
+S_make_records(size_t num_records) {
+    static const char text[] =
+        "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do "
+        "eiusmod tempor incididunt ut labore et dolore magna aliqua.";
+    Vector *records = Vec_new(num_records);
+    for (size_t i = 0; i < num_records; i++) {
+        Hash *record = Hash_new(8);
+        Hash_Store_Utf8(record, "id", 2, (Obj*)Int_new((int64_t)i * 7919));
+        Hash_Store_Utf8(record, "title", 5,
+                        (Obj*)Str_newf("Record number %u64", (uint64_t)i));
+        Hash_Store_Utf8(record, "body", 4,
+                        (Obj*)Str_new_from_utf8(text, sizeof(text) - 1));
+        Hash_Store_Utf8(record, "score", 5,
+                        (Obj*)Float_new((double)i / 3.0));
+        Hash_Store_Utf8(record, "published", 9,
+                        (Obj*)Bool_singleton(i % 2 == 0));
+        Hash_Store_Utf8(record, "digest", 6,
+                        (Obj*)Blob_new(text + i % 32, 16));
+        Vector *tags = Vec_new(3);
+        Vec_Push(tags, (Obj*)Str_newf("tag%u64", (uint64_t)(i % 10)));
+        Vec_Push(tags, (Obj*)Str_newf("group%u64", (uint64_t)(i % 100)));
+        Vec_Push(tags, (Obj*)Int_new(-(int64_t)i));
+        Hash_Store_Utf8(record, "tags", 4, (Obj*)tags);
+        Vec_Push(records, (Obj*)record);
+    }
+    return records;
+}
+
+static void
+S_report(const char *name, uint64_t elapsed, double bytes,
+         double num_records) {
+    double secs = (double)elapsed / 1e9;
+    printf("%-18s %9.1f MB/s %9.3f Mrecords/s\n", name, bytes / secs / 1e6,
+           num_records / secs / 1e6);
+}
+
+int
+main(int argc, char **argv) {
+    size_t num_records = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10)
+                                  : 10000;
+    int num_iters = argc > 2 ? atoi(argv[2]) : 20;
+
+    cfish_bootstrap_parcel();
+
+    Vector *records = S_make_records(num_records);
+    Blob *frozen = ObjFreezer_freeze_to_blob((Obj*)records);
+    size_t size = Blob_Get_Size(frozen);
+    printf("%lu records, %lu bytes frozen\n", (unsigned long)num_records,
+           (unsigned long)size);
+
+    double total_bytes   = (double)size * num_iters;
+    double total_records = (double)num_records * num_iters;
+
+    ByteBuf *buf = BB_new(size);
+    uint64_t start = S_now_ns();
+    for (int i = 0; i < num_iters; i++) {
+        BB_Set_Size(buf, 0);
+        ObjFreezer_freeze((Obj*)records, buf);
+    }
+    S_report("freeze", S_now_ns() - start, total_bytes, total_records);
+    DECREF(buf);
+
+    const bool modes[2] = { false, true };
+    const char *names[2] = { "thaw (copy)", "thaw (zero-copy)" };
+    for (int m = 0; m < 2; m++) {
+        Obj *thawed = ObjFreezer_thaw(frozen, modes[m]);
+        if (!Vec_Equals(records, thawed)) {
+            fprintf(stderr, "Round trip failed\n");
+            return 1;
+        }
+        DECREF(thawed);
+
+        start = S_now_ns();
+        for (int i = 0; i < num_iters; i++) {
+            thawed = ObjFreezer_thaw(frozen, modes[m]);
+            DECREF(thawed);
+        }
+        S_report(names[m], S_now_ns() - start, total_bytes, total_records);
+    }
+
+    DECREF(frozen);
+    DECREF(records);
+    return 0;
+}
@@ -0,0 +1,130 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Run the benchmark batches of the TestClownfish parcel with BenchRunner.
+ *
+ * Usage: harness [--quick] [--json FILE] [--compare FILE] [--threshold PCT]
+ *
+ *   --quick          Take fewer and shorter samples.
+ *   --json FILE      Write the results as JSON to FILE.
+ *   --compare FILE   Compare the results with an earlier JSON file and exit
+ *                    with a non-zero status if any benchmark regressed.
+ *   --threshold PCT  Tolerated slowdown in percent, 10 by default.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CFISH_USE_SHORT_NAMES
+#define TESTCFISH_USE_SHORT_NAMES
+
+#include "Clownfish/String.h"
+#include "Clownfish/Vector.h"
+#include "Clownfish/TestHarness/BenchBatch.h"
+#include "Clownfish/TestHarness/BenchRunner.h"
+#include "Clownfish/Util/Memory.h"
+#include "Clownfish/Test.h"
+
+static String*
+S_slurp(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Can't open %s\n", path);
+        exit(1);
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *buf = (char*)MALLOCATE((size_t)size + 1);
+    size_t got = fread(buf, 1, (size_t)size, file);
+    fclose(file);
+    String *string = Str_new_from_utf8(buf, got);
+    FREEMEM(buf);
+    return string;
+}
+
+static void
+S_spew(const char *path, String *content) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Can't open %s for writing\n", path);
+        exit(1);
+    }
+    fwrite(Str_Get_Ptr8(content), 1, Str_Get_Size(content), file);
+    fputc('\n', file);
+    fclose(file);
+}
+
+int
+main(int argc, char **argv) {
+    bool        quick        = false;
+    const char *json_path    = NULL;
+    const char *compare_path = NULL;
+    double      threshold    = 10.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            quick = true;
+        }
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            compare_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        }
+        else {
+            fprintf(stderr, "Usage: %s [--quick] [--json FILE]"
+                    " [--compare FILE] [--threshold PCT]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    testcfish_bootstrap_parcel();
+
+    BenchRunner *runner = BenchRunner_new();
+    if (quick) {
+        BenchRunner_Set_Num_Samples(runner, 7);
+        BenchRunner_Set_Sample_Time(runner, 500000);
+    }
+
+    Vector *batches = Test_create_bench_batches();
+    for (size_t i = 0; i < Vec_Get_Size(batches); i++) {
+        BenchBatch *batch = (BenchBatch*)Vec_Fetch(batches, i);
+        BenchRunner_Run_Batch(runner, batch);
+    }
+    bool success = BenchRunner_Get_Num_Batches_Failed(runner) == 0;
+
+    if (json_path) {
+        String *json = BenchRunner_To_Json(runner);
+        S_spew(json_path, json);
+        DECREF(json);
+    }
+    if (compare_path) {
+        String *baseline = S_slurp(compare_path);
+        if (!BenchRunner_Compare(runner, baseline, threshold / 100.0)) {
+            success = false;
+        }
+        DECREF(baseline);
+    }
+
+    DECREF(batches);
+    DECREF(runner);
+    return success ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* Measure the cost of subtype checks with Obj_is_a and CERTIFY against a
+ * loop walking the chain of parent classes, for objects whose class sits
+ * at increasing depths of a hierarchy.  Checking against Obj and checking
+ * against an unrelated class are the worst cases for the parent walk.
+ * The walk is inlined while Obj_is_a goes through a library call, so at
+ * shallow depths the walk may come out ahead.
+ *
+ * Usage: is_a [NUM_ITERATIONS]
+ *
+ * NUM_ITERATIONS defaults to 50000000.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define C_CFISH_CLASS
+#define C_CFISH_OBJ
+#define CFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Class.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/Obj.h"
+#include "Clownfish/String.h"
+
+#define MAX_DEPTH 8
+
+static uint64_t
+S_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+// The subtype check before ancestor displays were introduced.
+static bool
+S_walk_is_a(Obj *obj, Class *ancestor) {
+    for (Class *klass = obj->klass; klass != NULL; klass = klass->parent) {
+        if (klass == ancestor) { return true; }
+    }
+    return false;
+}
+
+// Keep the compiler from hoisting the checks out of the loops.
+static Obj *volatile obj_slot;
+
+static double
+S_time_is_a(Class *target, int num_iters) {
+    uint64_t start = S_now_ns();
+    size_t hits = 0;
+    for (int i = 0; i < num_iters; i++) {
+        hits += Obj_is_a(obj_slot, target);
+    }
+    uint64_t elapsed = S_now_ns() - start;
+    if (hits == 1) { printf("unlikely\n"); }
+    return (double)elapsed / num_iters;
+}
+
+static double
+S_time_certify(Class *target, int num_iters) {
+    uint64_t start = S_now_ns();
+    for (int i = 0; i < num_iters; i++) {
+        CERTIFY(obj_slot, target);
+    }
+    return (double)(S_now_ns() - start) / num_iters;
+}
+
+static double
+S_time_walk(Class *target, int num_iters) {
+    uint64_t start = S_now_ns();
+    size_t hits = 0;
+    for (int i = 0; i < num_iters; i++) {
+        hits += S_walk_is_a(obj_slot, target);
+    }
+    uint64_t elapsed = S_now_ns() - start;
+    if (hits == 1) { printf("unlikely\n"); }
+    return (double)elapsed / num_iters;
+}
+
+int
+main(int argc, char **argv) {
+    int num_iters = argc > 1 ? atoi(argv[1]) : 50000000;
+
+    cfish_bootstrap_parcel();
+
+    // Build a chain of classes below Obj, like deep Lucy hierarchies.
+    Class *chain[MAX_DEPTH + 1];
+    chain[0] = OBJ;
+    for (int depth = 1; depth <= MAX_DEPTH; depth++) {
+        String *name = Str_newf("Bench::Depth%i32", (int32_t)depth);
+        chain[depth] = Class_singleton(name, chain[depth - 1]);
+        DECREF(name);
+    }
+    Class *unrelated = Class_singleton(SSTR_WRAP_C("Bench::Unrelated"), OBJ);
+
+    printf("ns per check    is_a(Obj)  walk(Obj)  CERTIFY(Obj)"
+           "  is_a(other)  walk(other)\n");
+    for (int depth = 1; depth <= MAX_DEPTH; depth++) {
+        Obj *obj = Class_Make_Obj(chain[depth]);
+        obj_slot = obj;
+        printf("depth %d       %10.2f %10.2f %13.2f %12.2f %12.2f\n", depth,
+               S_time_is_a(OBJ, num_iters), S_time_walk(OBJ, num_iters),
+               S_time_certify(OBJ, num_iters),
+               S_time_is_a(unrelated, num_iters),
+               S_time_walk(unrelated, num_iters));
+        DECREF(obj);
+    }
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* Measure the throughput of the JSON encoder and decoder for an array of
+ * records resembling typical documents: objects with short and long
+ * strings, some with escapes, integers, floats, booleans and a small nested
+ * array.
+ *
+ * Usage: json [NUM_RECORDS [NUM_ITERATIONS]]
+ *
+ * NUM_RECORDS defaults to 20000, which results in about 5 MB of JSON, and
+ * NUM_ITERATIONS to 10.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Boolean.h"
+#include "Clownfish/CharBuf.h"
+#include "Clownfish/Hash.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Vector.h"
+#include "Clownfish/Util/Json.h"
+
+static uint64_t
+S_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static Vector*
+S_make_records(size_t num_records) {
+    static const char text[] =
+        "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do "
+        "eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut "
+        "enim ad minim veniam, quis nostrud exercitation ullamco laboris.";
+    Vector *records = Vec_new(num_records);
+    for (size_t i = 0; i < num_records; i++) {
+        Hash *record = Hash_new(8);
+        Hash_Store_Utf8(record, "id", 2, (Obj*)Int_new((int64_t)i * 7919));
+        Hash_Store_Utf8(record, "title", 5,
+                        (Obj*)Str_newf("Record \"number\" %u64", (uint64_t)i));
+        Hash_Store_Utf8(record, "body", 4,
+                        (Obj*)Str_new_from_utf8(text, sizeof(text) - 1));
+        Hash_Store_Utf8(record, "score", 5,
+                        (Obj*)Float_new((double)i / 3.0));
+        Hash_Store_Utf8(record, "published", 9,
+                        (Obj*)Bool_singleton(i % 2 == 0));
+        Vector *tags = Vec_new(3);
+        Vec_Push(tags, (Obj*)Str_newf("tag%u64", (uint64_t)(i % 10)));
+        Vec_Push(tags, (Obj*)Str_newf("group%u64", (uint64_t)(i % 100)));
+        Vec_Push(tags, (Obj*)Int_new(-(int64_t)i));
+        Hash_Store_Utf8(record, "tags", 4, (Obj*)tags);
+        Vec_Push(records, (Obj*)record);
+    }
+    return records;
+}
+
+static void
+S_report(const char *name, uint64_t elapsed, double bytes,
+         double num_records) {
+    double secs = (double)elapsed / 1e9;
+    printf("%-8s %9.1f MB/s %9.3f Mrecords/s\n", name, bytes / secs / 1e6,
+           num_records / secs / 1e6);
+}
+
+int
+main(int argc, char **argv) {
+    size_t num_records = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10)
+                                  : 20000;
+    int num_iters = argc > 2 ? atoi(argv[2]) : 10;
+
+    cfish_bootstrap_parcel();
+
+    Vector *records = S_make_records(num_records);
+    String *json = Json_encode((Obj*)records);
+    size_t size = Str_Get_Size(json);
+    printf("%lu records, %lu bytes of JSON\n", (unsigned long)num_records,
+           (unsigned long)size);
+
+    double total_bytes   = (double)size * num_iters;
+    double total_records = (double)num_records * num_iters;
+
+    CharBuf *buf = CB_new(size);
+    uint64_t start = S_now_ns();
+    for (int i = 0; i < num_iters; i++) {
+        CB_Clear(buf);
+        Json_encode_into((Obj*)records, buf);
+    }
+    S_report("encode", S_now_ns() - start, total_bytes, total_records);
+    DECREF(buf);
+
+    Obj *decoded = Json_decode(json);
+    String *json_again = Json_encode(decoded);
+    if (!Str_Equals(json, (Obj*)json_again)) {
+        fprintf(stderr, "Round trip failed\n");
+        return 1;
+    }
+    DECREF(json_again);
+    DECREF(decoded);
+
+    start = S_now_ns();
+    for (int i = 0; i < num_iters; i++) {
+        decoded = Json_decode(json);
+        DECREF(decoded);
+    }
+    S_report("decode", S_now_ns() - start, total_bytes, total_records);
+
+    DECREF(json);
+    DECREF(records);
+    return 0;
+}
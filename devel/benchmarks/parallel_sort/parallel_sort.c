@@ -0,0 +1,119 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Measure how parallel sorting scales with the number of threads, for
+ * 10^6 elements up to a configurable maximum.  Each size is sorted with
+ * parallel_mergesort and with radixsort_u64, using 1 to MAX_THREADS
+ * threads.
+ *
+ * Usage: parallel_sort [MAX_THREADS [MAX_ELEMS]]
+ *
+ * MAX_THREADS defaults to the number of online processors and MAX_ELEMS to
+ * 10^7.  Sorting 10^8 elements needs 1.6 GB of memory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Util/SortUtils.h"
+#include "Clownfish/Util/ThreadPool.h"
+
+static uint64_t
+S_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static int
+S_compare(void *context, const void *va, const void *vb) {
+    uint64_t a = *(const uint64_t*)va;
+    uint64_t b = *(const uint64_t*)vb;
+    (void)context;
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static void
+S_fill(uint64_t *elems, size_t num_elems) {
+    uint64_t state = 1;
+    for (size_t i = 0; i < num_elems; i++) {
+        // xorshift64
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        elems[i] = state;
+    }
+}
+
+int
+main(int argc, char **argv) {
+    cfish_bootstrap_parcel();
+
+    uint32_t max_threads = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10)
+                                    : ThreadPool_num_cpus();
+    size_t   max_elems   = argc > 2 ? (size_t)strtoull(argv[2], NULL, 10)
+                                    : 10000000;
+    uint64_t *elems   = (uint64_t*)malloc(max_elems * sizeof(uint64_t));
+    uint64_t *scratch = (uint64_t*)malloc(max_elems * sizeof(uint64_t));
+
+    printf("%10s %7s %14s %14s\n", "elements", "threads", "mergesort ms",
+           "radixsort ms");
+
+    for (size_t num_elems = 1000000; num_elems <= max_elems;
+         num_elems *= 10
+        ) {
+        double merge_base = 0.0;
+        double radix_base = 0.0;
+
+        for (uint32_t threads = 1; threads <= max_threads; threads++) {
+            // The calling thread sorts, too.
+            ThreadPool *pool = ThreadPool_new(threads - 1);
+
+            S_fill(elems, num_elems);
+            uint64_t t0 = S_now_ns();
+            Sort_parallel_mergesort(elems, scratch, num_elems,
+                                    sizeof(uint64_t), S_compare, NULL,
+                                    pool);
+            uint64_t t1 = S_now_ns();
+            double merge_ms = (t1 - t0) / 1000000.0;
+
+            S_fill(elems, num_elems);
+            t0 = S_now_ns();
+            Sort_radixsort_u64(elems, scratch, num_elems, pool);
+            t1 = S_now_ns();
+            double radix_ms = (t1 - t0) / 1000000.0;
+
+            DECREF(pool);
+
+            if (threads == 1) {
+                merge_base = merge_ms;
+                radix_base = radix_ms;
+            }
+            printf("%10lu %7u %8.1f %4.1fx %8.1f %4.1fx\n",
+                   (unsigned long)num_elems, (unsigned)threads, merge_ms,
+                   merge_base / merge_ms, radix_ms, radix_base / radix_ms);
+        }
+    }
+
+    free(elems);
+    free(scratch);
+    return 0;
+}
+
@@ -0,0 +1,212 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Compare the SortUtils sorts against the recursive top-down merge sort
+ * which SortUtils used to implement, on random, sorted and reversed input
+ * with elements 4, 8 and 16 bytes wide.  Elements start with an unsigned
+ * integer key, so they can be radix sorted as well.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Util/SortUtils.h"
+
+#define NUM_ELEMS 1000000
+#define MAX_WIDTH 16
+
+enum { INPUT_RANDOM, INPUT_SORTED, INPUT_REVERSED, NUM_INPUTS };
+
+static const char *input_names[NUM_INPUTS] = {
+    "random", "sorted", "reversed"
+};
+
+static uint64_t num_compares;
+
+static int
+S_compare(void *context, const void *va, const void *vb) {
+    uint64_t a, b;
+    memcpy(&a, va, sizeof(uint64_t));
+    memcpy(&b, vb, sizeof(uint64_t));
+    (void)context;
+    num_compares++;
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+// 4-byte elements compare on 32 bits only.
+static int
+S_compare4(void *context, const void *va, const void *vb) {
+    uint32_t a, b;
+    memcpy(&a, va, sizeof(uint32_t));
+    memcpy(&b, vb, sizeof(uint32_t));
+    (void)context;
+    num_compares++;
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+/* The previous implementation, for reference. */
+
+static void
+S_old_merge(uint8_t *left_ptr, size_t left_size, uint8_t *right_ptr,
+            size_t right_size, uint8_t *dest, size_t width,
+            CFISH_Sort_Compare_t compare, void *context) {
+    uint8_t *left_limit  = left_ptr + left_size * width;
+    uint8_t *right_limit = right_ptr + right_size * width;
+
+    while (left_ptr < left_limit && right_ptr < right_limit) {
+        if (compare(context, left_ptr, right_ptr) < 1) {
+            memcpy(dest, left_ptr, width);
+            dest += width;
+            left_ptr += width;
+        }
+        else {
+            memcpy(dest, right_ptr, width);
+            dest += width;
+            right_ptr += width;
+        }
+    }
+
+    memcpy(dest, left_ptr, (size_t)(left_limit - left_ptr));
+    dest += left_limit - left_ptr;
+    memcpy(dest, right_ptr, (size_t)(right_limit - right_ptr));
+}
+
+static void
+S_old_msort(uint8_t *elems, uint8_t *scratch, size_t left, size_t right,
+            size_t width, CFISH_Sort_Compare_t compare, void *context) {
+    if (right > left) {
+        const size_t mid = left + (right - left) / 2 + 1;
+        S_old_msort(elems, scratch, left, mid - 1, width, compare, context);
+        S_old_msort(elems, scratch, mid,  right, width, compare, context);
+        S_old_merge(elems + left * width, mid - left, elems + mid * width,
+                    right - mid + 1, scratch, width, compare, context);
+        memcpy(elems + left * width, scratch, (right - left + 1) * width);
+    }
+}
+
+static void
+S_old_mergesort(void *elems, void *scratch, size_t num_elems, size_t width,
+                CFISH_Sort_Compare_t compare, void *context) {
+    if (num_elems < 2) { return; }
+    S_old_msort((uint8_t*)elems, (uint8_t*)scratch, 0, num_elems - 1, width,
+                compare, context);
+}
+
+static void
+S_quicksort(void *elems, void *scratch, size_t num_elems, size_t width,
+            CFISH_Sort_Compare_t compare, void *context) {
+    (void)scratch;
+    Sort_quicksort(elems, num_elems, width, compare, context);
+}
+
+static void
+S_radixsort(void *elems, void *scratch, size_t num_elems, size_t width,
+            CFISH_Sort_Compare_t compare, void *context) {
+    (void)compare;
+    (void)context;
+    switch (width) {
+        case 4:
+            Sort_radixsort_u32((uint32_t*)elems, (uint32_t*)scratch,
+                               num_elems, NULL);
+            break;
+        case 8:
+            Sort_radixsort_u64((uint64_t*)elems, (uint64_t*)scratch,
+                               num_elems, NULL);
+            break;
+        default:
+            Sort_radixsort_keyed(elems, scratch, num_elems, width, NULL);
+            break;
+    }
+}
+
+typedef void
+(*sort_t)(void *elems, void *scratch, size_t num_elems, size_t width,
+          CFISH_Sort_Compare_t compare, void *context);
+
+static uint64_t
+S_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void
+S_fill(uint8_t *elems, size_t width, int input) {
+    srand(1);
+    memset(elems, 0, NUM_ELEMS * width);
+    for (size_t i = 0; i < NUM_ELEMS; i++) {
+        uint64_t key;
+        switch (input) {
+            case INPUT_RANDOM:
+                key = (uint64_t)rand() << 16 ^ (uint64_t)rand();
+                break;
+            case INPUT_SORTED:
+                key = i;
+                break;
+            default:
+                key = NUM_ELEMS - i;
+                break;
+        }
+        if (width == 4) { key &= UINT32_MAX; }
+        memcpy(elems + i * width, &key, width < 8 ? width : 8);
+    }
+}
+
+static void
+S_bench(sort_t sort, const char *name, uint8_t *elems, uint8_t *scratch,
+        size_t width, int input) {
+    CFISH_Sort_Compare_t compare = width == 4 ? S_compare4 : S_compare;
+
+    S_fill(elems, width, input);
+    num_compares = 0;
+    uint64_t t0 = S_now_ns();
+    sort(elems, scratch, NUM_ELEMS, width, compare, NULL);
+    uint64_t t1 = S_now_ns();
+
+    printf("%-10s %2u bytes %-9s %8.2f ms %10" PRIu64 " compares\n", name,
+           (unsigned)width, input_names[input], (t1 - t0) / 1000000.0,
+           num_compares);
+}
+
+int
+main() {
+    static const size_t widths[] = { 4, 8, 16 };
+    uint8_t *elems   = (uint8_t*)malloc(NUM_ELEMS * MAX_WIDTH);
+    uint8_t *scratch = (uint8_t*)malloc(NUM_ELEMS * MAX_WIDTH);
+
+    for (size_t i = 0; i < sizeof(widths) / sizeof(widths[0]); i++) {
+        for (int input = 0; input < NUM_INPUTS; input++) {
+            S_bench(S_old_mergesort, "old merge", elems, scratch, widths[i],
+                    input);
+            S_bench(Sort_mergesort, "mergesort", elems, scratch, widths[i],
+                    input);
+            S_bench(S_quicksort, "quicksort", elems, scratch, widths[i],
+                    input);
+            S_bench(S_radixsort, "radixsort", elems, scratch, widths[i],
+                    input);
+        }
+    }
+
+    free(elems);
+    free(scratch);
+    return 0;
+}
+
@@ -0,0 +1,286 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* Compare buffered file I/O through BufOutStream and BufInStream against
+ * stdio.
+ *
+ * - Sequential writes of fixed-width and compressed 32-bit integers, and
+ *   of large chunks which bypass the buffer.
+ * - Sequential reads of the same data with a buffered BufInStream, a
+ *   memory-mapped BufInStream and stdio.
+ * - Random reads of 16-byte records at shuffled offsets.
+ *
+ * Usage: streams [NUM_VALUES [PATH]]
+ *
+ * NUM_VALUES defaults to 10^7.  The file at PATH, "streams.bin" by default,
+ * is overwritten and removed afterwards.  The reads mostly hit the page
+ * cache, so they measure the overhead of the I/O layer rather than the
+ * disk.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CFISH_USE_SHORT_NAMES
+
+#include "Clownfish/String.h"
+#include "Clownfish/Util/BufInStream.h"
+#include "Clownfish/Util/BufOutStream.h"
+
+#define CHUNK_SIZE   (256 * 1024)
+#define RECORD_SIZE  16
+#define NUM_RANDOM   1000000
+
+static uint64_t
+S_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+// Print the rate in millions of `unit` per second.
+static void
+S_report(const char *name, uint64_t start, double amount, const char *unit) {
+    double secs = (double)(S_now_ns() - start) / 1e9;
+    printf("%-36s %10.1f %-6s %9.3f s\n", name, amount / secs / 1e6, unit,
+           secs);
+}
+
+static FILE*
+S_fopen(const char *path, const char *mode) {
+    FILE *file = fopen(path, mode);
+    if (!file) {
+        perror(path);
+        exit(1);
+    }
+    return file;
+}
+
+static void
+S_stdio_put_cu32(FILE *file, uint32_t value) {
+    while (value >= 0x80) {
+        putc((int)(value | 0x80) & 0xFF, file);
+        value >>= 7;
+    }
+    putc((int)value, file);
+}
+
+static uint32_t
+S_stdio_get_cu32(FILE *file) {
+    uint32_t value = 0;
+    for (int shift = 0; ; shift += 7) {
+        int byte = getc(file);
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) { return value; }
+    }
+}
+
+static uint32_t
+S_value(size_t i) {
+    return (uint32_t)(i * 2654435761u) >> (i % 25);
+}
+
+static void
+S_bench_write(String *path, const char *path_c, size_t num_values,
+              char *chunk) {
+    size_t num_chunks  = num_values * 4 / CHUNK_SIZE + 1;
+    double chunk_bytes = (double)num_chunks * CHUNK_SIZE;
+    uint64_t start;
+
+    start = S_now_ns();
+    BufOutStream *outstream = BufOut_open(path, false);
+    for (size_t i = 0; i < num_values; i++) {
+        BufOut_Write_U32(outstream, S_value(i));
+    }
+    BufOut_Close(outstream);
+    DECREF(outstream);
+    S_report("write u32: BufOutStream", start, (double)num_values, "Mop/s");
+
+    start = S_now_ns();
+    FILE *file = S_fopen(path_c, "wb");
+    for (size_t i = 0; i < num_values; i++) {
+        uint32_t value = S_value(i);
+        unsigned char bytes[4] = {
+            (unsigned char)(value >> 24), (unsigned char)(value >> 16),
+            (unsigned char)(value >> 8),  (unsigned char)value
+        };
+        fwrite(bytes, 1, 4, file);
+    }
+    fclose(file);
+    S_report("write u32: stdio", start, (double)num_values, "Mop/s");
+
+    start = S_now_ns();
+    outstream = BufOut_open(path, false);
+    for (size_t i = 0; i < num_chunks; i++) {
+        BufOut_Write_Bytes(outstream, chunk, CHUNK_SIZE);
+    }
+    BufOut_Close(outstream);
+    DECREF(outstream);
+    S_report("write 256K chunks: BufOutStream", start, chunk_bytes, "MB/s");
+
+    start = S_now_ns();
+    file = S_fopen(path_c, "wb");
+    for (size_t i = 0; i < num_chunks; i++) {
+        fwrite(chunk, 1, CHUNK_SIZE, file);
+    }
+    fclose(file);
+    S_report("write 256K chunks: stdio", start, chunk_bytes, "MB/s");
+
+    start = S_now_ns();
+    file = S_fopen(path_c, "wb");
+    for (size_t i = 0; i < num_values; i++) {
+        S_stdio_put_cu32(file, S_value(i));
+    }
+    fclose(file);
+    S_report("write cu32: stdio", start, (double)num_values, "Mop/s");
+
+    // Write the varints last, so that the read benchmarks can use them.
+    start = S_now_ns();
+    outstream = BufOut_open(path, false);
+    for (size_t i = 0; i < num_values; i++) {
+        BufOut_Write_CU32(outstream, S_value(i));
+    }
+    BufOut_Close(outstream);
+    DECREF(outstream);
+    S_report("write cu32: BufOutStream", start, (double)num_values, "Mop/s");
+}
+
+static void
+S_check(uint64_t sum, uint64_t expected) {
+    if (sum != expected) {
+        fprintf(stderr, "Checksum mismatch\n");
+        exit(1);
+    }
+}
+
+static void
+S_bench_read(String *path, const char *path_c, size_t num_values) {
+    uint64_t expected = 0;
+    for (size_t i = 0; i < num_values; i++) { expected += S_value(i); }
+    uint64_t start;
+    uint64_t sum;
+
+    start = S_now_ns();
+    BufInStream *instream = BufIn_open(path);
+    sum = 0;
+    for (size_t i = 0; i < num_values; i++) {
+        sum += BufIn_Read_CU32(instream);
+    }
+    DECREF(instream);
+    S_report("read cu32: BufInStream", start, (double)num_values, "Mop/s");
+    S_check(sum, expected);
+
+    start = S_now_ns();
+    instream = BufIn_open_mmap(path);
+    sum = 0;
+    for (size_t i = 0; i < num_values; i++) {
+        sum += BufIn_Read_CU32(instream);
+    }
+    DECREF(instream);
+    S_report("read cu32: BufInStream mmap", start, (double)num_values,
+             "Mop/s");
+    S_check(sum, expected);
+
+    start = S_now_ns();
+    FILE *file = S_fopen(path_c, "rb");
+    sum = 0;
+    for (size_t i = 0; i < num_values; i++) {
+        sum += S_stdio_get_cu32(file);
+    }
+    fclose(file);
+    S_report("read cu32: stdio", start, (double)num_values, "Mop/s");
+    S_check(sum, expected);
+}
+
+static void
+S_bench_random(String *path, const char *path_c) {
+    BufInStream *instream = BufIn_open(path);
+    int64_t num_records = BufIn_Length(instream) / RECORD_SIZE;
+    DECREF(instream);
+    if (num_records == 0) { return; }
+
+    int64_t *offsets = (int64_t*)malloc(NUM_RANDOM * sizeof(int64_t));
+    uint64_t state = 12345;
+    for (size_t i = 0; i < NUM_RANDOM; i++) {
+        state = state * 6364136223846793005u + 1442695040888963407u;
+        offsets[i] = (int64_t)((state >> 33) % (uint64_t)num_records)
+                     * RECORD_SIZE;
+    }
+    char record[RECORD_SIZE];
+    uint64_t start;
+    uint64_t sum_instream = 0, sum_mmap = 0, sum_stdio = 0;
+
+    start = S_now_ns();
+    instream = BufIn_open(path);
+    for (size_t i = 0; i < NUM_RANDOM; i++) {
+        BufIn_Seek(instream, offsets[i]);
+        BufIn_Read_Bytes(instream, record, RECORD_SIZE);
+        sum_instream += (unsigned char)record[0];
+    }
+    DECREF(instream);
+    S_report("random 16-byte reads: BufInStream", start, NUM_RANDOM, "Mop/s");
+
+    start = S_now_ns();
+    instream = BufIn_open_mmap(path);
+    for (size_t i = 0; i < NUM_RANDOM; i++) {
+        BufIn_Seek(instream, offsets[i]);
+        BufIn_Read_Bytes(instream, record, RECORD_SIZE);
+        sum_mmap += (unsigned char)record[0];
+    }
+    DECREF(instream);
+    S_report("random 16-byte reads: BufInStream mmap",
+             start, NUM_RANDOM, "Mop/s");
+
+    start = S_now_ns();
+    FILE *file = S_fopen(path_c, "rb");
+    for (size_t i = 0; i < NUM_RANDOM; i++) {
+        fseek(file, (long)offsets[i], SEEK_SET);
+        if (fread(record, 1, RECORD_SIZE, file) != RECORD_SIZE) {
+            fprintf(stderr, "Short read\n");
+            exit(1);
+        }
+        sum_stdio += (unsigned char)record[0];
+    }
+    fclose(file);
+    S_report("random 16-byte reads: stdio", start, NUM_RANDOM, "Mop/s");
+
+    S_check(sum_mmap, sum_instream);
+    S_check(sum_stdio, sum_instream);
+    free(offsets);
+}
+
+int
+main(int argc, char **argv) {
+    size_t num_values = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10)
+                                 : 10000000;
+    const char *path_c = argc > 2 ? argv[2] : "streams.bin";
+
+    cfish_bootstrap_parcel();
+
+    String *path = Str_newf("%s", path_c);
+    char *chunk = (char*)malloc(CHUNK_SIZE);
+    memset(chunk, 'x', CHUNK_SIZE);
+
+    S_bench_write(path, path_c, num_values, chunk);
+    S_bench_read(path, path_c, num_values);
+    S_bench_random(path, path_c);
+
+    remove(path_c);
+    free(chunk);
+    DECREF(path);
+    return 0;
+}
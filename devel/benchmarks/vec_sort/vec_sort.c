@@ -0,0 +1,126 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Sort a Vector of random term-like Strings:
+ *
+ *   compare_to  Sort_By with a comparator that dispatches to Compare_To,
+ *               which is what Vec_Sort used to do.
+ *   msd_radix   Sort_radixsort_bytes over (pointer, size) keys.
+ *   Vec_Sort    The prefix-caching fast path for homogeneous Vectors.
+ *
+ * Usage: vec_sort [NUM_TERMS]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Class.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Vector.h"
+#include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/SortUtils.h"
+
+static uint64_t
+S_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static int
+S_compare_to(void *context, const void *va, const void *vb) {
+    (void)context;
+    return Obj_Compare_To(*(Obj**)va, *(Obj**)vb);
+}
+
+static void
+S_msd_radix(Vector *vec) {
+    size_t size = Vec_Get_Size(vec);
+    SortByteKey *keys
+        = (SortByteKey*)MALLOCATE(2 * size * sizeof(SortByteKey));
+    for (size_t i = 0; i < size; i++) {
+        String *string = (String*)Vec_Fetch(vec, i);
+        keys[i].ptr   = (const uint8_t*)Str_Get_Ptr8(string);
+        keys[i].size  = Str_Get_Size(string);
+        keys[i].value = string;
+    }
+    Sort_radixsort_bytes(keys, keys + size, size);
+    Vector *sorted = Vec_new(size);
+    for (size_t i = 0; i < size; i++) {
+        Vec_Push(sorted, INCREF(keys[i].value));
+    }
+    DECREF(sorted);
+    FREEMEM(keys);
+}
+
+// Build terms which look like words: a few common prefixes followed by
+// random lowercase letters.
+static Vector*
+S_make_terms(size_t num_terms) {
+    static const char *prefixes[] = { "", "pre", "inter", "un", "con" };
+    Vector *terms = Vec_new(num_terms);
+    char buf[32];
+    srand(1);
+    for (size_t i = 0; i < num_terms; i++) {
+        const char *prefix = prefixes[rand() % 5];
+        size_t len = strlen(prefix);
+        memcpy(buf, prefix, len);
+        size_t extra = 2 + (size_t)(rand() % 10);
+        for (size_t j = 0; j < extra; j++) {
+            buf[len++] = (char)('a' + rand() % 26);
+        }
+        Vec_Push(terms, (Obj*)Str_new_from_trusted_utf8(buf, len));
+    }
+    return terms;
+}
+
+int
+main(int argc, char **argv) {
+    size_t num_terms = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10)
+                                : 1000000;
+    cfish_bootstrap_parcel();
+
+    Vector *terms = S_make_terms(num_terms);
+
+    Vector *vec = Vec_Clone(terms);
+    uint64_t t0 = S_now_ns();
+    Vec_Sort_By(vec, S_compare_to, NULL);
+    uint64_t t1 = S_now_ns();
+    printf("compare_to %9.1f ms\n", (t1 - t0) / 1000000.0);
+    DECREF(vec);
+
+    vec = Vec_Clone(terms);
+    t0 = S_now_ns();
+    S_msd_radix(vec);
+    t1 = S_now_ns();
+    printf("msd_radix  %9.1f ms\n", (t1 - t0) / 1000000.0);
+    DECREF(vec);
+
+    vec = Vec_Clone(terms);
+    t0 = S_now_ns();
+    Vec_Sort(vec);
+    t1 = S_now_ns();
+    printf("Vec_Sort   %9.1f ms\n", (t1 - t0) / 1000000.0);
+    DECREF(vec);
+
+    DECREF(terms);
+    return 0;
+}
+
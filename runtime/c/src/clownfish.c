@@ -36,9 +36,11 @@
 #include "Clownfish/Hash.h"
 #include "Clownfish/Method.h"
 #include "Clownfish/Num.h"
+#include "Clownfish/NumVector.h"
 #include "Clownfish/String.h"
 #include "Clownfish/TestHarness/TestUtils.h"
 #include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/Trace.h"
 #include "Clownfish/Vector.h"
 
 /**** Obj ******************************************************************/
@@ -87,6 +89,9 @@ cfish_inc_refcount(void *vself) {
         else if (SI_immortal(klass)) {
             return self;
         }
+        else if (klass == CFISH_INTEGER && cfish_Int_is_cached(self)) {
+            return self;
+        }
     }
 
     self->refcount++;
@@ -98,7 +103,9 @@ cfish_dec_refcount(void *vself) {
     cfish_Obj *self = (Obj*)vself;
     cfish_Class *klass = self->klass;
     if (klass->flags & CFISH_fREFCOUNTSPECIAL) {
-        if (SI_immortal(klass)) {
+        if (SI_immortal(klass)
+            || (klass == CFISH_INTEGER && cfish_Int_is_cached(self))
+           ) {
             return (uint32_t)self->refcount;
         }
     }
@@ -134,6 +141,7 @@ Class_Make_Obj_IMP(Class *self) {
     Obj *obj = (Obj*)Memory_wrapped_calloc(self->obj_alloc_size, 1);
     obj->klass = self;
     obj->refcount = 1;
+    CENSUS_NEW_OBJ(self);
     return obj;
 }
 
@@ -197,6 +205,7 @@ Err_set_error(Err *error) {
 void
 Err_do_throw(Err *error) {
     ErrContext *context = Tls_get_err_context();
+    TRACE_INSTANT("Err", "throw", 0);
 
     if (context->current_env) {
         context->thrown_error = error;
@@ -320,3 +329,24 @@ Bool_To_Host_IMP(Boolean *self, void *vcache) {
     return super_to_host(self, vcache);
 }
 
+void*
+I32Vec_To_Host_IMP(I32Vector *self, void *vcache) {
+    I32Vec_To_Host_t super_to_host
+        = SUPER_METHOD_PTR(I32VECTOR, CFISH_I32Vec_To_Host);
+    return super_to_host(self, vcache);
+}
+
+void*
+I64Vec_To_Host_IMP(I64Vector *self, void *vcache) {
+    I64Vec_To_Host_t super_to_host
+        = SUPER_METHOD_PTR(I64VECTOR, CFISH_I64Vec_To_Host);
+    return super_to_host(self, vcache);
+}
+
+void*
+F64Vec_To_Host_IMP(F64Vector *self, void *vcache) {
+    F64Vec_To_Host_t super_to_host
+        = SUPER_METHOD_PTR(F64VECTOR, CFISH_F64Vec_To_Host);
+    return super_to_host(self, vcache);
+}
+
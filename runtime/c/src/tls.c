@@ -24,20 +24,70 @@
 
 #include "tls.h"
 
+#include "Clownfish/Util/Atomic.h"
 #include "Clownfish/Util/Memory.h"
 
+/* Slot reservations.  A slot is taken by pointing its claim at its
+ * destructor entry.
+ */
+static struct {
+    Tls_Destroy_t destroy;
+} slot_info[CFISH_TLS_MAX_SLOTS];
+static void *volatile slot_claims[CFISH_TLS_MAX_SLOTS];
+
+int
+Tls_new_slot(Tls_Destroy_t destroy) {
+    for (int i = 0; i < CFISH_TLS_MAX_SLOTS; i++) {
+        if (Atomic_cas_ptr(&slot_claims[i], NULL, &slot_info[i])) {
+            slot_info[i].destroy = destroy;
+            return i;
+        }
+    }
+    return -1;
+}
+
+#ifndef CFISH_NOTHREADS
+// Release everything held by a thread's block, but not the block itself.
+// Destructors may store new values in the block, so repeat until it's
+// empty, giving up after a few rounds like pthreads does.
+static void
+S_clear_block(TlsBlock *block) {
+    for (int round = 0; round < 4; round++) {
+        bool cleared = false;
+        if (block->err_context.current_error != NULL) {
+            DECREF(block->err_context.current_error);
+            block->err_context.current_error = NULL;
+            cleared = true;
+        }
+        for (int i = 0; i < CFISH_TLS_MAX_SLOTS; i++) {
+            void *value = block->slots[i];
+            if (value == NULL) { continue; }
+            block->slots[i] = NULL;
+            if (slot_info[i].destroy != NULL) {
+                slot_info[i].destroy(value);
+            }
+            cleared = true;
+        }
+        if (!cleared) { break; }
+    }
+    // Register again if the block is used by later thread-exit code.
+    block->registered = false;
+}
+#endif
+
+
 /**************************** No thread support ****************************/
 #ifdef CFISH_NOTHREADS
 
-static ErrContext err_context;
+static TlsBlock tls_block;
 
 void
 Tls_init() {
 }
 
-ErrContext*
-Tls_get_err_context() {
-    return &err_context;
+TlsBlock*
+Tls_get_block() {
+    return &tls_block;
 }
 
 /********************************** Windows ********************************/
@@ -45,7 +95,7 @@ Tls_get_err_context() {
 
 #include <windows.h>
 
-static DWORD err_context_tls_index;
+static DWORD tls_block_index;
 
 void
 Tls_init() {
@@ -54,27 +104,26 @@ Tls_init() {
         fprintf(stderr, "TlsAlloc failed (TLS_OUT_OF_INDEXES)\n");
         abort();
     }
-    LONG old_index = InterlockedCompareExchange((LONG*)&err_context_tls_index,
+    LONG old_index = InterlockedCompareExchange((LONG*)&tls_block_index,
                                                 tls_index, 0);
     if (old_index != 0) {
         TlsFree(tls_index);
     }
 }
 
-ErrContext*
-Tls_get_err_context() {
-    ErrContext *context
-        = (ErrContext*)TlsGetValue(err_context_tls_index);
+TlsBlock*
+Tls_get_block() {
+    TlsBlock *block = (TlsBlock*)TlsGetValue(tls_block_index);
 
-    if (!context) {
-        context = (ErrContext*)CALLOCATE(1, sizeof(ErrContext));
-        if (!TlsSetValue(err_context_tls_index, context)) {
+    if (!block) {
+        block = (TlsBlock*)CALLOCATE(1, sizeof(TlsBlock));
+        if (!TlsSetValue(tls_block_index, block)) {
             fprintf(stderr, "TlsSetValue failed: %lu\n", GetLastError());
             abort();
         }
     }
 
-    return context;
+    return block;
 }
 
 BOOL WINAPI
@@ -83,59 +132,95 @@ DllMain(HINSTANCE dll, DWORD reason, LPVOID reserved) {
     UNUSED_VAR(reserved);
 
     if (reason == DLL_THREAD_DETACH) {
-        ErrContext *context
-            = (ErrContext*)TlsGetValue(err_context_tls_index);
+        TlsBlock *block = (TlsBlock*)TlsGetValue(tls_block_index);
 
-        if (context) {
-            CFISH_DECREF(context->current_error);
-            FREEMEM(context);
+        if (block) {
+            S_clear_block(block);
+            TlsSetValue(tls_block_index, NULL);
+            FREEMEM(block);
         }
     }
 
     return TRUE;
 }
 
+/*********************** Native thread-local storage ***********************/
+#elif defined(CFISH_TLS_NATIVE)
+
+#include <pthread.h>
+
+CHY_THREAD_LOCAL TlsBlock cfish_Tls_block;
+
+static pthread_key_t tls_block_key;
+
+static void
+S_destroy_block(void *block);
+
+void
+Tls_init() {
+    int error = pthread_key_create(&tls_block_key, S_destroy_block);
+    if (error) {
+        fprintf(stderr, "pthread_key_create failed: %d\n", error);
+        abort();
+    }
+}
+
+// Called on the first access from a thread.  Registering the block with
+// the pthread key makes S_destroy_block run when the thread exits.
+void
+Tls_register_block() {
+    int error = pthread_setspecific(tls_block_key, &cfish_Tls_block);
+    if (error) {
+        fprintf(stderr, "pthread_setspecific failed: %d\n", error);
+        abort();
+    }
+    cfish_Tls_block.registered = true;
+}
+
+static void
+S_destroy_block(void *block) {
+    S_clear_block((TlsBlock*)block);
+}
+
 /******************************** pthreads *********************************/
 #elif defined(CHY_HAS_PTHREAD_H)
 
 #include <pthread.h>
 
-static pthread_key_t err_context_key;
+static pthread_key_t tls_block_key;
 
 static void
-S_destroy_context(void *context);
+S_destroy_block(void *block);
 
 void
 Tls_init() {
-    int error = pthread_key_create(&err_context_key, S_destroy_context);
+    int error = pthread_key_create(&tls_block_key, S_destroy_block);
     if (error) {
         fprintf(stderr, "pthread_key_create failed: %d\n", error);
         abort();
     }
 }
 
-ErrContext*
-Tls_get_err_context() {
-    ErrContext *context
-        = (ErrContext*)pthread_getspecific(err_context_key);
+TlsBlock*
+Tls_get_block() {
+    TlsBlock *block = (TlsBlock*)pthread_getspecific(tls_block_key);
 
-    if (!context) {
-        context = (ErrContext*)CALLOCATE(1, sizeof(ErrContext));
-        int error = pthread_setspecific(err_context_key, context);
+    if (!block) {
+        block = (TlsBlock*)CALLOCATE(1, sizeof(TlsBlock));
+        int error = pthread_setspecific(tls_block_key, block);
         if (error) {
             fprintf(stderr, "pthread_setspecific failed: %d\n", error);
             abort();
         }
     }
 
-    return context;
+    return block;
 }
 
 static void
-S_destroy_context(void *arg) {
-    ErrContext *context = (ErrContext*)arg;
-    DECREF(context->current_error);
-    FREEMEM(context);
+S_destroy_block(void *block) {
+    S_clear_block((TlsBlock*)block);
+    FREEMEM(block);
 }
 
 /****************** No support for thread-local storage ********************/
@@ -145,4 +230,3 @@ S_destroy_context(void *arg) {
 
 #endif
 
-
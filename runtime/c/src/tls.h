@@ -33,16 +33,88 @@ typedef struct {
     jmp_buf *current_env;
 } cfish_ErrContext;
 
+#define CFISH_TLS_MAX_SLOTS 8
+
+typedef void
+(*cfish_Tls_Destroy_t)(void *value);
+
+/* Per-thread state.  Besides the error context, the block has a few
+ * generic slots for per-thread caches, so that all per-thread data is
+ * reached with a single thread-local lookup.
+ */
+typedef struct {
+    cfish_ErrContext  err_context;
+    void             *slots[CFISH_TLS_MAX_SLOTS];
+    bool              registered;
+} cfish_TlsBlock;
+
 void
 cfish_Tls_init(void);
 
-cfish_ErrContext*
-cfish_Tls_get_err_context();
+/* Reserve a slot in the per-thread block.  `destroy` is called with the
+ * value of the slot, if it isn't NULL, when a thread exits.  The slot is
+ * cleared before, so `destroy` may store a new value which is destroyed in
+ * turn.  Returns -1 if all slots are taken.
+ */
+CFISH_VISIBLE int
+cfish_Tls_new_slot(cfish_Tls_Destroy_t destroy);
+
+#if defined(CHY_HAS_THREAD_LOCAL) \
+    && defined(CHY_HAS_PTHREAD_H) \
+    && !defined(CHY_HAS_WINDOWS_H) \
+    && !defined(CFISH_NOTHREADS)
+
+/* Native thread-local storage.  The pthread key is only used to clean up
+ * when a thread exits.
+ */
+#define CFISH_TLS_NATIVE
+
+extern CFISH_VISIBLE CHY_THREAD_LOCAL cfish_TlsBlock cfish_Tls_block;
+
+CFISH_VISIBLE void
+cfish_Tls_register_block(void);
+
+static CFISH_INLINE cfish_TlsBlock*
+cfish_Tls_get_block(void) {
+    if (!cfish_Tls_block.registered) {
+        cfish_Tls_register_block();
+    }
+    return &cfish_Tls_block;
+}
+
+#else
+
+CFISH_VISIBLE cfish_TlsBlock*
+cfish_Tls_get_block(void);
+
+#endif
+
+static CFISH_INLINE cfish_ErrContext*
+cfish_Tls_get_err_context(void) {
+    return &cfish_Tls_get_block()->err_context;
+}
+
+static CFISH_INLINE void*
+cfish_Tls_get_slot(int slot) {
+    return cfish_Tls_get_block()->slots[slot];
+}
+
+static CFISH_INLINE void
+cfish_Tls_set_slot(int slot, void *value) {
+    cfish_Tls_get_block()->slots[slot] = value;
+}
 
 #ifdef CFISH_USE_SHORT_NAMES
   #define ErrContext            cfish_ErrContext
+  #define TlsBlock              cfish_TlsBlock
+  #define Tls_Destroy_t         cfish_Tls_Destroy_t
   #define Tls_init              cfish_Tls_init
+  #define Tls_register_block    cfish_Tls_register_block
+  #define Tls_new_slot          cfish_Tls_new_slot
+  #define Tls_get_block         cfish_Tls_get_block
   #define Tls_get_err_context   cfish_Tls_get_err_context
+  #define Tls_get_slot          cfish_Tls_get_slot
+  #define Tls_set_slot          cfish_Tls_set_slot
 #endif
 
 #ifdef __cplusplus
@@ -16,6 +16,8 @@
 
 #include <stdlib.h>
 
+#include "Clownfish/Class.h"
+#include "Clownfish/Err.h"
 #include "Clownfish/TestHarness/TestFormatter.h"
 #include "Clownfish/TestHarness/TestSuite.h"
 #include "Clownfish/Test.h"
@@ -24,16 +26,32 @@ int
 main() {
     cfish_TestFormatter *formatter;
     cfish_TestSuite     *suite;
+    const char          *threads_env;
+    uint32_t             num_threads;
     bool success;
 
     testcfish_bootstrap_parcel();
 
+    // Report leaked objects at exit if CLOWNFISH_CENSUS is set.
+    if (getenv("CLOWNFISH_CENSUS")) {
+        cfish_Class_enable_census(true);
+    }
+
     formatter = (cfish_TestFormatter*)cfish_TestFormatterCF_new();
     suite     = testcfish_Test_create_test_suite();
-    success   = CFISH_TestSuite_Run_All_Batches(suite, formatter);
+
+    // Run batches on all processors unless CLOWNFISH_TEST_THREADS is set.
+    threads_env = getenv("CLOWNFISH_TEST_THREADS");
+    num_threads = threads_env ? (uint32_t)strtoul(threads_env, NULL, 10) : 0;
+    success = CFISH_TestSuite_Run_All_Batches_Parallel(suite, formatter,
+                                                       num_threads);
 
     CFISH_DECREF(formatter);
     CFISH_DECREF(suite);
+
+    // Release the last error trapped on the main thread, so that it isn't
+    // reported as leaked.
+    cfish_Err_set_error(NULL);
     return success ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
@@ -0,0 +1,192 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Tests for the per-thread storage of the C host, which isn't available to
+ * the host-independent test suite.  Output follows the TAP protocol.
+ */
+
+#define CFISH_USE_SHORT_NAMES
+
+#include "charmony.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tls.h"
+
+#include "Clownfish/Class.h"
+
+#if defined(CFISH_NOTHREADS)
+  /* No worker threads. */
+#elif defined(CHY_HAS_WINDOWS_H)
+  #include <windows.h>
+  #include <process.h>
+#elif defined(CHY_HAS_PTHREAD_H)
+  #include <pthread.h>
+#endif
+
+#define NUM_TESTS 11
+
+static int test_num = 0;
+static int num_failed = 0;
+
+static void
+S_ok(int ok, const char *name) {
+    test_num++;
+    if (!ok) { num_failed++; }
+    printf("%sok %d - %s\n", ok ? "" : "not ", test_num, name);
+}
+
+static void
+S_skip(int num, const char *reason) {
+    for (int i = 0; i < num; i++) {
+        test_num++;
+        printf("ok %d # SKIP %s\n", test_num, reason);
+    }
+}
+
+static int first_slot;
+static int second_slot;
+
+/* Values destroyed by the slot destructors.  Only touched by one thread at
+ * a time.
+ */
+static void *first_destroyed;
+static void *second_destroyed;
+static int   num_destroyed;
+
+static int worker_value;
+static int worker_restored_value;
+
+static void
+S_destroy_first(void *value) {
+    first_destroyed = value;
+    num_destroyed++;
+    // Store a new value in a slot that was already cleared.
+    Tls_set_slot(second_slot, &worker_restored_value);
+}
+
+static void
+S_destroy_second(void *value) {
+    second_destroyed = value;
+    num_destroyed++;
+}
+
+typedef struct {
+    int         slot_was_empty;
+    int         round_trip;
+    ErrContext *err_context;
+} WorkerResult;
+
+#ifndef CFISH_NOTHREADS
+static void
+S_worker(WorkerResult *result) {
+    result->slot_was_empty = Tls_get_slot(first_slot) == NULL;
+    Tls_set_slot(first_slot, &worker_value);
+    result->round_trip  = Tls_get_slot(first_slot) == &worker_value;
+    result->err_context = Tls_get_err_context();
+}
+#endif
+
+#if defined(CFISH_NOTHREADS)
+
+static int
+S_run_worker(WorkerResult *result) {
+    (void)result;
+    return 0;
+}
+
+#elif defined(CHY_HAS_WINDOWS_H)
+
+static unsigned __stdcall
+S_thread_main(void *arg) {
+    S_worker((WorkerResult*)arg);
+    return 0;
+}
+
+static int
+S_run_worker(WorkerResult *result) {
+    uintptr_t thread = _beginthreadex(NULL, 0, S_thread_main, result, 0,
+                                      NULL);
+    if (thread == 0) { return 0; }
+    WaitForSingleObject((HANDLE)thread, INFINITE);
+    CloseHandle((HANDLE)thread);
+    return 1;
+}
+
+#else
+
+static void*
+S_thread_main(void *arg) {
+    S_worker((WorkerResult*)arg);
+    return NULL;
+}
+
+static int
+S_run_worker(WorkerResult *result) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, S_thread_main, result) != 0) {
+        return 0;
+    }
+    pthread_join(thread, NULL);
+    return 1;
+}
+
+#endif
+
+int
+main() {
+    int main_value = 0;
+
+    cfish_bootstrap_parcel();
+    printf("1..%d\n", NUM_TESTS);
+
+    // The second slot gets the lower index, so it has already been cleared
+    // when the first slot's destructor stores a value in it.
+    second_slot = Tls_new_slot(S_destroy_second);
+    first_slot  = Tls_new_slot(S_destroy_first);
+    S_ok(first_slot >= 0 && second_slot >= 0, "new_slot");
+
+    S_ok(Tls_get_slot(first_slot) == NULL, "new slot is empty");
+    Tls_set_slot(first_slot, &main_value);
+    S_ok(Tls_get_slot(first_slot) == &main_value, "set_slot and get_slot");
+
+    WorkerResult result = { 0, 0, NULL };
+    if (S_run_worker(&result)) {
+        S_ok(result.slot_was_empty, "slot is empty in other thread");
+        S_ok(result.round_trip, "set_slot and get_slot in other thread");
+        S_ok(result.err_context != NULL
+             && result.err_context != Tls_get_err_context(),
+             "each thread has its own error context");
+        S_ok(first_destroyed == &worker_value,
+             "destructor runs when thread exits");
+        S_ok(second_destroyed == &worker_restored_value,
+             "value stored by destructor is destroyed");
+        S_ok(num_destroyed == 2, "destructors run once per value");
+    }
+    else {
+        S_skip(6, "No thread support");
+    }
+    S_ok(Tls_get_slot(first_slot) == &main_value,
+         "exit of other thread doesn't affect slot");
+
+    int num_slots = 2;
+    while (Tls_new_slot(NULL) >= 0) { num_slots++; }
+    S_ok(num_slots == CFISH_TLS_MAX_SLOTS, "new_slot fails if all are taken");
+
+    Tls_set_slot(first_slot, NULL);
+    return num_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
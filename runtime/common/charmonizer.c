@@ -8693,6 +8693,9 @@ S_ends_with(const char *string, const char *postfix);
 static int
 S_need_libpthread(chaz_CLI *cli);
 
+static void
+S_probe_thread_local(void);
+
 int main(int argc, const char **argv) {
     chaz_CFlags *link_flags;
 
@@ -8740,6 +8743,7 @@ int main(int argc, const char **argv) {
     if (chaz_HeadCheck_defines_symbol("__sync_bool_compare_and_swap", "")) {
         chaz_ConfWriter_add_def("HAS___SYNC_BOOL_COMPARE_AND_SWAP", NULL);
     }
+    S_probe_thread_local();
     link_flags = S_link_flags(cli);
     chaz_ConfWriter_add_def("EXTRA_LDFLAGS",
                             chaz_CFlags_get_string(link_flags));
@@ -9186,8 +9190,27 @@ cfish_MakeFile_write_c_test_rules(cfish_MakeFile *self) {
     chaz_MakeFile_add_rule(self->makefile, "$(TEST_CFISH_EXE_OBJS)",
                            self->autogen_target);
 
-    rule = chaz_MakeFile_add_rule(self->makefile, "test", "$(TEST_CFISH_EXE)");
+    /* Tests for the per-thread storage of the C host. */
+    exe = chaz_MakeFile_add_exe(self->makefile, "t", "test_tls");
+    chaz_MakeBinary_add_src_file(exe, "t", "test_tls.c");
+
+    link_flags = chaz_MakeBinary_get_link_flags(exe);
+    chaz_CFlags_add_rpath(link_flags, "\"$$PWD\"");
+    chaz_CFlags_add_shared_lib(link_flags, NULL, "clownfish",
+                               cfish_major_version);
+    if (S_need_libpthread(self->cli)) {
+        chaz_CFlags_add_external_lib(link_flags, "pthread");
+    }
+
+    chaz_MakeBinary_add_prereq(exe, "$(CLOWNFISH_SHARED_LIB)");
+
+    chaz_MakeFile_add_rule(self->makefile, "$(TEST_TLS_EXE_OBJS)",
+                           self->autogen_target);
+
+    rule = chaz_MakeFile_add_rule(self->makefile, "test",
+                                  "$(TEST_CFISH_EXE) $(TEST_TLS_EXE)");
     chaz_MakeRule_add_command(rule, "$(TEST_CFISH_EXE)");
+    chaz_MakeRule_add_command(rule, "$(TEST_TLS_EXE)");
 
     if (chaz_OS_shell_type() == CHAZ_OS_POSIX) {
         const char *valgrind_command;
@@ -9270,6 +9293,34 @@ S_ends_with(const char *string, const char *postfix) {
            && memcmp(string + len - postfix_len, postfix, postfix_len) == 0;
 }
 
+/* Find the keyword for native thread-local storage, preferring __thread
+ * which doesn't cause warnings with -pedantic in C99 mode.
+ */
+static void
+S_probe_thread_local(void) {
+    static const char *const keywords[] = {
+        "__thread", "_Thread_local", NULL
+    };
+    static const char source_pattern[] =
+        "static %s int value;\n"
+        "\n"
+        "int main() {\n"
+        "    value++;\n"
+        "    return value - 1;\n"
+        "}\n";
+    char source[sizeof(source_pattern) + 20];
+    int i;
+
+    for (i = 0; keywords[i] != NULL; i++) {
+        sprintf(source, source_pattern, keywords[i]);
+        if (chaz_CC_test_link(source)) {
+            chaz_ConfWriter_add_def("HAS_THREAD_LOCAL", NULL);
+            chaz_ConfWriter_add_def("THREAD_LOCAL", keywords[i]);
+            return;
+        }
+    }
+}
+
 static int
 S_need_libpthread(chaz_CLI *cli) {
     static const char source[] =
@@ -18,6 +18,7 @@
 #include "Clownfish/Hash.h"
 #include "Clownfish/HashIterator.h"
 #include "Clownfish/Err.h"
+#include "Clownfish/Num.h"
 
 void
 cfish_init_parcel() {
@@ -25,5 +26,6 @@ cfish_init_parcel() {
     cfish_Hash_init_class();
     cfish_HashIter_init_class();
     cfish_Err_init_class();
+    cfish_Int_init_class();
 }
 
@@ -18,12 +18,29 @@
 #define CFISH_USE_SHORT_NAMES
 
 #include <string.h>
+#include <errno.h>
+
+#include "charmony.h"
 
 #include "Clownfish/Class.h"
 #include "Clownfish/Blob.h"
 #include "Clownfish/Err.h"
+#include "Clownfish/String.h"
 #include "Clownfish/Util/Memory.h"
 
+#if defined(CHY_HAS_WINDOWS_H)
+  #define BLOB_MMAP_WINDOWS
+  #include <windows.h>
+#elif defined(CHY_HAS_SYS_MMAN_H) && defined(CHY_HAS_UNISTD_H) \
+      && defined(CHY_HAS_FCNTL_H) && defined(CHY_HAS_SYS_STAT_H)
+  #define BLOB_MMAP_POSIX
+  #include <sys/types.h>
+  #include <sys/stat.h>
+  #include <sys/mman.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
 Blob*
 Blob_new(const void *bytes, size_t size) {
     Blob *self = (Blob*)Class_Make_Obj(BLOB);
@@ -35,9 +52,12 @@ Blob_init(Blob *self, const void *bytes, size_t size) {
     char *copy = (char*)MALLOCATE(size);
     memcpy(copy, bytes, size);
 
-    self->buf      = copy;
-    self->size     = size;
-    self->owns_buf = true;
+    self->buf             = copy;
+    self->size            = size;
+    self->owns_buf        = true;
+    self->release         = NULL;
+    self->release_context = NULL;
+    CENSUS_BYTES(self, size);
 
     return self;
 }
@@ -50,9 +70,12 @@ Blob_new_steal(void *bytes, size_t size) {
 
 Blob*
 Blob_init_steal(Blob *self, void *bytes, size_t size) {
-    self->buf      = (char*)bytes;
-    self->size     = size;
-    self->owns_buf = true;
+    self->buf             = (char*)bytes;
+    self->size            = size;
+    self->owns_buf        = true;
+    self->release         = NULL;
+    self->release_context = NULL;
+    CENSUS_BYTES(self, size);
 
     return self;
 }
@@ -65,16 +88,323 @@ Blob_new_wrap(const void *bytes, size_t size) {
 
 Blob*
 Blob_init_wrap(Blob *self, const void *bytes, size_t size) {
-    self->buf      = (char*)bytes;
-    self->size     = size;
-    self->owns_buf = false;
+    self->buf             = (char*)bytes;
+    self->size            = size;
+    self->owns_buf        = false;
+    self->release         = NULL;
+    self->release_context = NULL;
+
+    return self;
+}
+
+Blob*
+Blob_new_external(const void *bytes, size_t size, Blob_Release_t release,
+                  void *context) {
+    Blob *self = (Blob*)Class_Make_Obj(BLOB);
+    return Blob_init_external(self, bytes, size, release, context);
+}
+
+Blob*
+Blob_init_external(Blob *self, const void *bytes, size_t size,
+                   Blob_Release_t release, void *context) {
+    self->buf             = (const char*)bytes;
+    self->size            = size;
+    self->owns_buf        = false;
+    self->release         = release;
+    self->release_context = context;
 
     return self;
 }
 
+/******************************** mmap *************************************/
+
+// The start of a mapping must be aligned, so it may begin before the
+// Blob's buffer.
+typedef struct {
+    void   *base;
+    size_t  len;
+} BlobMapping;
+
+static void
+S_release_mapping(void *context, const char *buf, size_t size);
+
+// Map a range of a file.  Return an error message on failure.
+static String*
+S_map_file(String *path, int64_t offset, int64_t len, BlobMapping *mapping,
+           const char **buf, size_t *size);
+
+Blob*
+Blob_new_mmap(String *path, int64_t offset, int64_t len) {
+    Blob *self = (Blob*)Class_Make_Obj(BLOB);
+    return Blob_init_mmap(self, path, offset, len);
+}
+
+Blob*
+Blob_init_mmap(Blob *self, String *path, int64_t offset, int64_t len) {
+    BlobMapping  mapping = { NULL, 0 };
+    const char  *buf     = NULL;
+    size_t       size    = 0;
+
+    // Start out empty, so that self can be destroyed on error.
+    Blob_init_wrap(self, "", 0);
+
+    String *mess = offset < 0
+                   ? MAKE_MESS("Negative offset for '%o': %i64", path, offset)
+                   : S_map_file(path, offset, len, &mapping, &buf, &size);
+    if (mess) {
+        DECREF(self);
+        Err_throw_mess(ERR, mess);
+    }
+    if (mapping.base == NULL) {
+        // Empty range.  There's nothing to map.
+        return self;
+    }
+
+    BlobMapping *context = (BlobMapping*)MALLOCATE(sizeof(BlobMapping));
+    *context = mapping;
+    return Blob_init_external(self, buf, size, S_release_mapping, context);
+}
+
+bool
+Blob_Is_Mapped_IMP(Blob *self) {
+    return self->release == S_release_mapping;
+}
+
+#if defined(BLOB_MMAP_POSIX)
+
+static size_t
+S_page_size() {
+    static size_t page_size = 0;
+    if (page_size == 0) {
+        long result = sysconf(_SC_PAGESIZE);
+        page_size = result > 0 ? (size_t)result : 4096;
+    }
+    return page_size;
+}
+
+static String*
+S_map_file(String *path, int64_t offset, int64_t len, BlobMapping *mapping,
+           const char **buf, size_t *size) {
+    char *path_utf8 = Str_To_Utf8(path);
+    int fd = open(path_utf8, O_RDONLY);
+    FREEMEM(path_utf8);
+    if (fd < 0) {
+        return MAKE_MESS("Can't open '%o': %s", path, strerror(errno));
+    }
+
+    struct stat stat_buf;
+    if (fstat(fd, &stat_buf) != 0) {
+        int error = errno;
+        close(fd);
+        return MAKE_MESS("Can't stat '%o': %s", path, strerror(error));
+    }
+    int64_t file_size = (int64_t)stat_buf.st_size;
+    if (len < 0) {
+        len = offset < file_size ? file_size - offset : 0;
+    }
+    if (offset > file_size || len > file_size - offset) {
+        close(fd);
+        return MAKE_MESS("Range %i64+%i64 outside of '%o' (%i64 bytes)",
+                         offset, len, path, file_size);
+    }
+    if ((uint64_t)len > SIZE_MAX - S_page_size()) {
+        close(fd);
+        return MAKE_MESS("Range of %i64 bytes too large to map", len);
+    }
+    if (len == 0) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t delta = (size_t)(offset % (int64_t)S_page_size());
+    size_t map_len = (size_t)len + delta;
+    void *base = mmap(NULL, map_len, PROT_READ, MAP_SHARED, fd,
+                      (off_t)(offset - (int64_t)delta));
+    int error = errno;
+    close(fd);
+    if (base == MAP_FAILED) {
+        return MAKE_MESS("Can't mmap '%o': %s", path, strerror(error));
+    }
+
+    mapping->base = base;
+    mapping->len  = map_len;
+    *buf  = (const char*)base + delta;
+    *size = (size_t)len;
+    return NULL;
+}
+
+static void
+S_release_mapping(void *context, const char *buf, size_t size) {
+    BlobMapping *mapping = (BlobMapping*)context;
+    UNUSED_VAR(buf);
+    UNUSED_VAR(size);
+    munmap(mapping->base, mapping->len);
+    FREEMEM(mapping);
+}
+
+bool
+Blob_Advise_IMP(Blob *self, int32_t advice) {
+    if (self->release != S_release_mapping) { return false; }
+    BlobMapping *mapping = (BlobMapping*)self->release_context;
+
+    int posix_advice;
+    switch (advice) {
+        case BLOB_ADVICE_NORMAL:
+            posix_advice = POSIX_MADV_NORMAL;
+            break;
+        case BLOB_ADVICE_SEQUENTIAL:
+            posix_advice = POSIX_MADV_SEQUENTIAL;
+            break;
+        case BLOB_ADVICE_RANDOM:
+            posix_advice = POSIX_MADV_RANDOM;
+            break;
+        case BLOB_ADVICE_WILLNEED:
+            posix_advice = POSIX_MADV_WILLNEED;
+            break;
+        case BLOB_ADVICE_DONTNEED:
+            // Mappings are read-only and shared, so dropping pages never
+            // loses data.
+            posix_advice = POSIX_MADV_DONTNEED;
+            break;
+        default:
+            THROW(ERR, "Invalid advice: %i32", advice);
+            UNREACHABLE_RETURN(bool);
+    }
+
+    return posix_madvise(mapping->base, mapping->len, posix_advice) == 0;
+}
+
+#elif defined(BLOB_MMAP_WINDOWS)
+
+static String*
+S_map_file(String *path, int64_t offset, int64_t len, BlobMapping *mapping,
+           const char **buf, size_t *size) {
+    char *path_utf8 = Str_To_Utf8(path);
+    HANDLE file = CreateFileA(path_utf8, GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    FREEMEM(path_utf8);
+    if (file == INVALID_HANDLE_VALUE) {
+        return MAKE_MESS("Can't open '%o': error %u32", path,
+                         (uint32_t)GetLastError());
+    }
+
+    LARGE_INTEGER large_size;
+    if (!GetFileSizeEx(file, &large_size)) {
+        DWORD error = GetLastError();
+        CloseHandle(file);
+        return MAKE_MESS("Can't get size of '%o': error %u32", path,
+                         (uint32_t)error);
+    }
+    int64_t file_size = (int64_t)large_size.QuadPart;
+    if (len < 0) {
+        len = offset < file_size ? file_size - offset : 0;
+    }
+    if (offset > file_size || len > file_size - offset) {
+        CloseHandle(file);
+        return MAKE_MESS("Range %i64+%i64 outside of '%o' (%i64 bytes)",
+                         offset, len, path, file_size);
+    }
+    if ((uint64_t)len > SIZE_MAX - 0x10000) {
+        CloseHandle(file);
+        return MAKE_MESS("Range of %i64 bytes too large to map", len);
+    }
+    if (len == 0) {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    SYSTEM_INFO sys_info;
+    GetSystemInfo(&sys_info);
+    int64_t granularity = (int64_t)sys_info.dwAllocationGranularity;
+    size_t  delta       = (size_t)(offset % granularity);
+    int64_t map_offset  = offset - (int64_t)delta;
+    size_t  map_len     = (size_t)len + delta;
+
+    HANDLE map = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    DWORD error = GetLastError();
+    CloseHandle(file);
+    if (map == NULL) {
+        return MAKE_MESS("Can't create mapping for '%o': error %u32", path,
+                         (uint32_t)error);
+    }
+    void *base = MapViewOfFile(map, FILE_MAP_READ,
+                               (DWORD)((uint64_t)map_offset >> 32),
+                               (DWORD)((uint64_t)map_offset & 0xFFFFFFFF),
+                               map_len);
+    error = GetLastError();
+    // The view keeps the mapping alive.
+    CloseHandle(map);
+    if (base == NULL) {
+        return MAKE_MESS("Can't map view of '%o': error %u32", path,
+                         (uint32_t)error);
+    }
+
+    mapping->base = base;
+    mapping->len  = map_len;
+    *buf  = (const char*)base + delta;
+    *size = (size_t)len;
+    return NULL;
+}
+
+static void
+S_release_mapping(void *context, const char *buf, size_t size) {
+    BlobMapping *mapping = (BlobMapping*)context;
+    UNUSED_VAR(buf);
+    UNUSED_VAR(size);
+    UnmapViewOfFile(mapping->base);
+    FREEMEM(mapping);
+}
+
+bool
+Blob_Advise_IMP(Blob *self, int32_t advice) {
+    // Windows has no portable equivalent of madvise.
+    UNUSED_VAR(self);
+    if (advice < BLOB_ADVICE_NORMAL || advice > BLOB_ADVICE_DONTNEED) {
+        THROW(ERR, "Invalid advice: %i32", advice);
+    }
+    return false;
+}
+
+#else
+
+static String*
+S_map_file(String *path, int64_t offset, int64_t len, BlobMapping *mapping,
+           const char **buf, size_t *size) {
+    UNUSED_VAR(offset);
+    UNUSED_VAR(len);
+    UNUSED_VAR(mapping);
+    UNUSED_VAR(buf);
+    UNUSED_VAR(size);
+    return MAKE_MESS("Can't map '%o': mmap not supported on this platform",
+                     path);
+}
+
+static void
+S_release_mapping(void *context, const char *buf, size_t size) {
+    UNUSED_VAR(context);
+    UNUSED_VAR(buf);
+    UNUSED_VAR(size);
+}
+
+bool
+Blob_Advise_IMP(Blob *self, int32_t advice) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(advice);
+    return false;
+}
+
+#endif
+
 void
 Blob_Destroy_IMP(Blob *self) {
-    if (self->owns_buf) { FREEMEM((char*)self->buf); }
+    if (self->release) {
+        self->release(self->release_context, self->buf, self->size);
+    }
+    else if (self->owns_buf) {
+        CENSUS_BYTES(self, -(int64_t)self->size);
+        FREEMEM((char*)self->buf);
+    }
     SUPER_DESTROY(self, BLOB);
 }
 
@@ -60,6 +60,7 @@ BB_init(ByteBuf *self, size_t min_cap) {
     self->buf  = (char*)MALLOCATE(capacity);
     self->size = 0;
     self->cap  = capacity;
+    CENSUS_BYTES(self, capacity);
     return self;
 }
 
@@ -79,6 +80,7 @@ BB_init_bytes(ByteBuf *self, const void *bytes, size_t size) {
     self->buf  = (char*)MALLOCATE(capacity);
     self->size = size;
     self->cap  = capacity;
+    CENSUS_BYTES(self, capacity);
     memcpy(self->buf, bytes, size);
     return self;
 }
@@ -95,11 +97,13 @@ BB_init_steal_bytes(ByteBuf *self, void *bytes, size_t size,
     self->buf  = (char*)bytes;
     self->size = size;
     self->cap  = capacity;
+    CENSUS_BYTES(self, capacity);
     return self;
 }
 
 void
 BB_Destroy_IMP(ByteBuf *self) {
+    CENSUS_BYTES(self, -(int64_t)self->cap);
     FREEMEM(self->buf);
     SUPER_DESTROY(self, BYTEBUF);
 }
@@ -178,6 +182,7 @@ BB_Grow_IMP(ByteBuf *self, size_t min_cap) {
         if (capacity < min_cap) { capacity = SIZE_MAX; }
 
         self->buf = (char*)REALLOCATE(self->buf, capacity);
+        CENSUS_BYTES(self, capacity - self->cap);
         self->cap = capacity;
     }
 
@@ -187,6 +192,7 @@ BB_Grow_IMP(ByteBuf *self, size_t min_cap) {
 Blob*
 BB_Yield_Blob_IMP(ByteBuf *self) {
     Blob *blob = Blob_new_steal(self->buf, self->size);
+    CENSUS_BYTES(self, -(int64_t)self->cap);
     self->buf  = NULL;
     self->size = 0;
     self->cap  = 0;
@@ -242,6 +248,7 @@ S_grow_and_oversize(ByteBuf *self, size_t min_size) {
     if (capacity < min_size) { capacity = SIZE_MAX; }
 
     self->buf = (char*)REALLOCATE(self->buf, capacity);
+    CENSUS_BYTES(self, (int64_t)capacity - (int64_t)self->cap);
     self->cap = capacity;
 }
 
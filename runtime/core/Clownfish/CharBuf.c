@@ -74,12 +74,14 @@ CB_init(CharBuf *self, size_t size) {
     // Assign.
     self->size = 0;
     self->cap  = size;
+    CENSUS_BYTES(self, size);
 
     return self;
 }
 
 void
 CB_Destroy_IMP(CharBuf *self) {
+    CENSUS_BYTES(self, -(int64_t)self->cap);
     FREEMEM(self->ptr);
     SUPER_DESTROY(self, CHARBUF);
 }
@@ -87,6 +89,7 @@ CB_Destroy_IMP(CharBuf *self) {
 void
 CB_Grow_IMP(CharBuf *self, size_t size) {
     if (size > self->cap) {
+        CENSUS_BYTES(self, size - self->cap);
         self->cap = size;
         self->ptr = (char*)REALLOCATE(self->ptr, size);
     }
@@ -270,6 +273,7 @@ CB_Yield_String_IMP(CharBuf *self) {
     String *retval = Str_new_steal_trusted_utf8(self->ptr, size);
 
     // Clear CharBuf.
+    CENSUS_BYTES(self, -(int64_t)self->cap);
     self->ptr  = NULL;
     self->size = 0;
     self->cap  = 0;
@@ -368,6 +372,7 @@ S_grow_and_oversize(CharBuf *self, size_t min_size) {
         capacity = SIZE_MAX;
     }
 
+    CENSUS_BYTES(self, (int64_t)capacity - (int64_t)self->cap);
     self->cap = capacity;
     self->ptr = (char*)REALLOCATE(self->ptr, capacity);
 }
@@ -20,6 +20,8 @@
 #define C_CFISH_METHOD
 #define CFISH_USE_SHORT_NAMES
 
+#include "charmony.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -32,9 +34,12 @@
 #include "Clownfish/Hash.h"
 #include "Clownfish/LockFreeRegistry.h"
 #include "Clownfish/Method.h"
+#include "Clownfish/Num.h"
 #include "Clownfish/Vector.h"
 #include "Clownfish/Util/Atomic.h"
 #include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/PerThread.h"
+#include "Clownfish/Util/Trace.h"
 
 #define NovelMethSpec            cfish_NovelMethSpec
 #define OverriddenMethSpec       cfish_OverriddenMethSpec
@@ -49,9 +54,45 @@ S_set_name(Class *self, const char *utf8, size_t size);
 static Method*
 S_find_method(Class *self, const char *meth_name);
 
+static Method**
+S_methods(Class *self);
+
+static Hash*
+S_host_meth_index(Class *self);
+
+static CFISH_INLINE size_t
+SI_cache_tick(const char *name, size_t size);
+
+static void
+S_init_ancestors(Class *klass, Class *parent);
+
 static LockFreeRegistry *Class_registry;
 cfish_Class_bootstrap_hook1_t cfish_Class_bootstrap_hook1;
 
+/* Direct-mapped cache in front of the registry, consulted by
+ * Class_singleton.  Classes are immortal and never unregistered, so a slot
+ * may be overwritten by any thread at any time.  Slots are published with
+ * Atomic_cas_ptr and read with Atomic_load_ptr, so that a thread which finds
+ * a Class in the cache also sees the fully initialized Class.
+ */
+#define CLASS_CACHE_SIZE 256
+static void *volatile Class_cache[CLASS_CACHE_SIZE];
+
+/* Index of the host names of overridable methods, see S_host_meth_index.
+ * Replaced indexes are kept alive, because other threads may still be
+ * reading them.
+ */
+typedef struct HostMethIndex {
+    Hash                 *methods;
+    uint32_t              generation;
+    struct HostMethIndex *stale;
+} HostMethIndex;
+
+/* Bumped whenever a host method alias or exclusion is added, which
+ * invalidates all host method indexes built before.
+ */
+static volatile uint32_t host_meth_generation = 0;
+
 void
 Class_bootstrap(const cfish_ParcelSpec *parcel_spec) {
     const ClassSpec          *specs            = parcel_spec->class_specs;
@@ -60,6 +101,9 @@ Class_bootstrap(const cfish_ParcelSpec *parcel_spec) {
     const InheritedMethSpec  *inherited_specs  = parcel_spec->inherited_specs;
     uint32_t num_classes = parcel_spec->num_classes;
 
+    TRACE_BEGIN("Class", "bootstrap");
+    TRACE_BEGIN("Class", "bootstrap: allocate");
+
     /* Pass 1:
      * - Allocate memory.
      * - Initialize global Class pointers.
@@ -97,6 +141,9 @@ Class_bootstrap(const cfish_ParcelSpec *parcel_spec) {
         }
     }
 
+    TRACE_END("Class", "bootstrap: allocate");
+    TRACE_BEGIN("Class", "bootstrap: initialize");
+
     /* Pass 2:
      * - Initialize IVARS_OFFSET.
      * - Initialize 'klass' ivar and refcount by calling Init_Obj.
@@ -112,19 +159,16 @@ Class_bootstrap(const cfish_ParcelSpec *parcel_spec) {
         Class *klass  = *spec->klass;
         Class *parent = spec->parent ? *spec->parent : NULL;
 
+        // Find the nearest ancestor from another parcel.
+        Class *foreign = parent;
+        while (foreign && foreign->parcel_spec == parcel_spec) {
+            foreign = foreign->parent;
+        }
+
         uint32_t ivars_offset = 0;
         if (spec->ivars_offset_ptr != NULL) {
-            if (parent) {
-                Class *ancestor = parent;
-                while (ancestor && ancestor->parcel_spec == parcel_spec) {
-                    ancestor = ancestor->parent;
-                }
-                ivars_offset = ancestor ? ancestor->obj_alloc_size : 0;
-                *spec->ivars_offset_ptr = ivars_offset;
-            }
-            else {
-                *spec->ivars_offset_ptr = 0;
-            }
+            ivars_offset = foreign ? foreign->obj_alloc_size : 0;
+            *spec->ivars_offset_ptr = ivars_offset;
         }
 
         // CLASS->obj_alloc_size is always 0, so Init_Obj doesn't clear any
@@ -133,6 +177,14 @@ Class_bootstrap(const cfish_ParcelSpec *parcel_spec) {
 
         klass->parent      = parent;
         klass->parcel_spec = parcel_spec;
+        S_init_ancestors(klass, parent);
+
+        // Method objects and the class name are created on demand from the
+        // specs.
+        klass->class_spec       = spec;
+        klass->novel_meth_specs = spec->num_novel_meths
+                                  ? &novel_specs[num_novel]
+                                  : NULL;
 
         // CLASS->obj_alloc_size must stay at 0.
         if (klass != CLASS) {
@@ -146,6 +198,7 @@ Class_bootstrap(const cfish_ParcelSpec *parcel_spec) {
         if (klass == CLASS
             || klass == METHOD
             || klass == BOOLEAN
+            || klass == INTEGER
             || klass == STRING
            ) {
             klass->flags |= CFISH_fREFCOUNTSPECIAL;
@@ -154,12 +207,33 @@ Class_bootstrap(const cfish_ParcelSpec *parcel_spec) {
             klass->flags |= CFISH_fFINAL;
         }
 
+        // CFC emits the vtable entries of all methods declared in this
+        // parcel.  They start after the vtable of the foreign ancestor.
+        uint32_t static_offset = foreign
+                                 ? foreign->class_alloc_size
+                                 : (uint32_t)offsetof(Class, vtable);
+
+        if (spec->vtable && !foreign) {
+            // The vtable layout is known at compile time, so CFC emitted the
+            // complete vtable and initialized all method offsets statically.
+            uint32_t vt_size = klass->class_alloc_size - static_offset;
+            memcpy(klass->vtable, spec->vtable, vt_size);
+            num_inherited  += spec->num_inherited_meths;
+            num_overridden += spec->num_overridden_meths;
+            num_novel      += spec->num_novel_meths;
+            continue;
+        }
+
         if (parent) {
             // Copy parent vtable.
             uint32_t parent_vt_size = parent->class_alloc_size
                                       - (uint32_t)offsetof(Class, vtable);
             memcpy(klass->vtable, parent->vtable, parent_vt_size);
         }
+        if (spec->vtable) {
+            memcpy((char*)klass + static_offset, spec->vtable,
+                   klass->class_alloc_size - static_offset);
+        }
 
         for (size_t i = 0; i < spec->num_inherited_meths; ++i) {
             const InheritedMethSpec *mspec = &inherited_specs[num_inherited++];
@@ -170,7 +244,10 @@ Class_bootstrap(const cfish_ParcelSpec *parcel_spec) {
             const OverriddenMethSpec *mspec
                 = &overridden_specs[num_overridden++];
             *mspec->offset = *mspec->parent_offset;
-            Class_Override_IMP(klass, mspec->func, *mspec->offset);
+            // Only patch overrides of the foreign ancestor's methods.
+            if (!spec->vtable || *mspec->offset < static_offset) {
+                Class_Override_IMP(klass, mspec->func, *mspec->offset);
+            }
         }
 
         uint32_t novel_offset = parent
@@ -181,68 +258,34 @@ Class_bootstrap(const cfish_ParcelSpec *parcel_spec) {
             const NovelMethSpec *mspec = &novel_specs[num_novel++];
             *mspec->offset = novel_offset;
             novel_offset += (uint32_t)sizeof(cfish_method_t);
-            Class_Override_IMP(klass, mspec->func, *mspec->offset);
+            if (!spec->vtable) {
+                Class_Override_IMP(klass, mspec->func, *mspec->offset);
+            }
         }
     }
 
+    TRACE_END("Class", "bootstrap: initialize");
+    TRACE_BEGIN("Class", "bootstrap: register");
+
     /* Now it's safe to call methods.
      *
      * Pass 3:
-     * - Inititalize name and method array.
      * - Register class.
      */
-    num_novel      = 0;
-    num_overridden = 0;
-    num_inherited  = 0;
     for (uint32_t i = 0; i < num_classes; ++i) {
         const ClassSpec *spec = &specs[i];
-        Class *klass = *spec->klass;
-
-        String *name_internal
-            = Str_new_from_trusted_utf8(spec->name, strlen(spec->name));
-        if (!Atomic_cas_ptr((void**)&klass->name_internal, NULL,
-                            name_internal)
-           ) {
-            DECREF(name_internal);
-            name_internal = klass->name_internal;
-        }
-
-        String *name = Str_new_wrap_trusted_utf8(Str_Get_Ptr8(name_internal),
-                                                 Str_Get_Size(name_internal));
-        if (!Atomic_cas_ptr((void**)&klass->name, NULL, name)) {
-            DECREF(name);
-            name = klass->name;
-        }
-
-        Method **methods = (Method**)MALLOCATE((spec->num_novel_meths + 1)
-                                               * sizeof(Method*));
-
-        // Only store novel methods for now.
-        for (size_t i = 0; i < spec->num_novel_meths; ++i) {
-            const NovelMethSpec *mspec = &novel_specs[num_novel++];
-            String *name = SSTR_WRAP_C(mspec->name);
-            Method *method = Method_new(name, mspec->callback_func,
-                                        *mspec->offset);
-            methods[i] = method;
-        }
-
-        methods[spec->num_novel_meths] = NULL;
-
-        if (!Atomic_cas_ptr((void**)&klass->methods, NULL, methods)) {
-            // Another thread beat us to it.
-            for (size_t i = 0; i < spec->num_novel_meths; ++i) {
-                Method_Destroy(methods[i]);
-            }
-            FREEMEM(methods);
-        }
-
-        Class_add_to_registry(klass);
+        Class_add_alias_to_registry(*spec->klass, spec->name,
+                                    strlen(spec->name));
     }
+
+    TRACE_END("Class", "bootstrap: register");
+    TRACE_END("Class", "bootstrap");
 }
 
 void
 Class_Destroy_IMP(Class *self) {
-    THROW(ERR, "Insane attempt to destroy Class for class '%o'", self->name);
+    THROW(ERR, "Insane attempt to destroy Class for class '%o'",
+          Class_Get_Name(self));
 }
 
 void
@@ -254,7 +297,29 @@ Class_Override_IMP(Class *self, cfish_method_t method, uint32_t offset) {
 
 String*
 Class_Get_Name_IMP(Class *self) {
-    return self->name;
+    String *name = self->name;
+    if (name) { return name; }
+
+    // Class names live as long as the process.
+    Class_census_suspend();
+
+    const char *utf8 = self->class_spec->name;
+    String *name_internal = Str_new_from_trusted_utf8(utf8, strlen(utf8));
+    if (!Atomic_cas_ptr((void**)&self->name_internal, NULL, name_internal)) {
+        // Another thread beat us to it.
+        DECREF(name_internal);
+        name_internal = self->name_internal;
+    }
+
+    name = Str_new_wrap_trusted_utf8(Str_Get_Ptr8(name_internal),
+                                     Str_Get_Size(name_internal));
+    if (!Atomic_cas_ptr((void**)&self->name, NULL, name)) {
+        DECREF(name);
+        name = self->name;
+    }
+
+    Class_census_resume();
+    return name;
 }
 
 Class*
@@ -269,10 +334,11 @@ Class_Get_Obj_Alloc_Size_IMP(Class *self) {
 
 Vector*
 Class_Get_Methods_IMP(Class *self) {
+    Method **methods = S_methods(self);
     Vector *retval = Vec_new(0);
 
-    for (size_t i = 0; self->methods[i]; ++i) {
-        Vec_Push(retval, INCREF(self->methods[i]));
+    for (size_t i = 0; methods[i]; ++i) {
+        Vec_Push(retval, INCREF(methods[i]));
     }
 
     return retval;
@@ -280,12 +346,32 @@ Class_Get_Methods_IMP(Class *self) {
 
 void
 Class_init_registry() {
+    Class_census_suspend();
     LockFreeRegistry *reg = LFReg_new(256);
-    if (Atomic_cas_ptr((void*volatile*)&Class_registry, NULL, reg)) {
+    if (!Atomic_cas_ptr((void*volatile*)&Class_registry, NULL, reg)) {
+        DECREF(reg);
+    }
+    Class_census_resume();
+}
+
+/* Set up the depth and the display of ancestors used for subtype checks.
+ * An object is an instance of `target` if its class has `target` in its
+ * display at index `target->depth`.  Only the first CLASS_DISPLAY_SIZE
+ * levels are stored, deeper ancestors are found by walking up the parents.
+ */
+static void
+S_init_ancestors(Class *klass, Class *parent) {
+    if (klass->display[0] != NULL) {
+        // Class was already bootstrapped by another run.
         return;
     }
-    else {
-        DECREF(reg);
+
+    uint32_t depth = parent ? parent->depth + 1 : 0;
+    klass->depth = depth;
+    for (uint32_t i = 0; i < CLASS_DISPLAY_SIZE; i++) {
+        klass->display[i] = i <  depth ? parent->display[i]
+                          : i == depth ? klass
+                          : NULL;
     }
 }
 
@@ -306,6 +392,7 @@ S_simple_subclass(Class *parent, String *name) {
     subclass->methods          = (Method**)CALLOCATE(1, sizeof(Method*));
 
     S_set_name(subclass, Str_Get_Ptr8(name), Str_Get_Size(name));
+    S_init_ancestors(subclass, parent);
 
     memcpy(subclass->vtable, parent->vtable,
            parent->class_alloc_size - offsetof(Class, vtable));
@@ -315,11 +402,23 @@ S_simple_subclass(Class *parent, String *name) {
 
 Class*
 Class_singleton(String *class_name, Class *parent) {
+    const char *name_ptr  = Str_Get_Ptr8(class_name);
+    size_t      name_size = Str_Get_Size(class_name);
+    size_t      tick      = SI_cache_tick(name_ptr, name_size);
+
+    void  *cached    = Atomic_load_ptr(&Class_cache[tick]);
+    Class *singleton = (Class*)cached;
+    if (singleton != NULL
+        && Str_Equals_Utf8(Class_Get_Name(singleton), name_ptr, name_size)
+       ) {
+        return singleton;
+    }
+
     if (Class_registry == NULL) {
         Class_init_registry();
     }
 
-    Class *singleton = (Class*)LFReg_fetch(Class_registry, class_name);
+    singleton = (Class*)LFReg_fetch(Class_registry, class_name);
     if (singleton == NULL) {
         Vector *fresh_host_methods;
         size_t num_fresh;
@@ -328,7 +427,7 @@ Class_singleton(String *class_name, Class *parent) {
             String *parent_class = Class_find_parent_class(class_name);
             if (parent_class == NULL) {
                 THROW(ERR, "Class '%o' doesn't descend from %o", class_name,
-                      OBJ->name);
+                      Class_Get_Name(OBJ));
             }
             else {
                 parent = Class_singleton(parent_class, NULL);
@@ -342,25 +441,15 @@ Class_singleton(String *class_name, Class *parent) {
         fresh_host_methods = Class_fresh_host_methods(class_name);
         num_fresh = Vec_Get_Size(fresh_host_methods);
         if (num_fresh) {
-            Hash *meths = Hash_new(num_fresh);
+            Hash *index = S_host_meth_index(parent);
             for (size_t i = 0; i < num_fresh; i++) {
                 String *meth = (String*)Vec_Fetch(fresh_host_methods, i);
-                Hash_Store(meths, meth, (Obj*)CFISH_TRUE);
-            }
-            for (Class *klass = parent; klass; klass = klass->parent) {
-                for (size_t i = 0; klass->methods[i]; i++) {
-                    Method *method = klass->methods[i];
-                    if (method->callback_func) {
-                        String *name = Method_Host_Name(method);
-                        if (Hash_Fetch(meths, name)) {
-                            Class_Override(singleton, method->callback_func,
-                                            method->offset);
-                        }
-                        DECREF(name);
-                    }
+                Method *method = (Method*)Hash_Fetch(index, meth);
+                if (method) {
+                    Class_Override(singleton, method->callback_func,
+                                   method->offset);
                 }
             }
-            DECREF(meths);
         }
         DECREF(fresh_host_methods);
 
@@ -379,6 +468,8 @@ Class_singleton(String *class_name, Class *parent) {
         }
     }
 
+    // If another thread changed the slot in the meantime, keep its entry.
+    Atomic_cas_ptr(&Class_cache[tick], cached, singleton);
     return singleton;
 }
 
@@ -387,12 +478,16 @@ Class_add_to_registry(Class *klass) {
     if (Class_registry == NULL) {
         Class_init_registry();
     }
-    if (LFReg_fetch(Class_registry, klass->name)) {
+    String *name = Class_Get_Name(klass);
+    if (LFReg_fetch(Class_registry, name)) {
         return false;
     }
-    else {
-        return LFReg_register(Class_registry, klass->name, (Obj*)klass);
-    }
+
+    // Registry entries live as long as the process.
+    Class_census_suspend();
+    bool registered = LFReg_register(Class_registry, name, (Obj*)klass);
+    Class_census_resume();
+    return registered;
 }
 
 bool
@@ -405,9 +500,12 @@ Class_add_alias_to_registry(Class *klass, const char *alias_ptr,
     if (LFReg_fetch(Class_registry, alias)) {
         return false;
     }
-    else {
-        return LFReg_register(Class_registry, alias, (Obj*)klass);
-    }
+
+    // Registry entries live as long as the process.
+    Class_census_suspend();
+    bool registered = LFReg_register(Class_registry, alias, (Obj*)klass);
+    Class_census_resume();
+    return registered;
 }
 
 Class*
@@ -428,7 +526,10 @@ Class_Add_Host_Method_Alias_IMP(Class *self, const char *alias,
         abort();
     }
     String *string = SSTR_WRAP_C(alias);
+    Class_census_suspend();
     Method_Set_Host_Alias(method, string);
+    Class_census_resume();
+    host_meth_generation++;
 }
 
 void
@@ -439,6 +540,7 @@ Class_Exclude_Host_Method_IMP(Class *self, const char *meth_name) {
         abort();
     }
     method->is_excluded = true;
+    host_meth_generation++;
 }
 
 static void
@@ -448,17 +550,20 @@ S_set_name(Class *self, const char *utf8, size_t size) {
      * threadsafe: the sole reference is owned by an immortal object and any
      * INCREF spawns a copy.
      */
+    Class_census_suspend();
     self->name_internal = Str_new_from_trusted_utf8(utf8, size);
     self->name = Str_new_wrap_trusted_utf8(Str_Get_Ptr8(self->name_internal),
                                            Str_Get_Size(self->name_internal));
+    Class_census_resume();
 }
 
 static Method*
 S_find_method(Class *self, const char *name) {
-    size_t name_len = strlen(name);
+    Method **methods  = S_methods(self);
+    size_t   name_len = strlen(name);
 
-    for (size_t i = 0; self->methods[i]; i++) {
-        Method *method = self->methods[i];
+    for (size_t i = 0; methods[i]; i++) {
+        Method *method = methods[i];
         if (Str_Equals_Utf8(method->name, name, name_len)) {
             return method;
         }
@@ -467,3 +572,390 @@ S_find_method(Class *self, const char *name) {
     return NULL;
 }
 
+
+/* Return the NULL-terminated array of novel methods, creating the Method
+ * objects from the class's NovelMethSpecs on first use.
+ */
+static Method**
+S_methods(Class *self) {
+    Method **methods = self->methods;
+    if (methods) { return methods; }
+
+    // Method objects live as long as their class.
+    Class_census_suspend();
+
+    const NovelMethSpec *novel_specs = self->novel_meth_specs;
+    uint32_t num_novel = self->class_spec->num_novel_meths;
+    methods = (Method**)MALLOCATE((num_novel + 1) * sizeof(Method*));
+
+    for (uint32_t i = 0; i < num_novel; ++i) {
+        const NovelMethSpec *mspec = &novel_specs[i];
+        String *name = SSTR_WRAP_C(mspec->name);
+        methods[i] = Method_new(name, mspec->callback_func, *mspec->offset);
+    }
+    methods[num_novel] = NULL;
+
+    if (!Atomic_cas_ptr((void**)&self->methods, NULL, methods)) {
+        // Another thread beat us to it.
+        for (uint32_t i = 0; i < num_novel; ++i) {
+            Method_Destroy(methods[i]);
+        }
+        FREEMEM(methods);
+        methods = self->methods;
+    }
+
+    Class_census_resume();
+    return methods;
+}
+
+/* Return a Hash mapping the host name of every overridable method of the
+ * class and its ancestors to the Method object.  The index is built on first
+ * use and rebuilt after host method aliases or exclusions were added.
+ */
+static Hash*
+S_host_meth_index(Class *self) {
+    uint32_t       generation = host_meth_generation;
+    HostMethIndex *index
+        = (HostMethIndex*)Atomic_load_ptr(&self->host_meth_index);
+    if (index && index->generation == generation) {
+        return index->methods;
+    }
+
+    // Indexes are never freed, since another thread may still use a stale
+    // one.
+    Class_census_suspend();
+    Hash *methods = Hash_new(0);
+    for (Class *klass = self; klass; klass = klass->parent) {
+        Method **novel = S_methods(klass);
+        for (size_t i = 0; novel[i]; i++) {
+            Method *method = novel[i];
+            if (method->callback_func) {
+                // Ancestors are visited last, so their methods win in the
+                // unlikely case of a host name collision.
+                String *name = Method_Host_Name(method);
+                Hash_Store(methods, name, INCREF(method));
+                DECREF(name);
+            }
+        }
+    }
+
+    HostMethIndex *fresh = (HostMethIndex*)MALLOCATE(sizeof(HostMethIndex));
+    fresh->methods    = methods;
+    fresh->generation = generation;
+    fresh->stale      = index;
+    if (!Atomic_cas_ptr(&self->host_meth_index, index, fresh)) {
+        // Another thread beat us to it.  Its index may be stale, too, but
+        // it's good enough for this lookup.
+        DECREF(methods);
+        FREEMEM(fresh);
+        index = (HostMethIndex*)Atomic_load_ptr(&self->host_meth_index);
+        methods = index->methods;
+    }
+
+    Class_census_resume();
+    return methods;
+}
+
+// FNV-1a over the raw UTF-8 bytes of the class name.
+static CFISH_INLINE size_t
+SI_cache_tick(const char *name, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619u;
+    }
+    return (hash ^ (hash >> 16)) & (CLASS_CACHE_SIZE - 1);
+}
+
+/******************************** Census ********************************/
+
+// Number of slots in a per-thread table.  Must be a power of two.
+#define CENSUS_SLOTS 64
+
+// Number of events after which a thread merges its counts.
+#define CENSUS_MERGE_EVENTS 4096
+
+// Merged counts of a class, hung off Class->census.
+typedef struct CensusCounts {
+    Class               *klass;
+    int64_t              num_allocated;
+    int64_t              num_freed;
+    int64_t              live_bytes;
+    struct CensusCounts *next;
+} CensusCounts;
+
+typedef struct {
+    Class   *klass;
+    int64_t  num_allocated;
+    int64_t  num_freed;
+    int64_t  bytes;
+} CensusDelta;
+
+// Unmerged counts of a thread.
+typedef struct {
+    CensusDelta deltas[CENSUS_SLOTS];
+    uint32_t    num_events;
+    uint32_t    suspended;
+} CensusBlock;
+
+static void
+S_census_retire(void *dest, void *src);
+
+bool Class_census_enabled = false;
+
+// The lock of the per-thread blocks also guards the merged counts.
+static PerThread     census_threads
+    = PERTHREAD_INIT(sizeof(CensusBlock), S_census_retire);
+static CensusCounts *census_counts = NULL;
+static bool          census_report = false;
+
+// Return the merged counts of a class.  Must be called with the lock held.
+static CensusCounts*
+S_census_counts(Class *klass) {
+    CensusCounts *counts = (CensusCounts*)klass->census;
+    if (counts == NULL) {
+        counts = (CensusCounts*)CALLOCATE(1, sizeof(CensusCounts));
+        counts->klass  = klass;
+        counts->next   = census_counts;
+        census_counts  = counts;
+        klass->census  = counts;
+    }
+    return counts;
+}
+
+// Merge the counts of a thread.  Must be called with the lock held.
+static void
+S_census_merge(CensusBlock *block) {
+    for (size_t i = 0; i < CENSUS_SLOTS; i++) {
+        CensusDelta *delta = &block->deltas[i];
+        if (delta->klass) {
+            CensusCounts *counts = S_census_counts(delta->klass);
+            counts->num_allocated += delta->num_allocated;
+            counts->num_freed     += delta->num_freed;
+            counts->live_bytes    += delta->bytes;
+            memset(delta, 0, sizeof(CensusDelta));
+        }
+    }
+    block->num_events = 0;
+}
+
+// Called when a thread exits.  Its counts go straight to the merged counts,
+// so the block of retired threads stays empty.
+static void
+S_census_retire(void *dest, void *src) {
+    UNUSED_VAR(dest);
+    S_census_merge((CensusBlock*)src);
+}
+
+void
+Class_census_record(Class *klass, int32_t num_objects, int64_t bytes) {
+    CensusBlock *block = (CensusBlock*)PerThread_get_block(&census_threads);
+    if (block->suspended) { return; }
+
+    size_t       mask  = CENSUS_SLOTS - 1;
+    size_t       tick  = ((size_t)klass >> 4) & mask;
+    CensusDelta *delta = NULL;
+
+    // Linear probing over a few slots.  Merge if they're all taken.
+    for (size_t i = 0; i < 4; i++) {
+        CensusDelta *candidate = &block->deltas[(tick + i) & mask];
+        if (candidate->klass == klass || candidate->klass == NULL) {
+            delta = candidate;
+            break;
+        }
+    }
+    if (delta == NULL) {
+        PerThread_lock(&census_threads);
+        S_census_merge(block);
+        PerThread_unlock(&census_threads);
+        delta = &block->deltas[tick];
+    }
+
+    if (num_objects > 0)      { delta->num_allocated += num_objects; }
+    else if (num_objects < 0) { delta->num_freed     -= num_objects; }
+    delta->bytes += bytes;
+    delta->klass  = klass;
+
+    if (++block->num_events >= CENSUS_MERGE_EVENTS) {
+        PerThread_lock(&census_threads);
+        S_census_merge(block);
+        PerThread_unlock(&census_threads);
+    }
+}
+
+typedef struct {
+    Class      *klass;
+    ClassStats *stats;
+} CensusQuery;
+
+static void
+S_census_add_deltas(void *context, void *block) {
+    CensusQuery *query  = (CensusQuery*)context;
+    ClassStats  *stats  = query->stats;
+    CensusDelta *deltas = ((CensusBlock*)block)->deltas;
+    for (size_t i = 0; i < CENSUS_SLOTS; i++) {
+        if (deltas[i].klass == query->klass) {
+            stats->num_allocated += deltas[i].num_allocated;
+            stats->num_freed     += deltas[i].num_freed;
+            stats->live_bytes    += deltas[i].bytes;
+        }
+    }
+}
+
+static void
+S_census_add_classes(void *context, void *block) {
+    UNUSED_VAR(context);
+    CensusDelta *deltas = ((CensusBlock*)block)->deltas;
+    for (size_t i = 0; i < CENSUS_SLOTS; i++) {
+        if (deltas[i].klass) {
+            S_census_counts(deltas[i].klass);
+        }
+    }
+}
+
+// Add the merged and unmerged counts of a class.  Must be called with the
+// lock held.
+static void
+S_census_stats(Class *klass, ClassStats *stats) {
+    memset(stats, 0, sizeof(ClassStats));
+
+    CensusCounts *counts = (CensusCounts*)klass->census;
+    if (counts) {
+        stats->num_allocated = counts->num_allocated;
+        stats->num_freed     = counts->num_freed;
+        stats->live_bytes    = counts->live_bytes;
+    }
+
+    // Counts of other threads are read without synchronization, so they
+    // may be slightly out of date.
+    CensusQuery query;
+    query.klass = klass;
+    query.stats = stats;
+    PerThread_each(&census_threads, S_census_add_deltas, &query);
+
+    // Objects created before the census was enabled weren't counted, but
+    // their destruction is, so clamp the difference.
+    stats->num_live = stats->num_allocated - stats->num_freed;
+    if (stats->num_live < 0)   { stats->num_live   = 0; }
+    if (stats->live_bytes < 0) { stats->live_bytes = 0; }
+}
+
+// Return an array with the statistics of all classes seen by the census,
+// terminated by an entry with a NULL class.
+static ClassStats*
+S_census_collect(Class ***classes_ptr) {
+    PerThread_lock(&census_threads);
+
+    // Make sure that every class with unmerged counts has an entry.
+    PerThread_each(&census_threads, S_census_add_classes, NULL);
+
+    size_t num_classes = 0;
+    for (CensusCounts *counts = census_counts; counts; counts = counts->next) {
+        num_classes++;
+    }
+
+    ClassStats *stats = (ClassStats*)MALLOCATE(
+                            (num_classes + 1) * sizeof(ClassStats));
+    Class **classes = (Class**)MALLOCATE((num_classes + 1) * sizeof(Class*));
+    size_t i = 0;
+    for (CensusCounts *counts = census_counts; counts; counts = counts->next) {
+        classes[i] = counts->klass;
+        S_census_stats(counts->klass, &stats[i]);
+        i++;
+    }
+    classes[i] = NULL;
+
+    PerThread_unlock(&census_threads);
+
+    *classes_ptr = classes;
+    return stats;
+}
+
+static void
+S_report_leaks_at_exit(void) {
+    Class_report_leaks();
+}
+
+void
+Class_enable_census(bool report_leaks) {
+    if (report_leaks && !census_report) {
+        census_report = true;
+        atexit(S_report_leaks_at_exit);
+    }
+    Class_census_enabled = true;
+}
+
+void
+Class_census_suspend() {
+    if (Class_census_enabled) {
+        CensusBlock *block
+            = (CensusBlock*)PerThread_get_block(&census_threads);
+        block->suspended++;
+    }
+}
+
+void
+Class_census_resume() {
+    if (Class_census_enabled) {
+        CensusBlock *block
+            = (CensusBlock*)PerThread_get_block(&census_threads);
+        if (block->suspended > 0) { block->suspended--; }
+    }
+}
+
+void
+Class_get_stats(Class *klass, ClassStats *stats) {
+    PerThread_lock(&census_threads);
+    S_census_stats(klass, stats);
+    PerThread_unlock(&census_threads);
+}
+
+Hash*
+Class_census_dump() {
+    Class      **classes;
+    ClassStats  *stats = S_census_collect(&classes);
+
+    // Objects are created after the lock has been released, since they are
+    // counted themselves.
+    Hash *dump = Hash_new(0);
+    for (size_t i = 0; classes[i]; i++) {
+        Hash *entry = Hash_new(4);
+        Hash_Store_Utf8(entry, "allocated", 9,
+                        (Obj*)Int_new(stats[i].num_allocated));
+        Hash_Store_Utf8(entry, "freed", 5, (Obj*)Int_new(stats[i].num_freed));
+        Hash_Store_Utf8(entry, "live", 4, (Obj*)Int_new(stats[i].num_live));
+        Hash_Store_Utf8(entry, "live_bytes", 10,
+                        (Obj*)Int_new(stats[i].live_bytes));
+        Hash_Store(dump, Class_Get_Name(classes[i]), (Obj*)entry);
+    }
+
+    FREEMEM(classes);
+    FREEMEM(stats);
+    return dump;
+}
+
+int64_t
+Class_report_leaks() {
+    Class      **classes;
+    ClassStats  *stats = S_census_collect(&classes);
+    int64_t      total = 0;
+
+    for (size_t i = 0; classes[i]; i++) {
+        if (stats[i].num_live <= 0) {
+            continue;
+        }
+        if (total == 0) {
+            fprintf(stderr, "Live objects:\n");
+        }
+        total += stats[i].num_live;
+
+        char *name = Str_To_Utf8(Class_Get_Name(classes[i]));
+        fprintf(stderr, "  %-40s %10" PRId64 " objects %12" PRId64 " bytes\n",
+                name, stats[i].num_live, stats[i].live_bytes);
+        FREEMEM(name);
+    }
+
+    FREEMEM(classes);
+    FREEMEM(stats);
+    return total;
+}
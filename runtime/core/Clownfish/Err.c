@@ -29,6 +29,7 @@
 #include "Clownfish/CharBuf.h"
 #include "Clownfish/String.h"
 #include "Clownfish/Class.h"
+#include "Clownfish/Util/Atomic.h"
 #include "Clownfish/Util/Memory.h"
 
 Err*
@@ -39,26 +40,74 @@ Err_new(String *mess) {
 
 Err*
 Err_init(Err *self, String *mess) {
-    self->mess = mess;
+    self->mess       = mess;
+    self->full_mess  = NULL;
+    self->frames     = self->inline_frames;
+    self->num_frames = 0;
+    self->frames_cap = sizeof(self->inline_frames)
+                       / sizeof(self->inline_frames[0]);
     return self;
 }
 
 void
 Err_Destroy_IMP(Err *self) {
     DECREF(self->mess);
+    DECREF(self->full_mess);
+    if (self->frames != self->inline_frames) {
+        FREEMEM(self->frames);
+    }
     SUPER_DESTROY(self, ERR);
 }
 
+// Return the message with all stack frames appended, formatting it on
+// first use.
+static String*
+S_full_mess(Err *self) {
+    if (self->num_frames == 0) { return self->mess; }
+    if (self->full_mess)       { return self->full_mess; }
+
+    CharBuf *buf = CB_new(Str_Get_Size(self->mess) + 1
+                          + self->num_frames * 64);
+    CB_Cat(buf, self->mess);
+    if (!Str_Ends_With_Utf8(self->mess, "\n", 1)) {
+        CB_Cat_Char(buf, '\n');
+    }
+    for (uint32_t i = 0; i < self->num_frames; i++) {
+        Err_Frame_t *frame = &self->frames[i];
+        if (frame->func != NULL) {
+            CB_catf(buf, "\t%s at %s line %i32\n", frame->func, frame->file,
+                    (int32_t)frame->line);
+        }
+        else {
+            CB_catf(buf, "\tat %s line %i32\n", frame->file,
+                    (int32_t)frame->line);
+        }
+    }
+    String *full_mess = CB_Yield_String(buf);
+    DECREF(buf);
+
+    if (!Atomic_cas_ptr((void**)&self->full_mess, NULL, full_mess)) {
+        // Another thread beat us to it.
+        DECREF(full_mess);
+    }
+    return self->full_mess;
+}
+
 String*
 Err_To_String_IMP(Err *self) {
-    return (String*)INCREF(self->mess);
+    return (String*)INCREF(S_full_mess(self));
 }
 
 void
 Err_Cat_Mess_IMP(Err *self, String *mess) {
-    String *new_mess = Str_Cat(self->mess, mess);
+    // Fold the frames into the message so that `mess` is appended after
+    // them.
+    String *new_mess = Str_Cat(S_full_mess(self), mess);
     DECREF(self->mess);
-    self->mess = new_mess;
+    DECREF(self->full_mess);
+    self->mess       = new_mess;
+    self->full_mess  = NULL;
+    self->num_frames = 0;
 }
 
 // Fallbacks in case variadic macros aren't available.
@@ -148,28 +197,32 @@ Err_warn_at(const char *file, int line, const char *func,
 
 String*
 Err_Get_Mess_IMP(Err *self) {
-    return self->mess;
+    return S_full_mess(self);
 }
 
 void
 Err_Add_Frame_IMP(Err *self, const char *file, int line, const char *func) {
-    CharBuf *buf = CB_new(0);
-    CB_Cat(buf, self->mess);
-
-    if (!Str_Ends_With_Utf8(self->mess, "\n", 1)) {
-        CB_Cat_Char(buf, '\n');
+    if (self->num_frames == self->frames_cap) {
+        uint32_t cap = self->frames_cap ? self->frames_cap * 2 : 4;
+        Err_Frame_t *frames
+            = (Err_Frame_t*)MALLOCATE(cap * sizeof(Err_Frame_t));
+        memcpy(frames, self->frames, self->num_frames * sizeof(Err_Frame_t));
+        if (self->frames != self->inline_frames) {
+            FREEMEM(self->frames);
+        }
+        self->frames     = frames;
+        self->frames_cap = cap;
     }
 
-    if (func != NULL) {
-        CB_catf(buf, "\t%s at %s line %i32\n", func, file, (int32_t)line);
-    }
-    else {
-        CB_catf(buf, "\tat %s line %i32\n", file, (int32_t)line);
-    }
+    Err_Frame_t *frame = &self->frames[self->num_frames++];
+    frame->file = file;
+    frame->func = func;
+    frame->line = line;
 
-    DECREF(self->mess);
-    self->mess = CB_Yield_String(buf);
-    DECREF(buf);
+    if (self->full_mess) {
+        DECREF(self->full_mess);
+        self->full_mess = NULL;
+    }
 }
 
 void
@@ -183,28 +236,28 @@ Err_throw_at(Class *klass, const char *file, int line,
              const char *func, const char *pattern, ...) {
     va_list args;
 
+    // Only format the message.  The stack frame is formatted on demand.
+    CharBuf *buf = CB_new(strlen(pattern) + 30);
     va_start(args, pattern);
-    String *message = S_vmake_mess(file, line, func, pattern, args);
+    CB_VCatF(buf, pattern, args);
     va_end(args);
+    String *message = CB_Yield_String(buf);
+    DECREF(buf);
 
     Err *err = (Err*)Class_Make_Obj(klass);
     err = Err_init(err, message);
+    Err_Add_Frame_IMP(err, file, line, func);
     Err_do_throw(err);
 }
 
 // Inlined, slightly optimized version of Obj_is_a.
 static CFISH_INLINE bool
 SI_obj_is_a(Obj *obj, Class *target_class) {
-    Class *klass = obj->klass;
-
-    while (klass != NULL) {
-        if (klass == target_class) {
-            return true;
-        }
-        klass = klass->parent;
+    uint32_t depth = target_class->depth;
+    if (depth < CLASS_DISPLAY_SIZE) {
+        return obj->klass->display[depth] == target_class;
     }
-
-    return false;
+    return Obj_is_a(obj, target_class);
 }
 
 Obj*
@@ -28,6 +28,7 @@
 #include "Clownfish/Vector.h"
 #include "Clownfish/Util/Atomic.h"
 #include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/Trace.h"
 
 // TOMBSTONE is shared across threads, so it must never be incref'd or
 // decref'd.
@@ -41,6 +42,20 @@ typedef struct HashEntry {
     size_t  hash_sum;
 } HashEntry;
 
+// Fetch_Many resolves keys in groups of this size.  A group should be
+// large enough to cover the memory latency, but its buckets should still
+// fit into L1.
+#define FETCH_GROUP_SIZE 16
+
+#if defined(__GNUC__) || defined(__clang__)
+  #define PREFETCH(addr) __builtin_prefetch((addr), 0, 3)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #include <xmmintrin.h>
+  #define PREFETCH(addr) _mm_prefetch((const char*)(addr), _MM_HINT_T0)
+#else
+  #define PREFETCH(addr)
+#endif
+
 // Return the entry associated with the key, if any.
 static CFISH_INLINE HashEntry*
 SI_fetch_entry(Hash *self, String *key, size_t hash_sum);
@@ -49,6 +64,22 @@ SI_fetch_entry(Hash *self, String *key, size_t hash_sum);
 static CFISH_INLINE HashEntry*
 SI_rebuild_hash(Hash *self);
 
+// With CFISH_HASH_STATS, the statistics of a Hash are stored after its
+// entries, so they don't take up space in the object.
+#ifdef CFISH_HASH_STATS
+  #define STATS_SIZE sizeof(HashStats)
+  #define SI_STATS(self) \
+    ((HashStats*)((HashEntry*)(self)->entries + (self)->capacity))
+#else
+  #define STATS_SIZE 0
+#endif
+
+static CFISH_INLINE HashEntry*
+SI_alloc_entries(size_t capacity) {
+    return (HashEntry*)CALLOCATE(capacity * sizeof(HashEntry) + STATS_SIZE,
+                                 1);
+}
+
 void
 Hash_init_class() {
     String *tombstone = Str_newf("[HASHTOMBSTONE]");
@@ -80,8 +111,9 @@ Hash_init(Hash *self, size_t min_threshold) {
 
     // Derive.
     self->capacity  = capacity;
-    self->entries   = (HashEntry*)CALLOCATE(capacity, sizeof(HashEntry));
+    self->entries   = SI_alloc_entries(capacity);
     self->threshold = threshold;
+    CENSUS_BYTES(self, capacity * sizeof(HashEntry));
 
     return self;
 }
@@ -90,6 +122,7 @@ void
 Hash_Destroy_IMP(Hash *self) {
     if (self->entries) {
         Hash_Clear(self);
+        CENSUS_BYTES(self, -(int64_t)(self->capacity * sizeof(HashEntry)));
         FREEMEM(self->entries);
     }
     SUPER_DESTROY(self, HASH);
@@ -135,10 +168,16 @@ S_do_store(Hash *self, String *key, Obj *value, size_t hash_sum,
     size_t       tick = hash_sum;
     const size_t mask = self->capacity - 1;
 
+#ifdef CFISH_HASH_STATS
+    size_t num_probes = 1;
+#endif
+
     while (1) {
         tick &= mask;
         HashEntry *entry = entries + tick;
         if (entry->key == TOMBSTONE || !entry->key) {
+            HASHSTATS_PROBES(SI_STATS(self), HASHSTATS_HASH, HASHSTATS_INSERT,
+                             num_probes);
             if (entry->key == TOMBSTONE) {
                 // Take note of diminished tombstone clutter.
                 self->threshold++;
@@ -152,6 +191,9 @@ S_do_store(Hash *self, String *key, Obj *value, size_t hash_sum,
             break;
         }
         tick++; // linear scan
+#ifdef CFISH_HASH_STATS
+        num_probes++;
+#endif
     }
 }
 
@@ -177,21 +219,31 @@ SI_fetch_entry(Hash *self, String *key, size_t hash_sum) {
     size_t tick = hash_sum;
     HashEntry *const entries = (HashEntry*)self->entries;
     HashEntry *entry;
+#ifdef CFISH_HASH_STATS
+    size_t num_probes = 1;
+#endif
 
     while (1) {
         tick &= self->capacity - 1;
         entry = entries + tick;
         if (!entry->key) {
             // Failed to find the key, so return NULL.
+            HASHSTATS_PROBES(SI_STATS(self), HASHSTATS_HASH, HASHSTATS_MISS,
+                             num_probes);
             return NULL;
         }
         else if (entry->hash_sum == hash_sum
                  && entry->key != TOMBSTONE
                  && Str_Equals(key, (Obj*)entry->key)
                 ) {
+            HASHSTATS_PROBES(SI_STATS(self), HASHSTATS_HASH, HASHSTATS_HIT,
+                             num_probes);
             return entry;
         }
         tick++;
+#ifdef CFISH_HASH_STATS
+        num_probes++;
+#endif
     }
 }
 
@@ -201,6 +253,68 @@ Hash_Fetch_IMP(Hash *self, String *key) {
     return entry ? entry->value : NULL;
 }
 
+// Resolve a group of keys whose buckets have been prefetched.
+static void
+S_fetch_group(Hash *self, String **keys, size_t *hash_sums, size_t num_keys,
+              Obj **values) {
+    HashEntry *const entries = (HashEntry*)self->entries;
+    const size_t     mask    = self->capacity - 1;
+
+    // If the first bucket looks like a hit, the key will have to be
+    // compared, so load the stored key, too.
+    for (size_t i = 0; i < num_keys; i++) {
+        HashEntry *entry = entries + (hash_sums[i] & mask);
+        if (entry->hash_sum == hash_sums[i] && entry->key != keys[i]) {
+            PREFETCH(entry->key);
+        }
+    }
+
+    for (size_t i = 0; i < num_keys; i++) {
+        HashEntry *entry = SI_fetch_entry(self, keys[i], hash_sums[i]);
+        values[i] = entry ? entry->value : NULL;
+    }
+}
+
+void
+Hash_Fetch_Many_IMP(Hash *self, String **keys, size_t num_keys,
+                    Obj **values) {
+    HashEntry *const entries = (HashEntry*)self->entries;
+    const size_t     mask    = self->capacity - 1;
+    size_t           hash_sums[FETCH_GROUP_SIZE];
+
+    for (size_t start = 0; start < num_keys; start += FETCH_GROUP_SIZE) {
+        size_t group_size = num_keys - start < FETCH_GROUP_SIZE
+                            ? num_keys - start
+                            : FETCH_GROUP_SIZE;
+        // Prefetch every bucket right after hashing its key, so that the
+        // hashing of the remaining keys overlaps the cache misses.
+        for (size_t i = 0; i < group_size; i++) {
+            hash_sums[i] = Str_Hash_Sum(keys[start + i]);
+            PREFETCH(entries + (hash_sums[i] & mask));
+        }
+        S_fetch_group(self, keys + start, hash_sums, group_size,
+                      values + start);
+    }
+}
+
+void
+Hash_Fetch_Many_Hashed_IMP(Hash *self, String **keys, size_t *hash_sums,
+                           size_t num_keys, Obj **values) {
+    HashEntry *const entries = (HashEntry*)self->entries;
+    const size_t     mask    = self->capacity - 1;
+
+    for (size_t start = 0; start < num_keys; start += FETCH_GROUP_SIZE) {
+        size_t group_size = num_keys - start < FETCH_GROUP_SIZE
+                            ? num_keys - start
+                            : FETCH_GROUP_SIZE;
+        for (size_t i = 0; i < group_size; i++) {
+            PREFETCH(entries + (hash_sums[start + i] & mask));
+        }
+        S_fetch_group(self, keys + start, hash_sums + start, group_size,
+                      values + start);
+    }
+}
+
 Obj*
 Hash_Delete_IMP(Hash *self, String *key) {
     HashEntry *entry = SI_fetch_entry(self, key, Str_Hash_Sum(key));
@@ -212,6 +326,7 @@ Hash_Delete_IMP(Hash *self, String *key) {
         entry->hash_sum  = 0;
         self->size--;
         self->threshold--; // limit number of tombstones
+        HASHSTATS_TOMBSTONE(HASHSTATS_HASH);
         return value;
     }
     else {
@@ -289,6 +404,39 @@ Hash_Get_Capacity_IMP(Hash *self) {
     return self->capacity;
 }
 
+bool
+Hash_get_stats(Hash *self, HashStats *stats) {
+    memset(stats, 0, sizeof(HashStats));
+#ifdef CFISH_HASH_STATS
+    *stats = *SI_STATS(self);
+
+    // Find the longest cluster of occupied slots.  Clusters may wrap
+    // around, so start after an empty slot.
+    HashEntry *entries = (HashEntry*)self->entries;
+    size_t     mask    = self->capacity - 1;
+    size_t     start   = 0;
+    while (start < self->capacity && entries[start].key) { start++; }
+    size_t     run     = 0;
+    for (size_t i = 1; i <= self->capacity; i++) {
+        HashEntry *entry = &entries[(start + i) & mask];
+        if (entry->key) {
+            if (entry->key == TOMBSTONE) { stats->num_tombstones++; }
+            if (++run > stats->max_chain) { stats->max_chain = run; }
+        }
+        else {
+            run = 0;
+        }
+    }
+
+    stats->num_entries = self->size;
+    stats->capacity    = self->capacity;
+    return true;
+#else
+    UNUSED_VAR(self);
+    return false;
+#endif
+}
+
 size_t
 Hash_Get_Size_IMP(Hash *self) {
     return self->size;
@@ -300,23 +448,41 @@ SI_rebuild_hash(Hash *self) {
         THROW(ERR, "Hash grew too large");
     }
 
+    HASHSTATS_RESIZE_START(start_ns);
+    TRACE_BEGIN("Hash", "rebuild");
+
     HashEntry *old_entries = (HashEntry*)self->entries;
     HashEntry *entry       = old_entries;
     HashEntry *limit       = old_entries + self->capacity;
 
     self->capacity *= 2;
     self->threshold = (self->capacity / 3) * 2;
-    self->entries   = (HashEntry*)CALLOCATE(self->capacity, sizeof(HashEntry));
+    self->entries   = SI_alloc_entries(self->capacity);
     self->size      = 0;
-
+#ifdef CFISH_HASH_STATS
+    *SI_STATS(self) = *(HashStats*)limit;
+#endif
+    CENSUS_BYTES(self, (self->capacity / 2) * sizeof(HashEntry));
+
+    // Keys are known to be unique and the new table has no tombstones, so
+    // entries can be moved to the first free slot without a lookup.
+    HashEntry   *entries = (HashEntry*)self->entries;
+    const size_t mask    = self->capacity - 1;
     for (; entry < limit; entry++) {
         if (!entry->key || entry->key == TOMBSTONE) {
             continue;
         }
-        S_do_store(self, entry->key, entry->value, entry->hash_sum, false);
+        size_t tick = entry->hash_sum & mask;
+        while (entries[tick].key) {
+            tick = (tick + 1) & mask;
+        }
+        entries[tick] = *entry;
+        self->size++;
     }
 
     FREEMEM(old_entries);
+    HASHSTATS_RESIZE_END(SI_STATS(self), HASHSTATS_HASH, start_ns);
+    TRACE_END("Hash", "rebuild");
 
     return (HashEntry*)self->entries;
 }
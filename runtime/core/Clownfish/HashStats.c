@@ -0,0 +1,187 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define CFISH_USE_SHORT_NAMES
+
+#include "charmony.h"
+
+#include <string.h>
+
+#include "Clownfish/Hash.h"
+#include "Clownfish/Util/PerThread.h"
+
+uint64_t
+HashStats_num_ops(const HashStats *stats, cfish_HashStatsOp op) {
+    uint64_t num_ops = 0;
+    for (size_t i = 0; i < CFISH_HASHSTATS_PROBE_BUCKETS; i++) {
+        num_ops += stats->probes[op][i];
+    }
+    return num_ops;
+}
+
+double
+HashStats_mean_probes(const HashStats *stats, cfish_HashStatsOp op) {
+    uint64_t num_ops    = 0;
+    uint64_t num_probes = 0;
+    for (size_t i = 0; i < CFISH_HASHSTATS_PROBE_BUCKETS; i++) {
+        num_ops    += stats->probes[op][i];
+        num_probes += stats->probes[op][i] * i;
+    }
+    return num_ops ? (double)num_probes / (double)num_ops : 0.0;
+}
+
+#ifdef CFISH_HASH_STATS
+
+// Global counts of a thread.
+typedef struct {
+    HashStats stats[CFISH_HASHSTATS_NUM_TABLES];
+} StatsBlock;
+
+typedef struct {
+    cfish_HashStatsTable  table;
+    HashStats            *stats;
+} StatsQuery;
+
+static void
+S_merge_block(void *dest, void *src);
+
+static PerThread stats_threads
+    = PERTHREAD_INIT(sizeof(StatsBlock), S_merge_block);
+
+static void
+S_add_probes(HashStats *stats, cfish_HashStatsOp op, size_t num_probes) {
+    size_t bucket = num_probes < CFISH_HASHSTATS_PROBE_BUCKETS
+                    ? num_probes
+                    : CFISH_HASHSTATS_PROBE_BUCKETS - 1;
+    stats->probes[op][bucket]++;
+    if (num_probes > stats->max_probes) {
+        stats->max_probes = num_probes;
+    }
+}
+
+static void
+S_add_stats(HashStats *dest, const HashStats *src) {
+    for (size_t op = 0; op < CFISH_HASHSTATS_NUM_OPS; op++) {
+        for (size_t i = 0; i < CFISH_HASHSTATS_PROBE_BUCKETS; i++) {
+            dest->probes[op][i] += src->probes[op][i];
+        }
+    }
+    if (src->max_probes > dest->max_probes) {
+        dest->max_probes = src->max_probes;
+    }
+    dest->num_tombstones += src->num_tombstones;
+    dest->num_resizes    += src->num_resizes;
+    dest->resize_ns      += src->resize_ns;
+}
+
+static void
+S_merge_block(void *dest, void *src) {
+    StatsBlock *totals = (StatsBlock*)dest;
+    StatsBlock *block  = (StatsBlock*)src;
+    for (size_t i = 0; i < CFISH_HASHSTATS_NUM_TABLES; i++) {
+        S_add_stats(&totals->stats[i], &block->stats[i]);
+    }
+}
+
+static void
+S_visit_block(void *context, void *block) {
+    StatsQuery *query = (StatsQuery*)context;
+    S_add_stats(query->stats, &((StatsBlock*)block)->stats[query->table]);
+}
+
+bool
+HashStats_enabled() {
+    return true;
+}
+
+void
+HashStats_record_probes(HashStats *stats, cfish_HashStatsTable table,
+                        cfish_HashStatsOp op, size_t num_probes) {
+    S_add_probes(stats, op, num_probes);
+    StatsBlock *block = (StatsBlock*)PerThread_get_block(&stats_threads);
+    S_add_probes(&block->stats[table], op, num_probes);
+}
+
+void
+HashStats_record_resize(HashStats *stats, cfish_HashStatsTable table,
+                        uint64_t start_ns) {
+    uint64_t elapsed = Trace_time_ns() - start_ns;
+    stats->num_resizes++;
+    stats->resize_ns += elapsed;
+    StatsBlock *block = (StatsBlock*)PerThread_get_block(&stats_threads);
+    block->stats[table].num_resizes++;
+    block->stats[table].resize_ns += elapsed;
+}
+
+void
+HashStats_record_tombstone(cfish_HashStatsTable table) {
+    StatsBlock *block = (StatsBlock*)PerThread_get_block(&stats_threads);
+    block->stats[table].num_tombstones++;
+}
+
+bool
+HashStats_global(cfish_HashStatsTable table, HashStats *stats) {
+    memset(stats, 0, sizeof(HashStats));
+
+    StatsQuery query;
+    query.table = table;
+    query.stats = stats;
+    PerThread_lock(&stats_threads);
+    PerThread_each(&stats_threads, S_visit_block, &query);
+    PerThread_unlock(&stats_threads);
+
+    return true;
+}
+
+#else /* CFISH_HASH_STATS */
+
+bool
+HashStats_enabled() {
+    return false;
+}
+
+void
+HashStats_record_probes(HashStats *stats, cfish_HashStatsTable table,
+                        cfish_HashStatsOp op, size_t num_probes) {
+    UNUSED_VAR(stats);
+    UNUSED_VAR(table);
+    UNUSED_VAR(op);
+    UNUSED_VAR(num_probes);
+}
+
+void
+HashStats_record_resize(HashStats *stats, cfish_HashStatsTable table,
+                        uint64_t start_ns) {
+    UNUSED_VAR(stats);
+    UNUSED_VAR(table);
+    UNUSED_VAR(start_ns);
+}
+
+void
+HashStats_record_tombstone(cfish_HashStatsTable table) {
+    UNUSED_VAR(table);
+}
+
+bool
+HashStats_global(cfish_HashStatsTable table, HashStats *stats) {
+    UNUSED_VAR(table);
+    memset(stats, 0, sizeof(HashStats));
+    return false;
+}
+
+#endif /* CFISH_HASH_STATS */
+
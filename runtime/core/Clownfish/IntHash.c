@@ -0,0 +1,352 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_CFISH_INTHASH
+#define C_CFISH_INTHASHITERATOR
+#define CFISH_USE_SHORT_NAMES
+
+#include <string.h>
+
+#include "Clownfish/Class.h"
+
+#include "Clownfish/IntHash.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/NumVector.h"
+#include "Clownfish/Vector.h"
+#include "Clownfish/Util/Memory.h"
+
+// Empty slots have a NULL value, so NULL values can't be stored.
+typedef struct IntHashEntry {
+    int64_t  key;
+    Obj     *value;
+} IntHashEntry;
+
+// Multiplicative hash function using the prime nearest to the golden ratio,
+// like PtrHash.  The top bits of the product depend on all bits of the key,
+// so sequential ids are spread evenly.
+static CFISH_INLINE size_t
+SI_find_index(int64_t key, int shift) {
+    uint64_t value = (uint64_t)key * UINT64_C(0x9E3779B97F4A7C55);
+    return (size_t)(value >> shift);
+}
+
+// Return the entry holding the key or the empty entry where it would be
+// inserted.  There's always at least one empty entry.
+static CFISH_INLINE IntHashEntry*
+SI_find_entry(IntHash *self, int64_t key) {
+    IntHashEntry *const entries = (IntHashEntry*)self->entries;
+    const size_t        mask    = self->capacity - 1;
+    size_t              tick    = SI_find_index(key, self->shift);
+
+    while (entries[tick].value && entries[tick].key != key) {
+        tick = (tick + 1) & mask; // linear scan
+    }
+
+    return entries + tick;
+}
+
+// Double the number of buckets and redistribute all entries.
+static void
+S_rebuild_hash(IntHash *self);
+
+IntHash*
+IntHash_new(size_t capacity) {
+    IntHash *self = (IntHash*)Class_Make_Obj(INTHASH);
+    return IntHash_init(self, capacity);
+}
+
+IntHash*
+IntHash_init(IntHash *self, size_t min_threshold) {
+    // Allocate enough space to hold the requested number of elements without
+    // triggering a rebuild.
+    size_t threshold;
+    size_t capacity = 16;
+    int    shift    = 64 - 4;
+    do {
+        threshold = (capacity / 3) * 2;
+        if (threshold > min_threshold) { break; }
+        capacity *= 2;
+        shift    -= 1;
+    } while (capacity <= SIZE_MAX / 2);
+
+    // Init.
+    self->size        = 0;
+    self->num_changes = 0;
+
+    // Derive.
+    self->capacity  = capacity;
+    self->shift     = shift;
+    self->entries   = CALLOCATE(capacity, sizeof(IntHashEntry));
+    self->threshold = threshold;
+    CENSUS_BYTES(self, capacity * sizeof(IntHashEntry));
+
+    return self;
+}
+
+void
+IntHash_Destroy_IMP(IntHash *self) {
+    if (self->entries) {
+        IntHash_Clear(self);
+        CENSUS_BYTES(self,
+                     -(int64_t)(self->capacity * sizeof(IntHashEntry)));
+        FREEMEM(self->entries);
+    }
+    SUPER_DESTROY(self, INTHASH);
+}
+
+void
+IntHash_Clear_IMP(IntHash *self) {
+    IntHashEntry *entry       = (IntHashEntry*)self->entries;
+    IntHashEntry *const limit = entry + self->capacity;
+
+    for (; entry < limit; entry++) {
+        if (entry->value) {
+            DECREF(entry->value);
+            entry->key   = 0;
+            entry->value = NULL;
+        }
+    }
+
+    self->size = 0;
+    self->num_changes++;
+}
+
+void
+IntHash_Store_IMP(IntHash *self, int64_t key, Obj *value) {
+    if (value == NULL) {
+        THROW(ERR, "Can't store NULL value in IntHash");
+    }
+
+    IntHashEntry *entry = SI_find_entry(self, key);
+    if (entry->value) {
+        DECREF(entry->value);
+        entry->value = value;
+        return;
+    }
+
+    if (self->size >= self->threshold) {
+        S_rebuild_hash(self);
+        entry = SI_find_entry(self, key);
+    }
+
+    entry->key   = key;
+    entry->value = value;
+    self->size++;
+    self->num_changes++;
+}
+
+Obj*
+IntHash_Fetch_IMP(IntHash *self, int64_t key) {
+    return SI_find_entry(self, key)->value;
+}
+
+Obj*
+IntHash_Delete_IMP(IntHash *self, int64_t key) {
+    IntHashEntry *const entries = (IntHashEntry*)self->entries;
+    const size_t        mask    = self->capacity - 1;
+    size_t              hole    = (size_t)(SI_find_entry(self, key) - entries);
+    Obj                *value   = entries[hole].value;
+
+    if (!value) { return NULL; }
+
+    // Close the hole by moving back every following entry of the cluster
+    // whose probe sequence passes the hole.
+    size_t tick = hole;
+    while (1) {
+        tick = (tick + 1) & mask;
+        IntHashEntry *entry = entries + tick;
+        if (!entry->value) { break; }
+        size_t home = SI_find_index(entry->key, self->shift);
+        if (((tick - home) & mask) >= ((tick - hole) & mask)) {
+            entries[hole] = *entry;
+            hole = tick;
+        }
+    }
+
+    entries[hole].key   = 0;
+    entries[hole].value = NULL;
+    self->size--;
+    self->num_changes++;
+
+    return value;
+}
+
+bool
+IntHash_Has_Key_IMP(IntHash *self, int64_t key) {
+    return SI_find_entry(self, key)->value != NULL;
+}
+
+I64Vector*
+IntHash_Keys_IMP(IntHash *self) {
+    I64Vector    *keys        = I64Vec_new(self->size);
+    IntHashEntry *entry       = (IntHashEntry*)self->entries;
+    IntHashEntry *const limit = entry + self->capacity;
+
+    for (; entry < limit; entry++) {
+        if (entry->value) {
+            I64Vec_Push(keys, entry->key);
+        }
+    }
+
+    return keys;
+}
+
+Vector*
+IntHash_Values_IMP(IntHash *self) {
+    Vector       *values      = Vec_new(self->size);
+    IntHashEntry *entry       = (IntHashEntry*)self->entries;
+    IntHashEntry *const limit = entry + self->capacity;
+
+    for (; entry < limit; entry++) {
+        if (entry->value) {
+            Vec_Push(values, INCREF(entry->value));
+        }
+    }
+
+    return values;
+}
+
+bool
+IntHash_Equals_IMP(IntHash *self, Obj *other) {
+    IntHash *twin = (IntHash*)other;
+
+    if (twin == self)              { return true; }
+    if (!Obj_is_a(other, INTHASH)) { return false; }
+    if (self->size != twin->size)  { return false; }
+
+    IntHashEntry *entry       = (IntHashEntry*)self->entries;
+    IntHashEntry *const limit = entry + self->capacity;
+
+    for (; entry < limit; entry++) {
+        if (entry->value) {
+            Obj *other_val = SI_find_entry(twin, entry->key)->value;
+            if (!other_val || !Obj_Equals(other_val, entry->value)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+size_t
+IntHash_Get_Capacity_IMP(IntHash *self) {
+    return self->capacity;
+}
+
+size_t
+IntHash_Get_Size_IMP(IntHash *self) {
+    return self->size;
+}
+
+static void
+S_rebuild_hash(IntHash *self) {
+    if (self->capacity > SIZE_MAX / 2) {
+        THROW(ERR, "IntHash grew too large");
+    }
+
+    IntHashEntry *old_entries = (IntHashEntry*)self->entries;
+    IntHashEntry *entry       = old_entries;
+    IntHashEntry *limit       = old_entries + self->capacity;
+
+    self->capacity *= 2;
+    self->shift    -= 1;
+    self->threshold = (self->capacity / 3) * 2;
+    self->entries   = CALLOCATE(self->capacity, sizeof(IntHashEntry));
+    CENSUS_BYTES(self, (self->capacity / 2) * sizeof(IntHashEntry));
+
+    // Keys are known to be unique, so entries can be moved to the first
+    // free slot without comparing keys.
+    IntHashEntry *entries = (IntHashEntry*)self->entries;
+    const size_t  mask    = self->capacity - 1;
+    for (; entry < limit; entry++) {
+        if (!entry->value) { continue; }
+        size_t tick = SI_find_index(entry->key, self->shift);
+        while (entries[tick].value) {
+            tick = (tick + 1) & mask;
+        }
+        entries[tick] = *entry;
+    }
+
+    FREEMEM(old_entries);
+}
+
+/***************************** IntHashIterator *****************************/
+
+IntHashIterator*
+IntHashIter_new(IntHash *hash) {
+    IntHashIterator *self = (IntHashIterator*)Class_Make_Obj(INTHASHITERATOR);
+    return IntHashIter_init(self, hash);
+}
+
+IntHashIterator*
+IntHashIter_init(IntHashIterator *self, IntHash *hash) {
+    self->hash        = (IntHash*)INCREF(hash);
+    self->tick        = (size_t)-1;
+    self->num_changes = hash->num_changes;
+    return self;
+}
+
+static IntHashEntry*
+S_current_entry(IntHashIterator *self, const char *method) {
+    if (self->num_changes != self->hash->num_changes) {
+        THROW(ERR, "IntHash modified during iteration.");
+    }
+    if (self->tick == (size_t)-1) {
+        THROW(ERR, "Invalid call to %s before iteration.", method);
+    }
+    else if (self->tick >= self->hash->capacity) {
+        THROW(ERR, "Invalid call to %s after end of iteration.", method);
+    }
+    return (IntHashEntry*)self->hash->entries + self->tick;
+}
+
+bool
+IntHashIter_Next_IMP(IntHashIterator *self) {
+    if (self->num_changes != self->hash->num_changes) {
+        THROW(ERR, "IntHash modified during iteration.");
+    }
+
+    IntHashEntry *const entries  = (IntHashEntry*)self->hash->entries;
+    const size_t        capacity = self->hash->capacity;
+    while (1) {
+        if (++self->tick >= capacity) {
+            // Iteration complete. Pin tick at capacity.
+            self->tick = capacity;
+            return false;
+        }
+        else if (entries[self->tick].value) {
+            return true;
+        }
+    }
+}
+
+int64_t
+IntHashIter_Get_Key_IMP(IntHashIterator *self) {
+    return S_current_entry(self, "Get_Key")->key;
+}
+
+Obj*
+IntHashIter_Get_Value_IMP(IntHashIterator *self) {
+    return S_current_entry(self, "Get_Value")->value;
+}
+
+void
+IntHashIter_Destroy_IMP(IntHashIterator *self) {
+    DECREF(self->hash);
+    SUPER_DESTROY(self, INTHASHITERATOR);
+}
+
@@ -16,10 +16,13 @@
 
 #define CFISH_USE_SHORT_NAMES
 
+#include <string.h>
+
 #include "Clownfish/Obj.h"
 #include "Clownfish/LockFreeRegistry.h"
 #include "Clownfish/Err.h"
 #include "Clownfish/Class.h"
+#include "Clownfish/Hash.h"
 #include "Clownfish/String.h"
 #include "Clownfish/Util/Atomic.h"
 #include "Clownfish/Util/Memory.h"
@@ -27,6 +30,10 @@
 struct cfish_LockFreeRegistry {
     size_t  capacity;
     void   *entries;
+#ifdef CFISH_HASH_STATS
+    // Updated without synchronization, so concurrent updates may be lost.
+    HashStats stats;
+#endif
 };
 
 typedef struct cfish_LFRegEntry {
@@ -53,6 +60,9 @@ LFReg_register(LockFreeRegistry *self, String *key, Obj *value) {
     size_t       bucket    = hash_sum  % self->capacity;
     LFRegEntry  *volatile *entries = (LFRegEntry*volatile*)self->entries;
     LFRegEntry  *volatile *slot    = &(entries[bucket]);
+#ifdef CFISH_HASH_STATS
+    size_t num_probes = 0;
+#endif
 
     // Proceed through the linked list.  Bail out if the key has already been
     // registered.
@@ -61,6 +71,8 @@ FIND_END_OF_LINKED_LIST:
         LFRegEntry *entry = *slot;
         if (entry->hash_sum == hash_sum) {
             if (Str_Equals(key, (Obj*)entry->key)) {
+                HASHSTATS_PROBES(&self->stats, HASHSTATS_LFREG, HASHSTATS_HIT,
+                                 num_probes + 1);
                 if (new_entry) {
                     DECREF(new_entry->key);
                     DECREF(new_entry->value);
@@ -70,6 +82,9 @@ FIND_END_OF_LINKED_LIST:
             }
         }
         slot = &(entry->next);
+#ifdef CFISH_HASH_STATS
+        num_probes++;
+#endif
     }
 
     // We've found an empty slot. Create the new entry.
@@ -102,6 +117,8 @@ FIND_END_OF_LINKED_LIST:
     }
 #endif
 
+    HASHSTATS_PROBES(&self->stats, HASHSTATS_LFREG, HASHSTATS_INSERT,
+                     num_probes);
     return true;
 }
 
@@ -111,19 +128,53 @@ LFReg_fetch(LockFreeRegistry *self, String *key) {
     size_t       bucket    = hash_sum  % self->capacity;
     LFRegEntry **entries   = (LFRegEntry**)self->entries;
     LFRegEntry  *entry     = entries[bucket];
+#ifdef CFISH_HASH_STATS
+    size_t num_probes = 0;
+#endif
 
     while (entry) {
+#ifdef CFISH_HASH_STATS
+        num_probes++;
+#endif
         if (entry->hash_sum  == hash_sum) {
             if (Str_Equals(key, (Obj*)entry->key)) {
+                HASHSTATS_PROBES(&self->stats, HASHSTATS_LFREG, HASHSTATS_HIT,
+                                 num_probes);
                 return entry->value;
             }
         }
         entry = entry->next;
     }
 
+    HASHSTATS_PROBES(&self->stats, HASHSTATS_LFREG, HASHSTATS_MISS,
+                     num_probes);
     return NULL;
 }
 
+bool
+LFReg_get_stats(LockFreeRegistry *self, HashStats *stats) {
+    memset(stats, 0, sizeof(HashStats));
+#ifdef CFISH_HASH_STATS
+    *stats = self->stats;
+
+    LFRegEntry **entries = (LFRegEntry**)self->entries;
+    for (size_t i = 0; i < self->capacity; i++) {
+        size_t chain = 0;
+        for (LFRegEntry *entry = entries[i]; entry; entry = entry->next) {
+            chain++;
+        }
+        if (chain > stats->max_chain) { stats->max_chain = chain; }
+        stats->num_entries += chain;
+    }
+
+    stats->capacity = self->capacity;
+    return true;
+#else
+    UNUSED_VAR(self);
+    return false;
+#endif
+}
+
 void
 LFReg_destroy(LockFreeRegistry *self) {
     LFRegEntry **entries = (LFRegEntry**)self->entries;
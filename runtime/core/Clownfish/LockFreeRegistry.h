@@ -20,6 +20,7 @@
 #include <stddef.h>
 
 #include "cfish_parcel.h"
+#include "Clownfish/Hash.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,12 +47,19 @@ cfish_LFReg_register(cfish_LockFreeRegistry *self, struct cfish_String *key,
 CFISH_VISIBLE struct cfish_Obj*
 cfish_LFReg_fetch(cfish_LockFreeRegistry *self, struct cfish_String *key);
 
+/** Fill in probe-length and load statistics, see Hash.h.  `max_chain`
+ * is the length of the longest chain.
+ */
+CFISH_VISIBLE bool
+cfish_LFReg_get_stats(cfish_LockFreeRegistry *self, cfish_HashStats *stats);
+
 #ifdef CFISH_USE_SHORT_NAMES
   #define LockFreeRegistry cfish_LockFreeRegistry
   #define LFReg_new        cfish_LFReg_new
   #define LFReg_destroy    cfish_LFReg_destroy
   #define LFReg_register   cfish_LFReg_register
   #define LFReg_fetch      cfish_LFReg_fetch
+  #define LFReg_get_stats  cfish_LFReg_get_stats
 #endif
 
 #ifdef __cplusplus
@@ -26,6 +26,8 @@
 #include "Clownfish/String.h"
 #include "Clownfish/Err.h"
 #include "Clownfish/Class.h"
+#include "Clownfish/Util/Atomic.h"
+#include "Clownfish/Util/Memory.h"
 
 #if FLT_RADIX != 2
   #error Unsupported FLT_RADIX
@@ -119,8 +121,59 @@ Float_Clone_IMP(Float *self) {
 
 /***************************************************************************/
 
+#if CFISH_INT_CACHE_MAX >= CFISH_INT_CACHE_MIN
+  #define INT_CACHE_SIZE (CFISH_INT_CACHE_MAX - CFISH_INT_CACHE_MIN + 1)
+#else
+  #define INT_CACHE_SIZE 0
+#endif
+
+static Integer **Int_cache = NULL;
+
+void
+Int_init_class() {
+    if (INT_CACHE_SIZE == 0) { return; }
+
+    // Cached Integers live as long as the process.
+    Class_census_suspend();
+    Integer **cache
+        = (Integer**)MALLOCATE(INT_CACHE_SIZE * sizeof(Integer*));
+    for (int64_t i = 0; i < INT_CACHE_SIZE; i++) {
+        Integer *self = (Integer*)Class_Make_Obj(INTEGER);
+        cache[i] = Int_init(self, i + CFISH_INT_CACHE_MIN);
+    }
+
+    if (!Atomic_cas_ptr((void**)&Int_cache, NULL, cache)) {
+        // Another thread beat us to it.  Our Integers aren't cached, so
+        // they can be destroyed as usual.
+        for (int64_t i = 0; i < INT_CACHE_SIZE; i++) {
+            DECREF(cache[i]);
+        }
+        FREEMEM(cache);
+    }
+    Class_census_resume();
+}
+
+bool
+Int_is_cached(Obj *obj) {
+    Integer *self  = (Integer*)obj;
+    int64_t  value = self->value;
+    return value >= CFISH_INT_CACHE_MIN
+           && value <= CFISH_INT_CACHE_MAX
+           && Int_cache != NULL
+           && Int_cache[value - CFISH_INT_CACHE_MIN] == self;
+}
+
 Integer*
 Int_new(int64_t value) {
+    if (value >= CFISH_INT_CACHE_MIN
+        && value <= CFISH_INT_CACHE_MAX
+        && Int_cache != NULL
+       ) {
+        // INTEGER is flagged with fREFCOUNTSPECIAL, so INCREF takes the
+        // host's slow path, which leaves the refcount of cached Integers
+        // alone.
+        return (Integer*)INCREF(Int_cache[value - CFISH_INT_CACHE_MIN]);
+    }
     Integer *self = (Integer*)Class_Make_Obj(INTEGER);
     return Int_init(self, value);
 }
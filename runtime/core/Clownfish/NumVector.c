@@ -0,0 +1,575 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_CFISH_I32VECTOR
+#define C_CFISH_I64VECTOR
+#define C_CFISH_F64VECTOR
+#define CFISH_USE_SHORT_NAMES
+
+#include <string.h>
+
+#include "charmony.h"
+
+#include "Clownfish/NumVector.h"
+#include "Clownfish/Class.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/SortUtils.h"
+#include "Clownfish/Util/ThreadPool.h"
+
+// Vectors at least this long are sorted with a radix sort.
+#define RADIX_SORT_THRESHOLD 256
+
+// Return the new capacity for an array which must hold at least `min_size`
+// elements of `width` bytes.  Throw an exception on overflow.
+static size_t
+S_oversize(size_t min_size, size_t width);
+
+static void
+S_overflow_error(void);
+
+static int
+S_compare_i32(void *context, const void *va, const void *vb);
+
+static int
+S_compare_i64(void *context, const void *va, const void *vb);
+
+static int
+S_compare_f64(void *context, const void *va, const void *vb);
+
+/**** I32Vector ************************************************************/
+
+I32Vector*
+I32Vec_new(size_t capacity) {
+    I32Vector *self = (I32Vector*)Class_Make_Obj(I32VECTOR);
+    return I32Vec_init(self, capacity);
+}
+
+I32Vector*
+I32Vec_new_from_array(const int32_t *values, size_t size) {
+    I32Vector *self = (I32Vector*)Class_Make_Obj(I32VECTOR);
+    I32Vec_init(self, size);
+    if (size) {
+        memcpy(self->elems, values, size * sizeof(int32_t));
+    }
+    self->size = size;
+    return self;
+}
+
+I32Vector*
+I32Vec_init(I32Vector *self, size_t capacity) {
+    if (capacity > SIZE_MAX / sizeof(int32_t)) {
+        S_overflow_error();
+    }
+    self->size  = 0;
+    self->cap   = capacity;
+    self->elems = (int32_t*)MALLOCATE(capacity * sizeof(int32_t));
+    return self;
+}
+
+void
+I32Vec_Destroy_IMP(I32Vector *self) {
+    FREEMEM(self->elems);
+    SUPER_DESTROY(self, I32VECTOR);
+}
+
+I32Vector*
+I32Vec_Clone_IMP(I32Vector *self) {
+    return I32Vec_new_from_array(self->elems, self->size);
+}
+
+void
+I32Vec_Push_IMP(I32Vector *self, int32_t value) {
+    if (self->size == self->cap) {
+        I32Vec_Grow(self, S_oversize(self->size + 1, sizeof(int32_t)));
+    }
+    self->elems[self->size++] = value;
+}
+
+void
+I32Vec_Grow_IMP(I32Vector *self, size_t capacity) {
+    if (capacity > self->cap) {
+        if (capacity > SIZE_MAX / sizeof(int32_t)) {
+            S_overflow_error();
+        }
+        self->elems = (int32_t*)REALLOCATE(self->elems,
+                                           capacity * sizeof(int32_t));
+        self->cap   = capacity;
+    }
+}
+
+int32_t
+I32Vec_Fetch_IMP(I32Vector *self, size_t tick) {
+    if (tick >= self->size) {
+        THROW(ERR, "Index %u64 out of bounds (size %u64)", (uint64_t)tick,
+              (uint64_t)self->size);
+    }
+    return self->elems[tick];
+}
+
+void
+I32Vec_Store_IMP(I32Vector *self, size_t tick, int32_t value) {
+    if (tick >= self->size) {
+        if (tick == SIZE_MAX) { S_overflow_error(); }
+        I32Vec_Resize(self, tick + 1);
+    }
+    self->elems[tick] = value;
+}
+
+void
+I32Vec_Resize_IMP(I32Vector *self, size_t size) {
+    if (size > self->size) {
+        if (size > self->cap) {
+            I32Vec_Grow(self, S_oversize(size, sizeof(int32_t)));
+        }
+        memset(self->elems + self->size, 0,
+               (size - self->size) * sizeof(int32_t));
+    }
+    self->size = size;
+}
+
+void
+I32Vec_Clear_IMP(I32Vector *self) {
+    self->size = 0;
+}
+
+static void
+S_sort_i32(I32Vector *self, ThreadPool *pool) {
+    if (self->size >= RADIX_SORT_THRESHOLD) {
+        int32_t *scratch = (int32_t*)MALLOCATE(self->size * sizeof(int32_t));
+        Sort_radixsort_i32(self->elems, scratch, self->size, pool);
+        FREEMEM(scratch);
+    }
+    else {
+        Sort_quicksort(self->elems, self->size, sizeof(int32_t),
+                       S_compare_i32, NULL);
+    }
+}
+
+void
+I32Vec_Sort_IMP(I32Vector *self) {
+    S_sort_i32(self, NULL);
+}
+
+void
+I32Vec_Sort_Parallel_IMP(I32Vector *self, ThreadPool *pool) {
+    S_sort_i32(self, pool);
+}
+
+I32Vector*
+I32Vec_Slice_IMP(I32Vector *self, size_t offset, size_t length) {
+    if (offset >= self->size) {
+        offset = 0;
+        length = 0;
+    }
+    else if (length > self->size - offset) {
+        length = self->size - offset;
+    }
+    return I32Vec_new_from_array(self->elems + offset, length);
+}
+
+size_t
+I32Vec_Get_Size_IMP(I32Vector *self) {
+    return self->size;
+}
+
+size_t
+I32Vec_Get_Capacity_IMP(I32Vector *self) {
+    return self->cap;
+}
+
+int32_t*
+I32Vec_Get_Ptr_IMP(I32Vector *self) {
+    return self->elems;
+}
+
+bool
+I32Vec_Equals_IMP(I32Vector *self, Obj *other) {
+    I32Vector *twin = (I32Vector*)other;
+    if (twin == self)                { return true; }
+    if (!Obj_is_a(other, I32VECTOR)) { return false; }
+    if (twin->size != self->size)    { return false; }
+    return memcmp(self->elems, twin->elems,
+                  self->size * sizeof(int32_t)) == 0;
+}
+
+/**** I64Vector ************************************************************/
+
+I64Vector*
+I64Vec_new(size_t capacity) {
+    I64Vector *self = (I64Vector*)Class_Make_Obj(I64VECTOR);
+    return I64Vec_init(self, capacity);
+}
+
+I64Vector*
+I64Vec_new_from_array(const int64_t *values, size_t size) {
+    I64Vector *self = (I64Vector*)Class_Make_Obj(I64VECTOR);
+    I64Vec_init(self, size);
+    if (size) {
+        memcpy(self->elems, values, size * sizeof(int64_t));
+    }
+    self->size = size;
+    return self;
+}
+
+I64Vector*
+I64Vec_init(I64Vector *self, size_t capacity) {
+    if (capacity > SIZE_MAX / sizeof(int64_t)) {
+        S_overflow_error();
+    }
+    self->size  = 0;
+    self->cap   = capacity;
+    self->elems = (int64_t*)MALLOCATE(capacity * sizeof(int64_t));
+    return self;
+}
+
+void
+I64Vec_Destroy_IMP(I64Vector *self) {
+    FREEMEM(self->elems);
+    SUPER_DESTROY(self, I64VECTOR);
+}
+
+I64Vector*
+I64Vec_Clone_IMP(I64Vector *self) {
+    return I64Vec_new_from_array(self->elems, self->size);
+}
+
+void
+I64Vec_Push_IMP(I64Vector *self, int64_t value) {
+    if (self->size == self->cap) {
+        I64Vec_Grow(self, S_oversize(self->size + 1, sizeof(int64_t)));
+    }
+    self->elems[self->size++] = value;
+}
+
+void
+I64Vec_Grow_IMP(I64Vector *self, size_t capacity) {
+    if (capacity > self->cap) {
+        if (capacity > SIZE_MAX / sizeof(int64_t)) {
+            S_overflow_error();
+        }
+        self->elems = (int64_t*)REALLOCATE(self->elems,
+                                           capacity * sizeof(int64_t));
+        self->cap   = capacity;
+    }
+}
+
+int64_t
+I64Vec_Fetch_IMP(I64Vector *self, size_t tick) {
+    if (tick >= self->size) {
+        THROW(ERR, "Index %u64 out of bounds (size %u64)", (uint64_t)tick,
+              (uint64_t)self->size);
+    }
+    return self->elems[tick];
+}
+
+void
+I64Vec_Store_IMP(I64Vector *self, size_t tick, int64_t value) {
+    if (tick >= self->size) {
+        if (tick == SIZE_MAX) { S_overflow_error(); }
+        I64Vec_Resize(self, tick + 1);
+    }
+    self->elems[tick] = value;
+}
+
+void
+I64Vec_Resize_IMP(I64Vector *self, size_t size) {
+    if (size > self->size) {
+        if (size > self->cap) {
+            I64Vec_Grow(self, S_oversize(size, sizeof(int64_t)));
+        }
+        memset(self->elems + self->size, 0,
+               (size - self->size) * sizeof(int64_t));
+    }
+    self->size = size;
+}
+
+void
+I64Vec_Clear_IMP(I64Vector *self) {
+    self->size = 0;
+}
+
+static void
+S_sort_i64(I64Vector *self, ThreadPool *pool) {
+    if (self->size >= RADIX_SORT_THRESHOLD) {
+        int64_t *scratch = (int64_t*)MALLOCATE(self->size * sizeof(int64_t));
+        Sort_radixsort_i64(self->elems, scratch, self->size, pool);
+        FREEMEM(scratch);
+    }
+    else {
+        Sort_quicksort(self->elems, self->size, sizeof(int64_t),
+                       S_compare_i64, NULL);
+    }
+}
+
+void
+I64Vec_Sort_IMP(I64Vector *self) {
+    S_sort_i64(self, NULL);
+}
+
+void
+I64Vec_Sort_Parallel_IMP(I64Vector *self, ThreadPool *pool) {
+    S_sort_i64(self, pool);
+}
+
+I64Vector*
+I64Vec_Slice_IMP(I64Vector *self, size_t offset, size_t length) {
+    if (offset >= self->size) {
+        offset = 0;
+        length = 0;
+    }
+    else if (length > self->size - offset) {
+        length = self->size - offset;
+    }
+    return I64Vec_new_from_array(self->elems + offset, length);
+}
+
+size_t
+I64Vec_Get_Size_IMP(I64Vector *self) {
+    return self->size;
+}
+
+size_t
+I64Vec_Get_Capacity_IMP(I64Vector *self) {
+    return self->cap;
+}
+
+int64_t*
+I64Vec_Get_Ptr_IMP(I64Vector *self) {
+    return self->elems;
+}
+
+bool
+I64Vec_Equals_IMP(I64Vector *self, Obj *other) {
+    I64Vector *twin = (I64Vector*)other;
+    if (twin == self)                { return true; }
+    if (!Obj_is_a(other, I64VECTOR)) { return false; }
+    if (twin->size != self->size)    { return false; }
+    return memcmp(self->elems, twin->elems,
+                  self->size * sizeof(int64_t)) == 0;
+}
+
+/**** F64Vector ************************************************************/
+
+F64Vector*
+F64Vec_new(size_t capacity) {
+    F64Vector *self = (F64Vector*)Class_Make_Obj(F64VECTOR);
+    return F64Vec_init(self, capacity);
+}
+
+F64Vector*
+F64Vec_new_from_array(const double *values, size_t size) {
+    F64Vector *self = (F64Vector*)Class_Make_Obj(F64VECTOR);
+    F64Vec_init(self, size);
+    if (size) {
+        memcpy(self->elems, values, size * sizeof(double));
+    }
+    self->size = size;
+    return self;
+}
+
+F64Vector*
+F64Vec_init(F64Vector *self, size_t capacity) {
+    if (capacity > SIZE_MAX / sizeof(double)) {
+        S_overflow_error();
+    }
+    self->size  = 0;
+    self->cap   = capacity;
+    self->elems = (double*)MALLOCATE(capacity * sizeof(double));
+    return self;
+}
+
+void
+F64Vec_Destroy_IMP(F64Vector *self) {
+    FREEMEM(self->elems);
+    SUPER_DESTROY(self, F64VECTOR);
+}
+
+F64Vector*
+F64Vec_Clone_IMP(F64Vector *self) {
+    return F64Vec_new_from_array(self->elems, self->size);
+}
+
+void
+F64Vec_Push_IMP(F64Vector *self, double value) {
+    if (self->size == self->cap) {
+        F64Vec_Grow(self, S_oversize(self->size + 1, sizeof(double)));
+    }
+    self->elems[self->size++] = value;
+}
+
+void
+F64Vec_Grow_IMP(F64Vector *self, size_t capacity) {
+    if (capacity > self->cap) {
+        if (capacity > SIZE_MAX / sizeof(double)) {
+            S_overflow_error();
+        }
+        self->elems = (double*)REALLOCATE(self->elems,
+                                           capacity * sizeof(double));
+        self->cap   = capacity;
+    }
+}
+
+double
+F64Vec_Fetch_IMP(F64Vector *self, size_t tick) {
+    if (tick >= self->size) {
+        THROW(ERR, "Index %u64 out of bounds (size %u64)", (uint64_t)tick,
+              (uint64_t)self->size);
+    }
+    return self->elems[tick];
+}
+
+void
+F64Vec_Store_IMP(F64Vector *self, size_t tick, double value) {
+    if (tick >= self->size) {
+        if (tick == SIZE_MAX) { S_overflow_error(); }
+        F64Vec_Resize(self, tick + 1);
+    }
+    self->elems[tick] = value;
+}
+
+void
+F64Vec_Resize_IMP(F64Vector *self, size_t size) {
+    if (size > self->size) {
+        if (size > self->cap) {
+            F64Vec_Grow(self, S_oversize(size, sizeof(double)));
+        }
+        memset(self->elems + self->size, 0,
+               (size - self->size) * sizeof(double));
+    }
+    self->size = size;
+}
+
+void
+F64Vec_Clear_IMP(F64Vector *self) {
+    self->size = 0;
+}
+
+static void
+S_sort_f64(F64Vector *self, ThreadPool *pool) {
+    if (self->size >= RADIX_SORT_THRESHOLD) {
+        double *scratch = (double*)MALLOCATE(self->size * sizeof(double));
+        Sort_radixsort_f64(self->elems, scratch, self->size, pool);
+        FREEMEM(scratch);
+    }
+    else {
+        Sort_quicksort(self->elems, self->size, sizeof(double),
+                       S_compare_f64, NULL);
+    }
+}
+
+void
+F64Vec_Sort_IMP(F64Vector *self) {
+    S_sort_f64(self, NULL);
+}
+
+void
+F64Vec_Sort_Parallel_IMP(F64Vector *self, ThreadPool *pool) {
+    S_sort_f64(self, pool);
+}
+
+F64Vector*
+F64Vec_Slice_IMP(F64Vector *self, size_t offset, size_t length) {
+    if (offset >= self->size) {
+        offset = 0;
+        length = 0;
+    }
+    else if (length > self->size - offset) {
+        length = self->size - offset;
+    }
+    return F64Vec_new_from_array(self->elems + offset, length);
+}
+
+size_t
+F64Vec_Get_Size_IMP(F64Vector *self) {
+    return self->size;
+}
+
+size_t
+F64Vec_Get_Capacity_IMP(F64Vector *self) {
+    return self->cap;
+}
+
+double*
+F64Vec_Get_Ptr_IMP(F64Vector *self) {
+    return self->elems;
+}
+
+bool
+F64Vec_Equals_IMP(F64Vector *self, Obj *other) {
+    F64Vector *twin = (F64Vector*)other;
+    if (twin == self)                { return true; }
+    if (!Obj_is_a(other, F64VECTOR)) { return false; }
+    if (twin->size != self->size)    { return false; }
+    // Compare bit patterns, so that NaNs equal themselves.
+    return memcmp(self->elems, twin->elems,
+                  self->size * sizeof(double)) == 0;
+}
+
+/**** Utility functions ***************************************************/
+
+static size_t
+S_oversize(size_t min_size, size_t width) {
+    // Oversize by 25%, but at least four elements.
+    size_t max_size = SIZE_MAX / width;
+    size_t extra    = min_size / 4;
+    if (extra < 4) { extra = 4; }
+    if (min_size > max_size)         { S_overflow_error(); }
+    if (extra > max_size - min_size) { return max_size; }
+    return min_size + extra;
+}
+
+static void
+S_overflow_error() {
+    THROW(ERR, "Numeric vector index overflow");
+}
+
+static int
+S_compare_i32(void *context, const void *va, const void *vb) {
+    int32_t a = *(const int32_t*)va;
+    int32_t b = *(const int32_t*)vb;
+    UNUSED_VAR(context);
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static int
+S_compare_i64(void *context, const void *va, const void *vb) {
+    int64_t a = *(const int64_t*)va;
+    int64_t b = *(const int64_t*)vb;
+    UNUSED_VAR(context);
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static int
+S_compare_f64(void *context, const void *va, const void *vb) {
+    double a = *(const double*)va;
+    double b = *(const double*)vb;
+    UNUSED_VAR(context);
+    if (a < b) { return -1; }
+    if (a > b) { return 1; }
+    if (a == b) {
+        // Negative zero sorts before positive zero, like in
+        // Sort_radixsort_f64.
+        uint64_t bits_a, bits_b;
+        memcpy(&bits_a, &a, sizeof(bits_a));
+        memcpy(&bits_b, &b, sizeof(bits_b));
+        return (int)(bits_b >> 63) - (int)(bits_a >> 63);
+    }
+    // At least one NaN.  NaNs sort to the back.
+    if (a != a) { return b != b ? 0 : 1; }
+    return -1;
+}
+
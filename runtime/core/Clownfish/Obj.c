@@ -39,21 +39,30 @@ Obj_init(Obj *self) {
 
 void
 Obj_Destroy_IMP(Obj *self) {
+    if (Class_census_enabled) {
+        Class *klass = self->klass;
+        Class_census_record(klass, -1, -(int64_t)klass->obj_alloc_size);
+    }
     FREEMEM(self);
 }
 
 bool
 Obj_is_a(Obj *self, Class *ancestor) {
-    Class *klass = self ? self->klass : NULL;
+    if (self == NULL || ancestor == NULL) { return false; }
 
-    while (klass != NULL) {
-        if (klass == ancestor) {
-            return true;
-        }
-        klass = klass->parent;
+    Class   *klass = self->klass;
+    uint32_t depth = ancestor->depth;
+    if (depth < CLASS_DISPLAY_SIZE) {
+        // Entries past the depth of `klass` are NULL.
+        return klass->display[depth] == ancestor;
     }
 
-    return false;
+    // Walk up to the depth of `ancestor`.
+    if (depth > klass->depth) { return false; }
+    for (uint32_t i = klass->depth; i > depth; i--) {
+        klass = klass->parent;
+    }
+    return klass == ancestor;
 }
 
 bool
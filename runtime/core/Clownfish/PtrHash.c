@@ -16,20 +16,16 @@
 
 #include <limits.h>
 #include <stddef.h>
+#include <string.h>
 
 #include "charmony.h"
 
 #define CFISH_USE_SHORT_NAMES
 #include "Clownfish/PtrHash.h"
 #include "Clownfish/Err.h"
+#include "Clownfish/Hash.h"
 #include "Clownfish/Util/Memory.h"
 
-#undef PTRHASH_STATS
-
-#ifdef PTRHASH_STATS
-  #include <stdio.h>
-#endif
-
 #if CHAR_BIT * CHY_SIZEOF_PTR <= 32
   #define PTR_BITS 32
 #else
@@ -49,6 +45,9 @@ struct PtrHash {
     int    shift;
     PtrHashEntry *entries;
     PtrHashEntry *end;
+#ifdef CFISH_HASH_STATS
+    HashStats stats;
+#endif
 };
 
 static CFISH_INLINE size_t
@@ -84,6 +83,9 @@ PtrHash_new(size_t min_cap) {
     self->shift     = shift;
     self->entries   = (PtrHashEntry*)CALLOCATE(size, sizeof(PtrHashEntry));
     self->end       = &self->entries[size];
+#ifdef CFISH_HASH_STATS
+    memset(&self->stats, 0, sizeof(HashStats));
+#endif
 
     return self;
 }
@@ -119,28 +121,45 @@ PtrHash_Store(PtrHash *self, void *key, void *value) {
 
     size_t index = SI_find_index(key, self->shift);
     PtrHashEntry *entry = &self->entries[index];
+#ifdef CFISH_HASH_STATS
+    size_t num_probes = 1;
+#endif
 
     while (entry->key != NULL) {
         if (entry->key == key) {
+            HASHSTATS_PROBES(&self->stats, HASHSTATS_PTRHASH, HASHSTATS_HIT,
+                             num_probes);
             entry->value = value;
             return;
         }
 
         entry += 1;
         if (entry >= self->end) { entry = self->entries; }
+#ifdef CFISH_HASH_STATS
+        num_probes++;
+#endif
     }
 
     if (self->num_items >= self->cap) {
         S_resize(self);
         index = SI_find_index(key, self->shift);
         entry = &self->entries[index];
+#ifdef CFISH_HASH_STATS
+        num_probes = 1;
+#endif
 
         while (entry->key != NULL) {
             entry += 1;
             if (entry >= self->end) { entry = self->entries; }
+#ifdef CFISH_HASH_STATS
+            num_probes++;
+#endif
         }
     }
 
+    HASHSTATS_PROBES(&self->stats, HASHSTATS_PTRHASH, HASHSTATS_INSERT,
+                     num_probes);
+
     entry->key   = key;
     entry->value = value;
     self->num_items += 1;
@@ -154,16 +173,26 @@ PtrHash_Fetch(PtrHash *self, void *key) {
 
     size_t index = SI_find_index(key, self->shift);
     PtrHashEntry *entry = &self->entries[index];
+#ifdef CFISH_HASH_STATS
+    size_t num_probes = 1;
+#endif
 
     while (entry->key != NULL) {
         if (entry->key == key) {
+            HASHSTATS_PROBES(&self->stats, HASHSTATS_PTRHASH, HASHSTATS_HIT,
+                             num_probes);
             return entry->value;
         }
 
         entry += 1;
         if (entry >= self->end) { entry = self->entries; }
+#ifdef CFISH_HASH_STATS
+        num_probes++;
+#endif
     }
 
+    HASHSTATS_PROBES(&self->stats, HASHSTATS_PTRHASH, HASHSTATS_MISS,
+                     num_probes);
     return NULL;
 }
 
@@ -180,9 +209,7 @@ S_resize(PtrHash *self) {
         = (PtrHashEntry*)CALLOCATE(size, sizeof(PtrHashEntry));
     PtrHashEntry *end = &entries[size];
 
-#ifdef PTRHASH_STATS
-    size_t extra_probes = 0;
-#endif
+    HASHSTATS_RESIZE_START(start_ns);
 
     for (PtrHashEntry *old_entry = self->entries;
          old_entry < self->end;
@@ -191,12 +218,6 @@ S_resize(PtrHash *self) {
         void *key = old_entry->key;
         if (key == NULL) { continue; }
 
-#ifdef PTRHASH_STATS
-        size_t i         = old_entry - self->entries;
-        size_t old_index = SI_find_index(key, self->shift);
-        extra_probes += (i - old_index) & (old_size - 1);
-#endif
-
         size_t index = SI_find_index(key, shift);
         PtrHashEntry *entry = &entries[index];
 
@@ -209,18 +230,44 @@ S_resize(PtrHash *self) {
         entry->value = old_entry->value;
     }
 
-#ifdef PTRHASH_STATS
-    fprintf(stderr, "size: %u, avg probes: %.2f\n",
-            (unsigned)old_size,
-            (double)extra_probes / self->num_items + 1.0);
-#endif
-
     FREEMEM(self->entries);
 
     self->cap     = SI_get_cap(size);
     self->shift   = shift;
     self->entries = entries;
     self->end     = end;
+
+    HASHSTATS_RESIZE_END(&self->stats, HASHSTATS_PTRHASH, start_ns);
+}
+
+bool
+PtrHash_Get_Stats(PtrHash *self, HashStats *stats) {
+    memset(stats, 0, sizeof(HashStats));
+#ifdef CFISH_HASH_STATS
+    *stats = self->stats;
+
+    // Find the longest cluster of occupied slots.  Clusters may wrap
+    // around, so start after an empty slot.
+    size_t size  = (size_t)(self->end - self->entries);
+    size_t start = 0;
+    while (start < size && self->entries[start].key) { start++; }
+    size_t run   = 0;
+    for (size_t i = 1; i <= size; i++) {
+        if (self->entries[(start + i) & (size - 1)].key) {
+            if (++run > stats->max_chain) { stats->max_chain = run; }
+        }
+        else {
+            run = 0;
+        }
+    }
+
+    stats->num_entries = self->num_items;
+    stats->capacity    = size;
+    return true;
+#else
+    UNUSED_VAR(self);
+    return false;
+#endif
 }
 
 
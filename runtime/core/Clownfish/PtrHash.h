@@ -20,6 +20,7 @@
 #include <stddef.h>
 
 #include "cfish_parcel.h"
+#include "Clownfish/Hash.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -39,12 +40,18 @@ CFISH_PtrHash_Store(cfish_PtrHash *self, void *key, void *value);
 CFISH_VISIBLE void*
 CFISH_PtrHash_Fetch(cfish_PtrHash *self, void *key);
 
+/** Fill in probe-length and load statistics, see Hash.h.
+ */
+CFISH_VISIBLE bool
+CFISH_PtrHash_Get_Stats(cfish_PtrHash *self, cfish_HashStats *stats);
+
 #ifdef CFISH_USE_SHORT_NAMES
   #define PtrHash           cfish_PtrHash
   #define PtrHash_new       cfish_PtrHash_new
   #define PtrHash_Destroy   CFISH_PtrHash_Destroy
   #define PtrHash_Store     CFISH_PtrHash_Store
   #define PtrHash_Fetch     CFISH_PtrHash_Fetch
+  #define PtrHash_Get_Stats CFISH_PtrHash_Get_Stats
 #endif
 
 #ifdef __cplusplus
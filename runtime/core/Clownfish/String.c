@@ -237,7 +237,8 @@ Str_init_from_trusted_utf8(String *self, const char *utf8, size_t size) {
     // Assign.
     self->ptr    = ptr;
     self->size   = size;
-    self->origin = self;
+    self->origin = (Obj*)self;
+    CENSUS_BYTES(self, size + 1);
 
     return self;
 }
@@ -259,7 +260,8 @@ String*
 Str_init_steal_trusted_utf8(String *self, char *utf8, size_t size) {
     self->ptr    = utf8;
     self->size   = size;
-    self->origin = self;
+    self->origin = (Obj*)self;
+    CENSUS_BYTES(self, size + 1);
     return self;
 }
 
@@ -290,6 +292,21 @@ Str_init_wrap_trusted_utf8(String *self, const char *ptr, size_t size) {
     return self;
 }
 
+String*
+Str_new_borrow_trusted_utf8(const char *utf8, size_t size, Obj *owner) {
+    String *self = (String*)Class_Make_Obj(STRING);
+    return Str_init_borrow_trusted_utf8(self, utf8, size, owner);
+}
+
+String*
+Str_init_borrow_trusted_utf8(String *self, const char *utf8, size_t size,
+                             Obj *owner) {
+    self->ptr    = utf8;
+    self->size   = size;
+    self->origin = INCREF(owner);
+    return self;
+}
+
 String*
 Str_new_from_char(int32_t code_point) {
     const size_t MAX_UTF8_BYTES = 4;
@@ -300,7 +317,8 @@ Str_new_from_char(int32_t code_point) {
     String *self = (String*)Class_Make_Obj(STRING);
     self->ptr    = ptr;
     self->size   = size;
-    self->origin = self;
+    self->origin = (Obj*)self;
+    CENSUS_BYTES(self, size + 1);
     return self;
 }
 
@@ -327,7 +345,7 @@ S_new_substring(String *string, size_t byte_offset, size_t size) {
     else {
         self->ptr    = string->ptr + byte_offset;
         self->size   = size;
-        self->origin = (String*)INCREF(string->origin);
+        self->origin = INCREF(string->origin);
     }
 
     return self;
@@ -340,7 +358,8 @@ Str_Is_Copy_On_IncRef_IMP(String *self) {
 
 void
 Str_Destroy_IMP(String *self) {
-    if (self->origin == self) {
+    if (self->origin == (Obj*)self) {
+        CENSUS_BYTES(self, -(int64_t)(self->size + 1));
         FREEMEM((char*)self->ptr);
     }
     else {
@@ -0,0 +1,403 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "charmony.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define C_CFISH_BENCHRUNNER
+#define CFISH_USE_SHORT_NAMES
+
+#include "Clownfish/TestHarness/BenchRunner.h"
+
+#include "Clownfish/Class.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/Hash.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Vector.h"
+#include "Clownfish/TestHarness/BenchBatch.h"
+#include "Clownfish/Util/Json.h"
+#include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/PerThread.h"
+#include "Clownfish/Util/SortUtils.h"
+#include "Clownfish/Util/Trace.h"
+
+#define MAX_OPS_PER_SAMPLE (UINT64_C(1) << 40)
+
+typedef struct {
+    uint64_t num_allocs;
+    uint64_t alloc_bytes;
+} AllocCounts;
+
+struct try_run_batch_context {
+    BenchRunner *runner;
+    BenchBatch  *batch;
+};
+
+static void
+S_try_run_batch(void *context);
+
+static uint64_t
+S_calibrate(BenchRunner *self, BenchRunner_Routine_t routine, void *context);
+
+static void
+S_count_alloc(void *context, size_t size);
+
+static void
+S_add_alloc_counts(void *dest, void *src);
+
+static void
+S_alloc_totals(AllocCounts *totals);
+
+static int
+S_compare_doubles(void *context, const void *va, const void *vb);
+
+static double
+S_median(const double *sorted, uint32_t count);
+
+static double
+S_number(Hash *hash, const char *key);
+
+static String*
+S_result_key(Hash *result);
+
+// Allocations are counted per thread, since the benchmarked routine may
+// allocate from several threads.
+static PerThread alloc_counts
+    = PERTHREAD_INIT(sizeof(AllocCounts), S_add_alloc_counts);
+
+BenchRunner*
+BenchRunner_new() {
+    BenchRunner *self = (BenchRunner*)Class_Make_Obj(BENCHRUNNER);
+    return BenchRunner_init(self);
+}
+
+BenchRunner*
+BenchRunner_init(BenchRunner *self) {
+    self->results            = Vec_new(0);
+    self->batch_name         = NULL;
+    self->sample_ns          = 2000000;
+    self->num_samples        = 31;
+    self->num_batches_failed = 0;
+
+    return self;
+}
+
+void
+BenchRunner_Destroy_IMP(BenchRunner *self) {
+    DECREF(self->results);
+    DECREF(self->batch_name);
+    SUPER_DESTROY(self, BENCHRUNNER);
+}
+
+void
+BenchRunner_Set_Num_Samples_IMP(BenchRunner *self, uint32_t num_samples) {
+    if (num_samples == 0) {
+        THROW(ERR, "Number of samples must be positive");
+    }
+    self->num_samples = num_samples;
+}
+
+void
+BenchRunner_Set_Sample_Time_IMP(BenchRunner *self, uint64_t sample_ns) {
+    if (sample_ns == 0) {
+        THROW(ERR, "Sample time must be positive");
+    }
+    self->sample_ns = sample_ns;
+}
+
+bool
+BenchRunner_Run_Batch_IMP(BenchRunner *self, BenchBatch *batch) {
+    String *class_name = BenchBatch_get_class_name(batch);
+    DECREF(self->batch_name);
+    self->batch_name = Str_Clone(class_name);
+
+    char *utf8 = Str_To_Utf8(class_name);
+    printf("Running %s...\n", utf8);
+    FREEMEM(utf8);
+
+    struct try_run_batch_context args;
+    args.runner = self;
+    args.batch  = batch;
+    Err *err = Err_trap(S_try_run_batch, &args);
+
+    DECREF(self->batch_name);
+    self->batch_name = NULL;
+
+    if (err) {
+        // The batch may have thrown while allocations were counted.
+        Memory_set_alloc_hook(NULL, NULL);
+        self->num_batches_failed += 1;
+        String *mess = Err_Get_Mess(err);
+        Err_warn_mess((String*)INCREF(mess));
+        DECREF(err);
+        return false;
+    }
+
+    return true;
+}
+
+static void
+S_try_run_batch(void *context) {
+    struct try_run_batch_context *args
+        = (struct try_run_batch_context*)context;
+    BenchBatch_Run(args->batch, args->runner);
+}
+
+void
+BenchRunner_Bench_IMP(BenchRunner *self, const char *name,
+                      BenchRunner_Routine_t routine, void *context) {
+    if (self->batch_name == NULL) {
+        THROW(ERR, "Bench must be called from a running batch");
+    }
+
+    // Calibrate and warm up.
+    uint64_t num_ops = S_calibrate(self, routine, context);
+    routine(context, num_ops);
+
+    uint32_t  num_samples = self->num_samples;
+    double   *times = (double*)MALLOCATE(num_samples * sizeof(double));
+    for (uint32_t i = 0; i < num_samples; i++) {
+        uint64_t start = Trace_time_ns();
+        routine(context, num_ops);
+        uint64_t elapsed = Trace_time_ns() - start;
+        times[i] = (double)elapsed / (double)num_ops;
+    }
+
+    Sort_quicksort(times, num_samples, sizeof(double), S_compare_doubles,
+                   NULL);
+    double   median   = S_median(times, num_samples);
+    uint32_t p99_tick = (uint32_t)ceil(num_samples * 0.99) - 1;
+    double   p99      = times[p99_tick];
+    for (uint32_t i = 0; i < num_samples; i++) {
+        times[i] = fabs(times[i] - median);
+    }
+    Sort_quicksort(times, num_samples, sizeof(double), S_compare_doubles,
+                   NULL);
+    double mad = S_median(times, num_samples);
+    FREEMEM(times);
+
+    // Count allocations in a separate run, so that the hook doesn't
+    // distort the timings.
+    AllocCounts before, after;
+    S_alloc_totals(&before);
+    Memory_set_alloc_hook(S_count_alloc, NULL);
+    routine(context, num_ops);
+    Memory_set_alloc_hook(NULL, NULL);
+    S_alloc_totals(&after);
+    double allocs_per_op = (double)(after.num_allocs - before.num_allocs)
+                           / (double)num_ops;
+    double bytes_per_op  = (double)(after.alloc_bytes - before.alloc_bytes)
+                           / (double)num_ops;
+
+    Hash *result = Hash_new(8);
+    Hash_Store_Utf8(result, "batch", 5, INCREF(self->batch_name));
+    Hash_Store_Utf8(result, "name", 4, (Obj*)Str_newf("%s", name));
+    Hash_Store_Utf8(result, "ops_per_sample", 14,
+                    (Obj*)Int_new((int64_t)num_ops));
+    Hash_Store_Utf8(result, "median_ns", 9, (Obj*)Float_new(median));
+    Hash_Store_Utf8(result, "p99_ns", 6, (Obj*)Float_new(p99));
+    Hash_Store_Utf8(result, "mad_ns", 6, (Obj*)Float_new(mad));
+    Hash_Store_Utf8(result, "allocs_per_op", 13,
+                    (Obj*)Float_new(allocs_per_op));
+    Hash_Store_Utf8(result, "bytes_per_op", 12,
+                    (Obj*)Float_new(bytes_per_op));
+    Vec_Push(self->results, (Obj*)result);
+
+    printf("  %-30s %10.1f ns/op  p99 %10.1f  MAD %8.1f  %7.2f allocs/op"
+           "  %9.1f B/op\n",
+           name, median, p99, mad, allocs_per_op, bytes_per_op);
+}
+
+static uint64_t
+S_calibrate(BenchRunner *self, BenchRunner_Routine_t routine,
+            void *context) {
+    uint64_t target  = self->sample_ns;
+    uint64_t num_ops = 1;
+
+    while (1) {
+        uint64_t start = Trace_time_ns();
+        routine(context, num_ops);
+        uint64_t elapsed = Trace_time_ns() - start;
+
+        if (elapsed >= target / 4 || num_ops >= MAX_OPS_PER_SAMPLE) {
+            if (elapsed == 0) {
+                elapsed = 1;
+            }
+            double scaled = (double)num_ops * (double)target / (double)elapsed;
+            if (scaled < 1.0) {
+                return 1;
+            }
+            if (scaled > (double)MAX_OPS_PER_SAMPLE) {
+                return MAX_OPS_PER_SAMPLE;
+            }
+            return (uint64_t)scaled;
+        }
+
+        // Grow fast while the runs are much too short.
+        num_ops *= elapsed < target / 100 ? 10 : 2;
+    }
+}
+
+static void
+S_count_alloc(void *context, size_t size) {
+    UNUSED_VAR(context);
+    AllocCounts *counts = (AllocCounts*)PerThread_get_block(&alloc_counts);
+    counts->num_allocs  += 1;
+    counts->alloc_bytes += size;
+}
+
+static void
+S_add_alloc_counts(void *dest, void *src) {
+    AllocCounts *totals = (AllocCounts*)dest;
+    AllocCounts *counts = (AllocCounts*)src;
+    totals->num_allocs  += counts->num_allocs;
+    totals->alloc_bytes += counts->alloc_bytes;
+}
+
+static void
+S_alloc_totals(AllocCounts *totals) {
+    memset(totals, 0, sizeof(AllocCounts));
+    PerThread_lock(&alloc_counts);
+    PerThread_each(&alloc_counts, S_add_alloc_counts, totals);
+    PerThread_unlock(&alloc_counts);
+}
+
+static int
+S_compare_doubles(void *context, const void *va, const void *vb) {
+    UNUSED_VAR(context);
+    double a = *(const double*)va;
+    double b = *(const double*)vb;
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static double
+S_median(const double *sorted, uint32_t count) {
+    uint32_t mid = count / 2;
+    return count % 2 ? sorted[mid] : (sorted[mid-1] + sorted[mid]) / 2.0;
+}
+
+Vector*
+BenchRunner_Get_Results_IMP(BenchRunner *self) {
+    return self->results;
+}
+
+String*
+BenchRunner_To_Json_IMP(BenchRunner *self) {
+    Hash *dump = Hash_new(1);
+    Hash_Store_Utf8(dump, "benchmarks", 10, INCREF(self->results));
+    String *json = Json_encode((Obj*)dump);
+    DECREF(dump);
+    return json;
+}
+
+bool
+BenchRunner_Compare_IMP(BenchRunner *self, String *baseline,
+                        double threshold) {
+    Obj *dump = Json_decode(baseline);
+    Vector *entries = NULL;
+    if (dump && Obj_is_a(dump, HASH)) {
+        entries = (Vector*)Hash_Fetch_Utf8((Hash*)dump, "benchmarks", 10);
+    }
+    if (!entries || !Obj_is_a((Obj*)entries, VECTOR)) {
+        DECREF(dump);
+        THROW(ERR, "Baseline has no 'benchmarks' array");
+    }
+
+    // Map "batch/name" to the median of the baseline.
+    size_t num_entries = Vec_Get_Size(entries);
+    Hash *medians = Hash_new(num_entries);
+    for (size_t i = 0; i < num_entries; i++) {
+        Hash *entry = (Hash*)Vec_Fetch(entries, i);
+        if (!entry || !Obj_is_a((Obj*)entry, HASH)) {
+            continue;
+        }
+        String *key = S_result_key(entry);
+        if (key) {
+            double median = S_number(entry, "median_ns");
+            Hash_Store(medians, key, (Obj*)Float_new(median));
+            DECREF(key);
+        }
+    }
+    DECREF(dump);
+
+    printf("Comparing with baseline (threshold %.1f%%)...\n",
+           threshold * 100.0);
+
+    bool   success     = true;
+    size_t num_results = Vec_Get_Size(self->results);
+    for (size_t i = 0; i < num_results; i++) {
+        Hash   *result = (Hash*)Vec_Fetch(self->results, i);
+        String *key    = S_result_key(result);
+        char   *utf8   = Str_To_Utf8(key);
+        Float  *old    = (Float*)Hash_Fetch(medians, key);
+        double  now    = S_number(result, "median_ns");
+
+        if (old == NULL) {
+            printf("  %-50s %10.1f ns/op  (new)\n", utf8, now);
+        }
+        else {
+            double before = Float_Get_Value(old);
+            double change = before > 0.0 ? now / before - 1.0 : 0.0;
+            bool   regressed = change > threshold;
+            if (regressed) {
+                success = false;
+            }
+            printf("  %-50s %10.1f -> %10.1f ns/op  %+7.1f%%%s\n", utf8,
+                   before, now, change * 100.0,
+                   regressed ? "  REGRESSION" : "");
+        }
+
+        FREEMEM(utf8);
+        DECREF(key);
+    }
+
+    DECREF(medians);
+    return success;
+}
+
+static double
+S_number(Hash *hash, const char *key) {
+    Obj *value = Hash_Fetch_Utf8(hash, key, strlen(key));
+    if (value && Obj_is_a(value, FLOAT)) {
+        return Float_Get_Value((Float*)value);
+    }
+    if (value && Obj_is_a(value, INTEGER)) {
+        return (double)Int_Get_Value((Integer*)value);
+    }
+    return 0.0;
+}
+
+static String*
+S_result_key(Hash *result) {
+    Obj *batch = Hash_Fetch_Utf8(result, "batch", 5);
+    Obj *name  = Hash_Fetch_Utf8(result, "name", 4);
+    if (!batch || !name
+        || !Obj_is_a(batch, STRING) || !Obj_is_a(name, STRING)
+       ) {
+        return NULL;
+    }
+    return Str_newf("%o/%o", batch, name);
+}
+
+uint32_t
+BenchRunner_Get_Num_Batches_Failed_IMP(BenchRunner *self) {
+    return self->num_batches_failed;
+}
+
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <stdarg.h>
 #include <stdio.h>
 
 #define C_CFISH_TESTFORMATTER
@@ -21,6 +22,7 @@
 
 #include "Clownfish/TestHarness/TestFormatter.h"
 
+#include "Clownfish/ByteBuf.h"
 #include "Clownfish/String.h"
 #include "Clownfish/Err.h"
 #include "Clownfish/TestHarness/TestBatch.h"
@@ -28,12 +30,74 @@
 #include "Clownfish/Util/Memory.h"
 #include "Clownfish/Class.h"
 
+static void
+S_printf(void *vself, const char *fmt, ...);
+
+static void
+S_vprintf(void *vself, const char *fmt, va_list args);
+
 TestFormatter*
 TestFormatter_init(TestFormatter *self) {
     ABSTRACT_CLASS_CHECK(self, TESTFORMATTER);
+    self->buffer = NULL;
     return self;
 }
 
+void
+TestFormatter_Destroy_IMP(TestFormatter *self) {
+    DECREF(self->buffer);
+    SUPER_DESTROY(self, TESTFORMATTER);
+}
+
+TestFormatter*
+TestFormatter_Clone_Buffered_IMP(TestFormatter *self) {
+    Class *klass = TestFormatter_get_class(self);
+    TestFormatter *clone = (TestFormatter*)Class_Make_Obj(klass);
+    TestFormatter_init(clone);
+    clone->buffer = BB_new(1024);
+    return clone;
+}
+
+void
+TestFormatter_Flush_IMP(TestFormatter *self) {
+    if (self->buffer) {
+        fwrite(BB_Get_Buf(self->buffer), 1, BB_Get_Size(self->buffer),
+               stdout);
+        BB_Set_Size(self->buffer, 0);
+    }
+}
+
+// Print to stdout or append to the buffer.
+static void
+S_printf(void *vself, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    S_vprintf(vself, fmt, args);
+    va_end(args);
+}
+
+static void
+S_vprintf(void *vself, const char *fmt, va_list args) {
+    TestFormatter *self = (TestFormatter*)vself;
+    if (!self->buffer) {
+        vprintf(fmt, args);
+        return;
+    }
+
+    va_list args_copy;
+    va_copy(args_copy, args);
+    int len = vsnprintf(NULL, 0, fmt, args_copy);
+    va_end(args_copy);
+    if (len <= 0) {
+        return;
+    }
+
+    size_t size = BB_Get_Size(self->buffer);
+    char *buf = BB_Grow(self->buffer, size + (size_t)len + 1);
+    vsnprintf(buf + size, (size_t)len + 1, fmt, args);
+    BB_Set_Size(self->buffer, size + (size_t)len);
+}
+
 void
 TestFormatter_test_result(TestFormatter *self, bool pass, uint32_t test_num,
                           const char *fmt, ...) {
@@ -74,11 +138,10 @@ TestFormatterCF_init(TestFormatterCF *self) {
 void
 TestFormatterCF_Batch_Prologue_IMP(TestFormatterCF *self, TestBatch *batch,
                                    uint32_t num_planned) {
-    UNUSED_VAR(self);
     UNUSED_VAR(num_planned);
     String *class_name = TestBatch_get_class_name(batch);
     char *utf8 = Str_To_Utf8(class_name);
-    printf("Running %s...\n", utf8);
+    S_printf(self, "Running %s...\n", utf8);
     FREEMEM(utf8);
 }
 
@@ -86,11 +149,10 @@ void
 TestFormatterCF_VTest_Result_IMP(TestFormatterCF *self, bool pass,
                                  uint32_t test_num, const char *fmt,
                                  va_list args) {
-    UNUSED_VAR(self);
     if (!pass) {
-        printf("  Failed test %u: ", test_num);
-        vprintf(fmt, args);
-        printf("\n");
+        S_printf(self, "  Failed test %u: ", test_num);
+        S_vprintf(self, fmt, args);
+        S_printf(self, "\n");
     }
 }
 
@@ -108,22 +170,19 @@ TestFormatterCF_VTest_Skip_IMP(TestFormatterCF *self, uint32_t test_num,
 void
 TestFormatterCF_VTest_Comment_IMP(TestFormatterCF *self, const char *fmt,
                                   va_list args) {
-    UNUSED_VAR(self);
-    printf("    ");
-    vprintf(fmt, args);
+    S_printf(self, "    ");
+    S_vprintf(self, fmt, args);
 }
 
 void
 TestFormatterCF_VBatch_Comment_IMP(TestFormatterCF *self, const char *fmt,
                                    va_list args) {
-    UNUSED_VAR(self);
-    printf("  ");
-    vprintf(fmt, args);
+    S_printf(self, "  ");
+    S_vprintf(self, fmt, args);
 }
 
 void
 TestFormatterCF_Summary_IMP(TestFormatterCF *self, TestSuiteRunner *runner) {
-    UNUSED_VAR(self);
     uint32_t num_batches = TestSuiteRunner_Get_Num_Batches(runner);
     uint32_t num_batches_failed
         = TestSuiteRunner_Get_Num_Batches_Failed(runner);
@@ -131,17 +190,18 @@ TestFormatterCF_Summary_IMP(TestFormatterCF *self, TestSuiteRunner *runner) {
     uint32_t num_tests_failed = TestSuiteRunner_Get_Num_Tests_Failed(runner);
 
     if (num_batches == 0) {
-        printf("No tests planned or run.\n");
+        S_printf(self, "No tests planned or run.\n");
     }
     else if (num_batches_failed == 0) {
-        printf("%u batches passed. %u tests passed.\n", num_batches,
-               num_tests);
-        printf("Result: PASS\n");
+        S_printf(self, "%u batches passed. %u tests passed.\n",
+                 num_batches, num_tests);
+        S_printf(self, "Result: PASS\n");
     }
     else {
-        printf("%u/%u batches failed. %u/%u tests failed.\n",
-               num_batches_failed, num_batches, num_tests_failed, num_tests);
-        printf("Result: FAIL\n");
+        S_printf(self, "%u/%u batches failed. %u/%u tests failed.\n",
+                 num_batches_failed, num_batches, num_tests_failed,
+                 num_tests);
+        S_printf(self, "Result: FAIL\n");
     }
 }
 
@@ -160,48 +220,43 @@ TestFormatterTAP_init(TestFormatterTAP *self) {
 void
 TestFormatterTAP_Batch_Prologue_IMP(TestFormatterTAP *self, TestBatch *batch,
                                 uint32_t num_planned) {
-    UNUSED_VAR(self);
     UNUSED_VAR(batch);
-    printf("1..%u\n", num_planned);
+    S_printf(self, "1..%u\n", num_planned);
 }
 
 void
 TestFormatterTAP_VTest_Result_IMP(TestFormatterTAP *self, bool pass,
                                   uint32_t test_num, const char *fmt,
                                   va_list args) {
-    UNUSED_VAR(self);
     const char *result = pass ? "ok" : "not ok";
-    printf("%s %u - ", result, test_num);
-    vprintf(fmt, args);
-    printf("\n");
+    S_printf(self, "%s %u - ", result, test_num);
+    S_vprintf(self, fmt, args);
+    S_printf(self, "\n");
 }
 
 void
 TestFormatterTAP_VTest_Skip_IMP(TestFormatterTAP *self, uint32_t test_num,
                                 uint32_t num_skipped, const char *fmt,
                                 va_list args) {
-    UNUSED_VAR(self);
     for (uint32_t i = 0; i < num_skipped; ++i) {
-        printf("ok %u # SKIP ", test_num + i);
-        vprintf(fmt, args);
-        printf("\n");
+        S_printf(self, "ok %u # SKIP ", test_num + i);
+        S_vprintf(self, fmt, args);
+        S_printf(self, "\n");
     }
 }
 
 void
 TestFormatterTAP_VTest_Comment_IMP(TestFormatterTAP *self, const char *fmt,
                                    va_list args) {
-    UNUSED_VAR(self);
-    printf("#   ");
-    vprintf(fmt, args);
+    S_printf(self, "#   ");
+    S_vprintf(self, fmt, args);
 }
 
 void
 TestFormatterTAP_VBatch_Comment_IMP(TestFormatterTAP *self, const char *fmt,
                                     va_list args) {
-    UNUSED_VAR(self);
-    printf("# ");
-    vprintf(fmt, args);
+    S_printf(self, "# ");
+    S_vprintf(self, fmt, args);
 }
 
 void
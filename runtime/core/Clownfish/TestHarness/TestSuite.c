@@ -97,6 +97,20 @@ TestSuite_Run_All_Batches_IMP(TestSuite *self, TestFormatter *formatter) {
     return result;
 }
 
+bool
+TestSuite_Run_All_Batches_Parallel_IMP(TestSuite *self,
+                                       TestFormatter *formatter,
+                                       uint32_t num_threads) {
+    S_unbuffer_stdout();
+
+    TestSuiteRunner *runner = TestSuiteRunner_new(formatter);
+    TestSuiteRunner_Run_Batches(runner, self->batches, num_threads);
+    bool result = TestSuiteRunner_Finish(runner);
+
+    DECREF(runner);
+    return result;
+}
+
 static void
 S_unbuffer_stdout() {
     int check_val = setvbuf(stdout, NULL, _IONBF, 0);
@@ -23,8 +23,26 @@
 #include "Clownfish/TestHarness/TestBatch.h"
 #include "Clownfish/TestHarness/TestBatchRunner.h"
 #include "Clownfish/TestHarness/TestFormatter.h"
+#include "Clownfish/TestHarness/TestUtils.h"
+#include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/ThreadPool.h"
+#include "Clownfish/Vector.h"
 #include "Clownfish/Class.h"
 
+typedef struct {
+    TestBatch       *batch;
+    TestFormatter   *formatter;
+    TestBatchRunner *runner;
+    bool             success;
+} BatchJob;
+
+static void
+S_run_job(void *context);
+
+static void
+S_add_stats(TestSuiteRunner *self, TestBatchRunner *batch_runner,
+            bool success);
+
 TestSuiteRunner*
 TestSuiteRunner_new(TestFormatter *formatter) {
     TestSuiteRunner *self = (TestSuiteRunner*)Class_Make_Obj(TESTSUITERUNNER);
@@ -52,7 +70,81 @@ bool
 TestSuiteRunner_Run_Batch_IMP(TestSuiteRunner *self, TestBatch *batch) {
     TestBatchRunner *batch_runner = TestBatchRunner_new(self->formatter);
     bool success = TestBatchRunner_Run_Batch(batch_runner, batch);
+    S_add_stats(self, batch_runner, success);
+    DECREF(batch_runner);
+    return success;
+}
 
+bool
+TestSuiteRunner_Run_Batches_IMP(TestSuiteRunner *self, Vector *batches,
+                                uint32_t num_threads) {
+    size_t num_batches = Vec_Get_Size(batches);
+    bool   success     = true;
+
+    if (num_threads == 0) {
+        num_threads = ThreadPool_num_cpus();
+    }
+    if (num_threads <= 1 || !TestUtils_has_threads) {
+        for (size_t i = 0; i < num_batches; i++) {
+            TestBatch *batch = (TestBatch*)Vec_Fetch(batches, i);
+            if (!TestSuiteRunner_Run_Batch(self, batch)) {
+                success = false;
+            }
+        }
+        return success;
+    }
+
+    // Refcounts aren't atomic, so all objects shared with the workers are
+    // created here and every job gets its own formatter and runner.
+    BatchJob   *jobs  = (BatchJob*)CALLOCATE(num_batches, sizeof(BatchJob));
+    ThreadPool *pool  = ThreadPool_new(num_threads - 1);
+    TaskGroup  *group = TaskGroup_new(pool, false);
+    for (size_t i = 0; i < num_batches; i++) {
+        BatchJob *job = &jobs[i];
+        job->batch = (TestBatch*)Vec_Fetch(batches, i);
+        if (TestBatch_Is_Thread_Safe(job->batch)) {
+            job->formatter = TestFormatter_Clone_Buffered(self->formatter);
+            job->runner    = TestBatchRunner_new(job->formatter);
+        }
+    }
+    for (size_t i = 0; i < num_batches; i++) {
+        if (jobs[i].runner) {
+            TaskGroup_Run(group, S_run_job, &jobs[i]);
+        }
+    }
+    TaskGroup_Join(group);
+    DECREF(group);
+    DECREF(pool);
+
+    for (size_t i = 0; i < num_batches; i++) {
+        BatchJob *job = &jobs[i];
+        if (job->runner) {
+            TestFormatter_Flush(job->formatter);
+            S_add_stats(self, job->runner, job->success);
+            if (!job->success) {
+                success = false;
+            }
+            DECREF(job->runner);
+            DECREF(job->formatter);
+        }
+        else if (!TestSuiteRunner_Run_Batch(self, job->batch)) {
+            success = false;
+        }
+    }
+
+    FREEMEM(jobs);
+    return success;
+}
+
+static void
+S_run_job(void *context) {
+    BatchJob *job = (BatchJob*)context;
+    job->success = TestBatchRunner_Run_Batch(job->runner, job->batch);
+}
+
+static void
+S_add_stats(TestSuiteRunner *self, TestBatchRunner *batch_runner,
+            bool success) {
     self->num_tests        += TestBatchRunner_Get_Num_Tests(batch_runner);
     self->num_tests_failed += TestBatchRunner_Get_Num_Failed(batch_runner);
     self->num_batches      += 1;
@@ -60,9 +152,6 @@ TestSuiteRunner_Run_Batch_IMP(TestSuiteRunner *self, TestBatch *batch) {
     if (!success) {
         self->num_batches_failed += 1;
     }
-
-    DECREF(batch_runner);
-    return success;
 }
 
 bool
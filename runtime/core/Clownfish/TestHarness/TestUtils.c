@@ -27,6 +27,7 @@
 #include "Clownfish/Err.h"
 #include "Clownfish/String.h"
 #include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/Threads.h"
 
 uint64_t
 TestUtils_random_u64() {
@@ -183,82 +184,20 @@ TestUtils_usleep(uint64_t microseconds) {
 #endif // OS switch.
 
 
-/********************************** Windows ********************************/
-#if !defined(CFISH_NOTHREADS) && defined(CHY_HAS_WINDOWS_H)
-
-#include <windows.h>
-
 struct Thread {
-    HANDLE            handle;
-    void             *runtime;
-    thread_routine_t  routine;
-    void             *arg;
-};
-
-bool TestUtils_has_threads = true;
-
-static DWORD __stdcall
-S_thread(void *arg) {
-    Thread *thread = (Thread*)arg;
-
-    if (thread->runtime) {
-        TestUtils_set_host_runtime(thread->runtime);
-    }
-
-    thread->routine(thread->arg);
-
-    return 0;
-}
-
-Thread*
-TestUtils_thread_create(thread_routine_t routine, void *arg,
-                        void *host_runtime) {
-    Thread *thread = (Thread*)MALLOCATE(sizeof(Thread));
-    thread->runtime = host_runtime;
-    thread->routine = routine;
-    thread->arg     = arg;
-
-    thread->handle = CreateThread(NULL, 0, S_thread, thread, 0, NULL);
-    if (thread->handle == NULL) {
-        FREEMEM(thread);
-        THROW(ERR, "CreateThread failed: %s", Err_win_error());
-    }
-
-    return thread;
-}
-
-void
-TestUtils_thread_yield() {
-    SwitchToThread();
-}
-
-void
-TestUtils_thread_join(Thread *thread) {
-    DWORD event = WaitForSingleObject(thread->handle, INFINITE);
-    FREEMEM(thread);
-    if (event != WAIT_OBJECT_0) {
-        THROW(ERR, "WaitForSingleObject failed: %s", Err_win_error());
-    }
-}
-
-/******************************** pthreads *********************************/
-#elif !defined(CFISH_NOTHREADS) \
-      && defined(CHY_HAS_PTHREAD_H) \
-      && defined(CHY_HAS_SCHED_H)
-
-#include <pthread.h>
-#include <sched.h>
-
-struct Thread {
-    pthread_t         pthread;
+    NativeThread      native;
     void             *runtime;
     thread_routine_t  routine;
     void             *arg;
 };
 
+#ifdef CFISH_HAS_THREADS
 bool TestUtils_has_threads = true;
+#else
+bool TestUtils_has_threads = false;
+#endif
 
-static void*
+static void
 S_thread(void *arg) {
     Thread *thread = (Thread*)arg;
 
@@ -267,8 +206,6 @@ S_thread(void *arg) {
     }
 
     thread->routine(thread->arg);
-
-    return NULL;
 }
 
 Thread*
@@ -279,10 +216,9 @@ TestUtils_thread_create(thread_routine_t routine, void *arg,
     thread->routine = routine;
     thread->arg     = arg;
 
-    int err = pthread_create(&thread->pthread, NULL, S_thread, thread);
-    if (err != 0) {
+    if (!NativeThread_start(&thread->native, S_thread, thread)) {
         FREEMEM(thread);
-        THROW(ERR, "pthread_create failed: %s", strerror(err));
+        THROW(ERR, "Can't create thread");
     }
 
     return thread;
@@ -290,43 +226,12 @@ TestUtils_thread_create(thread_routine_t routine, void *arg,
 
 void
 TestUtils_thread_yield() {
-    sched_yield();
+    Threads_yield();
 }
 
 void
 TestUtils_thread_join(Thread *thread) {
-    int err = pthread_join(thread->pthread, NULL);
+    NativeThread_join(&thread->native);
     FREEMEM(thread);
-    if (err != 0) {
-        THROW(ERR, "pthread_create failed: %s", strerror(err));
-    }
-}
-
-/**************************** No thread support ****************************/
-#else
-
-bool TestUtils_has_threads = false;
-
-Thread*
-TestUtils_thread_create(thread_routine_t routine, void *arg,
-                        void *host_runtime) {
-    UNUSED_VAR(routine);
-    UNUSED_VAR(arg);
-    UNUSED_VAR(host_runtime);
-    THROW(ERR, "No thread support");
-    UNREACHABLE_RETURN(Thread*);
-}
-
-void
-TestUtils_thread_yield() {
 }
 
-void
-TestUtils_thread_join(Thread *thread) {
-    UNUSED_VAR(thread);
-    THROW(ERR, "No thread support");
-}
-
-#endif
-
-
@@ -32,6 +32,12 @@ cfish_Atomic_wrapped_cas_ptr(void *volatile *target, void *old_value,
            == old_value;
 }
 
+void*
+cfish_Atomic_wrapped_load_ptr(void *volatile *target) {
+    // Interlocked functions imply a full barrier.
+    return InterlockedCompareExchangePointer(target, NULL, NULL);
+}
+
 /************************** Fall back to ptheads ***************************/
 #elif defined(CHY_HAS_PTHREAD_H)
 
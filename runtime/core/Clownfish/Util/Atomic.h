@@ -31,6 +31,13 @@ extern "C" {
 static CFISH_INLINE bool
 cfish_Atomic_cas_ptr(void *volatile *target, void *old_value, void *new_value);
 
+/** Load a pointer with acquire semantics.  Memory written by another thread
+ * before it stored the pointer with cfish_Atomic_cas_ptr is visible once the
+ * new pointer has been loaded.
+ */
+static CFISH_INLINE void*
+cfish_Atomic_load_ptr(void *volatile *target);
+
 /************************** Single threaded *******************************/
 #ifdef CFISH_NOTHREADS
 
@@ -45,6 +52,11 @@ cfish_Atomic_cas_ptr(void *volatile *target, void *old_value, void *new_value) {
     }
 }
 
+static CFISH_INLINE void*
+cfish_Atomic_load_ptr(void *volatile *target) {
+    return *target;
+}
+
 /************************** Mac OS X 10.4 and later ***********************/
 #elif defined(CHY_HAS_OSATOMIC_CAS_PTR)
 #include <libkern/OSAtomic.h>
@@ -54,6 +66,13 @@ cfish_Atomic_cas_ptr(void *volatile *target, void *old_value, void *new_value) {
     return OSAtomicCompareAndSwapPtr(old_value, new_value, target);
 }
 
+static CFISH_INLINE void*
+cfish_Atomic_load_ptr(void *volatile *target) {
+    void *value = *target;
+    OSMemoryBarrier();
+    return value;
+}
+
 /********************************** Windows *******************************/
 #elif defined(CHY_HAS_WINDOWS_H)
 
@@ -66,6 +85,14 @@ cfish_Atomic_cas_ptr(void *volatile *target, void *old_value, void *new_value) {
     return cfish_Atomic_wrapped_cas_ptr(target, old_value, new_value);
 }
 
+CFISH_VISIBLE void*
+cfish_Atomic_wrapped_load_ptr(void *volatile *target);
+
+static CFISH_INLINE void*
+cfish_Atomic_load_ptr(void *volatile *target) {
+    return cfish_Atomic_wrapped_load_ptr(target);
+}
+
 /**************************** Solaris 10 and later ************************/
 #elif defined(CHY_HAS_SYS_ATOMIC_H)
 #include <sys/atomic.h>
@@ -75,6 +102,13 @@ cfish_Atomic_cas_ptr(void *volatile *target, void *old_value, void *new_value) {
     return atomic_cas_ptr(target, old_value, new_value) == old_value;
 }
 
+static CFISH_INLINE void*
+cfish_Atomic_load_ptr(void *volatile *target) {
+    void *value = *target;
+    membar_consumer();
+    return value;
+}
+
 /****************************** GCC 4.1 and later *************************/
 #elif defined(CHY_HAS___SYNC_BOOL_COMPARE_AND_SWAP)
 
@@ -83,6 +117,17 @@ cfish_Atomic_cas_ptr(void *volatile *target, void *old_value, void *new_value) {
     return __sync_bool_compare_and_swap(target, old_value, new_value);
 }
 
+static CFISH_INLINE void*
+cfish_Atomic_load_ptr(void *volatile *target) {
+#ifdef __ATOMIC_ACQUIRE
+    return __atomic_load_n(target, __ATOMIC_ACQUIRE);
+#else
+    void *value = *target;
+    __sync_synchronize();
+    return value;
+#endif
+}
+
 /************************ Fall back to pthread.h. **************************/
 #elif defined(CHY_HAS_PTHREAD_H)
 #include <pthread.h>
@@ -103,6 +148,14 @@ cfish_Atomic_cas_ptr(void *volatile *target, void *old_value, void *new_value) {
     }
 }
 
+static CFISH_INLINE void*
+cfish_Atomic_load_ptr(void *volatile *target) {
+    pthread_mutex_lock(&cfish_Atomic_mutex);
+    void *value = *target;
+    pthread_mutex_unlock(&cfish_Atomic_mutex);
+    return value;
+}
+
 /******************** No support for atomics at all. ***********************/
 #else
 
@@ -112,6 +165,7 @@ cfish_Atomic_cas_ptr(void *volatile *target, void *old_value, void *new_value) {
 
 #ifdef CFISH_USE_SHORT_NAMES
   #define Atomic_cas_ptr cfish_Atomic_cas_ptr
+  #define Atomic_load_ptr cfish_Atomic_load_ptr
 #endif
 
 #ifdef __cplusplus
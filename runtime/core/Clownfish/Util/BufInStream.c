@@ -0,0 +1,439 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_CFISH_BUFINSTREAM
+#define C_CFISH_BYTEBUF
+#define CFISH_USE_SHORT_NAMES
+
+#include <errno.h>
+#include <string.h>
+
+#include "charmony.h"
+
+#include "Clownfish/Util/BufInStream.h"
+#include "Clownfish/Blob.h"
+#include "Clownfish/ByteBuf.h"
+#include "Clownfish/Class.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Util/Memory.h"
+
+#if defined(CHY_HAS_UNISTD_H) && defined(CHY_HAS_FCNTL_H)
+  #include <sys/types.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+  #define S_open_rdonly(path)   open(path, O_RDONLY)
+  #define S_close               close
+  typedef struct stat           FileStat;
+  #define S_fstat               fstat
+#else
+  #include <io.h>
+  #include <fcntl.h>
+  #include <sys/types.h>
+  #include <sys/stat.h>
+  #define S_open_rdonly(path)   _open(path, _O_RDONLY | _O_BINARY)
+  #define S_close               _close
+  typedef struct _stati64       FileStat;
+  #define S_fstat               _fstati64
+#endif
+
+#define IO_BUF_SIZE      65536
+#define MIN_READ_AHEAD   4096
+
+static int64_t
+S_pread(int fd, char *buf, size_t len, int64_t offset) {
+#if defined(CHY_HAS_UNISTD_H)
+    ssize_t check = pread(fd, buf, len, (off_t)offset);
+    return (int64_t)check;
+#else
+    if (_lseeki64(fd, offset, SEEK_SET) < 0) { return -1; }
+    if (len > INT32_MAX) { len = INT32_MAX; }
+    return _read(fd, buf, (unsigned)len);
+#endif
+}
+
+// Read exactly `len` bytes at `offset`, retrying after short reads.
+static void
+S_read_fully(BufInStream *self, char *buf, size_t len, int64_t offset) {
+    while (len > 0) {
+        int64_t check = S_pread(self->fd, buf, len, offset);
+        if (check < 0) {
+            if (errno == EINTR) { continue; }
+            THROW(ERR, "Read of %u64 bytes at %i64 failed: %s",
+                  (uint64_t)len, offset, strerror(errno));
+        }
+        if (check == 0) {
+            THROW(ERR, "Unexpected end of file at %i64", offset);
+        }
+        buf    += check;
+        len    -= (size_t)check;
+        offset += check;
+    }
+}
+
+BufInStream*
+BufIn_open(String *path) {
+    char *path_utf8 = Str_To_Utf8(path);
+    int fd = S_open_rdonly(path_utf8);
+    FREEMEM(path_utf8);
+    if (fd < 0) {
+        THROW(ERR, "Can't open '%o': %s", path, strerror(errno));
+    }
+    BufInStream *self = (BufInStream*)Class_Make_Obj(BUFINSTREAM);
+    return BufIn_init_fd(self, fd, true, 0);
+}
+
+BufInStream*
+BufIn_open_mmap(String *path) {
+    Blob *blob = Blob_new_mmap(path, 0, -1);
+    BufInStream *self = BufIn_new_blob(blob);
+    DECREF(blob);
+    return self;
+}
+
+BufInStream*
+BufIn_new_fd(int fd, size_t buf_size) {
+    BufInStream *self = (BufInStream*)Class_Make_Obj(BUFINSTREAM);
+    return BufIn_init_fd(self, fd, false, buf_size);
+}
+
+BufInStream*
+BufIn_new_blob(Blob *blob) {
+    BufInStream *self = (BufInStream*)Class_Make_Obj(BUFINSTREAM);
+    return BufIn_init_blob(self, blob);
+}
+
+BufInStream*
+BufIn_init_fd(BufInStream *self, int fd, bool owns_fd, size_t buf_size) {
+    self->fd      = fd;
+    self->owns_fd = owns_fd;
+
+    FileStat stat_buf;
+    if (S_fstat(fd, &stat_buf) != 0) {
+        int error = errno;
+        DECREF(self);
+        THROW(ERR, "Can't stat file descriptor %i32: %s", (int32_t)fd,
+              strerror(error));
+    }
+
+    self->buffer     = BB_new(buf_size ? buf_size : IO_BUF_SIZE);
+    self->blob       = NULL;
+    self->window     = self->buffer->buf;
+    self->cur        = self->window;
+    self->limit      = self->window;
+    self->window_pos = 0;
+    self->len        = (int64_t)stat_buf.st_size;
+    self->read_ahead = self->buffer->cap;
+
+    return self;
+}
+
+BufInStream*
+BufIn_init_blob(BufInStream *self, Blob *blob) {
+    self->fd         = -1;
+    self->owns_fd    = false;
+    self->buffer     = NULL;
+    self->blob       = (Blob*)INCREF(blob);
+    self->window     = Blob_Get_Buf(blob);
+    self->cur        = self->window;
+    self->limit      = self->window + Blob_Get_Size(blob);
+    self->window_pos = 0;
+    self->len        = (int64_t)Blob_Get_Size(blob);
+    return self;
+}
+
+void
+BufIn_Close_IMP(BufInStream *self) {
+    if (self->owns_fd && self->fd >= 0) {
+        if (S_close(self->fd) != 0) {
+            THROW(ERR, "Close failed: %s", strerror(errno));
+        }
+    }
+    self->fd = -1;
+    DECREF(self->buffer);
+    DECREF(self->blob);
+    self->buffer     = NULL;
+    self->blob       = NULL;
+    self->window     = NULL;
+    self->cur        = NULL;
+    self->limit      = NULL;
+    self->window_pos = 0;
+    self->len        = 0;
+}
+
+void
+BufIn_Destroy_IMP(BufInStream *self) {
+    if (self->owns_fd && self->fd >= 0) {
+        S_close(self->fd);
+    }
+    DECREF(self->buffer);
+    DECREF(self->blob);
+    SUPER_DESTROY(self, BUFINSTREAM);
+}
+
+int64_t
+BufIn_Tell_IMP(BufInStream *self) {
+    return self->window_pos + (self->cur - self->window);
+}
+
+int64_t
+BufIn_Length_IMP(BufInStream *self) {
+    return self->len;
+}
+
+void
+BufIn_Seek_IMP(BufInStream *self, int64_t target) {
+    if (target < 0 || target > self->len) {
+        THROW(ERR, "Can't seek to %i64, length is %i64", target, self->len);
+    }
+    int64_t offset = target - self->window_pos;
+    if (offset >= 0 && offset <= self->limit - self->window) {
+        self->cur = self->window + offset;
+    }
+    else {
+        // Invalidate the buffer.  It's refilled on the next read, with a
+        // small read in case access is random.
+        self->window_pos = target;
+        self->cur        = self->window;
+        self->limit      = self->window;
+        self->read_ahead = MIN_READ_AHEAD;
+    }
+}
+
+// Make at least `min` bytes available in the window.
+static void
+S_refill(BufInStream *self, size_t min) {
+    int64_t pos       = BufIn_Tell_IMP(self);
+    int64_t remaining = self->len - pos;
+    if ((int64_t)min > remaining || self->buffer == NULL) {
+        THROW(ERR, "Read past EOF: %u64 bytes at %i64, length is %i64",
+              (uint64_t)min, pos, self->len);
+    }
+
+    size_t cap    = self->buffer->cap;
+    size_t amount = self->read_ahead > min ? self->read_ahead : min;
+    if (amount > cap)                 { amount = cap; }
+    if ((int64_t)amount > remaining) { amount = (size_t)remaining; }
+    S_read_fully(self, self->buffer->buf, amount, pos);
+    self->read_ahead = self->read_ahead <= cap / 2
+                       ? self->read_ahead * 2
+                       : cap;
+    self->window     = self->buffer->buf;
+    self->cur        = self->window;
+    self->limit      = self->window + amount;
+    self->window_pos = pos;
+}
+
+// Copy `len` bytes, refilling the buffer or reading past it as needed.
+static void
+S_read_slow(BufInStream *self, char *buf, size_t len) {
+    size_t available = (size_t)(self->limit - self->cur);
+    if (available > 0) {
+        memcpy(buf, self->cur, available);
+        self->cur += available;
+        buf       += available;
+        len       -= available;
+    }
+
+    if (self->buffer == NULL || len < self->buffer->cap) {
+        S_refill(self, len);
+        memcpy(buf, self->cur, len);
+        self->cur += len;
+    }
+    else {
+        // Read large chunks directly into the destination.
+        int64_t pos = BufIn_Tell_IMP(self);
+        if ((int64_t)len > self->len - pos) {
+            THROW(ERR, "Read past EOF: %u64 bytes at %i64, length is %i64",
+                  (uint64_t)len, pos, self->len);
+        }
+        S_read_fully(self, buf, len, pos);
+        self->window_pos = pos + (int64_t)len;
+        self->cur        = self->window;
+        self->limit      = self->window;
+    }
+}
+
+static CFISH_INLINE void
+SI_read_bytes(BufInStream *self, char *buf, size_t len) {
+    if ((size_t)(self->limit - self->cur) >= len) {
+        memcpy(buf, self->cur, len);
+        self->cur += len;
+    }
+    else {
+        S_read_slow(self, buf, len);
+    }
+}
+
+void
+BufIn_Read_Bytes_IMP(BufInStream *self, char *buf, size_t len) {
+    SI_read_bytes(self, buf, len);
+}
+
+void
+BufIn_Read_Into_IMP(BufInStream *self, ByteBuf *target, size_t len) {
+    size_t size = target->size;
+    if (len > SIZE_MAX - size) {
+        THROW(ERR, "ByteBuf size overflow");
+    }
+    if (size + len > target->cap) {
+        BB_Grow(target, Memory_oversize(size + len, sizeof(char)));
+    }
+    SI_read_bytes(self, target->buf + size, len);
+    target->size = size + len;
+}
+
+uint8_t
+BufIn_Read_U8_IMP(BufInStream *self) {
+    if (self->cur >= self->limit) { S_refill(self, 1); }
+    return (uint8_t)*self->cur++;
+}
+
+static CFISH_INLINE uint64_t
+SI_decode_bigend(const uint8_t *bytes, size_t width) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < width; i++) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+uint32_t
+BufIn_Read_U32_IMP(BufInStream *self) {
+    uint8_t bytes[4];
+    SI_read_bytes(self, (char*)bytes, 4);
+    return (uint32_t)SI_decode_bigend(bytes, 4);
+}
+
+uint64_t
+BufIn_Read_U64_IMP(BufInStream *self) {
+    uint8_t bytes[8];
+    SI_read_bytes(self, (char*)bytes, 8);
+    return SI_decode_bigend(bytes, 8);
+}
+
+double
+BufIn_Read_F64_IMP(BufInStream *self) {
+    union { uint64_t u; double d; } bits;
+    bits.u = BufIn_Read_U64_IMP(self);
+    return bits.d;
+}
+
+static uint64_t
+S_read_cu64(BufInStream *self, uint32_t max_bytes) {
+    uint64_t value = 0;
+    uint32_t shift = 0;
+
+    if (self->limit - self->cur >= (ptrdiff_t)max_bytes) {
+        // Fast path: the whole integer is in the window.
+        const uint8_t *ptr = (const uint8_t*)self->cur;
+        for (uint32_t i = 0; i < max_bytes; i++, shift += 7) {
+            uint8_t byte = ptr[i];
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                self->cur += i + 1;
+                return value;
+            }
+        }
+    }
+    else {
+        for (uint32_t i = 0; i < max_bytes; i++, shift += 7) {
+            uint8_t byte = BufIn_Read_U8_IMP(self);
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) { return value; }
+        }
+    }
+
+    THROW(ERR, "Malformed compressed integer at %i64",
+          BufIn_Tell_IMP(self));
+    UNREACHABLE_RETURN(uint64_t);
+}
+
+uint32_t
+BufIn_Read_CU32_IMP(BufInStream *self) {
+    return (uint32_t)S_read_cu64(self, 5);
+}
+
+uint64_t
+BufIn_Read_CU64_IMP(BufInStream *self) {
+    return S_read_cu64(self, 10);
+}
+
+int64_t
+BufIn_Read_CI64_IMP(BufInStream *self) {
+    uint64_t zigzag = S_read_cu64(self, 10);
+    return (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+}
+
+typedef struct {
+    BufInStream *self;
+    char        *buf;
+    size_t       len;
+} ReadBytesContext;
+
+static void
+S_read_bytes_trapped(void *vcontext) {
+    ReadBytesContext *context = (ReadBytesContext*)vcontext;
+    SI_read_bytes(context->self, context->buf, context->len);
+}
+
+String*
+BufIn_Read_String_IMP(BufInStream *self) {
+    uint64_t size = BufIn_Read_CU64_IMP(self);
+    int64_t  pos  = BufIn_Tell_IMP(self);
+    if (size > (uint64_t)(self->len - pos)) {
+        THROW(ERR, "String size %u64 exceeds remaining stream length",
+              size);
+    }
+
+    // Strings that fit into the buffer are validated and copied from the
+    // window, so nothing is allocated before the read succeeded.
+    if ((uint64_t)(self->limit - self->cur) < size
+        && self->buffer != NULL
+        && size <= self->buffer->cap
+       ) {
+        S_refill(self, (size_t)size);
+    }
+    if ((uint64_t)(self->limit - self->cur) >= size) {
+        const char *utf8 = self->cur;
+        if (!Str_utf8_valid(utf8, (size_t)size)) {
+            THROW(ERR, "Invalid UTF-8 in String at %i64", pos);
+        }
+        self->cur += size;
+        return Str_new_from_trusted_utf8(utf8, (size_t)size);
+    }
+
+    // Larger strings are read straight into their own buffer, which must be
+    // freed if the read fails.
+    char *utf8 = (char*)MALLOCATE((size_t)size + 1);
+    ReadBytesContext context;
+    context.self = self;
+    context.buf  = utf8;
+    context.len  = (size_t)size;
+    Err *error = Err_trap(S_read_bytes_trapped, &context);
+    if (error != NULL) {
+        FREEMEM(utf8);
+        RETHROW(error);
+    }
+    utf8[size] = '\0';
+    if (!Str_utf8_valid(utf8, (size_t)size)) {
+        FREEMEM(utf8);
+        THROW(ERR, "Invalid UTF-8 in String at %i64", pos);
+    }
+    return Str_new_steal_trusted_utf8(utf8, (size_t)size);
+}
+
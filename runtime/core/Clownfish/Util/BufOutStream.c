@@ -0,0 +1,314 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_CFISH_BUFOUTSTREAM
+#define C_CFISH_BYTEBUF
+#define CFISH_USE_SHORT_NAMES
+
+#include <errno.h>
+#include <string.h>
+
+#include "charmony.h"
+
+#include "Clownfish/Util/BufOutStream.h"
+#include "Clownfish/ByteBuf.h"
+#include "Clownfish/Class.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Util/Memory.h"
+
+#if defined(CHY_HAS_UNISTD_H) && defined(CHY_HAS_FCNTL_H)
+  #include <sys/types.h>
+  #include <sys/uio.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+  #define OPEN_WRITE_FLAGS  (O_WRONLY | O_CREAT)
+  #define OPEN_APPEND       O_APPEND
+  #define OPEN_TRUNC        O_TRUNC
+  #define S_open            open
+  #define S_close           close
+  #define S_tell(fd)        ((int64_t)lseek(fd, 0, SEEK_CUR))
+  #define S_seek_end(fd)    lseek(fd, 0, SEEK_END)
+#else
+  #include <io.h>
+  #include <fcntl.h>
+  #include <sys/stat.h>
+  #define OPEN_WRITE_FLAGS  (_O_WRONLY | _O_CREAT | _O_BINARY)
+  #define OPEN_APPEND       _O_APPEND
+  #define OPEN_TRUNC        _O_TRUNC
+  #define S_open            _open
+  #define S_close           _close
+  #define S_tell(fd)        _telli64(fd)
+  #define S_seek_end(fd)    _lseeki64(fd, 0, SEEK_END)
+  struct iovec {
+      void   *iov_base;
+      size_t  iov_len;
+  };
+#endif
+
+#define IO_BUF_SIZE  65536
+
+// Write out the chunks described by `iov`, retrying after short writes.
+// Modifies the iovecs.  Return 0 on success or the errno of the failed
+// write.
+static int
+S_try_write_fully(int fd, struct iovec *iov, int num_iov) {
+    while (num_iov > 0) {
+        if (iov->iov_len == 0) {
+            iov++;
+            num_iov--;
+            continue;
+        }
+#if defined(CHY_HAS_UNISTD_H)
+        ssize_t check = num_iov == 1
+                        ? write(fd, iov->iov_base, iov->iov_len)
+                        : writev(fd, iov, num_iov);
+#else
+        unsigned len = iov->iov_len > INT32_MAX
+                       ? INT32_MAX
+                       : (unsigned)iov->iov_len;
+        int check = _write(fd, iov->iov_base, len);
+#endif
+        if (check < 0) {
+            if (errno == EINTR) { continue; }
+            return errno;
+        }
+
+        size_t written = (size_t)check;
+        while (num_iov > 0 && written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            num_iov--;
+        }
+        if (num_iov > 0) {
+            iov->iov_base = (char*)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+    return 0;
+}
+
+static void
+S_write_fully(int fd, struct iovec *iov, int num_iov) {
+    int error = S_try_write_fully(fd, iov, num_iov);
+    if (error != 0) {
+        THROW(ERR, "Write failed: %s", strerror(error));
+    }
+}
+
+BufOutStream*
+BufOut_open(String *path, bool append) {
+    char *path_utf8 = Str_To_Utf8(path);
+    int flags = OPEN_WRITE_FLAGS | (append ? OPEN_APPEND : OPEN_TRUNC);
+    int fd = S_open(path_utf8, flags, 0666);
+    FREEMEM(path_utf8);
+    if (fd < 0) {
+        THROW(ERR, "Can't open '%o': %s", path, strerror(errno));
+    }
+    if (append) {
+        // Start Tell at the end of the file.
+        S_seek_end(fd);
+    }
+    BufOutStream *self = (BufOutStream*)Class_Make_Obj(BUFOUTSTREAM);
+    return BufOut_init_fd(self, fd, true, 0);
+}
+
+BufOutStream*
+BufOut_new_fd(int fd, size_t buf_size) {
+    BufOutStream *self = (BufOutStream*)Class_Make_Obj(BUFOUTSTREAM);
+    return BufOut_init_fd(self, fd, false, buf_size);
+}
+
+BufOutStream*
+BufOut_init_fd(BufOutStream *self, int fd, bool owns_fd, size_t buf_size) {
+    self->fd      = fd;
+    self->owns_fd = owns_fd;
+    self->buffer  = BB_new(buf_size ? buf_size : IO_BUF_SIZE);
+
+    // Pipes and sockets can't tell their position.
+    int64_t pos = S_tell(fd);
+    self->buffer_pos = pos > 0 ? pos : 0;
+
+    return self;
+}
+
+void
+BufOut_Flush_IMP(BufOutStream *self) {
+    ByteBuf *buffer = self->buffer;
+    if (buffer == NULL) {
+        THROW(ERR, "Can't write to closed BufOutStream");
+    }
+    if (buffer->size == 0) { return; }
+
+    struct iovec iov;
+    iov.iov_base = buffer->buf;
+    iov.iov_len  = buffer->size;
+    S_write_fully(self->fd, &iov, 1);
+    self->buffer_pos += (int64_t)buffer->size;
+    buffer->size = 0;
+}
+
+void
+BufOut_Close_IMP(BufOutStream *self) {
+    if (self->buffer == NULL) { return; }
+    BufOut_Flush_IMP(self);
+    DECREF(self->buffer);
+    self->buffer = NULL;
+    if (self->owns_fd) {
+        if (S_close(self->fd) != 0) {
+            THROW(ERR, "Close failed: %s", strerror(errno));
+        }
+    }
+    self->fd = -1;
+}
+
+void
+BufOut_Destroy_IMP(BufOutStream *self) {
+    // Destructors must not throw, so write out the buffered data and close
+    // the file descriptor on a best-effort basis.  Call Close to find out
+    // whether the data was written successfully.
+    ByteBuf *buffer = self->buffer;
+    if (buffer) {
+        struct iovec iov;
+        iov.iov_base = buffer->buf;
+        iov.iov_len  = buffer->size;
+        S_try_write_fully(self->fd, &iov, 1);
+        if (self->owns_fd) {
+            S_close(self->fd);
+        }
+        DECREF(buffer);
+    }
+    SUPER_DESTROY(self, BUFOUTSTREAM);
+}
+
+int64_t
+BufOut_Tell_IMP(BufOutStream *self) {
+    size_t buffered = self->buffer ? self->buffer->size : 0;
+    return self->buffer_pos + (int64_t)buffered;
+}
+
+static void
+S_write_slow(BufOutStream *self, const void *bytes, size_t len) {
+    ByteBuf *buffer = self->buffer;
+    if (buffer == NULL) {
+        THROW(ERR, "Can't write to closed BufOutStream");
+    }
+
+    if (len < buffer->cap) {
+        BufOut_Flush_IMP(self);
+        memcpy(buffer->buf, bytes, len);
+        buffer->size = len;
+    }
+    else {
+        // Write the buffered data and the new bytes with a single call,
+        // without copying.
+        struct iovec iov[2];
+        iov[0].iov_base = buffer->buf;
+        iov[0].iov_len  = buffer->size;
+        iov[1].iov_base = (void*)bytes;
+        iov[1].iov_len  = len;
+        S_write_fully(self->fd, iov, 2);
+        self->buffer_pos += (int64_t)(buffer->size + len);
+        buffer->size = 0;
+    }
+}
+
+static CFISH_INLINE void
+SI_write_bytes(BufOutStream *self, const void *bytes, size_t len) {
+    ByteBuf *buffer = self->buffer;
+    if (buffer && len <= buffer->cap - buffer->size) {
+        memcpy(buffer->buf + buffer->size, bytes, len);
+        buffer->size += len;
+    }
+    else {
+        S_write_slow(self, bytes, len);
+    }
+}
+
+void
+BufOut_Write_Bytes_IMP(BufOutStream *self, const void *bytes, size_t len) {
+    SI_write_bytes(self, bytes, len);
+}
+
+void
+BufOut_Write_U8_IMP(BufOutStream *self, uint8_t value) {
+    SI_write_bytes(self, &value, 1);
+}
+
+static CFISH_INLINE void
+SI_encode_bigend(uint8_t *bytes, uint64_t value, size_t width) {
+    for (size_t i = width; i-- > 0;) {
+        bytes[i] = (uint8_t)value;
+        value >>= 8;
+    }
+}
+
+void
+BufOut_Write_U32_IMP(BufOutStream *self, uint32_t value) {
+    uint8_t bytes[4];
+    SI_encode_bigend(bytes, value, 4);
+    SI_write_bytes(self, bytes, 4);
+}
+
+void
+BufOut_Write_U64_IMP(BufOutStream *self, uint64_t value) {
+    uint8_t bytes[8];
+    SI_encode_bigend(bytes, value, 8);
+    SI_write_bytes(self, bytes, 8);
+}
+
+void
+BufOut_Write_F64_IMP(BufOutStream *self, double value) {
+    union { uint64_t u; double d; } bits;
+    bits.d = value;
+    BufOut_Write_U64_IMP(self, bits.u);
+}
+
+static CFISH_INLINE void
+SI_write_cu64(BufOutStream *self, uint64_t value) {
+    uint8_t bytes[10];
+    size_t  len = 0;
+    while (value >= 0x80) {
+        bytes[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[len++] = (uint8_t)value;
+    SI_write_bytes(self, bytes, len);
+}
+
+void
+BufOut_Write_CU32_IMP(BufOutStream *self, uint32_t value) {
+    SI_write_cu64(self, value);
+}
+
+void
+BufOut_Write_CU64_IMP(BufOutStream *self, uint64_t value) {
+    SI_write_cu64(self, value);
+}
+
+void
+BufOut_Write_CI64_IMP(BufOutStream *self, int64_t value) {
+    uint64_t zigzag = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    SI_write_cu64(self, zigzag);
+}
+
+void
+BufOut_Write_String_IMP(BufOutStream *self, String *string) {
+    size_t size = Str_Get_Size(string);
+    SI_write_cu64(self, size);
+    SI_write_bytes(self, Str_Get_Ptr8(string), size);
+}
+
@@ -0,0 +1,404 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_CFISH_CHANNEL
+#define CFISH_USE_SHORT_NAMES
+
+#include "charmony.h"
+
+#include "Clownfish/Util/Channel.h"
+#include "Clownfish/Class.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/Util/Atomic.h"
+#include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/Threads.h"
+
+/******************************* Ring buffer *******************************/
+
+// Counters are stored in pointer-sized slots, so they can be updated with
+// Atomic_cas_ptr, which also acts as a full memory barrier.
+typedef void *volatile AtomicSlot;
+
+#define CACHE_LINE_SIZE 64
+
+// Number of times a thread yields and retries before going to sleep on a
+// full or empty channel.  Sleeping and waking up are much more expensive
+// than a yield, so this pays off when the other side is about to catch up.
+#define YIELD_LIMIT 8
+
+// Each cell carries a sequence number which tells whose turn it is.  A
+// cell at position `pos` is free for the producer claiming `pos` if its
+// sequence equals `pos`, and holds an element for the consumer claiming
+// `pos` if its sequence equals `pos + 1`.  The consumer then advances the
+// sequence to the cell's position in the next lap.
+typedef struct {
+    AtomicSlot  sequence;
+    Obj        *element;
+} ChanCell;
+
+typedef struct {
+    AtomicSlot  enqueue_pos;
+    char        pad1[CACHE_LINE_SIZE - sizeof(AtomicSlot)];
+    AtomicSlot  dequeue_pos;
+    char        pad2[CACHE_LINE_SIZE - sizeof(AtomicSlot)];
+    AtomicSlot  closed;
+    AtomicSlot  waiting_producers;
+    AtomicSlot  waiting_consumers;
+    ChanCell   *cells;
+    size_t      mask;
+    Mutex       mutex;
+    CondVar     not_full;
+    CondVar     not_empty;
+} ChanImpl;
+
+static CFISH_INLINE size_t
+SI_load(AtomicSlot *slot) {
+    return (size_t)(uintptr_t)*slot;
+}
+
+static CFISH_INLINE bool
+SI_cas(AtomicSlot *slot, size_t old_value, size_t new_value) {
+    return Atomic_cas_ptr(slot, (void*)(uintptr_t)old_value,
+                          (void*)(uintptr_t)new_value);
+}
+
+static CFISH_INLINE void
+SI_add(AtomicSlot *slot, size_t delta) {
+    size_t value;
+    do {
+        value = SI_load(slot);
+    } while (!SI_cas(slot, value, value + delta));
+}
+
+// Claim up to `num_elems` consecutive free cells with a single CAS and
+// fill them.  Return the number of elements pushed.
+static size_t
+S_try_push_many(ChanImpl *impl, Obj **elems, size_t num_elems) {
+    ChanCell *cells = impl->cells;
+    size_t    mask  = impl->mask;
+    size_t    pos   = SI_load(&impl->enqueue_pos);
+    size_t    num_claimed;
+
+    if (num_elems == 0 || SI_load(&impl->closed)) { return 0; }
+
+    while (true) {
+        num_claimed = 0;
+        while (num_claimed < num_elems && num_claimed <= mask) {
+            size_t    cell_pos = pos + num_claimed;
+            ChanCell *cell     = cells + (cell_pos & mask);
+            if (SI_load(&cell->sequence) != cell_pos) { break; }
+            num_claimed++;
+        }
+
+        if (num_claimed == 0) {
+            ChanCell *cell = cells + (pos & mask);
+            intptr_t  diff = (intptr_t)(SI_load(&cell->sequence) - pos);
+            if (diff < 0) {
+                return 0; // Full.
+            }
+            // Another producer claimed the cell.
+            pos = SI_load(&impl->enqueue_pos);
+        }
+        else if (SI_cas(&impl->enqueue_pos, pos, pos + num_claimed)) {
+            break;
+        }
+        else {
+            pos = SI_load(&impl->enqueue_pos);
+        }
+    }
+
+    for (size_t i = 0; i < num_claimed; i++) {
+        ChanCell *cell = cells + ((pos + i) & mask);
+        cell->element = elems[i];
+        SI_cas(&cell->sequence, pos + i, pos + i + 1);
+    }
+
+    return num_claimed;
+}
+
+// Claim up to `max_elems` consecutive filled cells with a single CAS and
+// empty them.  Return the number of elements popped.
+static size_t
+S_try_pop_many(ChanImpl *impl, Obj **buffer, size_t max_elems) {
+    ChanCell *cells = impl->cells;
+    size_t    mask  = impl->mask;
+    size_t    pos   = SI_load(&impl->dequeue_pos);
+    size_t    num_claimed;
+
+    if (max_elems == 0) { return 0; }
+
+    while (true) {
+        num_claimed = 0;
+        while (num_claimed < max_elems && num_claimed <= mask) {
+            size_t    cell_pos = pos + num_claimed;
+            ChanCell *cell     = cells + (cell_pos & mask);
+            if (SI_load(&cell->sequence) != cell_pos + 1) { break; }
+            num_claimed++;
+        }
+
+        if (num_claimed == 0) {
+            ChanCell *cell = cells + (pos & mask);
+            intptr_t  diff = (intptr_t)(SI_load(&cell->sequence) - (pos + 1));
+            if (diff < 0) {
+                return 0; // Empty.
+            }
+            // Another consumer claimed the cell.
+            pos = SI_load(&impl->dequeue_pos);
+        }
+        else if (SI_cas(&impl->dequeue_pos, pos, pos + num_claimed)) {
+            break;
+        }
+        else {
+            pos = SI_load(&impl->dequeue_pos);
+        }
+    }
+
+    for (size_t i = 0; i < num_claimed; i++) {
+        ChanCell *cell = cells + ((pos + i) & mask);
+        buffer[i] = cell->element;
+        cell->element = NULL;
+        SI_cas(&cell->sequence, pos + i + 1, pos + i + mask + 1);
+    }
+
+    return num_claimed;
+}
+
+// Wake up threads sleeping on `cond` if there are any.  Waiters register
+// with a CAS before checking the ring buffer a last time, and the ring
+// buffer was just updated with a CAS, so either the waiter sees the update
+// or the waker sees the waiter.
+static void
+S_wake(ChanImpl *impl, AtomicSlot *waiting, CondVar *cond, bool all) {
+    if (SI_load(waiting)) {
+        Mutex_lock(&impl->mutex);
+        if (all) {
+            CondVar_broadcast(cond);
+        }
+        else {
+            CondVar_signal(cond);
+        }
+        Mutex_unlock(&impl->mutex);
+    }
+}
+
+static size_t
+S_push(ChanImpl *impl, Obj **elems, size_t num_elems) {
+    size_t pushed = S_try_push_many(impl, elems, num_elems);
+
+    for (int i = 0; i < YIELD_LIMIT; i++) {
+        if (pushed == num_elems || SI_load(&impl->closed)) { break; }
+        Threads_yield();
+        pushed += S_try_push_many(impl, elems + pushed, num_elems - pushed);
+    }
+
+    if (pushed < num_elems && !SI_load(&impl->closed)) {
+        Mutex_lock(&impl->mutex);
+        SI_add(&impl->waiting_producers, 1);
+        if (pushed && SI_load(&impl->waiting_consumers)) {
+            CondVar_broadcast(&impl->not_empty);
+        }
+        while (true) {
+            size_t more = S_try_push_many(impl, elems + pushed,
+                                          num_elems - pushed);
+            if (more && SI_load(&impl->waiting_consumers)) {
+                CondVar_broadcast(&impl->not_empty);
+            }
+            pushed += more;
+            if (pushed == num_elems || SI_load(&impl->closed)) { break; }
+            CondVar_wait(&impl->not_full, &impl->mutex);
+        }
+        SI_add(&impl->waiting_producers, (size_t)-1);
+        Mutex_unlock(&impl->mutex);
+    }
+    else if (pushed) {
+        S_wake(impl, &impl->waiting_consumers, &impl->not_empty, pushed > 1);
+    }
+
+    return pushed;
+}
+
+static size_t
+S_pop(ChanImpl *impl, Obj **buffer, size_t max_elems) {
+    size_t popped = S_try_pop_many(impl, buffer, max_elems);
+
+    for (int i = 0; i < YIELD_LIMIT; i++) {
+        if (popped || SI_load(&impl->closed)) { break; }
+        Threads_yield();
+        popped = S_try_pop_many(impl, buffer, max_elems);
+    }
+
+    if (popped == 0) {
+        Mutex_lock(&impl->mutex);
+        SI_add(&impl->waiting_consumers, 1);
+        while (true) {
+            // Check `closed` first, so elements pushed before Close are
+            // still seen.
+            bool closed = SI_load(&impl->closed) != 0;
+            popped = S_try_pop_many(impl, buffer, max_elems);
+            if (popped || closed) { break; }
+            CondVar_wait(&impl->not_empty, &impl->mutex);
+        }
+        SI_add(&impl->waiting_consumers, (size_t)-1);
+        Mutex_unlock(&impl->mutex);
+    }
+
+    if (popped) {
+        S_wake(impl, &impl->waiting_producers, &impl->not_full, popped > 1);
+    }
+    return popped;
+}
+
+/********************************* Channel *********************************/
+
+Channel*
+Chan_new(size_t capacity) {
+    Channel *self = (Channel*)Class_Make_Obj(CHANNEL);
+    return Chan_init(self, capacity);
+}
+
+Channel*
+Chan_init(Channel *self, size_t capacity) {
+    size_t cap = 2;
+    while (cap < capacity) {
+        if (cap > SIZE_MAX / 2 / sizeof(ChanCell)) {
+            DECREF(self);
+            THROW(ERR, "Channel capacity too large: %u64", (uint64_t)capacity);
+        }
+        cap *= 2;
+    }
+
+    ChanImpl *impl = (ChanImpl*)CALLOCATE(1, sizeof(ChanImpl));
+    impl->cells = (ChanCell*)MALLOCATE(cap * sizeof(ChanCell));
+    impl->mask  = cap - 1;
+    for (size_t i = 0; i < cap; i++) {
+        impl->cells[i].sequence = (void*)(uintptr_t)i;
+        impl->cells[i].element  = NULL;
+    }
+    Mutex_init(&impl->mutex);
+    CondVar_init(&impl->not_full);
+    CondVar_init(&impl->not_empty);
+
+    self->impl     = impl;
+    self->capacity = cap;
+    return self;
+}
+
+void
+Chan_Destroy_IMP(Channel *self) {
+    ChanImpl *impl = (ChanImpl*)self->impl;
+    Obj *element;
+    while (S_try_pop_many(impl, &element, 1)) {
+        DECREF(element);
+    }
+    CondVar_destroy(&impl->not_empty);
+    CondVar_destroy(&impl->not_full);
+    Mutex_destroy(&impl->mutex);
+    FREEMEM(impl->cells);
+    FREEMEM(impl);
+    SUPER_DESTROY(self, CHANNEL);
+}
+
+bool
+Chan_Push_IMP(Channel *self, Obj *element) {
+    if (element == NULL) {
+        THROW(ERR, "Can't push NULL onto a Channel");
+    }
+    if (S_push((ChanImpl*)self->impl, &element, 1) == 0) {
+        DECREF(element);
+        return false;
+    }
+    return true;
+}
+
+bool
+Chan_Try_Push_IMP(Channel *self, Obj *element) {
+    ChanImpl *impl = (ChanImpl*)self->impl;
+    if (element == NULL) {
+        THROW(ERR, "Can't push NULL onto a Channel");
+    }
+    if (S_try_push_many(impl, &element, 1) == 0) {
+        return false;
+    }
+    S_wake(impl, &impl->waiting_consumers, &impl->not_empty, false);
+    return true;
+}
+
+size_t
+Chan_Push_Batch_IMP(Channel *self, Obj **elements, size_t num_elements) {
+    for (size_t i = 0; i < num_elements; i++) {
+        if (elements[i] == NULL) {
+            THROW(ERR, "Can't push NULL onto a Channel");
+        }
+    }
+    return S_push((ChanImpl*)self->impl, elements, num_elements);
+}
+
+Obj*
+Chan_Pop_IMP(Channel *self) {
+    Obj *element = NULL;
+    S_pop((ChanImpl*)self->impl, &element, 1);
+    return element;
+}
+
+Obj*
+Chan_Try_Pop_IMP(Channel *self) {
+    ChanImpl *impl    = (ChanImpl*)self->impl;
+    Obj      *element = NULL;
+    if (S_try_pop_many(impl, &element, 1)) {
+        S_wake(impl, &impl->waiting_producers, &impl->not_full, false);
+    }
+    return element;
+}
+
+size_t
+Chan_Pop_Batch_IMP(Channel *self, Obj **buffer, size_t max_elements) {
+    if (max_elements == 0) { return 0; }
+    return S_pop((ChanImpl*)self->impl, buffer, max_elements);
+}
+
+void
+Chan_Close_IMP(Channel *self) {
+    ChanImpl *impl = (ChanImpl*)self->impl;
+    SI_cas(&impl->closed, 0, 1);
+    Mutex_lock(&impl->mutex);
+    CondVar_broadcast(&impl->not_full);
+    CondVar_broadcast(&impl->not_empty);
+    Mutex_unlock(&impl->mutex);
+}
+
+bool
+Chan_Is_Closed_IMP(Channel *self) {
+    ChanImpl *impl = (ChanImpl*)self->impl;
+    return SI_load(&impl->closed) != 0;
+}
+
+size_t
+Chan_Get_Capacity_IMP(Channel *self) {
+    return self->capacity;
+}
+
+size_t
+Chan_Get_Size_IMP(Channel *self) {
+    ChanImpl *impl = (ChanImpl*)self->impl;
+    size_t dequeue_pos = SI_load(&impl->dequeue_pos);
+    size_t enqueue_pos = SI_load(&impl->enqueue_pos);
+    size_t size = enqueue_pos - dequeue_pos;
+    // The positions aren't read atomically together.
+    if (size > self->capacity) {
+        size = enqueue_pos < dequeue_pos ? 0 : self->capacity;
+    }
+    return size;
+}
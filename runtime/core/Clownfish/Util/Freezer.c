@@ -0,0 +1,496 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_CFISH_BYTEBUF
+#define CFISH_USE_SHORT_NAMES
+
+#include <string.h>
+
+#include "Clownfish/Util/Freezer.h"
+#include "Clownfish/Blob.h"
+#include "Clownfish/Boolean.h"
+#include "Clownfish/ByteBuf.h"
+#include "Clownfish/Class.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/Hash.h"
+#include "Clownfish/HashIterator.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Vector.h"
+#include "Clownfish/Util/Memory.h"
+
+#define MAX_DEPTH  1000
+
+#define TAG_FIXINT_MAX  0x7F
+#define TAG_FIXSTR      0x80
+#define TAG_FIXVEC      0xA0
+#define TAG_FIXHASH     0xB0
+#define TAG_NULL        0xC0
+#define TAG_FALSE       0xC2
+#define TAG_TRUE        0xC3
+#define TAG_INT         0xC4
+#define TAG_FLOAT       0xC5
+#define TAG_STR         0xC6
+#define TAG_BLOB        0xC7
+#define TAG_VEC         0xC8
+#define TAG_HASH        0xC9
+
+#define FIXSTR_MAX      31
+#define FIXCONTAINER_MAX 15
+
+static const char MAGIC[3] = { 'C', 'F', 'z' };
+
+/******************************** Encoding *********************************/
+
+static void
+S_grow(ByteBuf *target, size_t len) {
+    if (len > SIZE_MAX - target->size) {
+        THROW(ERR, "ByteBuf size overflow");
+    }
+    BB_Grow(target, Memory_oversize(target->size + len, sizeof(char)));
+}
+
+static CFISH_INLINE uint8_t*
+SI_reserve(ByteBuf *target, size_t len) {
+    if (len > target->cap - target->size) { S_grow(target, len); }
+    return (uint8_t*)target->buf + target->size;
+}
+
+static CFISH_INLINE void
+SI_put_byte(ByteBuf *target, uint8_t byte) {
+    uint8_t *ptr = SI_reserve(target, 1);
+    *ptr = byte;
+    target->size++;
+}
+
+// Write a tag followed by a compressed integer.
+static CFISH_INLINE void
+SI_put_tag_cu64(ByteBuf *target, uint8_t tag, uint64_t value) {
+    uint8_t *ptr   = SI_reserve(target, 11);
+    uint8_t *start = ptr;
+    *ptr++ = tag;
+    while (value >= 0x80) {
+        *ptr++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *ptr++ = (uint8_t)value;
+    target->size += (size_t)(ptr - start);
+}
+
+static CFISH_INLINE void
+SI_put_bytes(ByteBuf *target, const void *bytes, size_t len) {
+    uint8_t *ptr = SI_reserve(target, len);
+    memcpy(ptr, bytes, len);
+    target->size += len;
+}
+
+static void
+S_put_string(ByteBuf *target, String *string) {
+    size_t size = Str_Get_Size(string);
+    if (size <= FIXSTR_MAX) {
+        SI_put_byte(target, (uint8_t)(TAG_FIXSTR | size));
+    }
+    else {
+        SI_put_tag_cu64(target, TAG_STR, size);
+    }
+    SI_put_bytes(target, Str_Get_Ptr8(string), size);
+}
+
+static void
+S_put_container(ByteBuf *target, uint8_t fixtag, uint8_t tag, size_t size) {
+    if (size <= FIXCONTAINER_MAX) {
+        SI_put_byte(target, (uint8_t)(fixtag | size));
+    }
+    else {
+        SI_put_tag_cu64(target, tag, size);
+    }
+}
+
+// Return an error message on failure, or NULL on success.
+static String*
+S_freeze(Obj *obj, ByteBuf *target, int depth) {
+    if (obj == NULL) {
+        SI_put_byte(target, TAG_NULL);
+        return NULL;
+    }
+
+    Class *klass = Obj_get_class(obj);
+    if (klass == STRING) {
+        S_put_string(target, (String*)obj);
+    }
+    else if (klass == INTEGER) {
+        int64_t value = Int_Get_Value((Integer*)obj);
+        if (value >= 0 && value <= TAG_FIXINT_MAX) {
+            SI_put_byte(target, (uint8_t)value);
+        }
+        else {
+            uint64_t zigzag = ((uint64_t)value << 1)
+                              ^ (uint64_t)(value >> 63);
+            SI_put_tag_cu64(target, TAG_INT, zigzag);
+        }
+    }
+    else if (klass == FLOAT) {
+        union { uint64_t u; double d; } bits;
+        bits.d = Float_Get_Value((Float*)obj);
+        uint8_t *ptr = SI_reserve(target, 9);
+        ptr[0] = TAG_FLOAT;
+        for (int i = 8; i > 0; i--) {
+            ptr[i] = (uint8_t)bits.u;
+            bits.u >>= 8;
+        }
+        target->size += 9;
+    }
+    else if (klass == BOOLEAN) {
+        SI_put_byte(target, Bool_Get_Value((Boolean*)obj)
+                            ? TAG_TRUE
+                            : TAG_FALSE);
+    }
+    else if (klass == BLOB) {
+        size_t size = Blob_Get_Size((Blob*)obj);
+        SI_put_tag_cu64(target, TAG_BLOB, size);
+        SI_put_bytes(target, Blob_Get_Buf((Blob*)obj), size);
+    }
+    else if (klass == BYTEBUF) {
+        ByteBuf *bb = (ByteBuf*)obj;
+        SI_put_tag_cu64(target, TAG_BLOB, bb->size);
+        SI_put_bytes(target, bb->buf, bb->size);
+    }
+    else if (Obj_is_a(obj, VECTOR)) {
+        if (depth >= MAX_DEPTH) {
+            return Str_newf("Data structure nested too deeply");
+        }
+        Vector *vector = (Vector*)obj;
+        size_t  size   = Vec_Get_Size(vector);
+        S_put_container(target, TAG_FIXVEC, TAG_VEC, size);
+        for (size_t i = 0; i < size; i++) {
+            String *error = S_freeze(Vec_Fetch(vector, i), target, depth + 1);
+            if (error) { return error; }
+        }
+    }
+    else if (Obj_is_a(obj, HASH)) {
+        if (depth >= MAX_DEPTH) {
+            return Str_newf("Data structure nested too deeply");
+        }
+        Hash *hash = (Hash*)obj;
+        S_put_container(target, TAG_FIXHASH, TAG_HASH, Hash_Get_Size(hash));
+        HashIterator *iter = HashIter_new(hash);
+        while (HashIter_Next(iter)) {
+            S_put_string(target, HashIter_Get_Key(iter));
+            String *error = S_freeze(HashIter_Get_Value(iter), target,
+                                     depth + 1);
+            if (error) {
+                DECREF(iter);
+                return error;
+            }
+        }
+        DECREF(iter);
+    }
+    else {
+        return Str_newf("Can't freeze object of class %o",
+                        Class_Get_Name(klass));
+    }
+
+    return NULL;
+}
+
+void
+ObjFreezer_freeze(Obj *obj, ByteBuf *target) {
+    size_t orig_size = target->size;
+    SI_put_bytes(target, MAGIC, sizeof(MAGIC));
+    SI_put_byte(target, CFISH_FREEZER_FORMAT_VERSION);
+    String *error = S_freeze(obj, target, 0);
+    if (error) {
+        // Don't leave a partial serialization behind.
+        target->size = orig_size;
+        Err_throw_mess(ERR, error);
+    }
+}
+
+Blob*
+ObjFreezer_freeze_to_blob(Obj *obj) {
+    ByteBuf *buf = BB_new(64);
+    String *error = NULL;
+    SI_put_bytes(buf, MAGIC, sizeof(MAGIC));
+    SI_put_byte(buf, CFISH_FREEZER_FORMAT_VERSION);
+    error = S_freeze(obj, buf, 0);
+    if (error) {
+        DECREF(buf);
+        Err_throw_mess(ERR, error);
+    }
+    Blob *blob = BB_Yield_Blob(buf);
+    DECREF(buf);
+    return blob;
+}
+
+/******************************** Decoding *********************************/
+
+typedef struct {
+    const uint8_t *start;
+    const uint8_t *ptr;
+    const uint8_t *limit;
+    Blob          *owner;
+    String        *error;
+} Thawer;
+
+static bool
+S_fail(Thawer *thawer, const char *problem) {
+    thawer->error = Str_newf("Can't thaw: %s at byte %u64", problem,
+                             (uint64_t)(thawer->ptr - thawer->start));
+    return false;
+}
+
+static bool
+S_get_cu64(Thawer *thawer, uint64_t *result) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 70; shift += 7) {
+        if (thawer->ptr >= thawer->limit) {
+            return S_fail(thawer, "unexpected end of input");
+        }
+        uint8_t byte = *thawer->ptr++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *result = value;
+            return true;
+        }
+    }
+    return S_fail(thawer, "malformed compressed integer");
+}
+
+// Read a size which must not exceed the remaining input.
+static bool
+S_get_size(Thawer *thawer, size_t *result) {
+    uint64_t size;
+    if (!S_get_cu64(thawer, &size)) { return false; }
+    if (size > (uint64_t)(thawer->limit - thawer->ptr)) {
+        return S_fail(thawer, "size exceeds input");
+    }
+    *result = (size_t)size;
+    return true;
+}
+
+static void
+S_release_owner(void *context, const char *buf, size_t size) {
+    UNUSED_VAR(buf);
+    UNUSED_VAR(size);
+    DECREF((Obj*)context);
+}
+
+static bool
+S_get_string(Thawer *thawer, uint8_t tag, String **result) {
+    size_t size;
+    if (tag >= TAG_FIXSTR && tag <= TAG_FIXSTR + FIXSTR_MAX) {
+        size = tag - TAG_FIXSTR;
+        if (size > (size_t)(thawer->limit - thawer->ptr)) {
+            return S_fail(thawer, "size exceeds input");
+        }
+    }
+    else if (tag == TAG_STR) {
+        if (!S_get_size(thawer, &size)) { return false; }
+    }
+    else {
+        return S_fail(thawer, "expected String");
+    }
+
+    const char *utf8 = (const char*)thawer->ptr;
+    if (!Str_utf8_valid(utf8, size)) {
+        return S_fail(thawer, "invalid UTF-8");
+    }
+    thawer->ptr += size;
+    *result = thawer->owner
+              ? Str_new_borrow_trusted_utf8(utf8, size, (Obj*)thawer->owner)
+              : Str_new_from_trusted_utf8(utf8, size);
+    return true;
+}
+
+static bool
+S_thaw(Thawer *thawer, int depth, Obj **result);
+
+static bool
+S_get_vector(Thawer *thawer, size_t size, int depth, Obj **result) {
+    Vector *vector = Vec_new(size);
+    for (size_t i = 0; i < size; i++) {
+        Obj *elem;
+        if (!S_thaw(thawer, depth + 1, &elem)) {
+            DECREF(vector);
+            return false;
+        }
+        Vec_Push(vector, elem);
+    }
+    *result = (Obj*)vector;
+    return true;
+}
+
+static bool
+S_get_hash(Thawer *thawer, size_t size, int depth, Obj **result) {
+    Hash *hash = Hash_new(size);
+    for (size_t i = 0; i < size; i++) {
+        String *key;
+        Obj    *value;
+        if (thawer->ptr >= thawer->limit) {
+            DECREF(hash);
+            return S_fail(thawer, "unexpected end of input");
+        }
+        uint8_t tag = *thawer->ptr++;
+        if (!S_get_string(thawer, tag, &key)) {
+            DECREF(hash);
+            return false;
+        }
+        if (!S_thaw(thawer, depth + 1, &value)) {
+            DECREF(key);
+            DECREF(hash);
+            return false;
+        }
+        Hash_Store(hash, key, value);
+        DECREF(key);
+    }
+    *result = (Obj*)hash;
+    return true;
+}
+
+static bool
+S_thaw(Thawer *thawer, int depth, Obj **result) {
+    if (thawer->ptr >= thawer->limit) {
+        return S_fail(thawer, "unexpected end of input");
+    }
+    uint8_t tag = *thawer->ptr++;
+
+    if (tag <= TAG_FIXINT_MAX) {
+        *result = (Obj*)Int_new(tag);
+        return true;
+    }
+    if (tag < TAG_FIXVEC || tag == TAG_STR) {
+        return S_get_string(thawer, tag, (String**)result);
+    }
+
+    size_t size;
+    switch (tag) {
+        case TAG_NULL:
+            *result = NULL;
+            return true;
+        case TAG_FALSE:
+            *result = (Obj*)CFISH_FALSE;
+            return true;
+        case TAG_TRUE:
+            *result = (Obj*)CFISH_TRUE;
+            return true;
+        case TAG_INT: {
+            uint64_t zigzag;
+            if (!S_get_cu64(thawer, &zigzag)) { return false; }
+            int64_t value = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+            *result = (Obj*)Int_new(value);
+            return true;
+        }
+        case TAG_FLOAT: {
+            if (thawer->limit - thawer->ptr < 8) {
+                return S_fail(thawer, "unexpected end of input");
+            }
+            union { uint64_t u; double d; } bits;
+            bits.u = 0;
+            for (int i = 0; i < 8; i++) {
+                bits.u = (bits.u << 8) | thawer->ptr[i];
+            }
+            thawer->ptr += 8;
+            *result = (Obj*)Float_new(bits.d);
+            return true;
+        }
+        case TAG_BLOB: {
+            if (!S_get_size(thawer, &size)) { return false; }
+            const uint8_t *bytes = thawer->ptr;
+            thawer->ptr += size;
+            *result = thawer->owner
+                      ? (Obj*)Blob_new_external(bytes, size, S_release_owner,
+                                                INCREF(thawer->owner))
+                      : (Obj*)Blob_new(bytes, size);
+            return true;
+        }
+        default:
+            break;
+    }
+
+    bool is_vector;
+    if (tag >= TAG_FIXVEC && tag <= TAG_FIXVEC + FIXCONTAINER_MAX) {
+        is_vector = true;
+        size      = tag - TAG_FIXVEC;
+    }
+    else if (tag >= TAG_FIXHASH && tag <= TAG_FIXHASH + FIXCONTAINER_MAX) {
+        is_vector = false;
+        size      = tag - TAG_FIXHASH;
+    }
+    else if (tag == TAG_VEC || tag == TAG_HASH) {
+        is_vector = tag == TAG_VEC;
+        if (!S_get_size(thawer, &size)) { return false; }
+    }
+    else {
+        thawer->ptr--;
+        return S_fail(thawer, "unknown tag");
+    }
+
+    // Every element takes at least one byte.
+    if (size > (size_t)(thawer->limit - thawer->ptr)) {
+        return S_fail(thawer, "size exceeds input");
+    }
+    if (depth >= MAX_DEPTH) {
+        return S_fail(thawer, "data structure nested too deeply");
+    }
+    return is_vector
+           ? S_get_vector(thawer, size, depth, result)
+           : S_get_hash(thawer, size, depth, result);
+}
+
+static Obj*
+S_thaw_input(const void *bytes, size_t size, Blob *owner) {
+    Thawer thawer;
+    thawer.start = (const uint8_t*)bytes;
+    thawer.ptr   = thawer.start;
+    thawer.limit = thawer.start + size;
+    thawer.owner = owner;
+    thawer.error = NULL;
+
+    if (size < sizeof(MAGIC) + 1
+        || memcmp(bytes, MAGIC, sizeof(MAGIC)) != 0
+       ) {
+        THROW(ERR, "Can't thaw: not a frozen data structure");
+    }
+    uint8_t version = thawer.start[sizeof(MAGIC)];
+    if (version == 0 || version > CFISH_FREEZER_FORMAT_VERSION) {
+        THROW(ERR, "Can't thaw: unsupported format version %u32",
+              (uint32_t)version);
+    }
+    thawer.ptr += sizeof(MAGIC) + 1;
+
+    Obj *result;
+    if (!S_thaw(&thawer, 0, &result)) {
+        Err_throw_mess(ERR, thawer.error);
+    }
+    if (thawer.ptr != thawer.limit) {
+        DECREF(result);
+        S_fail(&thawer, "trailing garbage");
+        Err_throw_mess(ERR, thawer.error);
+    }
+    return result;
+}
+
+Obj*
+ObjFreezer_thaw(Blob *input, bool zero_copy) {
+    return S_thaw_input(Blob_Get_Buf(input), Blob_Get_Size(input),
+                        zero_copy ? input : NULL);
+}
+
+Obj*
+ObjFreezer_thaw_bytes(const void *bytes, size_t size) {
+    return S_thaw_input(bytes, size, NULL);
+}
+
@@ -0,0 +1,1023 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_CFISH_CHARBUF
+#define CFISH_USE_SHORT_NAMES
+
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+  #define JSON_USE_SSE2
+#endif
+
+#include "Clownfish/Util/Json.h"
+#include "Clownfish/Boolean.h"
+#include "Clownfish/CharBuf.h"
+#include "Clownfish/Class.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/Hash.h"
+#include "Clownfish/HashIterator.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Vector.h"
+#include "Clownfish/Util/Memory.h"
+
+#define MAX_DEPTH  1000
+
+// Maximum number of distinct object keys shared within a single document.
+#define MAX_SHARED_KEYS  1024
+
+/****************************** Float format *******************************/
+
+// sprintf and strtod use the decimal point of the current locale, but JSON
+// always uses a period.
+static const char*
+S_decimal_point() {
+    const char *decimal_point = localeconv()->decimal_point;
+    return decimal_point && decimal_point[0] ? decimal_point : ".";
+}
+
+// Format a double with `precision` significant digits into `buf`, which must
+// hold at least 40 bytes.  Return the length.
+static int
+S_format_f64(char *buf, int precision, double value) {
+    int len = sprintf(buf, "%.*g", precision, value);
+    const char *decimal_point = S_decimal_point();
+    if (strcmp(decimal_point, ".") != 0) {
+        char *found = strstr(buf, decimal_point);
+        if (found) {
+            size_t dp_len = strlen(decimal_point);
+            *found = '.';
+            memmove(found + 1, found + dp_len,
+                    (size_t)len - (size_t)(found - buf) - dp_len + 1);
+            len -= (int)dp_len - 1;
+        }
+    }
+    return len;
+}
+
+// Parse a number that has already been validated.
+static double
+S_strtod(const char *number, size_t len) {
+    // strtod needs a NUL-terminated copy with the decimal point of the
+    // current locale.
+    const char *decimal_point = S_decimal_point();
+    size_t      dp_len        = strlen(decimal_point);
+    char        stack_buf[64];
+    char       *copy = len + dp_len < sizeof(stack_buf)
+                       ? stack_buf
+                       : (char*)MALLOCATE(len + dp_len + 1);
+    char       *dest = copy;
+    for (size_t i = 0; i < len; i++) {
+        if (number[i] == '.') {
+            memcpy(dest, decimal_point, dp_len);
+            dest += dp_len;
+        }
+        else {
+            *dest++ = number[i];
+        }
+    }
+    *dest = '\0';
+    double value = strtod(copy, NULL);
+    if (copy != stack_buf) { FREEMEM(copy); }
+    return value;
+}
+
+/******************************** Scanning *********************************/
+
+#define ONES   UINT64_C(0x0101010101010101)
+#define HIGHS  UINT64_C(0x8080808080808080)
+
+#ifdef JSON_USE_SSE2
+static CFISH_INLINE int
+SI_lowest_bit(int mask) {
+#if defined(__GNUC__)
+    return __builtin_ctz((unsigned)mask);
+#else
+    int bit = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+#else
+// Set the high bit of every byte in `word` which equals `byte`.  Bytes
+// above the first match may be flagged spuriously.
+static CFISH_INLINE uint64_t
+SI_match_byte(uint64_t word, uint8_t byte) {
+    uint64_t x = word ^ (ONES * byte);
+    return (x - ONES) & ~x & HIGHS;
+}
+
+static CFISH_INLINE uint64_t
+SI_load_word(const uint8_t *ptr) {
+    uint64_t word;
+    memcpy(&word, ptr, sizeof(word));
+    return word;
+}
+#endif
+
+static CFISH_INLINE bool
+SI_is_string_special(uint8_t c) {
+    return c == '"' || c == '\\' || c < 0x20;
+}
+
+// Return a pointer to the first double quote, backslash or control
+// character in the buffer, or `end`.  Used both when parsing and when
+// escaping strings.
+static const uint8_t*
+S_find_string_special(const uint8_t *ptr, const uint8_t *end) {
+#ifdef JSON_USE_SSE2
+    const __m128i quote  = _mm_set1_epi8('"');
+    const __m128i bslash = _mm_set1_epi8('\\');
+    const __m128i ctrl   = _mm_set1_epi8(0x1F);
+    while (end - ptr >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)ptr);
+        __m128i hits  = _mm_or_si128(
+                            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                         _mm_cmpeq_epi8(chunk, bslash)),
+                            _mm_cmpeq_epi8(_mm_min_epu8(chunk, ctrl), chunk));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask) { return ptr + SI_lowest_bit(mask); }
+        ptr += 16;
+    }
+#else
+    while (end - ptr >= 8) {
+        uint64_t word = SI_load_word(ptr);
+        uint64_t hits = SI_match_byte(word, '"')
+                        | SI_match_byte(word, '\\')
+                        | ((word - ONES * 0x20) & ~word & HIGHS);
+        if (hits) { break; }
+        ptr += 8;
+    }
+#endif
+    while (ptr < end && !SI_is_string_special(*ptr)) { ptr++; }
+    return ptr;
+}
+
+// Return a pointer to the first double quote, bracket, brace or comma in the
+// buffer, or `end`.  Brackets and braces differ only in bit 0x20.
+static const uint8_t*
+S_find_structural(const uint8_t *ptr, const uint8_t *end) {
+#ifdef JSON_USE_SSE2
+    const __m128i quote  = _mm_set1_epi8('"');
+    const __m128i comma  = _mm_set1_epi8(',');
+    const __m128i bit20  = _mm_set1_epi8(0x20);
+    const __m128i open   = _mm_set1_epi8('{');
+    const __m128i close  = _mm_set1_epi8('}');
+    while (end - ptr >= 16) {
+        __m128i chunk  = _mm_loadu_si128((const __m128i*)ptr);
+        __m128i folded = _mm_or_si128(chunk, bit20);
+        __m128i hits   = _mm_or_si128(
+                             _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                          _mm_cmpeq_epi8(chunk, comma)),
+                             _mm_or_si128(_mm_cmpeq_epi8(folded, open),
+                                          _mm_cmpeq_epi8(folded, close)));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask) { return ptr + SI_lowest_bit(mask); }
+        ptr += 16;
+    }
+#else
+    while (end - ptr >= 8) {
+        uint64_t word   = SI_load_word(ptr);
+        uint64_t folded = word | (ONES * 0x20);
+        uint64_t hits   = SI_match_byte(word, '"')
+                          | SI_match_byte(word, ',')
+                          | SI_match_byte(folded, '{')
+                          | SI_match_byte(folded, '}');
+        if (hits) { break; }
+        ptr += 8;
+    }
+#endif
+    while (ptr < end) {
+        uint8_t c = *ptr;
+        if (c == '"' || c == ',' || (c | 0x20) == '{' || (c | 0x20) == '}') {
+            break;
+        }
+        ptr++;
+    }
+    return ptr;
+}
+
+static CFISH_INLINE bool
+SI_is_space(uint8_t c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+typedef struct {
+    uint32_t *counts;
+    size_t    num_containers;
+    size_t    cap;
+} ContainerIndex;
+
+// A container which hasn't been closed yet.
+typedef struct {
+    size_t   container;
+    uint32_t num_commas;
+} OpenContainer;
+
+// Structural pass: find every array and object and count its elements, so
+// that the parser can allocate containers of the right size.  Counts are
+// stored in the order of the opening brackets.  Malformed input isn't
+// detected here, only by the parser, but the counts are never trusted
+// beyond their use as a capacity hint.
+static bool
+S_index_containers(const uint8_t *start, const uint8_t *end,
+                   ContainerIndex *index) {
+    // The stack of open containers grows on demand, so that shallow
+    // documents don't pay for MAX_DEPTH entries.
+    OpenContainer *open_containers = NULL;
+    int            stack_cap       = 0;
+    int            depth           = 0;
+    bool           ok              = true;
+
+    const uint8_t *ptr = start;
+    while (ok && (ptr = S_find_structural(ptr, end)) < end) {
+        switch (*ptr) {
+            case '"':
+                // Skip the string, including escaped quotes.
+                for (ptr++; ; ptr++) {
+                    ptr = S_find_string_special(ptr, end);
+                    if (ptr >= end || *ptr == '"') { break; }
+                    if (*ptr == '\\' && ++ptr >= end) { break; }
+                }
+                break;
+            case '[':
+            case '{':
+                if (depth >= MAX_DEPTH) {
+                    ok = false;
+                    break;
+                }
+                if (depth == stack_cap) {
+                    stack_cap = stack_cap ? stack_cap * 2 : 16;
+                    if (stack_cap > MAX_DEPTH) { stack_cap = MAX_DEPTH; }
+                    open_containers = (OpenContainer*)REALLOCATE(
+                        open_containers,
+                        (size_t)stack_cap * sizeof(OpenContainer));
+                }
+                if (index->num_containers == index->cap) {
+                    index->cap = Memory_oversize(index->num_containers + 1,
+                                                 sizeof(uint32_t));
+                    index->counts
+                        = (uint32_t*)REALLOCATE(index->counts,
+                                                index->cap * sizeof(uint32_t));
+                }
+                open_containers[depth].container  = index->num_containers;
+                open_containers[depth].num_commas = 0;
+                index->counts[index->num_containers++] = 0;
+                depth++;
+                break;
+            case ']':
+            case '}':
+                if (depth > 0) {
+                    depth--;
+                    const uint8_t *prev = ptr - 1;
+                    while (prev > start && SI_is_space(*prev)) { prev--; }
+                    bool empty = (*prev | 0x20) == '{';
+                    index->counts[open_containers[depth].container]
+                        = empty ? 0 : open_containers[depth].num_commas + 1;
+                }
+                break;
+            case ',':
+                if (depth > 0) { open_containers[depth - 1].num_commas++; }
+                break;
+        }
+        if (ptr >= end) { break; }  // Unterminated string.
+        ptr++;
+    }
+
+    FREEMEM(open_containers);
+    return ok;
+}
+
+/******************************** Decoding *********************************/
+
+typedef struct {
+    const uint8_t  *start;
+    const uint8_t  *ptr;
+    const uint8_t  *end;
+    const uint32_t *counts;
+    size_t          num_counts;
+    size_t          next_container;
+    char           *scratch;
+    size_t          scratch_size;
+    size_t          scratch_cap;
+    Hash           *keys;
+    String         *error;
+} JsonParser;
+
+static bool
+S_fail(JsonParser *parser, const char *problem) {
+    if (parser->ptr >= parser->end) {
+        problem = "unexpected end of input";
+    }
+    parser->error = Str_newf("Can't decode JSON: %s at byte %u64", problem,
+                             (uint64_t)(parser->ptr - parser->start));
+    return false;
+}
+
+static CFISH_INLINE void
+SI_skip_space(JsonParser *parser) {
+    const uint8_t *ptr = parser->ptr;
+    while (ptr < parser->end && SI_is_space(*ptr)) { ptr++; }
+    parser->ptr = ptr;
+}
+
+static CFISH_INLINE size_t
+SI_next_count(JsonParser *parser) {
+    size_t tick = parser->next_container++;
+    return tick < parser->num_counts ? parser->counts[tick] : 0;
+}
+
+static void
+S_scratch_append(JsonParser *parser, const void *bytes, size_t len) {
+    if (len == 0) { return; }
+    if (len > parser->scratch_cap - parser->scratch_size) {
+        parser->scratch_cap
+            = Memory_oversize(parser->scratch_size + len, sizeof(char));
+        parser->scratch
+            = (char*)REALLOCATE(parser->scratch, parser->scratch_cap);
+    }
+    memcpy(parser->scratch + parser->scratch_size, bytes, len);
+    parser->scratch_size += len;
+}
+
+static bool
+S_parse_hex4(JsonParser *parser, uint32_t *result) {
+    if (parser->end - parser->ptr < 4) {
+        parser->ptr = parser->end;
+        return S_fail(parser, "truncated \\u escape");
+    }
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        uint8_t c = *parser->ptr;
+        uint32_t digit;
+        if (c >= '0' && c <= '9')      { digit = c - '0'; }
+        else if (c >= 'a' && c <= 'f') { digit = c - 'a' + 10; }
+        else if (c >= 'A' && c <= 'F') { digit = c - 'A' + 10; }
+        else { return S_fail(parser, "invalid \\u escape"); }
+        value = (value << 4) | digit;
+        parser->ptr++;
+    }
+    *result = value;
+    return true;
+}
+
+static bool
+S_parse_unicode_escape(JsonParser *parser) {
+    uint32_t code_point;
+    if (!S_parse_hex4(parser, &code_point)) { return false; }
+    if (code_point >= 0xDC00 && code_point <= 0xDFFF) {
+        return S_fail(parser, "unpaired surrogate");
+    }
+    if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+        uint32_t low;
+        if (parser->end - parser->ptr < 2
+            || parser->ptr[0] != '\\'
+            || parser->ptr[1] != 'u'
+           ) {
+            return S_fail(parser, "unpaired surrogate");
+        }
+        parser->ptr += 2;
+        if (!S_parse_hex4(parser, &low)) { return false; }
+        if (low < 0xDC00 || low > 0xDFFF) {
+            return S_fail(parser, "unpaired surrogate");
+        }
+        code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+    }
+
+    uint8_t utf8[4];
+    size_t  len;
+    if (code_point < 0x80) {
+        utf8[0] = (uint8_t)code_point;
+        len = 1;
+    }
+    else if (code_point < 0x800) {
+        utf8[0] = (uint8_t)(0xC0 | (code_point >> 6));
+        utf8[1] = (uint8_t)(0x80 | (code_point & 0x3F));
+        len = 2;
+    }
+    else if (code_point < 0x10000) {
+        utf8[0] = (uint8_t)(0xE0 | (code_point >> 12));
+        utf8[1] = (uint8_t)(0x80 | ((code_point >> 6) & 0x3F));
+        utf8[2] = (uint8_t)(0x80 | (code_point & 0x3F));
+        len = 3;
+    }
+    else {
+        utf8[0] = (uint8_t)(0xF0 | (code_point >> 18));
+        utf8[1] = (uint8_t)(0x80 | ((code_point >> 12) & 0x3F));
+        utf8[2] = (uint8_t)(0x80 | ((code_point >> 6) & 0x3F));
+        utf8[3] = (uint8_t)(0x80 | (code_point & 0x3F));
+        len = 4;
+    }
+    S_scratch_append(parser, utf8, len);
+    return true;
+}
+
+// Parse the content of a string, starting after the opening quote.  Strings
+// without escapes point into the input, others into the scratch buffer,
+// which is overwritten by the next string.
+static bool
+S_parse_string_content(JsonParser *parser, const char **utf8, size_t *size,
+                       bool *in_scratch) {
+    const uint8_t *end = parser->end;
+    const uint8_t *run = parser->ptr;
+    const uint8_t *ptr = S_find_string_special(run, end);
+
+    if (ptr < end && *ptr == '"') {
+        *utf8       = (const char*)run;
+        *size       = (size_t)(ptr - run);
+        *in_scratch = false;
+        parser->ptr = ptr + 1;
+        return true;
+    }
+
+    parser->scratch_size = 0;
+    while (1) {
+        parser->ptr = ptr;
+        if (ptr >= end) {
+            return S_fail(parser, "unterminated string");
+        }
+        S_scratch_append(parser, run, (size_t)(ptr - run));
+        uint8_t c = *ptr;
+        if (c == '"') {
+            break;
+        }
+        if (c != '\\') {
+            return S_fail(parser, "control character in string");
+        }
+
+        parser->ptr = ++ptr;
+        if (ptr >= end) {
+            return S_fail(parser, "unterminated string");
+        }
+        char unescaped;
+        switch (*ptr) {
+            case '"':  unescaped = '"';  break;
+            case '\\': unescaped = '\\'; break;
+            case '/':  unescaped = '/';  break;
+            case 'b':  unescaped = '\b'; break;
+            case 'f':  unescaped = '\f'; break;
+            case 'n':  unescaped = '\n'; break;
+            case 'r':  unescaped = '\r'; break;
+            case 't':  unescaped = '\t'; break;
+            case 'u':
+                parser->ptr++;
+                if (!S_parse_unicode_escape(parser)) { return false; }
+                run = parser->ptr;
+                ptr = S_find_string_special(run, end);
+                continue;
+            default:
+                return S_fail(parser, "invalid escape");
+        }
+        S_scratch_append(parser, &unescaped, 1);
+        run = ptr + 1;
+        ptr = S_find_string_special(run, end);
+    }
+
+    *utf8       = parser->scratch;
+    *size       = parser->scratch_size;
+    *in_scratch = true;
+    parser->ptr = ptr + 1;
+    return true;
+}
+
+static CFISH_INLINE bool
+SI_is_digit(uint8_t c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool
+S_parse_number(JsonParser *parser, Obj **result) {
+    const uint8_t *start = parser->ptr;
+    const uint8_t *end   = parser->end;
+    const uint8_t *ptr   = start;
+    bool           negative = false;
+    uint64_t       mantissa = 0;
+
+    if (*ptr == '-') {
+        negative = true;
+        ptr++;
+    }
+    const uint8_t *digits = ptr;
+    if (ptr < end && *ptr == '0') {
+        ptr++;
+    }
+    else {
+        while (ptr < end && SI_is_digit(*ptr)) {
+            mantissa = mantissa * 10 + (uint64_t)(*ptr - '0');
+            ptr++;
+        }
+    }
+    size_t num_digits = (size_t)(ptr - digits);
+    if (num_digits == 0) {
+        parser->ptr = ptr;
+        return S_fail(parser, "invalid number");
+    }
+
+    bool is_float = false;
+    if (ptr < end && *ptr == '.') {
+        is_float = true;
+        const uint8_t *frac = ++ptr;
+        while (ptr < end && SI_is_digit(*ptr)) { ptr++; }
+        if (ptr == frac) {
+            parser->ptr = ptr;
+            return S_fail(parser, "invalid number");
+        }
+    }
+    if (ptr < end && (*ptr | 0x20) == 'e') {
+        is_float = true;
+        ptr++;
+        if (ptr < end && (*ptr == '+' || *ptr == '-')) { ptr++; }
+        const uint8_t *exp = ptr;
+        while (ptr < end && SI_is_digit(*ptr)) { ptr++; }
+        if (ptr == exp) {
+            parser->ptr = ptr;
+            return S_fail(parser, "invalid number");
+        }
+    }
+    parser->ptr = ptr;
+
+    if (!is_float) {
+        // Up to 19 digits can't overflow the mantissa.
+        if (num_digits <= 18) {
+            int64_t value = (int64_t)mantissa;
+            *result = (Obj*)Int_new(negative ? -value : value);
+            return true;
+        }
+        if (num_digits == 19) {
+            if (!negative && mantissa <= (uint64_t)INT64_MAX) {
+                *result = (Obj*)Int_new((int64_t)mantissa);
+                return true;
+            }
+            if (negative && mantissa <= (uint64_t)INT64_MAX) {
+                *result = (Obj*)Int_new(-(int64_t)mantissa);
+                return true;
+            }
+            if (negative && mantissa == (uint64_t)INT64_MAX + 1) {
+                *result = (Obj*)Int_new(INT64_MIN);
+                return true;
+            }
+        }
+        // Too large for an Integer, fall back to Float.
+    }
+
+    double value = S_strtod((const char*)start, (size_t)(ptr - start));
+    *result = (Obj*)Float_new(value);
+    return true;
+}
+
+static bool
+S_parse_literal(JsonParser *parser, const char *literal, size_t len) {
+    if ((size_t)(parser->end - parser->ptr) < len
+        || memcmp(parser->ptr, literal, len) != 0
+       ) {
+        return S_fail(parser, "invalid literal");
+    }
+    parser->ptr += len;
+    return true;
+}
+
+// Return a String for an object key.  Documents tend to repeat the same
+// keys, so unescaped keys are shared between all objects.
+static String*
+S_make_key(JsonParser *parser, const char *utf8, size_t size,
+           bool in_scratch) {
+    if (in_scratch) {
+        return Str_new_from_trusted_utf8(utf8, size);
+    }
+    String *wrapped = SSTR_WRAP_UTF8(utf8, size);
+    String *key     = (String*)Hash_Fetch(parser->keys, wrapped);
+    if (key) {
+        return (String*)INCREF(key);
+    }
+    key = Str_new_from_trusted_utf8(utf8, size);
+    if (Hash_Get_Size(parser->keys) < MAX_SHARED_KEYS) {
+        Hash_Store(parser->keys, key, INCREF(key));
+    }
+    return key;
+}
+
+static bool
+S_parse_value(JsonParser *parser, int depth, Obj **result);
+
+static bool
+S_parse_array(JsonParser *parser, int depth, Obj **result) {
+    if (depth >= MAX_DEPTH) {
+        return S_fail(parser, "data structure nested too deeply");
+    }
+    Vector *vector = Vec_new(SI_next_count(parser));
+    parser->ptr++;
+    SI_skip_space(parser);
+    if (parser->ptr < parser->end && *parser->ptr == ']') {
+        parser->ptr++;
+        *result = (Obj*)vector;
+        return true;
+    }
+
+    while (1) {
+        Obj *elem;
+        if (!S_parse_value(parser, depth + 1, &elem)) {
+            DECREF(vector);
+            return false;
+        }
+        Vec_Push(vector, elem);
+        SI_skip_space(parser);
+        if (parser->ptr < parser->end) {
+            uint8_t c = *parser->ptr++;
+            if (c == ',') {
+                SI_skip_space(parser);
+                continue;
+            }
+            if (c == ']') { break; }
+            parser->ptr--;
+        }
+        DECREF(vector);
+        return S_fail(parser, "expected ',' or ']'");
+    }
+
+    *result = (Obj*)vector;
+    return true;
+}
+
+static bool
+S_parse_object(JsonParser *parser, int depth, Obj **result) {
+    if (depth >= MAX_DEPTH) {
+        return S_fail(parser, "data structure nested too deeply");
+    }
+    Hash *hash = Hash_new(SI_next_count(parser));
+    parser->ptr++;
+    SI_skip_space(parser);
+    if (parser->ptr < parser->end && *parser->ptr == '}') {
+        parser->ptr++;
+        *result = (Obj*)hash;
+        return true;
+    }
+
+    while (1) {
+        const char *key_utf8;
+        size_t      key_size;
+        bool        in_scratch;
+        String     *key;
+        Obj        *value;
+
+        if (parser->ptr >= parser->end || *parser->ptr != '"') {
+            DECREF(hash);
+            return S_fail(parser, "expected string key");
+        }
+        parser->ptr++;
+        if (!S_parse_string_content(parser, &key_utf8, &key_size,
+                                    &in_scratch)) {
+            DECREF(hash);
+            return false;
+        }
+        key = S_make_key(parser, key_utf8, key_size, in_scratch);
+
+        SI_skip_space(parser);
+        if (parser->ptr >= parser->end || *parser->ptr != ':') {
+            DECREF(key);
+            DECREF(hash);
+            return S_fail(parser, "expected ':'");
+        }
+        parser->ptr++;
+        SI_skip_space(parser);
+        if (!S_parse_value(parser, depth + 1, &value)) {
+            DECREF(key);
+            DECREF(hash);
+            return false;
+        }
+        Hash_Store(hash, key, value);
+        DECREF(key);
+
+        SI_skip_space(parser);
+        if (parser->ptr < parser->end) {
+            uint8_t c = *parser->ptr++;
+            if (c == ',') {
+                SI_skip_space(parser);
+                continue;
+            }
+            if (c == '}') { break; }
+            parser->ptr--;
+        }
+        DECREF(hash);
+        return S_fail(parser, "expected ',' or '}'");
+    }
+
+    *result = (Obj*)hash;
+    return true;
+}
+
+static bool
+S_parse_value(JsonParser *parser, int depth, Obj **result) {
+    if (parser->ptr >= parser->end) {
+        return S_fail(parser, "unexpected end of input");
+    }
+
+    switch (*parser->ptr) {
+        case '{':
+            return S_parse_object(parser, depth, result);
+        case '[':
+            return S_parse_array(parser, depth, result);
+        case '"': {
+            const char *utf8;
+            size_t      size;
+            bool        in_scratch;
+            parser->ptr++;
+            if (!S_parse_string_content(parser, &utf8, &size, &in_scratch)) {
+                return false;
+            }
+            *result = (Obj*)Str_new_from_trusted_utf8(utf8, size);
+            return true;
+        }
+        case 't':
+            *result = (Obj*)CFISH_TRUE;
+            return S_parse_literal(parser, "true", 4);
+        case 'f':
+            *result = (Obj*)CFISH_FALSE;
+            return S_parse_literal(parser, "false", 5);
+        case 'n':
+            *result = NULL;
+            return S_parse_literal(parser, "null", 4);
+        case '-':
+        case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+            return S_parse_number(parser, result);
+        default:
+            return S_fail(parser, "unexpected character");
+    }
+}
+
+static Obj*
+S_decode(const char *json, size_t size) {
+    JsonParser parser;
+    parser.start          = (const uint8_t*)json;
+    parser.ptr            = parser.start;
+    parser.end            = parser.start + size;
+    parser.next_container = 0;
+    parser.scratch        = NULL;
+    parser.scratch_size   = 0;
+    parser.scratch_cap    = 0;
+    parser.error          = NULL;
+
+    ContainerIndex index;
+    index.counts         = NULL;
+    index.num_containers = 0;
+    index.cap            = 0;
+    if (!S_index_containers(parser.start, parser.end, &index)) {
+        FREEMEM(index.counts);
+        THROW(ERR, "Can't decode JSON: data structure nested too deeply");
+    }
+    parser.counts     = index.counts;
+    parser.num_counts = index.num_containers;
+    parser.keys       = Hash_new(0);
+
+    Obj *result = NULL;
+    SI_skip_space(&parser);
+    if (S_parse_value(&parser, 0, &result)) {
+        SI_skip_space(&parser);
+        if (parser.ptr != parser.end) {
+            DECREF(result);
+            S_fail(&parser, "trailing garbage");
+        }
+    }
+
+    FREEMEM(index.counts);
+    FREEMEM(parser.scratch);
+    DECREF(parser.keys);
+    if (parser.error) { Err_throw_mess(ERR, parser.error); }
+    return result;
+}
+
+Obj*
+Json_decode(String *json) {
+    return S_decode(Str_Get_Ptr8(json), Str_Get_Size(json));
+}
+
+Obj*
+Json_decode_utf8(const char *json, size_t size) {
+    if (!Str_utf8_valid(json, size)) {
+        THROW(ERR, "Can't decode JSON: invalid UTF-8");
+    }
+    return S_decode(json, size);
+}
+
+/******************************** Encoding *********************************/
+
+static void
+S_grow(CharBuf *target, size_t len) {
+    if (len > SIZE_MAX - target->size) {
+        THROW(ERR, "CharBuf size overflow");
+    }
+    CB_Grow(target, Memory_oversize(target->size + len, sizeof(char)));
+}
+
+static CFISH_INLINE char*
+SI_reserve(CharBuf *target, size_t len) {
+    if (len > target->cap - target->size) { S_grow(target, len); }
+    return target->ptr + target->size;
+}
+
+static CFISH_INLINE void
+SI_cat(CharBuf *target, const void *bytes, size_t len) {
+    char *ptr = SI_reserve(target, len);
+    memcpy(ptr, bytes, len);
+    target->size += len;
+}
+
+static CFISH_INLINE void
+SI_cat_char(CharBuf *target, char c) {
+    char *ptr = SI_reserve(target, 1);
+    *ptr = c;
+    target->size++;
+}
+
+static void
+S_cat_string(CharBuf *target, const char *utf8, size_t size) {
+    static const char hex[] = "0123456789abcdef";
+    const uint8_t *ptr = (const uint8_t*)utf8;
+    const uint8_t *end = ptr + size;
+
+    SI_cat_char(target, '"');
+    while (1) {
+        const uint8_t *special = S_find_string_special(ptr, end);
+        SI_cat(target, ptr, (size_t)(special - ptr));
+        if (special == end) { break; }
+
+        char    escape[6] = { '\\', 0, 0, 0, 0, 0 };
+        size_t  len       = 2;
+        uint8_t c         = *special;
+        switch (c) {
+            case '"':  escape[1] = '"';  break;
+            case '\\': escape[1] = '\\'; break;
+            case '\b': escape[1] = 'b';  break;
+            case '\f': escape[1] = 'f';  break;
+            case '\n': escape[1] = 'n';  break;
+            case '\r': escape[1] = 'r';  break;
+            case '\t': escape[1] = 't';  break;
+            default:
+                escape[1] = 'u';
+                escape[2] = '0';
+                escape[3] = '0';
+                escape[4] = hex[c >> 4];
+                escape[5] = hex[c & 0xF];
+                len = 6;
+                break;
+        }
+        SI_cat(target, escape, len);
+        ptr = special + 1;
+    }
+    SI_cat_char(target, '"');
+}
+
+static void
+S_cat_i64(CharBuf *target, int64_t value) {
+    char     buf[24];
+    char    *end = buf + sizeof(buf);
+    char    *ptr = end;
+    uint64_t magnitude = value < 0
+                         ? (uint64_t)0 - (uint64_t)value
+                         : (uint64_t)value;
+    do {
+        *--ptr = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) { *--ptr = '-'; }
+    SI_cat(target, ptr, (size_t)(end - ptr));
+}
+
+static void
+S_cat_f64(CharBuf *target, double value) {
+    // Use the shorter representation if it survives a round trip.
+    char buf[40];
+    int  len = S_format_f64(buf, 15, value);
+    if (S_strtod(buf, (size_t)len) != value) {
+        len = S_format_f64(buf, 17, value);
+    }
+    // Keep the number a Float when it's decoded again.
+    if (strpbrk(buf, ".eE") == NULL) {
+        buf[len++] = '.';
+        buf[len++] = '0';
+    }
+    SI_cat(target, buf, (size_t)len);
+}
+
+// Return an error message on failure, or NULL on success.
+static String*
+S_encode(Obj *obj, CharBuf *target, int depth) {
+    if (obj == NULL) {
+        SI_cat(target, "null", 4);
+        return NULL;
+    }
+
+    Class *klass = Obj_get_class(obj);
+    if (klass == STRING) {
+        String *string = (String*)obj;
+        S_cat_string(target, Str_Get_Ptr8(string), Str_Get_Size(string));
+    }
+    else if (klass == INTEGER) {
+        S_cat_i64(target, Int_Get_Value((Integer*)obj));
+    }
+    else if (klass == FLOAT) {
+        double value = Float_Get_Value((Float*)obj);
+        if (isnan(value) || isinf(value)) {
+            return Str_newf("Can't encode %f64 as JSON", value);
+        }
+        S_cat_f64(target, value);
+    }
+    else if (klass == BOOLEAN) {
+        if (Bool_Get_Value((Boolean*)obj)) {
+            SI_cat(target, "true", 4);
+        }
+        else {
+            SI_cat(target, "false", 5);
+        }
+    }
+    else if (Obj_is_a(obj, VECTOR)) {
+        if (depth >= MAX_DEPTH) {
+            return Str_newf("Data structure nested too deeply");
+        }
+        Vector *vector = (Vector*)obj;
+        size_t  size   = Vec_Get_Size(vector);
+        SI_cat_char(target, '[');
+        for (size_t i = 0; i < size; i++) {
+            if (i > 0) { SI_cat_char(target, ','); }
+            String *error = S_encode(Vec_Fetch(vector, i), target, depth + 1);
+            if (error) { return error; }
+        }
+        SI_cat_char(target, ']');
+    }
+    else if (Obj_is_a(obj, HASH)) {
+        if (depth >= MAX_DEPTH) {
+            return Str_newf("Data structure nested too deeply");
+        }
+        HashIterator *iter  = HashIter_new((Hash*)obj);
+        bool          first = true;
+        SI_cat_char(target, '{');
+        while (HashIter_Next(iter)) {
+            String *key = HashIter_Get_Key(iter);
+            if (!first) { SI_cat_char(target, ','); }
+            first = false;
+            S_cat_string(target, Str_Get_Ptr8(key), Str_Get_Size(key));
+            SI_cat_char(target, ':');
+            String *error = S_encode(HashIter_Get_Value(iter), target,
+                                     depth + 1);
+            if (error) {
+                DECREF(iter);
+                return error;
+            }
+        }
+        DECREF(iter);
+        SI_cat_char(target, '}');
+    }
+    else {
+        return Str_newf("Can't encode object of class %o as JSON",
+                        Class_Get_Name(klass));
+    }
+
+    return NULL;
+}
+
+void
+Json_encode_into(Obj *obj, CharBuf *target) {
+    size_t  orig_size = target->size;
+    String *error     = S_encode(obj, target, 0);
+    if (error) {
+        // Don't leave partial JSON behind.
+        target->size = orig_size;
+        Err_throw_mess(ERR, error);
+    }
+}
+
+String*
+Json_encode(Obj *obj) {
+    CharBuf *buf   = CB_new(64);
+    String  *error = S_encode(obj, buf, 0);
+    if (error) {
+        DECREF(buf);
+        Err_throw_mess(ERR, error);
+    }
+    String *json = CB_Yield_String(buf);
+    DECREF(buf);
+    return json;
+}
+
@@ -23,9 +23,43 @@
 #include <stdio.h>
 
 #include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/Atomic.h"
+#include "Clownfish/Util/Threads.h"
+#include "Clownfish/Util/Trace.h"
+
+// Allocations of this size or larger are traced.
+#define LARGE_ALLOC_SIZE (1024 * 1024)
+
+// A hook and its context.  Records are published with a single pointer,
+// so a thread never sees a hook with the context of another.  They're
+// immutable and never freed, because a thread may still be calling a hook
+// after it was replaced.  Installing the same hook and context again reuses
+// the record, so there are only as many records as distinct pairs.
+typedef struct AllocHook {
+    Memory_Alloc_Hook_t  hook;
+    void                *context;
+    struct AllocHook    *next;
+} AllocHook;
+
+static void      *alloc_hook       = NULL;
+static SpinLock   alloc_hooks_lock = SPINLOCK_INIT;
+static AllocHook *alloc_hooks      = NULL;
+
+static CFISH_INLINE void
+SI_call_alloc_hook(size_t size) {
+    AllocHook *record = (AllocHook*)alloc_hook;
+    if (record) {
+        record->hook(record->context, size);
+    }
+}
 
 void*
 Memory_wrapped_malloc(size_t count) {
+    SI_call_alloc_hook(count);
+    if (Trace_enabled && count >= LARGE_ALLOC_SIZE) {
+        Trace_record(TRACE_PHASE_INSTANT, "Memory", "large malloc",
+                     (int64_t)count);
+    }
     void *pointer = malloc(count);
     if (pointer == NULL && count != 0) {
         fprintf(stderr, "Can't malloc %" PRIu64 " bytes.\n", (uint64_t)count);
@@ -36,6 +70,11 @@ Memory_wrapped_malloc(size_t count) {
 
 void*
 Memory_wrapped_calloc(size_t count, size_t size) {
+    SI_call_alloc_hook(count * size);
+    if (Trace_enabled && count * size >= LARGE_ALLOC_SIZE) {
+        Trace_record(TRACE_PHASE_INSTANT, "Memory", "large calloc",
+                     (int64_t)(count * size));
+    }
     void *pointer = calloc(count, size);
     if (pointer == NULL && count != 0) {
         fprintf(stderr, "Can't calloc %" PRIu64 " elements of size %" PRIu64 ".\n",
@@ -47,6 +86,11 @@ Memory_wrapped_calloc(size_t count, size_t size) {
 
 void*
 Memory_wrapped_realloc(void *ptr, size_t size) {
+    SI_call_alloc_hook(size);
+    if (Trace_enabled && size >= LARGE_ALLOC_SIZE) {
+        Trace_record(TRACE_PHASE_INSTANT, "Memory", "large realloc",
+                     (int64_t)size);
+    }
     void *pointer = realloc(ptr, size);
     if (pointer == NULL && size != 0) {
         fprintf(stderr, "Can't realloc %" PRIu64 " bytes.\n", (uint64_t)size);
@@ -60,6 +104,39 @@ Memory_wrapped_free(void *ptr) {
     free(ptr);
 }
 
+void
+Memory_set_alloc_hook(Memory_Alloc_Hook_t hook, void *context) {
+    AllocHook *record = NULL;
+
+    if (hook) {
+        SpinLock_lock(&alloc_hooks_lock);
+        for (AllocHook *other = alloc_hooks; other; other = other->next) {
+            if (other->hook == hook && other->context == context) {
+                record = other;
+                break;
+            }
+        }
+        if (record == NULL) {
+            // Not MALLOCATE, which would call the current hook.
+            record = (AllocHook*)malloc(sizeof(AllocHook));
+            if (record == NULL) {
+                fprintf(stderr, "Can't malloc alloc hook.\n");
+                exit(1);
+            }
+            record->hook    = hook;
+            record->context = context;
+            record->next    = alloc_hooks;
+            alloc_hooks     = record;
+        }
+        SpinLock_unlock(&alloc_hooks_lock);
+    }
+
+    void *old_record;
+    do {
+        old_record = alloc_hook;
+    } while (!Atomic_cas_ptr(&alloc_hook, old_record, record));
+}
+
 size_t
 Memory_oversize(size_t minimum, size_t width) {
     // For larger arrays, grow by an excess of 1/8; grow faster when the array
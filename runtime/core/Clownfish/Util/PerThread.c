@@ -0,0 +1,207 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define CFISH_USE_SHORT_NAMES
+
+#include "charmony.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Clownfish/Util/PerThread.h"
+#include "Clownfish/Util/Atomic.h"
+
+typedef struct Block {
+    struct Block *next;
+    PerThread    *owner;
+    union {
+        uint64_t  u64;
+        double    f64;
+        void     *ptr;
+    } data[1];
+} Block;
+
+#define BLOCK_DATA_OFFSET offsetof(Block, data)
+
+// Blocks must not be allocated with MALLOCATE which might call an
+// allocation hook using a PerThread.
+static void*
+S_calloc(size_t size) {
+    void *pointer = calloc(1, size);
+    if (pointer == NULL) {
+        fprintf(stderr, "Can't calloc %" PRIu64 " bytes.\n", (uint64_t)size);
+        exit(1);
+    }
+    return pointer;
+}
+
+static Block*
+S_new_block(PerThread *self) {
+    Block *block = (Block*)S_calloc(BLOCK_DATA_OFFSET + self->block_size);
+    block->owner = self;
+    PerThread_lock(self);
+    block->next  = (Block*)self->blocks;
+    self->blocks = block;
+    PerThread_unlock(self);
+    return block;
+}
+
+#if !defined(CFISH_NOTHREADS) \
+    && (defined(CHY_HAS_WINDOWS_H) || defined(CHY_HAS_PTHREAD_H))
+
+// Merge the counters of an exiting thread and free its block.
+static void
+S_retire_block(Block *block) {
+    PerThread *self = block->owner;
+
+    PerThread_lock(self);
+    Block **next_ptr = (Block**)&self->blocks;
+    while (*next_ptr != block) {
+        next_ptr = &(*next_ptr)->next;
+    }
+    *next_ptr = block->next;
+    if (self->retired == NULL) {
+        self->retired = S_calloc(self->block_size);
+    }
+    self->merge(self->retired, block->data);
+    PerThread_unlock(self);
+
+    free(block);
+}
+
+#endif
+
+/********************************** Windows ********************************/
+#if !defined(CFISH_NOTHREADS) && defined(CHY_HAS_WINDOWS_H)
+
+#include <windows.h>
+
+// Fiber-local storage, unlike TlsAlloc, supports a destructor which is
+// called when a thread exits.
+static VOID WINAPI
+S_thread_exit(PVOID value) {
+    if (value) {
+        S_retire_block((Block*)value);
+    }
+}
+
+static DWORD*
+S_key(PerThread *self) {
+    DWORD *key = (DWORD*)self->key;
+    if (key == NULL) {
+        PerThread_lock(self);
+        if (self->key == NULL) {
+            DWORD *new_key = (DWORD*)S_calloc(sizeof(DWORD));
+            *new_key = FlsAlloc(S_thread_exit);
+            if (*new_key == FLS_OUT_OF_INDEXES) {
+                fprintf(stderr, "FlsAlloc failed.\n");
+                exit(1);
+            }
+            Atomic_cas_ptr(&self->key, NULL, new_key);
+        }
+        key = (DWORD*)self->key;
+        PerThread_unlock(self);
+    }
+    return key;
+}
+
+void*
+PerThread_get_block(PerThread *self) {
+    DWORD *key   = S_key(self);
+    Block *block = (Block*)FlsGetValue(*key);
+    if (block == NULL) {
+        block = S_new_block(self);
+        FlsSetValue(*key, block);
+    }
+    return block->data;
+}
+
+/********************************* pthreads ********************************/
+#elif !defined(CFISH_NOTHREADS) && defined(CHY_HAS_PTHREAD_H)
+
+#include <pthread.h>
+
+static void
+S_thread_exit(void *value) {
+    S_retire_block((Block*)value);
+}
+
+static pthread_key_t*
+S_key(PerThread *self) {
+    pthread_key_t *key = (pthread_key_t*)self->key;
+    if (key == NULL) {
+        PerThread_lock(self);
+        if (self->key == NULL) {
+            pthread_key_t *new_key
+                = (pthread_key_t*)S_calloc(sizeof(pthread_key_t));
+            if (pthread_key_create(new_key, S_thread_exit) != 0) {
+                fprintf(stderr, "pthread_key_create failed.\n");
+                exit(1);
+            }
+            Atomic_cas_ptr(&self->key, NULL, new_key);
+        }
+        key = (pthread_key_t*)self->key;
+        PerThread_unlock(self);
+    }
+    return key;
+}
+
+void*
+PerThread_get_block(PerThread *self) {
+    pthread_key_t *key   = S_key(self);
+    Block         *block = (Block*)pthread_getspecific(*key);
+    if (block == NULL) {
+        block = S_new_block(self);
+        pthread_setspecific(*key, block);
+    }
+    return block->data;
+}
+
+/***************************** Single threaded *****************************/
+#else
+
+void*
+PerThread_get_block(PerThread *self) {
+    Block *block = (Block*)self->blocks;
+    if (block == NULL) {
+        block = S_new_block(self);
+    }
+    return block->data;
+}
+
+#endif
+
+void
+PerThread_each(PerThread *self, PerThread_Visit_t visit, void *context) {
+    for (Block *block = (Block*)self->blocks; block; block = block->next) {
+        visit(context, block->data);
+    }
+    if (self->retired) {
+        visit(context, self->retired);
+    }
+}
+
+void
+PerThread_lock(PerThread *self) {
+    SpinLock_lock(&self->lock);
+}
+
+void
+PerThread_unlock(PerThread *self) {
+    SpinLock_unlock(&self->lock);
+}
+
@@ -0,0 +1,103 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef H_CLOWNFISH_UTIL_PERTHREAD
+#define H_CLOWNFISH_UTIL_PERTHREAD 1
+
+#include <stddef.h>
+
+#include "charmony.h"
+#include "cfish_parcel.h"
+#include "Clownfish/Util/Threads.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Per-thread blocks of counters.
+ *
+ * Every thread gets its own zeroed block of `block_size` bytes, so
+ * counters can be updated without atomics or locks.  When a thread exits,
+ * its block is added to a block for retired threads with the `merge`
+ * callback and freed.  Readers take the lock and add up all blocks with
+ * cfish_PerThread_each.  The counters of running threads are read without
+ * synchronization, so they may be slightly out of date.
+ *
+ * Registries are meant to be static variables initialized with
+ * CFISH_PERTHREAD_INIT.  They're never destroyed.
+ */
+
+/** Add the counters in `src` to `dest`.  Called with the lock held.
+ */
+typedef void
+(*cfish_PerThread_Merge_t)(void *dest, void *src);
+
+typedef void
+(*cfish_PerThread_Visit_t)(void *context, void *block);
+
+typedef struct cfish_PerThread {
+    size_t                   block_size;
+    cfish_PerThread_Merge_t  merge;
+    cfish_SpinLock           lock;
+    void                    *key;      /* Thread-local key, created lazily. */
+    void                    *blocks;   /* Blocks of running threads. */
+    void                    *retired;  /* Counters of exited threads. */
+} cfish_PerThread;
+
+#define CFISH_PERTHREAD_INIT(block_size, merge) \
+    { (block_size), (merge), CFISH_SPINLOCK_INIT, NULL, NULL, NULL }
+
+/** Return the block of the calling thread, creating it on first use.
+ *
+ * Blocks are allocated with the system allocator, not with MALLOCATE, so
+ * this is safe to call from an allocation hook.
+ */
+void*
+cfish_PerThread_get_block(cfish_PerThread *self);
+
+/** Call `visit` with every block, including the block of retired threads.
+ * Must be called with the lock held.
+ */
+void
+cfish_PerThread_each(cfish_PerThread *self, cfish_PerThread_Visit_t visit,
+                     void *context);
+
+/** Take the lock of the registry.  The lock is a spinlock, so it should
+ * only be held for short stretches.  It isn't recursive.
+ */
+void
+cfish_PerThread_lock(cfish_PerThread *self);
+
+void
+cfish_PerThread_unlock(cfish_PerThread *self);
+
+#ifdef CFISH_USE_SHORT_NAMES
+  #define PerThread                 cfish_PerThread
+  #define PerThread_Merge_t         cfish_PerThread_Merge_t
+  #define PerThread_Visit_t         cfish_PerThread_Visit_t
+  #define PERTHREAD_INIT            CFISH_PERTHREAD_INIT
+  #define PerThread_get_block       cfish_PerThread_get_block
+  #define PerThread_each            cfish_PerThread_each
+  #define PerThread_lock            cfish_PerThread_lock
+  #define PerThread_unlock          cfish_PerThread_unlock
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* H_CLOWNFISH_UTIL_PERTHREAD */
+
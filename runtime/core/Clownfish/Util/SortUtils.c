@@ -18,24 +18,75 @@
 #define CFISH_USE_SHORT_NAMES
 
 #include <string.h>
+
 #include "Clownfish/Util/SortUtils.h"
 #include "Clownfish/Err.h"
+#include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/ThreadPool.h"
+
+// Runs shorter than this are extended with insertion sort before merging.
+#define MIN_MERGE 64
+
+// Number of consecutive wins by one run which switches a merge into
+// galloping mode.
+#define MIN_GALLOP 7
+
+// Enough pending runs for any array addressable on a 64-bit machine, given
+// the stack invariants maintained by S_merge_collapse.
+#define MAX_PENDING_RUNS 85
+
+// pdqsort tuning parameters.
+#define INSERTION_SORT_THRESHOLD 24
+#define NINTHER_THRESHOLD        128
+#define PARTIAL_INSERTION_LIMIT  8
+
+typedef struct {
+    size_t base;
+    size_t len;
+} SortRun;
+
+typedef struct {
+    uint8_t              *elems;
+    uint8_t              *scratch;
+    size_t                width;
+    CFISH_Sort_Compare_t  compare;
+    void                 *context;
+    size_t                num_runs;
+    SortRun               runs[MAX_PENDING_RUNS];
+} SortState;
 
-// Recursive merge sorting functions.
+// Width-specialized stable sorts.
 static void
-S_msort4(void *velems, void *vscratch, size_t left, size_t right,
-         CFISH_Sort_Compare_t compare, void *context);
+S_mergesort4(SortState *state, size_t num_elems);
 static void
-S_msort8(void *velems, void *vscratch, size_t left, size_t right,
-         CFISH_Sort_Compare_t compare, void *context);
+S_mergesort8(SortState *state, size_t num_elems);
 static void
-S_msort_any(void *velems, void *vscratch, size_t left, size_t right,
-            CFISH_Sort_Compare_t compare, void *context, size_t width);
+S_mergesort16(SortState *state, size_t num_elems);
+static void
+S_mergesort_any(SortState *state, size_t num_elems);
 
-static CFISH_INLINE void
-SI_merge(void *left_vptr,  size_t left_size,
-         void *right_vptr, size_t right_size,
-         void *vdest, size_t width, CFISH_Sort_Compare_t compare, void *context);
+// Width-specialized unstable sorts.
+static void
+S_quicksort4(uint8_t *elems, size_t num_elems,
+             CFISH_Sort_Compare_t compare, void *context);
+static void
+S_quicksort8(uint8_t *elems, size_t num_elems,
+             CFISH_Sort_Compare_t compare, void *context);
+static void
+S_quicksort16(uint8_t *elems, size_t num_elems,
+              CFISH_Sort_Compare_t compare, void *context);
+static void
+S_quicksort_any(uint8_t *elems, size_t num_elems, size_t width,
+                CFISH_Sort_Compare_t compare, void *context);
+
+// Sort in parallel.  If `key_size` is nonzero, elements are radix sorted by
+// the unsigned integer key of that size at their start; otherwise they are
+// merge sorted using `compare`.  Return false without sorting if the input
+// is too small or the pool has no workers.
+static bool
+S_parallel_sort(uint8_t *elems, uint8_t *scratch, size_t num_elems,
+                size_t width, size_t key_size, CFISH_Sort_Compare_t compare,
+                void *context, ThreadPool *pool);
 
 void
 Sort_mergesort(void *elems, void *scratch, size_t num_elems, size_t width,
@@ -43,105 +94,1394 @@ Sort_mergesort(void *elems, void *scratch, size_t num_elems, size_t width,
     // Arrays of 0 or 1 items are already sorted.
     if (num_elems < 2) { return; }
 
+    SortState state;
+    state.elems    = (uint8_t*)elems;
+    state.scratch  = (uint8_t*)scratch;
+    state.width    = width;
+    state.compare  = compare;
+    state.context  = context;
+    state.num_runs = 0;
+
     // Dispatch by element size.
     switch (width) {
         case 0:
             THROW(ERR, "Parameter 'width' cannot be 0");
             break;
         case 4:
-            S_msort4(elems, scratch, 0, num_elems - 1, compare, context);
+            S_mergesort4(&state, num_elems);
             break;
         case 8:
-            S_msort8(elems, scratch, 0, num_elems - 1, compare, context);
+            S_mergesort8(&state, num_elems);
+            break;
+        case 16:
+            S_mergesort16(&state, num_elems);
             break;
         default:
-            S_msort_any(elems, scratch, 0, num_elems - 1, compare,
-                        context, width);
+            S_mergesort_any(&state, num_elems);
             break;
     }
 }
 
-#define WIDTH 4
+void
+Sort_quicksort(void *elems, size_t num_elems, size_t width,
+               CFISH_Sort_Compare_t compare, void *context) {
+    // Arrays of 0 or 1 items are already sorted.
+    if (num_elems < 2) { return; }
+
+    // Dispatch by element size.
+    switch (width) {
+        case 0:
+            THROW(ERR, "Parameter 'width' cannot be 0");
+            break;
+        case 4:
+            S_quicksort4((uint8_t*)elems, num_elems, compare, context);
+            break;
+        case 8:
+            S_quicksort8((uint8_t*)elems, num_elems, compare, context);
+            break;
+        case 16:
+            S_quicksort16((uint8_t*)elems, num_elems, compare, context);
+            break;
+        default:
+            S_quicksort_any((uint8_t*)elems, num_elems, width, compare,
+                            context);
+            break;
+    }
+}
+
+/**************************** Element moves ********************************/
+
+// When `width` is a compile-time constant, these reduce to register moves.
+
+static CFISH_INLINE void
+SI_copy(void *dest, const void *source, size_t width) {
+    memcpy(dest, source, width);
+}
+
+static CFISH_INLINE void
+SI_swap(uint8_t *a, uint8_t *b, size_t width) {
+    uint8_t temp[16];
+    while (width > sizeof(temp)) {
+        memcpy(temp, a, sizeof(temp));
+        memcpy(a, b, sizeof(temp));
+        memcpy(b, temp, sizeof(temp));
+        a     += sizeof(temp);
+        b     += sizeof(temp);
+        width -= sizeof(temp);
+    }
+    memcpy(temp, a, width);
+    memcpy(a, b, width);
+    memcpy(b, temp, width);
+}
+
+static CFISH_INLINE void
+SI_reverse(uint8_t *lo, uint8_t *hi, size_t width) {
+    // `hi` is exclusive.
+    while (hi - lo > (ptrdiff_t)width) {
+        hi -= width;
+        SI_swap(lo, hi, width);
+        lo += width;
+    }
+}
+
+/***************************** Stable sort *********************************/
+
+// Compute the minimum run length for an array of `num_elems` elements, such
+// that `num_elems / min_run` is a power of two or slightly less.
+static CFISH_INLINE size_t
+SI_min_run_length(size_t num_elems) {
+    size_t extra = 0;
+    while (num_elems >= MIN_MERGE) {
+        extra |= num_elems & 1;
+        num_elems >>= 1;
+    }
+    return num_elems + extra;
+}
+
+// Return the length of the run starting at `lo`, which is at most
+// `num_elems` long.  Strictly descending runs are reversed in place, so the
+// returned run is always ascending and stability is preserved.
+static CFISH_INLINE size_t
+SI_count_run(SortState *state, uint8_t *lo, size_t num_elems,
+             const size_t width) {
+    CFISH_Sort_Compare_t compare = state->compare;
+    void *context = state->context;
+    uint8_t *limit = lo + num_elems * width;
+    uint8_t *ptr   = lo + width;
+
+    if (ptr == limit) { return 1; }
+    if (compare(context, ptr, lo) < 0) {
+        ptr += width;
+        while (ptr < limit && compare(context, ptr, ptr - width) < 0) {
+            ptr += width;
+        }
+        SI_reverse(lo, ptr, width);
+    }
+    else {
+        ptr += width;
+        while (ptr < limit && compare(context, ptr, ptr - width) >= 0) {
+            ptr += width;
+        }
+    }
+    return (size_t)(ptr - lo) / width;
+}
+
+// Sort `num_elems` elements starting at `lo` using binary insertion sort.
+// The first `sorted` elements must already be in order.  The scratch buffer
+// is used to hold the element being inserted.
+static CFISH_INLINE void
+SI_binary_insertion_sort(SortState *state, uint8_t *lo, size_t num_elems,
+                         size_t sorted, const size_t width) {
+    CFISH_Sort_Compare_t compare = state->compare;
+    void *context = state->context;
+    uint8_t *temp = state->scratch;
+
+    for (size_t i = sorted; i < num_elems; i++) {
+        uint8_t *pivot = lo + i * width;
+        size_t left  = 0;
+        size_t right = i;
+
+        // Find the position after the last element which is <= pivot.
+        while (left < right) {
+            size_t mid = left + (right - left) / 2;
+            if (compare(context, pivot, lo + mid * width) < 0) {
+                right = mid;
+            }
+            else {
+                left = mid + 1;
+            }
+        }
+        if (left < i) {
+            uint8_t *dest = lo + left * width;
+            SI_copy(temp, pivot, width);
+            memmove(dest + width, dest, (i - left) * width);
+            SI_copy(dest, temp, width);
+        }
+    }
+}
+
+// Return the number of elements at the start of the ascending array `base`
+// which are less than `key` (if `strict`) or less than or equal to `key`
+// (otherwise).  The search gallops from the front or the back of the array,
+// making it cheap when the answer lies close to that end.
+static CFISH_INLINE size_t
+SI_gallop(SortState *state, const uint8_t *key, const uint8_t *base,
+          size_t num_elems, bool strict, bool from_back,
+          const size_t width) {
+    CFISH_Sort_Compare_t compare = state->compare;
+    void *context = state->context;
+    const int threshold = strict ? 1 : 0;
+    size_t lo, hi;
+
+    // Narrow down the range [lo, hi] which contains the answer.
+    if (!from_back) {
+        size_t offset = 1;
+        lo = 0;
+        while (offset <= num_elems
+               && compare(context, key, base + (offset - 1) * width)
+                  >= threshold
+              ) {
+            lo = offset;
+            offset = (offset << 1) + 1;
+        }
+        hi = offset <= num_elems ? offset - 1 : num_elems;
+    }
+    else {
+        size_t offset = 1;
+        hi = num_elems;
+        while (offset <= num_elems
+               && compare(context, key, base + (num_elems - offset) * width)
+                  < threshold
+              ) {
+            hi = num_elems - offset;
+            offset = (offset << 1) + 1;
+        }
+        lo = offset <= num_elems ? num_elems - offset + 1 : 0;
+    }
+
+    // Binary search.
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (compare(context, key, base + mid * width) >= threshold) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+// Merge the adjacent ascending runs `a` and `b`, where `a` is no longer
+// than `b`.  Only `a` is copied to scratch; the merge proceeds front to
+// back.  The first element of `b` must sort before the first element of `a`
+// and the last element of `a` must sort after the last element of `b`.
+static CFISH_INLINE void
+SI_merge_lo(SortState *state, uint8_t *a, size_t len_a, uint8_t *b,
+            size_t len_b, const size_t width) {
+    CFISH_Sort_Compare_t compare = state->compare;
+    void *context = state->context;
+    uint8_t *dest  = a;
+    uint8_t *ptr_a = state->scratch;
+    uint8_t *ptr_b = b;
+
+    memcpy(ptr_a, a, len_a * width);
+
+    while (len_a > 0 && len_b > 0) {
+        size_t wins_a = 0;
+        size_t wins_b = 0;
+
+        // Merge one element at a time until one run starts winning
+        // consistently.
+        do {
+            if (compare(context, ptr_b, ptr_a) < 0) {
+                SI_copy(dest, ptr_b, width);
+                dest  += width;
+                ptr_b += width;
+                len_b--;
+                wins_b++;
+                wins_a = 0;
+            }
+            else {
+                SI_copy(dest, ptr_a, width);
+                dest  += width;
+                ptr_a += width;
+                len_a--;
+                wins_a++;
+                wins_b = 0;
+            }
+        } while (len_a > 0 && len_b > 0
+                 && wins_a < MIN_GALLOP && wins_b < MIN_GALLOP);
+
+        // Gallop, moving whole stretches of elements at once, for as long
+        // as that keeps paying off.
+        while (len_a > 0 && len_b > 0) {
+            wins_a = SI_gallop(state, ptr_b, ptr_a, len_a, false, false,
+                               width);
+            memcpy(dest, ptr_a, wins_a * width);
+            dest  += wins_a * width;
+            ptr_a += wins_a * width;
+            len_a -= wins_a;
+            if (len_a == 0) { break; }
+
+            SI_copy(dest, ptr_b, width);
+            dest  += width;
+            ptr_b += width;
+            len_b--;
+            if (len_b == 0) { break; }
+
+            wins_b = SI_gallop(state, ptr_a, ptr_b, len_b, true, false,
+                               width);
+            memmove(dest, ptr_b, wins_b * width);
+            dest  += wins_b * width;
+            ptr_b += wins_b * width;
+            len_b -= wins_b;
+            if (len_b == 0) { break; }
+
+            SI_copy(dest, ptr_a, width);
+            dest  += width;
+            ptr_a += width;
+            len_a--;
+
+            if (wins_a < MIN_GALLOP && wins_b < MIN_GALLOP) { break; }
+        }
+    }
+
+    // Whatever remains of `b` is already in place.
+    memcpy(dest, ptr_a, len_a * width);
+}
+
+// Merge the adjacent ascending runs `a` and `b`, where `b` is no longer
+// than `a`.  Only `b` is copied to scratch; the merge proceeds back to
+// front.  Preconditions as for SI_merge_lo.
+static CFISH_INLINE void
+SI_merge_hi(SortState *state, uint8_t *a, size_t len_a, uint8_t *b,
+            size_t len_b, const size_t width) {
+    CFISH_Sort_Compare_t compare = state->compare;
+    void *context = state->context;
+    uint8_t *dest_end = b + len_b * width;
+
+    memcpy(state->scratch, b, len_b * width);
+
+    // End pointers are exclusive.
+    uint8_t *end_a = a + len_a * width;
+    uint8_t *end_b = state->scratch + len_b * width;
+
+    while (len_a > 0 && len_b > 0) {
+        size_t wins_a = 0;
+        size_t wins_b = 0;
+
+        do {
+            if (compare(context, end_b - width, end_a - width) < 0) {
+                dest_end -= width;
+                end_a    -= width;
+                SI_copy(dest_end, end_a, width);
+                len_a--;
+                wins_a++;
+                wins_b = 0;
+            }
+            else {
+                dest_end -= width;
+                end_b    -= width;
+                SI_copy(dest_end, end_b, width);
+                len_b--;
+                wins_b++;
+                wins_a = 0;
+            }
+        } while (len_a > 0 && len_b > 0
+                 && wins_a < MIN_GALLOP && wins_b < MIN_GALLOP);
+
+        while (len_a > 0 && len_b > 0) {
+            // Elements of `a` which sort after the last element of `b`.
+            size_t keep = SI_gallop(state, end_b - width, a, len_a, false,
+                                    true, width);
+            wins_a = len_a - keep;
+            dest_end -= wins_a * width;
+            end_a    -= wins_a * width;
+            memmove(dest_end, end_a, wins_a * width);
+            len_a = keep;
+            if (len_a == 0) { break; }
+
+            dest_end -= width;
+            end_b    -= width;
+            SI_copy(dest_end, end_b, width);
+            len_b--;
+            if (len_b == 0) { break; }
+
+            // Elements of `b` which sort at or after the last element of
+            // `a`.
+            keep = SI_gallop(state, end_a - width, state->scratch, len_b,
+                             true, true, width);
+            wins_b = len_b - keep;
+            dest_end -= wins_b * width;
+            end_b    -= wins_b * width;
+            memcpy(dest_end, end_b, wins_b * width);
+            len_b = keep;
+            if (len_b == 0) { break; }
+
+            dest_end -= width;
+            end_a    -= width;
+            SI_copy(dest_end, end_a, width);
+            len_a--;
+
+            if (wins_a < MIN_GALLOP && wins_b < MIN_GALLOP) { break; }
+        }
+    }
+
+    // Whatever remains of `a` is already in place.
+    memcpy(a, state->scratch, len_b * width);
+}
+
+// Merge the pending runs at stack positions `i` and `i + 1`.
+static CFISH_INLINE void
+SI_merge_at(SortState *state, size_t i, const size_t width) {
+    SortRun *runs  = state->runs;
+    uint8_t *a     = state->elems + runs[i].base * width;
+    size_t   len_a = runs[i].len;
+    uint8_t *b     = state->elems + runs[i + 1].base * width;
+    size_t   len_b = runs[i + 1].len;
+
+    runs[i].len = len_a + len_b;
+    if (i + 3 == state->num_runs) {
+        runs[i + 1] = runs[i + 2];
+    }
+    state->num_runs--;
+
+    // Elements at the start of `a` which sort before `b` are in place.
+    size_t skip = SI_gallop(state, b, a, len_a, false, false, width);
+    a     += skip * width;
+    len_a -= skip;
+    if (len_a == 0) { return; }
+
+    // Elements at the end of `b` which sort after `a` are in place.
+    len_b = SI_gallop(state, a + (len_a - 1) * width, b, len_b, true, true,
+                      width);
+    if (len_b == 0) { return; }
+
+    if (len_a <= len_b) {
+        SI_merge_lo(state, a, len_a, b, len_b, width);
+    }
+    else {
+        SI_merge_hi(state, a, len_a, b, len_b, width);
+    }
+}
+
+// Merge pending runs until the lengths on the stack decrease at least as
+// fast as the Fibonacci sequence, which keeps merges balanced.
+static CFISH_INLINE void
+SI_merge_collapse(SortState *state, const size_t width) {
+    SortRun *runs = state->runs;
+    while (state->num_runs > 1) {
+        size_t n = state->num_runs - 2;
+        if ((n > 0 && runs[n - 1].len <= runs[n].len + runs[n + 1].len)
+            || (n > 1 && runs[n - 2].len <= runs[n - 1].len + runs[n].len)
+           ) {
+            if (runs[n - 1].len < runs[n + 1].len) { n--; }
+        }
+        else if (runs[n].len > runs[n + 1].len) {
+            break;
+        }
+        SI_merge_at(state, n, width);
+    }
+}
+
+static CFISH_INLINE void
+SI_mergesort(SortState *state, size_t num_elems, const size_t width) {
+    const size_t min_run = SI_min_run_length(num_elems);
+    size_t lo = 0;
+
+    while (lo < num_elems) {
+        uint8_t *run_start = state->elems + lo * width;
+        size_t   remaining = num_elems - lo;
+        size_t   run_len   = SI_count_run(state, run_start, remaining,
+                                          width);
+
+        // Extend short runs.
+        if (run_len < min_run) {
+            size_t forced = remaining < min_run ? remaining : min_run;
+            SI_binary_insertion_sort(state, run_start, forced, run_len,
+                                     width);
+            run_len = forced;
+        }
+
+        state->runs[state->num_runs].base = lo;
+        state->runs[state->num_runs].len  = run_len;
+        state->num_runs++;
+        SI_merge_collapse(state, width);
+        lo += run_len;
+    }
+
+    // Merge all remaining runs.
+    while (state->num_runs > 1) {
+        size_t n = state->num_runs - 2;
+        if (n > 0 && state->runs[n - 1].len < state->runs[n + 1].len) {
+            n--;
+        }
+        SI_merge_at(state, n, width);
+    }
+}
+
+static void
+S_mergesort4(SortState *state, size_t num_elems) {
+    SI_mergesort(state, num_elems, 4);
+}
+
+static void
+S_mergesort8(SortState *state, size_t num_elems) {
+    SI_mergesort(state, num_elems, 8);
+}
+
+static void
+S_mergesort16(SortState *state, size_t num_elems) {
+    SI_mergesort(state, num_elems, 16);
+}
+
+static void
+S_mergesort_any(SortState *state, size_t num_elems) {
+    SI_mergesort(state, num_elems, state->width);
+}
+
+/**************************** Unstable sort ********************************/
+
+// Pattern-defeating quicksort, after Orson Peters.  Ranges are given as
+// byte pointers with exclusive ends.
+
+static CFISH_INLINE void
+SI_sort2(uint8_t *a, uint8_t *b, CFISH_Sort_Compare_t compare,
+         void *context, const size_t width) {
+    if (compare(context, b, a) < 0) { SI_swap(a, b, width); }
+}
+
+static CFISH_INLINE void
+SI_sort3(uint8_t *a, uint8_t *b, uint8_t *c, CFISH_Sort_Compare_t compare,
+         void *context, const size_t width) {
+    SI_sort2(a, b, compare, context, width);
+    SI_sort2(b, c, compare, context, width);
+    SI_sort2(a, b, compare, context, width);
+}
+
+// Insertion sort.  If `guarded` is false, the element before `begin` must
+// sort before or equal to every element in the range.
+static CFISH_INLINE void
+SI_insertion_sort(uint8_t *begin, uint8_t *end, bool guarded,
+                  CFISH_Sort_Compare_t compare, void *context,
+                  const size_t width) {
+    for (uint8_t *cur = begin + width; cur < end; cur += width) {
+        uint8_t *sift = cur;
+        while ((!guarded || sift > begin)
+               && compare(context, sift, sift - width) < 0
+              ) {
+            SI_swap(sift, sift - width, width);
+            sift -= width;
+        }
+    }
+}
+
+// Attempt an insertion sort, giving up once more than a few elements have
+// had to be moved.  Return true if the range was sorted.
+static CFISH_INLINE bool
+SI_partial_insertion_sort(uint8_t *begin, uint8_t *end,
+                          CFISH_Sort_Compare_t compare, void *context,
+                          const size_t width) {
+    size_t moves = 0;
+    for (uint8_t *cur = begin + width; cur < end; cur += width) {
+        uint8_t *sift = cur;
+        while (sift > begin && compare(context, sift, sift - width) < 0) {
+            SI_swap(sift, sift - width, width);
+            sift -= width;
+            moves++;
+        }
+        if (moves > PARTIAL_INSERTION_LIMIT) { return false; }
+    }
+    return true;
+}
+
+static CFISH_INLINE void
+SI_sift_down(uint8_t *begin, size_t root, size_t size,
+             CFISH_Sort_Compare_t compare, void *context,
+             const size_t width) {
+    while (1) {
+        size_t child = 2 * root + 1;
+        if (child >= size) { break; }
+        if (child + 1 < size
+            && compare(context, begin + child * width,
+                       begin + (child + 1) * width) < 0
+           ) {
+            child++;
+        }
+        if (!(compare(context, begin + root * width,
+                      begin + child * width) < 0)
+           ) {
+            break;
+        }
+        SI_swap(begin + root * width, begin + child * width, width);
+        root = child;
+    }
+}
+
+static CFISH_INLINE void
+SI_heapsort(uint8_t *begin, uint8_t *end, CFISH_Sort_Compare_t compare,
+            void *context, const size_t width) {
+    size_t size = (size_t)(end - begin) / width;
+    for (size_t i = size / 2; i-- > 0;) {
+        SI_sift_down(begin, i, size, compare, context, width);
+    }
+    while (size > 1) {
+        size--;
+        SI_swap(begin, begin + size * width, width);
+        SI_sift_down(begin, 0, size, compare, context, width);
+    }
+}
+
+// Partition around the pivot at `begin`.  Elements equal to the pivot go to
+// the right.  Return the final position of the pivot, and set
+// `already_partitioned` if no elements had to be swapped.
+static CFISH_INLINE uint8_t*
+SI_partition_right(uint8_t *begin, uint8_t *end, bool *already_partitioned,
+                   CFISH_Sort_Compare_t compare, void *context,
+                   const size_t width) {
+    uint8_t *pivot = begin;
+    uint8_t *first = begin;
+    uint8_t *last  = end;
+
+    // Median-of-three selection guarantees that an element >= pivot exists.
+    do {
+        first += width;
+    } while (compare(context, first, pivot) < 0);
+
+    // If `first` did not move, no element < pivot is guaranteed to exist
+    // to stop the search from the right.
+    if (first - width == begin) {
+        while (first < last) {
+            last -= width;
+            if (compare(context, last, pivot) < 0) { break; }
+        }
+    }
+    else {
+        do {
+            last -= width;
+        } while (!(compare(context, last, pivot) < 0));
+    }
+
+    *already_partitioned = first >= last;
+
+    while (first < last) {
+        SI_swap(first, last, width);
+        do {
+            first += width;
+        } while (compare(context, first, pivot) < 0);
+        do {
+            last -= width;
+        } while (!(compare(context, last, pivot) < 0));
+    }
+
+    uint8_t *pivot_pos = first - width;
+    SI_swap(begin, pivot_pos, width);
+    return pivot_pos;
+}
+
+// Partition around the pivot at `begin`.  Elements equal to the pivot go to
+// the left.  Used when the pivot equals its predecessor, in which case no
+// element to the left needs to be sorted again.
+static CFISH_INLINE uint8_t*
+SI_partition_left(uint8_t *begin, uint8_t *end,
+                  CFISH_Sort_Compare_t compare, void *context,
+                  const size_t width) {
+    uint8_t *pivot = begin;
+    uint8_t *first = begin;
+    uint8_t *last  = end;
+
+    do {
+        last -= width;
+    } while (compare(context, pivot, last) < 0);
+
+    if (last + width == end) {
+        while (first < last) {
+            first += width;
+            if (compare(context, pivot, first) < 0) { break; }
+        }
+    }
+    else {
+        do {
+            first += width;
+        } while (!(compare(context, pivot, first) < 0));
+    }
+
+    while (first < last) {
+        SI_swap(first, last, width);
+        do {
+            last -= width;
+        } while (compare(context, pivot, last) < 0);
+        do {
+            first += width;
+        } while (!(compare(context, pivot, first) < 0));
+    }
+
+    SI_swap(begin, last, width);
+    return last;
+}
+
 static void
-S_msort4(void *velems, void *vscratch, size_t left, size_t right,
-         CFISH_Sort_Compare_t compare, void *context) {
-    uint8_t *elems   = (uint8_t*)velems;
-    uint8_t *scratch = (uint8_t*)vscratch;
-    if (right > left) {
-        const size_t mid = left + (right - left) / 2 + 1;
-        S_msort4(elems, scratch, left, mid - 1, compare, context);
-        S_msort4(elems, scratch, mid,  right, compare, context);
-        SI_merge((elems + left * WIDTH), (mid - left),
-                 (elems + mid * WIDTH), (right - mid + 1),
-                 scratch, WIDTH, compare, context);
-        memcpy((elems + left * WIDTH), scratch, ((right - left + 1) * WIDTH));
+S_pdqsort_loop(uint8_t *begin, uint8_t *end, int bad_allowed, bool leftmost,
+               CFISH_Sort_Compare_t compare, void *context,
+               const size_t width);
+
+static CFISH_INLINE void
+SI_pdqsort_loop(uint8_t *begin, uint8_t *end, int bad_allowed,
+                bool leftmost, CFISH_Sort_Compare_t compare, void *context,
+                const size_t width) {
+    while (1) {
+        size_t size = (size_t)(end - begin) / width;
+
+        if (size < INSERTION_SORT_THRESHOLD) {
+            SI_insertion_sort(begin, end, leftmost, compare, context, width);
+            return;
+        }
+
+        // Move the pivot to `begin`: median of three, or pseudomedian of
+        // nine for larger ranges.
+        size_t half = size / 2;
+        if (size > NINTHER_THRESHOLD) {
+            SI_sort3(begin, begin + half * width, end - width,
+                     compare, context, width);
+            SI_sort3(begin + width, begin + (half - 1) * width,
+                     end - 2 * width, compare, context, width);
+            SI_sort3(begin + 2 * width, begin + (half + 1) * width,
+                     end - 3 * width, compare, context, width);
+            SI_sort3(begin + (half - 1) * width, begin + half * width,
+                     begin + (half + 1) * width, compare, context, width);
+            SI_swap(begin, begin + half * width, width);
+        }
+        else {
+            SI_sort3(begin + half * width, begin, end - width,
+                     compare, context, width);
+        }
+
+        // If the pivot equals the predecessor of this range, it is the
+        // smallest value in the range.  Put all equal elements to the left
+        // and continue with the rest.
+        if (!leftmost && !(compare(context, begin - width, begin) < 0)) {
+            begin = SI_partition_left(begin, end, compare, context, width)
+                    + width;
+            continue;
+        }
+
+        bool already_partitioned;
+        uint8_t *pivot_pos
+            = SI_partition_right(begin, end, &already_partitioned,
+                                 compare, context, width);
+
+        size_t left_size  = (size_t)(pivot_pos - begin) / width;
+        size_t right_size = (size_t)(end - pivot_pos) / width - 1;
+
+        if (left_size < size / 8 || right_size < size / 8) {
+            // Too many bad partitions: fall back to heapsort, which
+            // guarantees O(n log n).
+            if (--bad_allowed == 0) {
+                SI_heapsort(begin, end, compare, context, width);
+                return;
+            }
+
+            // Break up patterns which may have caused the imbalance.
+            if (left_size >= INSERTION_SORT_THRESHOLD) {
+                size_t q = left_size / 4;
+                SI_swap(begin, begin + q * width, width);
+                SI_swap(pivot_pos - width, pivot_pos - q * width, width);
+                if (left_size > NINTHER_THRESHOLD) {
+                    SI_swap(begin + width, begin + (q + 1) * width, width);
+                    SI_swap(begin + 2 * width, begin + (q + 2) * width,
+                            width);
+                    SI_swap(pivot_pos - 2 * width,
+                            pivot_pos - (q + 1) * width, width);
+                    SI_swap(pivot_pos - 3 * width,
+                            pivot_pos - (q + 2) * width, width);
+                }
+            }
+            if (right_size >= INSERTION_SORT_THRESHOLD) {
+                size_t q = right_size / 4;
+                SI_swap(pivot_pos + width, pivot_pos + (q + 1) * width,
+                        width);
+                SI_swap(end - width, end - q * width, width);
+                if (right_size > NINTHER_THRESHOLD) {
+                    SI_swap(pivot_pos + 2 * width,
+                            pivot_pos + (q + 2) * width, width);
+                    SI_swap(pivot_pos + 3 * width,
+                            pivot_pos + (q + 3) * width, width);
+                    SI_swap(end - 2 * width, end - (q + 1) * width, width);
+                    SI_swap(end - 3 * width, end - (q + 2) * width, width);
+                }
+            }
+        }
+        else if (already_partitioned
+                 && SI_partial_insertion_sort(begin, pivot_pos, compare,
+                                              context, width)
+                 && SI_partial_insertion_sort(pivot_pos + width, end,
+                                              compare, context, width)
+                ) {
+            // The range was (nearly) sorted already.
+            return;
+        }
+
+        // Recurse into the left partition and loop on the right one.
+        S_pdqsort_loop(begin, pivot_pos, bad_allowed, leftmost, compare,
+                       context, width);
+        begin    = pivot_pos + width;
+        leftmost = false;
     }
 }
 
-#undef WIDTH
-#define WIDTH 8
 static void
-S_msort8(void *velems, void *vscratch, size_t left, size_t right,
-         CFISH_Sort_Compare_t compare, void *context) {
-    uint8_t *elems   = (uint8_t*)velems;
-    uint8_t *scratch = (uint8_t*)vscratch;
-    if (right > left) {
-        const size_t mid = left + (right - left) / 2 + 1;
-        S_msort8(elems, scratch, left, mid - 1, compare, context);
-        S_msort8(elems, scratch, mid,  right, compare, context);
-        SI_merge((elems + left * WIDTH), (mid - left),
-                 (elems + mid * WIDTH), (right - mid + 1),
-                 scratch, WIDTH, compare, context);
-        memcpy((elems + left * WIDTH), scratch, ((right - left + 1) * WIDTH));
+S_pdqsort_loop(uint8_t *begin, uint8_t *end, int bad_allowed, bool leftmost,
+               CFISH_Sort_Compare_t compare, void *context,
+               const size_t width) {
+    switch (width) {
+        case 4:
+            SI_pdqsort_loop(begin, end, bad_allowed, leftmost, compare,
+                            context, 4);
+            break;
+        case 8:
+            SI_pdqsort_loop(begin, end, bad_allowed, leftmost, compare,
+                            context, 8);
+            break;
+        case 16:
+            SI_pdqsort_loop(begin, end, bad_allowed, leftmost, compare,
+                            context, 16);
+            break;
+        default:
+            SI_pdqsort_loop(begin, end, bad_allowed, leftmost, compare,
+                            context, width);
+            break;
     }
 }
 
-#undef WIDTH
+// Return the number of bad partitions tolerated before switching to
+// heapsort: floor(log2(num_elems)).
+static CFISH_INLINE int
+SI_log2(size_t num_elems) {
+    int log = 0;
+    while (num_elems >>= 1) { log++; }
+    return log;
+}
+
+static void
+S_quicksort4(uint8_t *elems, size_t num_elems,
+             CFISH_Sort_Compare_t compare, void *context) {
+    SI_pdqsort_loop(elems, elems + num_elems * 4, SI_log2(num_elems), true,
+                    compare, context, 4);
+}
+
 static void
-S_msort_any(void *velems, void *vscratch, size_t left, size_t right,
-            CFISH_Sort_Compare_t compare, void *context, size_t width) {
-    uint8_t *elems   = (uint8_t*)velems;
-    uint8_t *scratch = (uint8_t*)vscratch;
-    if (right > left) {
-        const size_t mid = left + (right - left) / 2 + 1;
-        S_msort_any(elems, scratch, left, mid - 1, compare, context, width);
-        S_msort_any(elems, scratch, mid,  right,   compare, context, width);
-        SI_merge((elems + left * width), (mid - left),
-                 (elems + mid * width), (right - mid + 1),
-                 scratch, width, compare, context);
-        memcpy((elems + left * width), scratch, ((right - left + 1) * width));
+S_quicksort8(uint8_t *elems, size_t num_elems,
+             CFISH_Sort_Compare_t compare, void *context) {
+    SI_pdqsort_loop(elems, elems + num_elems * 8, SI_log2(num_elems), true,
+                    compare, context, 8);
+}
+
+static void
+S_quicksort16(uint8_t *elems, size_t num_elems,
+              CFISH_Sort_Compare_t compare, void *context) {
+    SI_pdqsort_loop(elems, elems + num_elems * 16, SI_log2(num_elems), true,
+                    compare, context, 16);
+}
+
+static void
+S_quicksort_any(uint8_t *elems, size_t num_elems, size_t width,
+                CFISH_Sort_Compare_t compare, void *context) {
+    SI_pdqsort_loop(elems, elems + num_elems * width, SI_log2(num_elems),
+                    true, compare, context, width);
+}
+
+/****************************** Radix sort *********************************/
+
+// Elements shorter than this are sorted with insertion sort by
+// radixsort_bytes.
+#define BYTES_INSERTION_THRESHOLD 32
+
+static CFISH_INLINE uint64_t
+SI_load_key(const uint8_t *elem, const size_t key_size) {
+    if (key_size == 4) {
+        uint32_t key;
+        memcpy(&key, elem, sizeof(key));
+        return key;
+    }
+    else {
+        uint64_t key;
+        memcpy(&key, elem, sizeof(key));
+        return key;
     }
 }
 
+// Sort elements of `width` bytes by the native unsigned integer of
+// `key_size` bytes at their start, one byte per pass.  Passes in which every
+// key has the same byte are skipped.
 static CFISH_INLINE void
-SI_merge(void *left_vptr,  size_t left_size,
-         void *right_vptr, size_t right_size,
-         void *vdest, size_t width, CFISH_Sort_Compare_t compare,
-         void *context) {
-    uint8_t *left_ptr    = (uint8_t*)left_vptr;
-    uint8_t *right_ptr   = (uint8_t*)right_vptr;
-    uint8_t *left_limit  = left_ptr + left_size * width;
-    uint8_t *right_limit = right_ptr + right_size * width;
-    uint8_t *dest        = (uint8_t*)vdest;
+SI_lsd_radix(uint8_t *elems, uint8_t *scratch, size_t num_elems,
+             const size_t width, const size_t key_size) {
+    size_t counts[8][256];
+    memset(counts, 0, sizeof(counts));
 
-    while (left_ptr < left_limit && right_ptr < right_limit) {
-        if (compare(context, left_ptr, right_ptr) < 1) {
-            memcpy(dest, left_ptr, width);
-            dest += width;
-            left_ptr += width;
+    // Build the histograms for all passes at once.
+    for (size_t i = 0; i < num_elems; i++) {
+        uint64_t key = SI_load_key(elems + i * width, key_size);
+        for (size_t pass = 0; pass < key_size; pass++) {
+            counts[pass][(key >> (pass * 8)) & 0xFF]++;
+        }
+    }
+
+    const uint64_t first_key = SI_load_key(elems, key_size);
+    uint8_t *source = elems;
+    uint8_t *dest   = scratch;
+
+    for (size_t pass = 0; pass < key_size; pass++) {
+        const size_t shift = pass * 8;
+        size_t *count = counts[pass];
+        if (count[(first_key >> shift) & 0xFF] == num_elems) { continue; }
+
+        // Turn counts into bucket offsets.
+        size_t offset = 0;
+        for (size_t digit = 0; digit < 256; digit++) {
+            size_t digit_count = count[digit];
+            count[digit] = offset;
+            offset += digit_count;
+        }
+
+        for (size_t i = 0; i < num_elems; i++) {
+            const uint8_t *elem = source + i * width;
+            size_t digit = (SI_load_key(elem, key_size) >> shift) & 0xFF;
+            SI_copy(dest + count[digit]++ * width, elem, width);
+        }
+
+        uint8_t *temp = source;
+        source = dest;
+        dest   = temp;
+    }
+
+    if (source != elems) {
+        memcpy(elems, source, num_elems * width);
+    }
+}
+
+// Elements 4 bytes wide have 32-bit keys; all others have 64-bit keys.
+static void
+S_radix_serial(uint8_t *elems, uint8_t *scratch, size_t num_elems,
+               size_t width) {
+    switch (width) {
+        case 4:
+            SI_lsd_radix(elems, scratch, num_elems, 4, 4);
+            break;
+        case 8:
+            SI_lsd_radix(elems, scratch, num_elems, 8, 8);
+            break;
+        case 16:
+            SI_lsd_radix(elems, scratch, num_elems, 16, 8);
+            break;
+        default:
+            SI_lsd_radix(elems, scratch, num_elems, width, 8);
+            break;
+    }
+}
+
+// Radix sort, in parallel if a pool is given and the input is large enough.
+static void
+S_radix(uint8_t *elems, uint8_t *scratch, size_t num_elems, size_t width,
+        size_t key_size, ThreadPool *pool) {
+    if (pool == NULL
+        || !S_parallel_sort(elems, scratch, num_elems, width, key_size, NULL,
+                            NULL, pool)
+       ) {
+        S_radix_serial(elems, scratch, num_elems, width);
+    }
+}
+
+void
+Sort_radixsort_u32(uint32_t *elems, uint32_t *scratch, size_t num_elems,
+                   ThreadPool *pool) {
+    if (num_elems < 2) { return; }
+    S_radix((uint8_t*)elems, (uint8_t*)scratch, num_elems, 4, 4, pool);
+}
+
+void
+Sort_radixsort_i32(int32_t *elems, int32_t *scratch, size_t num_elems,
+                   ThreadPool *pool) {
+    if (num_elems < 2) { return; }
+
+    // Flipping the sign bit maps two's complement order to unsigned order.
+    uint32_t *keys = (uint32_t*)elems;
+    for (size_t i = 0; i < num_elems; i++) { keys[i] ^= UINT32_C(1) << 31; }
+    S_radix((uint8_t*)elems, (uint8_t*)scratch, num_elems, 4, 4, pool);
+    for (size_t i = 0; i < num_elems; i++) { keys[i] ^= UINT32_C(1) << 31; }
+}
+
+void
+Sort_radixsort_u64(uint64_t *elems, uint64_t *scratch, size_t num_elems,
+                   ThreadPool *pool) {
+    if (num_elems < 2) { return; }
+    S_radix((uint8_t*)elems, (uint8_t*)scratch, num_elems, 8, 8, pool);
+}
+
+void
+Sort_radixsort_i64(int64_t *elems, int64_t *scratch, size_t num_elems,
+                   ThreadPool *pool) {
+    if (num_elems < 2) { return; }
+
+    uint64_t *keys = (uint64_t*)elems;
+    for (size_t i = 0; i < num_elems; i++) { keys[i] ^= UINT64_C(1) << 63; }
+    S_radix((uint8_t*)elems, (uint8_t*)scratch, num_elems, 8, 8, pool);
+    for (size_t i = 0; i < num_elems; i++) { keys[i] ^= UINT64_C(1) << 63; }
+}
+
+void
+Sort_radixsort_f64(double *elems, double *scratch, size_t num_elems,
+                   ThreadPool *pool) {
+    const uint64_t sign_bit = UINT64_C(1) << 63;
+    size_t num_numbers = 0;
+    size_t num_nans    = 0;
+
+    // Move NaNs to the end, preserving their order.
+    for (size_t i = 0; i < num_elems; i++) {
+        if (elems[i] != elems[i]) {
+            scratch[num_nans++] = elems[i];
+        }
+        else {
+            elems[num_numbers++] = elems[i];
+        }
+    }
+    memcpy(elems + num_numbers, scratch, num_nans * sizeof(double));
+    if (num_numbers < 2) { return; }
+
+    // Map IEEE 754 order to unsigned order: flip all bits of negative
+    // numbers and only the sign bit of positive numbers.
+    for (size_t i = 0; i < num_numbers; i++) {
+        uint64_t bits;
+        memcpy(&bits, elems + i, sizeof(bits));
+        bits = (bits & sign_bit) ? ~bits : bits | sign_bit;
+        memcpy(elems + i, &bits, sizeof(bits));
+    }
+    S_radix((uint8_t*)elems, (uint8_t*)scratch, num_numbers, 8, 8, pool);
+    for (size_t i = 0; i < num_numbers; i++) {
+        uint64_t bits;
+        memcpy(&bits, elems + i, sizeof(bits));
+        bits = (bits & sign_bit) ? bits & ~sign_bit : ~bits;
+        memcpy(elems + i, &bits, sizeof(bits));
+    }
+}
+
+void
+Sort_radixsort_keyed(void *elems, void *scratch, size_t num_elems,
+                     size_t width, ThreadPool *pool) {
+    if (width < 8 || width % 8 != 0) {
+        THROW(ERR, "Invalid width for keyed radix sort: %u64",
+              (uint64_t)width);
+    }
+    if (num_elems < 2) { return; }
+    S_radix((uint8_t*)elems, (uint8_t*)scratch, num_elems, width, 8, pool);
+}
+
+// Compare two byte string keys, ignoring their first `depth` bytes.
+static CFISH_INLINE int
+SI_compare_bytes(const cfish_SortByteKey *a, const cfish_SortByteKey *b,
+                 size_t depth) {
+    size_t a_size = a->size - depth;
+    size_t b_size = b->size - depth;
+    size_t min_size = a_size < b_size ? a_size : b_size;
+    int comparison = memcmp(a->ptr + depth, b->ptr + depth, min_size);
+    if (comparison != 0) { return comparison; }
+    return a_size < b_size ? -1 : a_size > b_size ? 1 : 0;
+}
+
+// Return 0 for keys which end before `depth` and the byte at `depth` plus
+// one otherwise.
+static CFISH_INLINE size_t
+SI_bucket(const cfish_SortByteKey *key, size_t depth) {
+    return depth < key->size ? (size_t)key->ptr[depth] + 1 : 0;
+}
+
+// Sort byte string keys which share their first `depth` bytes.  Recurse
+// into all buckets but the largest and loop on the largest, which bounds
+// the recursion depth by log2(num_elems).
+static void
+S_msd_radix(cfish_SortByteKey *elems, cfish_SortByteKey *scratch,
+            size_t num_elems, size_t depth) {
+    while (num_elems >= BYTES_INSERTION_THRESHOLD) {
+        size_t counts[257];
+        memset(counts, 0, sizeof(counts));
+        for (size_t i = 0; i < num_elems; i++) {
+            counts[SI_bucket(elems + i, depth)]++;
+        }
+
+        // If all keys fall into the same bucket, look at the next byte.
+        size_t first_bucket = SI_bucket(elems, depth);
+        if (counts[first_bucket] == num_elems) {
+            if (first_bucket == 0) { return; } // All keys are equal.
+            depth++;
+            continue;
+        }
+
+        size_t starts[257];
+        size_t offset = 0;
+        for (size_t bucket = 0; bucket < 257; bucket++) {
+            starts[bucket] = offset;
+            offset += counts[bucket];
+        }
+        for (size_t i = 0; i < num_elems; i++) {
+            size_t bucket = SI_bucket(elems + i, depth);
+            scratch[starts[bucket]++] = elems[i];
+        }
+        memcpy(elems, scratch, num_elems * sizeof(cfish_SortByteKey));
+
+        // Keys in bucket 0 are equal and need no further sorting.
+        size_t largest = 1;
+        for (size_t bucket = 2; bucket < 257; bucket++) {
+            if (counts[bucket] > counts[largest]) { largest = bucket; }
+        }
+        size_t start = counts[0];
+        size_t largest_start = 0;
+        for (size_t bucket = 1; bucket < 257; bucket++) {
+            if (bucket == largest) {
+                largest_start = start;
+            }
+            else if (counts[bucket] > 1) {
+                S_msd_radix(elems + start, scratch + start, counts[bucket],
+                            depth + 1);
+            }
+            start += counts[bucket];
+        }
+
+        elems     += largest_start;
+        scratch   += largest_start;
+        num_elems  = counts[largest];
+        depth++;
+    }
+
+    // Stable insertion sort for small ranges.
+    for (size_t i = 1; i < num_elems; i++) {
+        cfish_SortByteKey temp = elems[i];
+        size_t j = i;
+        while (j > 0 && SI_compare_bytes(&temp, elems + j - 1, depth) < 0) {
+            elems[j] = elems[j - 1];
+            j--;
+        }
+        elems[j] = temp;
+    }
+}
+
+void
+Sort_radixsort_bytes(cfish_SortByteKey *elems, cfish_SortByteKey *scratch,
+                     size_t num_elems) {
+    if (num_elems < 2) { return; }
+    S_msd_radix(elems, scratch, num_elems, 0);
+}
+
+/***************************** Parallel sort *******************************/
+
+// Inputs shorter than this are always sorted by a single thread.
+#define PARALLEL_SORT_THRESHOLD (1 << 16)
+
+// Each thread gets at least this many elements.
+#define PARALLEL_MIN_CHUNK (1 << 14)
+
+enum {
+    SORT_TASK_SORT,
+    SORT_TASK_MERGE
+};
+
+// Either sort `a` using `dest` as scratch space, or merge `a` and `b` into
+// `dest`.
+typedef struct {
+    int      type;
+    uint8_t *a;
+    size_t   a_len;
+    uint8_t *b;
+    size_t   b_len;
+    uint8_t *dest;
+} SortTask;
+
+typedef struct {
+    ThreadPool           *pool;
+    SortTask             *tasks;
+    size_t                num_tasks;
+    size_t                num_workers;
+    size_t                width;
+    size_t                key_size;
+    CFISH_Sort_Compare_t  compare;
+    void                 *context;
+} SortJob;
+
+typedef struct {
+    SortJob *job;
+    size_t   worker_id;
+} SortWorker;
+
+static int
+S_compare_key32(void *context, const void *va, const void *vb) {
+    uint32_t a, b;
+    memcpy(&a, va, sizeof(a));
+    memcpy(&b, vb, sizeof(b));
+    UNUSED_VAR(context);
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static int
+S_compare_key64(void *context, const void *va, const void *vb) {
+    uint64_t a, b;
+    memcpy(&a, va, sizeof(a));
+    memcpy(&b, vb, sizeof(b));
+    UNUSED_VAR(context);
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static void
+S_merge_into(SortJob *job, SortTask *task) {
+    CFISH_Sort_Compare_t compare = job->compare;
+    void     *context = job->context;
+    size_t    width   = job->width;
+    uint8_t  *a       = task->a;
+    uint8_t  *a_limit = a + task->a_len * width;
+    uint8_t  *b       = task->b;
+    uint8_t  *b_limit = b + task->b_len * width;
+    uint8_t  *dest    = task->dest;
+
+    while (a < a_limit && b < b_limit) {
+        if (compare(context, b, a) < 0) {
+            SI_copy(dest, b, width);
+            b += width;
+        }
+        else {
+            SI_copy(dest, a, width);
+            a += width;
+        }
+        dest += width;
+    }
+    memcpy(dest, a, (size_t)(a_limit - a));
+    dest += a_limit - a;
+    memcpy(dest, b, (size_t)(b_limit - b));
+}
+
+static void
+S_run_worker(void *arg) {
+    SortWorker *worker = (SortWorker*)arg;
+    SortJob    *job    = worker->job;
+
+    for (size_t i = worker->worker_id; i < job->num_tasks;
+         i += job->num_workers
+        ) {
+        SortTask *task = job->tasks + i;
+        if (task->type == SORT_TASK_MERGE) {
+            S_merge_into(job, task);
+        }
+        else if (job->key_size) {
+            S_radix_serial(task->a, task->dest, task->a_len, job->width);
+        }
+        else {
+            Sort_mergesort(task->a, task->dest, task->a_len, job->width,
+                           job->compare, job->context);
+        }
+    }
+}
+
+// Run all tasks of a job on the job's thread pool, with the calling thread
+// acting as the first worker.
+static void
+S_run_job(SortJob *job, SortWorker *workers) {
+    TaskGroup *group = TaskGroup_new(job->pool, false);
+    for (size_t i = 1; i < job->num_workers; i++) {
+        workers[i].job       = job;
+        workers[i].worker_id = i;
+        TaskGroup_Run(group, S_run_worker, workers + i);
+    }
+    workers[0].job       = job;
+    workers[0].worker_id = 0;
+    S_run_worker(workers);
+    TaskGroup_Join(group);
+    DECREF(group);
+}
+
+// Return the number of elements which the first `diagonal` elements of the
+// stable merge of `a` and `b` take from `a`.
+static size_t
+S_merge_path(SortJob *job, const uint8_t *a, size_t a_len, const uint8_t *b,
+             size_t b_len, size_t diagonal) {
+    size_t width = job->width;
+    size_t lo = diagonal > b_len ? diagonal - b_len : 0;
+    size_t hi = diagonal < a_len ? diagonal : a_len;
+
+    while (lo < hi) {
+        size_t i = lo + (hi - lo) / 2;
+        size_t j = diagonal - i;
+        // On ties, elements of `a` come first.
+        if (job->compare(job->context, a + i * width, b + (j - 1) * width)
+            <= 0
+           ) {
+            lo = i + 1;
         }
         else {
-            memcpy(dest, right_ptr, width);
-            dest += width;
-            right_ptr += width;
+            hi = i;
+        }
+    }
+
+    return lo;
+}
+
+static bool
+S_parallel_sort(uint8_t *elems, uint8_t *scratch, size_t num_elems,
+                size_t width, size_t key_size, CFISH_Sort_Compare_t compare,
+                void *context, ThreadPool *pool) {
+    if (num_elems < PARALLEL_SORT_THRESHOLD) { return false; }
+    // The calling thread works, too.
+    size_t num_workers = (size_t)ThreadPool_Get_Num_Threads(pool) + 1;
+    if (num_workers > num_elems / PARALLEL_MIN_CHUNK) {
+        num_workers = num_elems / PARALLEL_MIN_CHUNK;
+    }
+    if (num_workers < 2) { return false; }
+
+    SortJob job;
+    job.pool        = pool;
+    job.num_workers = num_workers;
+    job.width       = width;
+    job.key_size    = key_size;
+    job.compare     = compare;
+    job.context     = context;
+    if (key_size) {
+        job.compare = key_size == 4 ? S_compare_key32 : S_compare_key64;
+    }
+
+    // A merge round needs at most one task per worker plus one per pair of
+    // runs.
+    SortTask   *tasks   = (SortTask*)MALLOCATE(2 * num_workers
+                                                * sizeof(SortTask));
+    SortWorker *workers = (SortWorker*)MALLOCATE(num_workers
+                                                 * sizeof(SortWorker));
+    size_t     *bounds  = (size_t*)MALLOCATE((num_workers + 1)
+                                             * sizeof(size_t));
+    job.tasks = tasks;
+
+    // Sort one chunk per worker.
+    for (size_t i = 0; i < num_workers; i++) {
+        size_t lo = num_elems * i / num_workers;
+        size_t hi = num_elems * (i + 1) / num_workers;
+        tasks[i].type  = SORT_TASK_SORT;
+        tasks[i].a     = elems + lo * width;
+        tasks[i].a_len = hi - lo;
+        tasks[i].dest  = scratch + lo * width;
+        bounds[i] = lo;
+    }
+    bounds[num_workers] = num_elems;
+    job.num_tasks = num_workers;
+    S_run_job(&job, workers);
+
+    // Merge pairs of runs until a single run is left.  Each merge is split
+    // along its merge path into pieces of roughly equal size, so all workers
+    // stay busy even in the last rounds.
+    uint8_t *source   = elems;
+    uint8_t *dest     = scratch;
+    size_t   num_runs = num_workers;
+    while (num_runs > 1) {
+        size_t num_tasks    = 0;
+        size_t num_new_runs = 0;
+
+        for (size_t r = 0; r < num_runs; r += 2) {
+            size_t   lo     = bounds[r];
+            size_t   mid    = bounds[r + 1];
+            size_t   hi     = r + 1 < num_runs ? bounds[r + 2] : mid;
+            size_t   len    = hi - lo;
+            uint8_t *a      = source + lo * width;
+            uint8_t *b      = source + mid * width;
+            size_t   a_len  = mid - lo;
+            size_t   b_len  = hi - mid;
+            size_t   pieces = len * num_workers / num_elems;
+            if (pieces == 0) { pieces = 1; }
+
+            size_t prev_diagonal = 0;
+            size_t prev_i        = 0;
+            for (size_t p = 1; p <= pieces; p++) {
+                size_t diagonal = len * p / pieces;
+                size_t i = S_merge_path(&job, a, a_len, b, b_len, diagonal);
+                SortTask *task = tasks + num_tasks++;
+                task->type  = SORT_TASK_MERGE;
+                task->a     = a + prev_i * width;
+                task->a_len = i - prev_i;
+                task->b     = b + (prev_diagonal - prev_i) * width;
+                task->b_len = (diagonal - i) - (prev_diagonal - prev_i);
+                task->dest  = dest + (lo + prev_diagonal) * width;
+                prev_diagonal = diagonal;
+                prev_i        = i;
+            }
+
+            bounds[num_new_runs++] = lo;
         }
+        bounds[num_new_runs] = num_elems;
+
+        job.num_tasks = num_tasks;
+        S_run_job(&job, workers);
+
+        uint8_t *temp = source;
+        source   = dest;
+        dest     = temp;
+        num_runs = num_new_runs;
     }
 
-    const ptrdiff_t left_remaining = left_limit - left_ptr;
-    memcpy(dest, left_ptr, (size_t)left_remaining);
-    dest += left_remaining;
-    const ptrdiff_t right_remaining = right_limit - right_ptr;
-    memcpy(dest, right_ptr, (size_t)right_remaining);
+    if (source != elems) {
+        memcpy(elems, source, num_elems * width);
+    }
+
+    FREEMEM(tasks);
+    FREEMEM(workers);
+    FREEMEM(bounds);
+    return true;
 }
 
+void
+Sort_parallel_mergesort(void *elems, void *scratch, size_t num_elems,
+                        size_t width, CFISH_Sort_Compare_t compare,
+                        void *context, ThreadPool *pool) {
+    if (width == 0) {
+        THROW(ERR, "Parameter 'width' cannot be 0");
+    }
+    if (!S_parallel_sort((uint8_t*)elems, (uint8_t*)scratch, num_elems,
+                         width, 0, compare, context, pool)
+       ) {
+        Sort_mergesort(elems, scratch, num_elems, width, compare, context);
+    }
+}
 
@@ -0,0 +1,504 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_CFISH_THREADPOOL
+#define C_CFISH_TASKGROUP
+#define CFISH_USE_SHORT_NAMES
+
+#include <string.h>
+
+#include "charmony.h"
+
+#include "Clownfish/Util/ThreadPool.h"
+#include "Clownfish/Class.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/Util/Atomic.h"
+#include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/Threads.h"
+
+uint32_t
+ThreadPool_num_cpus() {
+    return Threads_num_cpus();
+}
+
+/****************************** Task deques ********************************/
+
+typedef struct {
+    ThreadPool_Task_t  routine;
+    void              *context;
+    TaskGroup         *group;
+} PoolTask;
+
+// A growable ring buffer of tasks.  `top` and `bottom` only ever increase
+// and are masked on access.  The owning worker pushes and pops at the
+// bottom, thieves take the oldest task from the top.
+typedef struct {
+    Mutex      mutex;
+    PoolTask  *tasks;
+    size_t     cap;
+    size_t     top;
+    size_t     bottom;
+} TaskDeque;
+
+#define DEQUE_INITIAL_CAP 64
+
+static void
+S_deque_init(TaskDeque *deque) {
+    Mutex_init(&deque->mutex);
+    deque->tasks  = (PoolTask*)MALLOCATE(DEQUE_INITIAL_CAP * sizeof(PoolTask));
+    deque->cap    = DEQUE_INITIAL_CAP;
+    deque->top    = 0;
+    deque->bottom = 0;
+}
+
+static void
+S_deque_destroy(TaskDeque *deque) {
+    Mutex_destroy(&deque->mutex);
+    FREEMEM(deque->tasks);
+}
+
+static void
+S_deque_push(TaskDeque *deque, PoolTask *task) {
+    Mutex_lock(&deque->mutex);
+    if (deque->bottom - deque->top == deque->cap) {
+        size_t    new_cap   = deque->cap * 2;
+        PoolTask *new_tasks = (PoolTask*)MALLOCATE(new_cap * sizeof(PoolTask));
+        for (size_t i = deque->top; i < deque->bottom; i++) {
+            new_tasks[i & (new_cap - 1)] = deque->tasks[i & (deque->cap - 1)];
+        }
+        FREEMEM(deque->tasks);
+        deque->tasks = new_tasks;
+        deque->cap   = new_cap;
+    }
+    deque->tasks[deque->bottom & (deque->cap - 1)] = *task;
+    deque->bottom++;
+    Mutex_unlock(&deque->mutex);
+}
+
+static bool
+S_deque_pop(TaskDeque *deque, PoolTask *task) {
+    bool found = false;
+    Mutex_lock(&deque->mutex);
+    if (deque->bottom != deque->top) {
+        deque->bottom--;
+        *task = deque->tasks[deque->bottom & (deque->cap - 1)];
+        found = true;
+    }
+    Mutex_unlock(&deque->mutex);
+    return found;
+}
+
+static bool
+S_deque_steal(TaskDeque *deque, PoolTask *task) {
+    bool found = false;
+    Mutex_lock(&deque->mutex);
+    if (deque->bottom != deque->top) {
+        *task = deque->tasks[deque->top & (deque->cap - 1)];
+        deque->top++;
+        found = true;
+    }
+    Mutex_unlock(&deque->mutex);
+    return found;
+}
+
+/******************************** ThreadPool *******************************/
+
+typedef struct PoolImpl PoolImpl;
+
+typedef struct {
+    PoolImpl     *impl;
+    NativeThread  thread;
+    TaskDeque     deque;
+} PoolWorker;
+
+struct PoolImpl {
+    PoolWorker *workers;
+    uint32_t    num_workers;
+    TaskDeque   injector;
+
+    // Guards `num_queued` and `shutdown`.  Idle workers sleep on
+    // `work_cond` until a task is queued.
+    Mutex       mutex;
+    CondVar     work_cond;
+    int64_t     num_queued;
+    bool        shutdown;
+};
+
+typedef struct {
+    Mutex    mutex;
+    CondVar  done_cond;
+} GroupSync;
+
+static ThreadPool *ThreadPool_global_pool = NULL;
+
+static void
+S_worker_main(void *arg);
+
+static void
+S_execute(PoolTask *task);
+
+ThreadPool*
+ThreadPool_new(uint32_t num_threads) {
+    ThreadPool *self = (ThreadPool*)Class_Make_Obj(THREADPOOL);
+    return ThreadPool_init(self, num_threads);
+}
+
+ThreadPool*
+ThreadPool_init(ThreadPool *self, uint32_t num_threads) {
+    PoolImpl *impl = (PoolImpl*)MALLOCATE(sizeof(PoolImpl));
+    impl->workers     = (PoolWorker*)MALLOCATE((num_threads + 1)
+                                               * sizeof(PoolWorker));
+    impl->num_workers = 0;
+    impl->num_queued  = 0;
+    impl->shutdown    = false;
+    S_deque_init(&impl->injector);
+    Mutex_init(&impl->mutex);
+    CondVar_init(&impl->work_cond);
+    self->impl = impl;
+
+    // Workers don't start looking for tasks before the mutex is released,
+    // so they always see their complete thread IDs.
+    Mutex_lock(&impl->mutex);
+    for (uint32_t i = 0; i < num_threads; i++) {
+        PoolWorker *worker = impl->workers + impl->num_workers;
+        worker->impl = impl;
+        S_deque_init(&worker->deque);
+        if (!NativeThread_start(&worker->thread, S_worker_main, worker)) {
+            S_deque_destroy(&worker->deque);
+            break;
+        }
+        impl->num_workers++;
+    }
+    Mutex_unlock(&impl->mutex);
+    self->num_threads = impl->num_workers;
+
+    return self;
+}
+
+void
+ThreadPool_Destroy_IMP(ThreadPool *self) {
+    PoolImpl *impl = (PoolImpl*)self->impl;
+    if (impl) {
+        Mutex_lock(&impl->mutex);
+        impl->shutdown = true;
+        CondVar_broadcast(&impl->work_cond);
+        Mutex_unlock(&impl->mutex);
+        // Workers which are still running may steal from the deques of
+        // workers which have already exited.
+        for (uint32_t i = 0; i < impl->num_workers; i++) {
+            NativeThread_join(&impl->workers[i].thread);
+        }
+        for (uint32_t i = 0; i < impl->num_workers; i++) {
+            S_deque_destroy(&impl->workers[i].deque);
+        }
+        S_deque_destroy(&impl->injector);
+        CondVar_destroy(&impl->work_cond);
+        Mutex_destroy(&impl->mutex);
+        FREEMEM(impl->workers);
+        FREEMEM(impl);
+    }
+    SUPER_DESTROY(self, THREADPOOL);
+}
+
+ThreadPool*
+ThreadPool_global() {
+    ThreadPool *pool = ThreadPool_global_pool;
+    if (pool == NULL) {
+        // The global pool lives as long as the process.
+        Class_census_suspend();
+        pool = ThreadPool_new(ThreadPool_num_cpus() - 1);
+        if (!Atomic_cas_ptr((void*volatile*)&ThreadPool_global_pool, NULL,
+                            pool)
+           ) {
+            // Another thread won the race.
+            DECREF(pool);
+            pool = ThreadPool_global_pool;
+        }
+        Class_census_resume();
+    }
+    return pool;
+}
+
+uint32_t
+ThreadPool_Get_Num_Threads_IMP(ThreadPool *self) {
+    return self->num_threads;
+}
+
+// Return the worker running on the current thread, or NULL if the current
+// thread doesn't belong to the pool.
+static PoolWorker*
+S_current_worker(PoolImpl *impl) {
+    for (uint32_t i = 0; i < impl->num_workers; i++) {
+        if (NativeThread_is_current(&impl->workers[i].thread)) {
+            return impl->workers + i;
+        }
+    }
+    return NULL;
+}
+
+static void
+S_submit(PoolImpl *impl, PoolTask *task) {
+    PoolWorker *worker = S_current_worker(impl);
+    S_deque_push(worker ? &worker->deque : &impl->injector, task);
+
+    Mutex_lock(&impl->mutex);
+    impl->num_queued++;
+    CondVar_signal(&impl->work_cond);
+    Mutex_unlock(&impl->mutex);
+}
+
+// Take a task from the worker's own deque, from the shared queue, or from
+// another worker, in that order.
+static bool
+S_take_task(PoolImpl *impl, PoolWorker *worker, PoolTask *task) {
+    bool found = false;
+
+    if (worker && S_deque_pop(&worker->deque, task)) {
+        found = true;
+    }
+    else if (S_deque_steal(&impl->injector, task)) {
+        found = true;
+    }
+    else if (impl->num_workers) {
+        uint32_t num_workers = impl->num_workers;
+        uint32_t start = worker ? (uint32_t)(worker - impl->workers) + 1 : 0;
+        for (uint32_t i = 0; i < num_workers; i++) {
+            PoolWorker *victim = impl->workers + (start + i) % num_workers;
+            if (victim != worker && S_deque_steal(&victim->deque, task)) {
+                found = true;
+                break;
+            }
+        }
+    }
+
+    if (found) {
+        Mutex_lock(&impl->mutex);
+        impl->num_queued--;
+        Mutex_unlock(&impl->mutex);
+    }
+    return found;
+}
+
+static void
+S_worker_main(void *arg) {
+    PoolWorker *worker = (PoolWorker*)arg;
+    PoolImpl   *impl   = worker->impl;
+
+    // Wait for ThreadPool_init to finish.
+    Mutex_lock(&impl->mutex);
+    Mutex_unlock(&impl->mutex);
+
+    while (true) {
+        PoolTask task;
+        if (S_take_task(impl, worker, &task)) {
+            S_execute(&task);
+            continue;
+        }
+
+        Mutex_lock(&impl->mutex);
+        while (impl->num_queued <= 0 && !impl->shutdown) {
+            CondVar_wait(&impl->work_cond, &impl->mutex);
+        }
+        bool done = impl->shutdown && impl->num_queued <= 0;
+        Mutex_unlock(&impl->mutex);
+        if (done) { break; }
+    }
+}
+
+typedef struct {
+    TaskGroup          *group;
+    ThreadPool_Range_t  routine;
+    void               *context;
+    size_t              begin;
+    size_t              end;
+    size_t              grain;
+} ForRange;
+
+// Split off the upper half of the range as a new task until the rest is
+// small enough, then process the rest.
+static void
+S_for_range(void *arg) {
+    ForRange range = *(ForRange*)arg;
+    FREEMEM(arg);
+
+    while (range.end - range.begin > range.grain) {
+        size_t    mid   = range.begin + (range.end - range.begin) / 2;
+        ForRange *upper = (ForRange*)MALLOCATE(sizeof(ForRange));
+        *upper = range;
+        upper->begin = mid;
+        TaskGroup_Run(range.group, S_for_range, upper);
+        range.end = mid;
+    }
+
+    range.routine(range.context, range.begin, range.end);
+}
+
+static Err*
+S_join(TaskGroup *self);
+
+void
+ThreadPool_Parallel_For_IMP(ThreadPool *self, size_t begin, size_t end,
+                            size_t grain, ThreadPool_Range_t routine,
+                            void *context, bool trap_errors) {
+    if (end <= begin) { return; }
+    if (grain == 0) {
+        grain = (end - begin) / (4 * ((size_t)self->num_threads + 1));
+        if (grain == 0) { grain = 1; }
+    }
+
+    TaskGroup *group = TaskGroup_new(self, trap_errors);
+    ForRange  *range = (ForRange*)MALLOCATE(sizeof(ForRange));
+    range->group   = group;
+    range->routine = routine;
+    range->context = context;
+    range->begin   = begin;
+    range->end     = end;
+    range->grain   = grain;
+    TaskGroup_Run(group, S_for_range, range);
+
+    Err *error = S_join(group);
+    DECREF(group);
+    if (error) {
+        RETHROW(error);
+    }
+}
+
+/******************************** TaskGroup ********************************/
+
+TaskGroup*
+TaskGroup_new(ThreadPool *pool, bool trap_errors) {
+    TaskGroup *self = (TaskGroup*)Class_Make_Obj(TASKGROUP);
+    return TaskGroup_init(self, pool, trap_errors);
+}
+
+TaskGroup*
+TaskGroup_init(TaskGroup *self, ThreadPool *pool, bool trap_errors) {
+    GroupSync *sync = (GroupSync*)MALLOCATE(sizeof(GroupSync));
+    Mutex_init(&sync->mutex);
+    CondVar_init(&sync->done_cond);
+    self->pool        = pool;
+    self->sync        = sync;
+    self->pending     = 0;
+    self->error       = NULL;
+    self->trap_errors = trap_errors;
+    return self;
+}
+
+void
+TaskGroup_Destroy_IMP(TaskGroup *self) {
+    GroupSync *sync = (GroupSync*)self->sync;
+    if (self->pending) {
+        DECREF(S_join(self));
+    }
+    DECREF(self->error);
+    CondVar_destroy(&sync->done_cond);
+    Mutex_destroy(&sync->mutex);
+    FREEMEM(sync);
+    SUPER_DESTROY(self, TASKGROUP);
+}
+
+void
+TaskGroup_Run_IMP(TaskGroup *self, ThreadPool_Task_t routine, void *context) {
+    GroupSync *sync = (GroupSync*)self->sync;
+    PoolTask task;
+    task.routine = routine;
+    task.context = context;
+    task.group   = self;
+
+    Mutex_lock(&sync->mutex);
+    self->pending++;
+    Mutex_unlock(&sync->mutex);
+
+    S_submit((PoolImpl*)self->pool->impl, &task);
+}
+
+static void
+S_run_task(void *context) {
+    PoolTask *task = (PoolTask*)context;
+    task->routine(task->context);
+}
+
+static void
+S_execute(PoolTask *task) {
+    TaskGroup *group = task->group;
+    GroupSync *sync  = (GroupSync*)group->sync;
+    Err       *error = NULL;
+
+    if (group->trap_errors) {
+        error = Err_trap(S_run_task, task);
+    }
+    else {
+        task->routine(task->context);
+    }
+
+    Mutex_lock(&sync->mutex);
+    if (error) {
+        if (group->error) {
+            DECREF(error);
+        }
+        else {
+            group->error = error;
+        }
+    }
+    if (--group->pending == 0) {
+        CondVar_broadcast(&sync->done_cond);
+    }
+    Mutex_unlock(&sync->mutex);
+}
+
+// Wait for all tasks of the group, helping out with queued tasks.  Return
+// the first error thrown by a task, if any.
+static Err*
+S_join(TaskGroup *self) {
+    PoolImpl   *impl   = (PoolImpl*)self->pool->impl;
+    GroupSync  *sync   = (GroupSync*)self->sync;
+    PoolWorker *worker = S_current_worker(impl);
+
+    while (true) {
+        Mutex_lock(&sync->mutex);
+        size_t pending = self->pending;
+        Mutex_unlock(&sync->mutex);
+        if (pending == 0) { break; }
+
+        PoolTask task;
+        if (S_take_task(impl, worker, &task)) {
+            S_execute(&task);
+            continue;
+        }
+
+        // Nothing left to steal.  The remaining tasks of the group are
+        // running on other threads, so wait for one of them to finish.
+        Mutex_lock(&sync->mutex);
+        if (self->pending != 0) {
+            CondVar_wait(&sync->done_cond, &sync->mutex);
+        }
+        Mutex_unlock(&sync->mutex);
+    }
+
+    Mutex_lock(&sync->mutex);
+    Err *error = self->error;
+    self->error = NULL;
+    Mutex_unlock(&sync->mutex);
+    return error;
+}
+
+void
+TaskGroup_Join_IMP(TaskGroup *self) {
+    Err *error = S_join(self);
+    if (error) {
+        RETHROW(error);
+    }
+}
@@ -0,0 +1,141 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define CFISH_USE_SHORT_NAMES
+
+#include "charmony.h"
+
+#include "Clownfish/Util/Threads.h"
+#include "Clownfish/Err.h"
+
+/********************************** Windows ********************************/
+#if !defined(CFISH_NOTHREADS) && defined(CHY_HAS_WINDOWS_H)
+
+static DWORD __stdcall
+S_thread_main(void *arg) {
+    NativeThread *thread = (NativeThread*)arg;
+    thread->routine(thread->arg);
+    return 0;
+}
+
+bool
+NativeThread_start(NativeThread *thread, NativeThread_Routine_t routine,
+                   void *arg) {
+    thread->routine = routine;
+    thread->arg     = arg;
+    thread->handle  = CreateThread(NULL, 0, S_thread_main, thread, 0,
+                                   &thread->id);
+    return thread->handle != NULL;
+}
+
+void
+NativeThread_join(NativeThread *thread) {
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+}
+
+bool
+NativeThread_is_current(NativeThread *thread) {
+    return thread->id == GetCurrentThreadId();
+}
+
+uint32_t
+Threads_num_cpus() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (uint32_t)info.dwNumberOfProcessors;
+}
+
+/********************************* pthreads ********************************/
+#elif !defined(CFISH_NOTHREADS) && defined(CHY_HAS_PTHREAD_H)
+
+#ifdef CHY_HAS_UNISTD_H
+  #include <unistd.h>
+#endif
+
+static void*
+S_thread_main(void *arg) {
+    NativeThread *thread = (NativeThread*)arg;
+    thread->routine(thread->arg);
+    return NULL;
+}
+
+bool
+NativeThread_start(NativeThread *thread, NativeThread_Routine_t routine,
+                   void *arg) {
+    thread->routine = routine;
+    thread->arg     = arg;
+    return pthread_create(&thread->pthread, NULL, S_thread_main, thread) == 0;
+}
+
+void
+NativeThread_join(NativeThread *thread) {
+    pthread_join(thread->pthread, NULL);
+}
+
+bool
+NativeThread_is_current(NativeThread *thread) {
+    return pthread_equal(thread->pthread, pthread_self()) != 0;
+}
+
+uint32_t
+Threads_num_cpus() {
+#ifdef _SC_NPROCESSORS_ONLN
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return num_cpus > 0 ? (uint32_t)num_cpus : 1;
+#else
+    return 1;
+#endif
+}
+
+/***************************** Single threaded *****************************/
+#else
+
+void
+CondVar_wait(CondVar *cond, Mutex *mutex) {
+    UNUSED_VAR(cond);
+    UNUSED_VAR(mutex);
+    THROW(ERR, "Would wait forever without thread support");
+}
+
+bool
+NativeThread_start(NativeThread *thread, NativeThread_Routine_t routine,
+                   void *arg) {
+    UNUSED_VAR(thread);
+    UNUSED_VAR(routine);
+    UNUSED_VAR(arg);
+    return false;
+}
+
+void
+NativeThread_join(NativeThread *thread) {
+    UNUSED_VAR(thread);
+}
+
+bool
+NativeThread_is_current(NativeThread *thread) {
+    UNUSED_VAR(thread);
+    return false;
+}
+
+uint32_t
+Threads_num_cpus() {
+    return 1;
+}
+
+#endif
+
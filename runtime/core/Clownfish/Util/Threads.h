@@ -0,0 +1,318 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef H_CLOWNFISH_UTIL_THREADS
+#define H_CLOWNFISH_UTIL_THREADS 1
+
+#include "charmony.h"
+#include "cfish_parcel.h"
+#include "Clownfish/Util/Atomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Internal platform layer for threads, mutexes, condition variables and
+ * spinlocks.
+ *
+ * CFISH_HAS_THREADS is defined if threads can be created.  Otherwise,
+ * mutexes and spinlocks are no-ops, and waiting on a condition variable
+ * throws, since no other thread could ever signal it.
+ */
+
+typedef void
+(*cfish_NativeThread_Routine_t)(void *arg);
+
+/** A spinlock for short critical sections, safe to use from allocation
+ * hooks.  Initialize with CFISH_SPINLOCK_INIT.  It isn't recursive.
+ */
+typedef void *volatile cfish_SpinLock;
+
+#define CFISH_SPINLOCK_INIT NULL
+
+static CFISH_INLINE void
+cfish_SpinLock_lock(cfish_SpinLock *lock);
+
+static CFISH_INLINE void
+cfish_SpinLock_unlock(cfish_SpinLock *lock);
+
+static CFISH_INLINE void
+cfish_Threads_yield(void);
+
+/** Return the number of online CPUs, at least 1.
+ */
+uint32_t
+cfish_Threads_num_cpus(void);
+
+/********************************** Windows ********************************/
+#if !defined(CFISH_NOTHREADS) && defined(CHY_HAS_WINDOWS_H)
+
+#include <windows.h>
+
+#define CFISH_HAS_THREADS
+
+typedef CRITICAL_SECTION   cfish_Mutex;
+typedef CONDITION_VARIABLE cfish_CondVar;
+
+typedef struct cfish_NativeThread {
+    HANDLE                        handle;
+    DWORD                         id;
+    cfish_NativeThread_Routine_t  routine;
+    void                         *arg;
+} cfish_NativeThread;
+
+static CFISH_INLINE void
+cfish_Mutex_init(cfish_Mutex *mutex) {
+    InitializeCriticalSection(mutex);
+}
+
+static CFISH_INLINE void
+cfish_Mutex_destroy(cfish_Mutex *mutex) {
+    DeleteCriticalSection(mutex);
+}
+
+static CFISH_INLINE void
+cfish_Mutex_lock(cfish_Mutex *mutex) {
+    EnterCriticalSection(mutex);
+}
+
+static CFISH_INLINE void
+cfish_Mutex_unlock(cfish_Mutex *mutex) {
+    LeaveCriticalSection(mutex);
+}
+
+static CFISH_INLINE void
+cfish_CondVar_init(cfish_CondVar *cond) {
+    InitializeConditionVariable(cond);
+}
+
+static CFISH_INLINE void
+cfish_CondVar_destroy(cfish_CondVar *cond) {
+    CFISH_UNUSED_VAR(cond);
+}
+
+static CFISH_INLINE void
+cfish_CondVar_wait(cfish_CondVar *cond, cfish_Mutex *mutex) {
+    SleepConditionVariableCS(cond, mutex, INFINITE);
+}
+
+static CFISH_INLINE void
+cfish_CondVar_signal(cfish_CondVar *cond) {
+    WakeConditionVariable(cond);
+}
+
+static CFISH_INLINE void
+cfish_CondVar_broadcast(cfish_CondVar *cond) {
+    WakeAllConditionVariable(cond);
+}
+
+static CFISH_INLINE void
+cfish_Threads_yield(void) {
+    SwitchToThread();
+}
+
+/********************************* pthreads ********************************/
+#elif !defined(CFISH_NOTHREADS) && defined(CHY_HAS_PTHREAD_H)
+
+#include <pthread.h>
+#ifdef CHY_HAS_SCHED_H
+  #include <sched.h>
+#endif
+
+#define CFISH_HAS_THREADS
+
+typedef pthread_mutex_t cfish_Mutex;
+typedef pthread_cond_t  cfish_CondVar;
+
+typedef struct cfish_NativeThread {
+    pthread_t                     pthread;
+    cfish_NativeThread_Routine_t  routine;
+    void                         *arg;
+} cfish_NativeThread;
+
+static CFISH_INLINE void
+cfish_Mutex_init(cfish_Mutex *mutex) {
+    pthread_mutex_init(mutex, NULL);
+}
+
+static CFISH_INLINE void
+cfish_Mutex_destroy(cfish_Mutex *mutex) {
+    pthread_mutex_destroy(mutex);
+}
+
+static CFISH_INLINE void
+cfish_Mutex_lock(cfish_Mutex *mutex) {
+    pthread_mutex_lock(mutex);
+}
+
+static CFISH_INLINE void
+cfish_Mutex_unlock(cfish_Mutex *mutex) {
+    pthread_mutex_unlock(mutex);
+}
+
+static CFISH_INLINE void
+cfish_CondVar_init(cfish_CondVar *cond) {
+    pthread_cond_init(cond, NULL);
+}
+
+static CFISH_INLINE void
+cfish_CondVar_destroy(cfish_CondVar *cond) {
+    pthread_cond_destroy(cond);
+}
+
+static CFISH_INLINE void
+cfish_CondVar_wait(cfish_CondVar *cond, cfish_Mutex *mutex) {
+    pthread_cond_wait(cond, mutex);
+}
+
+static CFISH_INLINE void
+cfish_CondVar_signal(cfish_CondVar *cond) {
+    pthread_cond_signal(cond);
+}
+
+static CFISH_INLINE void
+cfish_CondVar_broadcast(cfish_CondVar *cond) {
+    pthread_cond_broadcast(cond);
+}
+
+static CFISH_INLINE void
+cfish_Threads_yield(void) {
+#ifdef CHY_HAS_SCHED_H
+    sched_yield();
+#endif
+}
+
+/***************************** Single threaded *****************************/
+#else
+
+typedef int cfish_Mutex;
+typedef int cfish_CondVar;
+
+typedef struct cfish_NativeThread {
+    int dummy;
+} cfish_NativeThread;
+
+static CFISH_INLINE void
+cfish_Mutex_init(cfish_Mutex *mutex) {
+    CFISH_UNUSED_VAR(mutex);
+}
+
+static CFISH_INLINE void
+cfish_Mutex_destroy(cfish_Mutex *mutex) {
+    CFISH_UNUSED_VAR(mutex);
+}
+
+static CFISH_INLINE void
+cfish_Mutex_lock(cfish_Mutex *mutex) {
+    CFISH_UNUSED_VAR(mutex);
+}
+
+static CFISH_INLINE void
+cfish_Mutex_unlock(cfish_Mutex *mutex) {
+    CFISH_UNUSED_VAR(mutex);
+}
+
+static CFISH_INLINE void
+cfish_CondVar_init(cfish_CondVar *cond) {
+    CFISH_UNUSED_VAR(cond);
+}
+
+static CFISH_INLINE void
+cfish_CondVar_destroy(cfish_CondVar *cond) {
+    CFISH_UNUSED_VAR(cond);
+}
+
+/** Throws, since no other thread could ever signal `cond`.
+ */
+void
+cfish_CondVar_wait(cfish_CondVar *cond, cfish_Mutex *mutex);
+
+static CFISH_INLINE void
+cfish_CondVar_signal(cfish_CondVar *cond) {
+    CFISH_UNUSED_VAR(cond);
+}
+
+static CFISH_INLINE void
+cfish_CondVar_broadcast(cfish_CondVar *cond) {
+    CFISH_UNUSED_VAR(cond);
+}
+
+static CFISH_INLINE void
+cfish_Threads_yield(void) {
+}
+
+#endif
+
+/** Start a thread running `routine(arg)`.  Return false on failure.
+ * `thread` must stay valid until the thread was joined.  Always fails
+ * without thread support.
+ */
+bool
+cfish_NativeThread_start(cfish_NativeThread *thread,
+                         cfish_NativeThread_Routine_t routine, void *arg);
+
+void
+cfish_NativeThread_join(cfish_NativeThread *thread);
+
+/** Return true if `thread` is the calling thread.
+ */
+bool
+cfish_NativeThread_is_current(cfish_NativeThread *thread);
+
+static CFISH_INLINE void
+cfish_SpinLock_lock(cfish_SpinLock *lock) {
+    while (!cfish_Atomic_cas_ptr(lock, NULL, (void*)lock)) {
+        // Spin.
+    }
+}
+
+static CFISH_INLINE void
+cfish_SpinLock_unlock(cfish_SpinLock *lock) {
+    cfish_Atomic_cas_ptr(lock, (void*)lock, NULL);
+}
+
+#ifdef CFISH_USE_SHORT_NAMES
+  #define NativeThread_Routine_t    cfish_NativeThread_Routine_t
+  #define SpinLock                  cfish_SpinLock
+  #define SPINLOCK_INIT             CFISH_SPINLOCK_INIT
+  #define SpinLock_lock             cfish_SpinLock_lock
+  #define SpinLock_unlock           cfish_SpinLock_unlock
+  #define Threads_yield             cfish_Threads_yield
+  #define Threads_num_cpus          cfish_Threads_num_cpus
+  #define Mutex                     cfish_Mutex
+  #define Mutex_init                cfish_Mutex_init
+  #define Mutex_destroy             cfish_Mutex_destroy
+  #define Mutex_lock                cfish_Mutex_lock
+  #define Mutex_unlock              cfish_Mutex_unlock
+  #define CondVar                   cfish_CondVar
+  #define CondVar_init              cfish_CondVar_init
+  #define CondVar_destroy           cfish_CondVar_destroy
+  #define CondVar_wait              cfish_CondVar_wait
+  #define CondVar_signal            cfish_CondVar_signal
+  #define CondVar_broadcast         cfish_CondVar_broadcast
+  #define NativeThread              cfish_NativeThread
+  #define NativeThread_start        cfish_NativeThread_start
+  #define NativeThread_join         cfish_NativeThread_join
+  #define NativeThread_is_current   cfish_NativeThread_is_current
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* H_CLOWNFISH_UTIL_THREADS */
+
@@ -0,0 +1,390 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_CFISH_TRACE
+#define CFISH_USE_SHORT_NAMES
+
+#include "charmony.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Clownfish/Util/Trace.h"
+#include "Clownfish/CharBuf.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Util/Atomic.h"
+#include "Clownfish/Util/Json.h"
+#include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/PerThread.h"
+#include "Clownfish/Util/Threads.h"
+
+#define DEFAULT_CAPACITY 65536
+
+// Publish the number of events written to a ring after the events
+// themselves, so that readers never see torn events. The fences keep the
+// event stores of the next record behind the head store of the previous
+// one, and the event loads of a reader ahead of its second head load.
+#if defined(__GNUC__) || defined(__clang__)
+  #define STORE_RELEASE(ptr, value) \
+    __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+  #define LOAD_ACQUIRE(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+  #define STORE_FENCE() __atomic_thread_fence(__ATOMIC_RELEASE)
+  #define LOAD_FENCE()  __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#else
+  #define STORE_RELEASE(ptr, value) (*(ptr) = (value))
+  #define LOAD_ACQUIRE(ptr) (*(ptr))
+  #define STORE_FENCE()
+  #define LOAD_FENCE()
+#endif
+
+typedef struct TraceRing {
+    TraceEvent       *events;
+    uint32_t         *tids;   // Thread number of every event.
+    size_t            mask;
+    volatile size_t   head;   // Number of events ever written.
+    uint32_t          tid;    // Thread number of the current owner.
+    struct TraceRing *next;
+    struct TraceRing *next_free;
+} TraceRing;
+
+bool Trace_enabled = false;
+
+static size_t     trace_capacity = DEFAULT_CAPACITY;
+static uint64_t   trace_cleared  = 0;
+static TraceRing *trace_rings    = NULL;
+static uint32_t   trace_num_tids = 0;
+
+static TraceRing*
+S_new_ring() {
+    // Rings are allocated with plain calloc, since allocations made through
+    // Memory_wrapped_* may be traced themselves.
+    TraceRing *ring = (TraceRing*)calloc(1, sizeof(TraceRing));
+    size_t capacity = 1;
+    while (capacity < trace_capacity) { capacity *= 2; }
+    TraceEvent *events = (TraceEvent*)calloc(capacity, sizeof(TraceEvent));
+    uint32_t   *tids   = (uint32_t*)calloc(capacity, sizeof(uint32_t));
+    if (ring == NULL || events == NULL || tids == NULL) {
+        fprintf(stderr, "Can't allocate trace ring\n");
+        exit(1);
+    }
+    ring->events = events;
+    ring->tids   = tids;
+    ring->mask   = capacity - 1;
+
+    // Push onto the global list.  Rings are never freed, so the events of
+    // threads which have exited can still be exported.
+    while (1) {
+        TraceRing *next = trace_rings;
+        ring->next = next;
+        if (Atomic_cas_ptr((void*volatile*)&trace_rings, next, ring)) {
+            break;
+        }
+    }
+
+    return ring;
+}
+
+#if defined(CHY_HAS_THREAD_LOCAL) && !defined(CFISH_NOTHREADS)
+  #define RING_PER_THREAD
+  static CHY_THREAD_LOCAL TraceRing *thread_ring = NULL;
+
+  // When a thread exits, its ring goes on a free list and is handed to the
+  // next thread which starts tracing.  The events of the exited thread stay
+  // in the ring until they're overwritten.
+  typedef struct TraceBlock {
+      TraceRing *ring;
+  } TraceBlock;
+
+  static void
+  S_release_ring(void *dest, void *src);
+
+  static PerThread  trace_threads    = PERTHREAD_INIT(sizeof(TraceBlock),
+                                                      S_release_ring);
+  static TraceRing *trace_free_rings = NULL;
+#else
+  // Without thread-local storage, all threads share a single ring guarded
+  // by a spinlock.
+  static SpinLock   ring_lock   = SPINLOCK_INIT;
+  static TraceRing *thread_ring = NULL;
+#endif
+
+#ifdef RING_PER_THREAD
+
+// Called on the exiting thread with the lock of `trace_threads` held.
+static void
+S_release_ring(void *dest, void *src) {
+    UNUSED_VAR(dest);
+    TraceRing *ring = ((TraceBlock*)src)->ring;
+    if (ring) {
+        ring->next_free  = trace_free_rings;
+        trace_free_rings = ring;
+    }
+    thread_ring = NULL;
+}
+
+static TraceRing*
+S_acquire_ring() {
+    TraceBlock *block = (TraceBlock*)PerThread_get_block(&trace_threads);
+
+    size_t capacity = 1;
+    while (capacity < trace_capacity) { capacity *= 2; }
+
+    // Reuse a free ring with the current capacity.
+    PerThread_lock(&trace_threads);
+    TraceRing **ring_ptr = &trace_free_rings;
+    while (*ring_ptr && (*ring_ptr)->mask + 1 != capacity) {
+        ring_ptr = &(*ring_ptr)->next_free;
+    }
+    TraceRing *ring = *ring_ptr;
+    if (ring) {
+        *ring_ptr = ring->next_free;
+        ring->next_free = NULL;
+    }
+    uint32_t tid = ++trace_num_tids;
+    PerThread_unlock(&trace_threads);
+
+    if (ring == NULL) {
+        ring = S_new_ring();
+    }
+    ring->tid   = tid;
+    block->ring = ring;
+    return ring;
+}
+
+#else
+
+static TraceRing*
+S_acquire_ring() {
+    TraceRing *ring = S_new_ring();
+    ring->tid = ++trace_num_tids;
+    return ring;
+}
+
+#endif
+
+void
+Trace_enable(size_t capacity) {
+    trace_capacity = capacity ? capacity : DEFAULT_CAPACITY;
+    Trace_enabled  = true;
+}
+
+void
+Trace_disable() {
+    Trace_enabled = false;
+}
+
+void
+Trace_clear() {
+    trace_cleared = Trace_time_ns();
+}
+
+void
+Trace_record(char phase, const char *category, const char *name,
+             int64_t value) {
+#ifndef RING_PER_THREAD
+    SpinLock_lock(&ring_lock);
+#endif
+
+    TraceRing *ring = thread_ring;
+    if (ring == NULL) {
+        ring = thread_ring = S_acquire_ring();
+    }
+
+    size_t      head  = ring->head;
+    TraceEvent *event = &ring->events[head & ring->mask];
+    STORE_FENCE();
+    ring->tids[head & ring->mask] = ring->tid;
+    event->timestamp = Trace_time_ns();
+    event->category  = category;
+    event->name      = name;
+    event->value     = value;
+    event->phase     = phase;
+    STORE_RELEASE(&ring->head, head + 1);
+
+#ifndef RING_PER_THREAD
+    SpinLock_unlock(&ring_lock);
+#endif
+}
+
+size_t
+Trace_collect(TraceEvent **events_ptr, uint32_t **tids_ptr) {
+    size_t num_events = 0;
+    for (TraceRing *ring = trace_rings; ring; ring = ring->next) {
+        size_t capacity = ring->mask + 1;
+        size_t head     = LOAD_ACQUIRE(&ring->head);
+        num_events += head < capacity ? head : capacity;
+    }
+
+    TraceEvent *events = (TraceEvent*)MALLOCATE(
+                             (num_events + 1) * sizeof(TraceEvent));
+    uint32_t   *tids   = (uint32_t*)MALLOCATE(
+                             (num_events + 1) * sizeof(uint32_t));
+    size_t      count  = 0;
+
+    // Rings are prepended, so walk them in reverse to list the first
+    // thread first.
+    size_t num_rings = 0;
+    for (TraceRing *ring = trace_rings; ring; ring = ring->next) {
+        num_rings++;
+    }
+
+    for (size_t i = num_rings; i > 0; i--) {
+        TraceRing *ring = trace_rings;
+        for (size_t j = 1; j < i; j++) { ring = ring->next; }
+
+        size_t capacity = ring->mask + 1;
+        size_t head     = LOAD_ACQUIRE(&ring->head);
+        size_t start    = head > capacity ? head - capacity : 0;
+        size_t max      = num_events - count;
+        if (head - start > max) { start = head - max; }
+        size_t first    = count;
+
+        for (size_t k = start; k < head; k++) {
+            events[count] = ring->events[k & ring->mask];
+            tids[count]   = ring->tids[k & ring->mask];
+            count++;
+        }
+
+        // Drop events which the thread may have overwritten while they
+        // were copied. While head is new_head, the thread may already be
+        // writing event new_head into the slot of event new_head - capacity.
+        LOAD_FENCE();
+        size_t new_head  = LOAD_ACQUIRE(&ring->head);
+        size_t new_start = new_head + 1 > capacity
+                           ? new_head + 1 - capacity
+                           : 0;
+        if (new_start > start) {
+            size_t num_stale = new_start - start;
+            if (num_stale > count - first) { num_stale = count - first; }
+            memmove(events + first, events + first + num_stale,
+                    (count - first - num_stale) * sizeof(TraceEvent));
+            memmove(tids + first, tids + first + num_stale,
+                    (count - first - num_stale) * sizeof(uint32_t));
+            count -= num_stale;
+        }
+
+        // Drop events which were recorded before the trace was cleared.
+        size_t k = first;
+        while (k < count && events[k].timestamp < trace_cleared) { k++; }
+        if (k > first) {
+            memmove(events + first, events + k,
+                    (count - k) * sizeof(TraceEvent));
+            memmove(tids + first, tids + k, (count - k) * sizeof(uint32_t));
+            count -= k - first;
+        }
+    }
+
+    *events_ptr = events;
+    *tids_ptr   = tids;
+    return count;
+}
+
+String*
+Trace_export_json() {
+    TraceEvent *events;
+    uint32_t   *tids;
+    size_t      num_events = Trace_collect(&events, &tids);
+    CharBuf    *buf        = CB_new(num_events * 96 + 64);
+
+    CB_Cat_Trusted_Utf8(buf, "{\"traceEvents\":[", 16);
+
+    for (size_t i = 0; i < num_events; i++) {
+        TraceEvent *event = &events[i];
+        char num_buf[96];
+
+        if (i > 0) { CB_Cat_Trusted_Utf8(buf, ",\n", 2); }
+        CB_Cat_Trusted_Utf8(buf, "{\"name\":", 8);
+        Json_encode_into((Obj*)SSTR_WRAP_C(event->name), buf);
+        CB_Cat_Trusted_Utf8(buf, ",\"cat\":", 7);
+        Json_encode_into((Obj*)SSTR_WRAP_C(event->category), buf);
+
+        // Timestamps are in microseconds.
+        int size = sprintf(num_buf,
+                           ",\"ph\":\"%c\",\"ts\":%" PRIu64 ".%03u"
+                           ",\"pid\":1,\"tid\":%u",
+                           event->phase, event->timestamp / 1000,
+                           (unsigned)(event->timestamp % 1000),
+                           (unsigned)tids[i]);
+        CB_Cat_Trusted_Utf8(buf, num_buf, (size_t)size);
+
+        if (event->phase == TRACE_PHASE_COUNTER
+            || (event->phase == TRACE_PHASE_INSTANT && event->value != 0)
+           ) {
+            size = sprintf(num_buf, ",\"args\":{\"value\":%" PRId64 "}",
+                           event->value);
+            CB_Cat_Trusted_Utf8(buf, num_buf, (size_t)size);
+        }
+        if (event->phase == TRACE_PHASE_INSTANT) {
+            CB_Cat_Trusted_Utf8(buf, ",\"s\":\"t\"", 8);
+        }
+
+        CB_Cat_Trusted_Utf8(buf, "}", 1);
+    }
+
+    CB_Cat_Trusted_Utf8(buf, "],\"displayTimeUnit\":\"ns\"}\n", 26);
+
+    FREEMEM(events);
+    FREEMEM(tids);
+    String *json = CB_Yield_String(buf);
+    DECREF(buf);
+    return json;
+}
+
+/********************************* WINDOWS ********************************/
+#if defined(CHY_HAS_WINDOWS_H)
+
+#include <windows.h>
+
+uint64_t
+Trace_time_ns() {
+    static LARGE_INTEGER freq;
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+
+    LARGE_INTEGER count;
+    QueryPerformanceCounter(&count);
+
+    uint64_t secs = (uint64_t)(count.QuadPart / freq.QuadPart);
+    uint64_t rest = (uint64_t)(count.QuadPart % freq.QuadPart);
+    return secs * 1000000000 + rest * 1000000000 / (uint64_t)freq.QuadPart;
+}
+
+/********************************* UNIXEN *********************************/
+#elif defined(CHY_HAS_SYS_TIME_H)
+
+#include <sys/time.h>
+#include <time.h>
+
+uint64_t
+Trace_time_ns() {
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+        return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+    }
+#endif
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return (uint64_t)t.tv_sec * 1000000000 + (uint64_t)t.tv_usec * 1000;
+}
+
+#else
+  #error "Can't find a known time API."
+#endif // OS switch.
+
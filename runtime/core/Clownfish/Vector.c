@@ -22,12 +22,20 @@
 
 #include "Clownfish/Class.h"
 #include "Clownfish/Vector.h"
+#include "Clownfish/Blob.h"
 #include "Clownfish/Err.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/String.h"
 #include "Clownfish/Util/Memory.h"
 #include "Clownfish/Util/SortUtils.h"
+#include "Clownfish/Util/ThreadPool.h"
 
 #define MAX_VECTOR_SIZE (SIZE_MAX / sizeof(Obj*))
 
+// Vectors at least this long are radix sorted if all their elements
+// belong to the same class and have a numeric or byte string sort key.
+#define RADIX_SORT_THRESHOLD 64
+
 static CFISH_INLINE void
 SI_copy_and_incref(Obj **dst, Obj **src, size_t num);
 
@@ -57,6 +65,7 @@ Vec_init(Vector *self, size_t capacity) {
 
     // Derive.
     self->elems = (Obj**)CALLOCATE(capacity, sizeof(Obj*));
+    CENSUS_BYTES(self, capacity * sizeof(Obj*));
 
     return self;
 }
@@ -69,6 +78,7 @@ Vec_Destroy_IMP(Vector *self) {
         for (; elems < limit; elems++) {
             DECREF(*elems);
         }
+        CENSUS_BYTES(self, -(int64_t)(self->cap * sizeof(Obj*)));
         FREEMEM(self->elems);
     }
     SUPER_DESTROY(self, VECTOR);
@@ -173,6 +183,7 @@ Vec_Grow_IMP(Vector *self, size_t capacity) {
             return;
         }
         self->elems = (Obj**)REALLOCATE(self->elems, capacity * sizeof(Obj*));
+        CENSUS_BYTES(self, (capacity - self->cap) * sizeof(Obj*));
         self->cap   = capacity;
     }
 }
@@ -242,11 +253,198 @@ S_default_compare(void *context, const void *va, const void *vb) {
     else  /* b == NULL */            { return -1; } // NULL to the back
 }
 
+// Return the class of the elements if they all belong to the same class,
+// NULL otherwise.
+static Class*
+S_homogeneous_class(Vector *self) {
+    if (self->size == 0 || self->elems[0] == NULL) { return NULL; }
+    Class *klass = Obj_get_class(self->elems[0]);
+    for (size_t i = 1; i < self->size; i++) {
+        Obj *elem = self->elems[i];
+        if (elem == NULL || Obj_get_class(elem) != klass) { return NULL; }
+    }
+    return klass;
+}
+
+// An element paired with a sort key.  The element pointer is widened so
+// that the struct is 16 bytes wide on all platforms.
+typedef struct {
+    uint64_t key;
+    uint64_t elem;
+} KeyedElem;
+
+#define KEYED_ELEM_OBJ(keyed_elem) ((Obj*)(uintptr_t)(keyed_elem)->elem)
+
+static const uint8_t*
+S_byte_string(Obj *obj, size_t *size) {
+    if (Obj_get_class(obj) == STRING) {
+        *size = Str_Get_Size((String*)obj);
+        return (const uint8_t*)Str_Get_Ptr8((String*)obj);
+    }
+    else {
+        *size = Blob_Get_Size((Blob*)obj);
+        return (const uint8_t*)Blob_Get_Buf((Blob*)obj);
+    }
+}
+
+// Compare Strings or Blobs bytewise, without dispatching to Compare_To.
+// UTF-8 byte order matches code point order.
+static int
+S_compare_byte_strings(void *context, const void *va, const void *vb) {
+    size_t a_size, b_size;
+    const uint8_t *a = S_byte_string(*(Obj**)va, &a_size);
+    const uint8_t *b = S_byte_string(*(Obj**)vb, &b_size);
+    UNUSED_VAR(context);
+    int comparison = memcmp(a, b, a_size < b_size ? a_size : b_size);
+    if (comparison != 0) { return comparison; }
+    return a_size < b_size ? -1 : a_size > b_size ? 1 : 0;
+}
+
+static int
+S_compare_prefixed(void *context, const void *va, const void *vb) {
+    const KeyedElem *a = (const KeyedElem*)va;
+    const KeyedElem *b = (const KeyedElem*)vb;
+    if (a->key != b->key) { return a->key < b->key ? -1 : 1; }
+    return S_compare_byte_strings(context, &a->elem, &b->elem);
+}
+
+// Sort Strings or Blobs.  Each element is paired with its first eight bytes
+// in big-endian order, so most comparisons are resolved by a single integer
+// comparison without touching the element.  Only runs of elements with
+// equal prefixes are compared in full.
+static void
+S_sort_byte_strings(Vector *self, ThreadPool *pool) {
+    size_t     size  = self->size;
+    KeyedElem *elems = (KeyedElem*)MALLOCATE(2 * size * sizeof(KeyedElem));
+
+    for (size_t i = 0; i < size; i++) {
+        size_t byte_size;
+        const uint8_t *bytes = S_byte_string(self->elems[i], &byte_size);
+        size_t prefix_size = byte_size < 8 ? byte_size : 8;
+        uint64_t prefix = 0;
+        for (size_t j = 0; j < prefix_size; j++) {
+            prefix |= (uint64_t)bytes[j] << (56 - 8 * j);
+        }
+        elems[i].key  = prefix;
+        elems[i].elem = (uint64_t)(uintptr_t)self->elems[i];
+    }
+
+    if (size < RADIX_SORT_THRESHOLD) {
+        Sort_mergesort(elems, elems + size, size, sizeof(KeyedElem),
+                       S_compare_prefixed, NULL);
+        for (size_t i = 0; i < size; i++) {
+            self->elems[i] = KEYED_ELEM_OBJ(elems + i);
+        }
+    }
+    else {
+        Sort_radixsort_keyed(elems, elems + size, size, sizeof(KeyedElem),
+                             pool);
+        for (size_t i = 0; i < size; i++) {
+            self->elems[i] = KEYED_ELEM_OBJ(elems + i);
+        }
+
+        // Resolve ties.  The radix scratch space is free again.
+        for (size_t i = 0; i < size;) {
+            size_t run_end = i + 1;
+            while (run_end < size && elems[run_end].key == elems[i].key) {
+                run_end++;
+            }
+            if (run_end - i > 1) {
+                Sort_mergesort(self->elems + i, elems + size, run_end - i,
+                               sizeof(Obj*), S_compare_byte_strings, NULL);
+            }
+            i = run_end;
+        }
+    }
+
+    FREEMEM(elems);
+}
+
+static void
+S_sort_integers(Vector *self, ThreadPool *pool) {
+    size_t     size  = self->size;
+    KeyedElem *elems = (KeyedElem*)MALLOCATE(2 * size * sizeof(KeyedElem));
+    for (size_t i = 0; i < size; i++) {
+        int64_t value = Int_Get_Value((Integer*)self->elems[i]);
+        // Flipping the sign bit maps signed order to unsigned order.
+        elems[i].key  = (uint64_t)value ^ (UINT64_C(1) << 63);
+        elems[i].elem = (uint64_t)(uintptr_t)self->elems[i];
+    }
+    Sort_radixsort_keyed(elems, elems + size, size, sizeof(KeyedElem), pool);
+    for (size_t i = 0; i < size; i++) {
+        self->elems[i] = KEYED_ELEM_OBJ(elems + i);
+    }
+    FREEMEM(elems);
+}
+
+// Radix sort Floats.  Return false without sorting if there is a NaN, which
+// compares as equal to every number.
+static bool
+S_sort_floats(Vector *self, ThreadPool *pool) {
+    const uint64_t sign_bit = UINT64_C(1) << 63;
+    size_t     size  = self->size;
+    KeyedElem *elems = (KeyedElem*)MALLOCATE(2 * size * sizeof(KeyedElem));
+    for (size_t i = 0; i < size; i++) {
+        double value = Float_Get_Value((Float*)self->elems[i]);
+        if (value != value) {
+            FREEMEM(elems);
+            return false;
+        }
+        // Map IEEE 754 order to unsigned order.  Negative zero compares as
+        // equal to zero, so it must get the same key.
+        uint64_t bits;
+        if (value == 0.0) { value = 0.0; }
+        memcpy(&bits, &value, sizeof(bits));
+        elems[i].key  = (bits & sign_bit) ? ~bits : bits | sign_bit;
+        elems[i].elem = (uint64_t)(uintptr_t)self->elems[i];
+    }
+    Sort_radixsort_keyed(elems, elems + size, size, sizeof(KeyedElem), pool);
+    for (size_t i = 0; i < size; i++) {
+        self->elems[i] = KEYED_ELEM_OBJ(elems + i);
+    }
+    FREEMEM(elems);
+    return true;
+}
+
+// Only the radix sorts of keyed elements run on the pool's workers.  They
+// move keys and pointers around but never access the elements.
+static void
+S_sort(Vector *self, ThreadPool *pool) {
+    if (self->size < 2) { return; }
+
+    Class *klass = S_homogeneous_class(self);
+    if (klass == STRING || klass == BLOB) {
+        S_sort_byte_strings(self, pool);
+        return;
+    }
+    if (self->size >= RADIX_SORT_THRESHOLD) {
+        if (klass == INTEGER) {
+            S_sort_integers(self, pool);
+            return;
+        }
+        if (klass == FLOAT && S_sort_floats(self, pool)) {
+            return;
+        }
+    }
+
+    Vec_Sort_By(self, S_default_compare, NULL);
+}
+
 void
 Vec_Sort_IMP(Vector *self) {
+    S_sort(self, NULL);
+}
+
+void
+Vec_Sort_Parallel_IMP(Vector *self, ThreadPool *pool) {
+    S_sort(self, pool);
+}
+
+void
+Vec_Sort_By_IMP(Vector *self, CFISH_Sort_Compare_t compare, void *context) {
     void *scratch = MALLOCATE(self->size * sizeof(Obj*));
     Sort_mergesort(self->elems, scratch, self->size, sizeof(void*),
-                   S_default_compare, NULL);
+                   compare, context);
     FREEMEM(scratch);
 }
 
@@ -335,6 +533,7 @@ S_grow_and_oversize(Vector *self, size_t min_size) {
     }
 
     self->elems = (Obj**)REALLOCATE(self->elems, capacity * sizeof(Obj*));
+    CENSUS_BYTES(self, (capacity - self->cap) * sizeof(Obj*));
     self->cap   = capacity;
 }
 
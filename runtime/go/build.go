@@ -150,6 +150,7 @@ func specMethods(parcel *cfc.Parcel) {
 	classBinding := cfc.NewGoClass(parcel, "Clownfish::Class")
 	classBinding.SpecMethod("Get_Methods", "GetMethods() []Method")
 	classBinding.SpecMethod("Make_Obj", "MakeObj() Obj")
+	classBinding.SpecMethod("", "GetStats() ClassStats")
 	classBinding.Register()
 
 	stringBinding := cfc.NewGoClass(parcel, "Clownfish::String")
@@ -169,6 +170,18 @@ func specMethods(parcel *cfc.Parcel) {
 	vecBinding.SetSuppressCtor(true)
 	vecBinding.Register()
 
+	i32VecBinding := cfc.NewGoClass(parcel, "Clownfish::I32Vector")
+	i32VecBinding.SetSuppressCtor(true)
+	i32VecBinding.Register()
+
+	i64VecBinding := cfc.NewGoClass(parcel, "Clownfish::I64Vector")
+	i64VecBinding.SetSuppressCtor(true)
+	i64VecBinding.Register()
+
+	f64VecBinding := cfc.NewGoClass(parcel, "Clownfish::F64Vector")
+	f64VecBinding.SetSuppressCtor(true)
+	f64VecBinding.Register()
+
 	hashBinding := cfc.NewGoClass(parcel, "Clownfish::Hash")
 	hashBinding.SpecMethod("Keys", "Keys() []string")
 	hashBinding.SetSuppressCtor(true)
@@ -177,6 +190,15 @@ func specMethods(parcel *cfc.Parcel) {
 	hashIterBinding := cfc.NewGoClass(parcel, "Clownfish::HashIterator")
 	hashIterBinding.SetSuppressCtor(true)
 	hashIterBinding.Register()
+
+	intHashBinding := cfc.NewGoClass(parcel, "Clownfish::IntHash")
+	intHashBinding.SpecMethod("Keys", "Keys() []int64")
+	intHashBinding.SetSuppressCtor(true)
+	intHashBinding.Register()
+
+	intHashIterBinding := cfc.NewGoClass(parcel, "Clownfish::IntHashIterator")
+	intHashIterBinding.SetSuppressCtor(true)
+	intHashIterBinding.Register()
 }
 
 func prep() {
@@ -49,3 +49,24 @@ func TestMakeObj(t *testing.T) {
 		t.Error("MakeObj for Integer class didn't yield an Integer")
 	}
 }
+
+func TestCensus(t *testing.T) {
+	EnableCensus(false)
+	hashClass := FetchClass("Clownfish::Hash")
+	before := hashClass.GetStats()
+	NewHash(0)
+	after := hashClass.GetStats()
+	if after.NumAllocated != before.NumAllocated+1 {
+		t.Errorf("Expected %d allocated, got %d", before.NumAllocated+1,
+			after.NumAllocated)
+	}
+	dump := CensusDump()
+	entry, ok := dump["Clownfish::Hash"].(map[string]interface{})
+	if !ok {
+		t.Fatal("CensusDump has no entry for Clownfish::Hash")
+	}
+	if allocated, _ := entry["allocated"].(int64); allocated < after.NumAllocated {
+		t.Errorf("CensusDump: expected at least %d allocated, got %v",
+			after.NumAllocated, entry["allocated"])
+	}
+}
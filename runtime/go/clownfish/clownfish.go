@@ -19,6 +19,7 @@ package clownfish
 /*
 
 #include <limits.h>
+#include <string.h>
 
 #include "charmony.h"
 
@@ -32,8 +33,10 @@ package clownfish
 #include "Clownfish/Blob.h"
 #include "Clownfish/Hash.h"
 #include "Clownfish/HashIterator.h"
+#include "Clownfish/IntHash.h"
 #include "Clownfish/Vector.h"
 #include "Clownfish/Num.h"
+#include "Clownfish/NumVector.h"
 #include "Clownfish/Boolean.h"
 #include "Clownfish/Util/Memory.h"
 #include "Clownfish/Method.h"
@@ -159,6 +162,46 @@ func (c *ClassIMP) MakeObj() Obj {
 	return WRAPAny(unsafe.Pointer(retvalCF))
 }
 
+// Heap census statistics of a class.
+type ClassStats struct {
+	NumAllocated int64
+	NumFreed     int64
+	NumLive      int64
+	LiveBytes    int64
+}
+
+func (c *ClassIMP) GetStats() ClassStats {
+	self := (*C.cfish_Class)(Unwrap(c, "c"))
+	var statsC C.cfish_ClassStats
+	C.cfish_Class_get_stats(self, &statsC)
+	return ClassStats{
+		NumAllocated: int64(statsC.num_allocated),
+		NumFreed:     int64(statsC.num_freed),
+		NumLive:      int64(statsC.num_live),
+		LiveBytes:    int64(statsC.live_bytes),
+	}
+}
+
+// Start counting objects and their memory per class.  If reportLeaks is
+// true, the classes with live objects are printed when the process exits.
+func EnableCensus(reportLeaks bool) {
+	C.cfish_Class_enable_census(C.bool(reportLeaks))
+}
+
+// Return a map from the name of every class with census statistics to a
+// map with the keys "allocated", "freed", "live" and "live_bytes".
+func CensusDump() map[string]interface{} {
+	dumpCF := C.cfish_Class_census_dump()
+	defer C.cfish_decref(unsafe.Pointer(dumpCF))
+	return ToGo(unsafe.Pointer(dumpCF)).(map[string]interface{})
+}
+
+// Print the classes with live objects and their memory to stderr and
+// return the total number of live objects.
+func ReportLeaks() int64 {
+	return int64(C.cfish_Class_report_leaks())
+}
+
 func NewMethod(name string, callbackFunc unsafe.Pointer, offset uint32) Method {
 	nameCF := (*C.cfish_String)(goToString(name, false))
 	defer C.cfish_decref(unsafe.Pointer(nameCF))
@@ -188,6 +231,30 @@ func NewVector(size int) Vector {
 	return WRAPVector(unsafe.Pointer(cfObj))
 }
 
+func NewI32Vector(capacity int) I32Vector {
+	if (capacity < 0 || uint64(capacity) > ^uint64(0)) {
+		panic(NewErr(fmt.Sprintf("Param 'capacity' out of range: %d", capacity)))
+	}
+	cfObj := C.cfish_I32Vec_new(C.size_t(capacity))
+	return WRAPI32Vector(unsafe.Pointer(cfObj))
+}
+
+func NewI64Vector(capacity int) I64Vector {
+	if (capacity < 0 || uint64(capacity) > ^uint64(0)) {
+		panic(NewErr(fmt.Sprintf("Param 'capacity' out of range: %d", capacity)))
+	}
+	cfObj := C.cfish_I64Vec_new(C.size_t(capacity))
+	return WRAPI64Vector(unsafe.Pointer(cfObj))
+}
+
+func NewF64Vector(capacity int) F64Vector {
+	if (capacity < 0 || uint64(capacity) > ^uint64(0)) {
+		panic(NewErr(fmt.Sprintf("Param 'capacity' out of range: %d", capacity)))
+	}
+	cfObj := C.cfish_F64Vec_new(C.size_t(capacity))
+	return WRAPF64Vector(unsafe.Pointer(cfObj))
+}
+
 func NewHash(size int) Hash {
 	if (size < 0 || uint64(size) > ^uint64(0)) {
 		panic(NewErr(fmt.Sprintf("Param 'size' out of range: %d", size)))
@@ -214,6 +281,28 @@ func (h *HashIMP) Keys() []string {
 	return keys
 }
 
+func NewIntHash(size int) IntHash {
+	if (size < 0 || uint64(size) > ^uint64(0)) {
+		panic(NewErr(fmt.Sprintf("Param 'size' out of range: %d", size)))
+	}
+	cfObj := C.cfish_IntHash_new(C.size_t(size))
+	return WRAPIntHash(unsafe.Pointer(cfObj))
+}
+
+func NewIntHashIterator(hash IntHash) IntHashIterator {
+	hashCF := (*C.cfish_IntHash)(Unwrap(hash, "hash"))
+	cfObj := C.cfish_IntHashIter_new(hashCF)
+	return WRAPIntHashIterator(unsafe.Pointer(cfObj))
+}
+
+func (h *IntHashIMP) Keys() []int64 {
+	self := (*C.cfish_IntHash)(Unwrap(h, "h"))
+	keysCF := C.CFISH_IntHash_Keys(self)
+	keys := I64VectorToGo(unsafe.Pointer(keysCF))
+	C.cfish_decref(unsafe.Pointer(keysCF))
+	return keys
+}
+
 func (o *ObjIMP) INITOBJ(ptr unsafe.Pointer) {
 	o.ref = uintptr(ptr)
 	runtime.SetFinalizer(o, ClearRef)
@@ -514,6 +603,12 @@ func ToGo(ptr unsafe.Pointer) interface{} {
 	} else if class == C.CFISH_FLOAT {
 		val := C.CFISH_Float_Get_Value((*C.cfish_Float)(ptr))
 		return float64(val)
+	} else if class == C.CFISH_I32VECTOR {
+		return I32VectorToGo(ptr)
+	} else if class == C.CFISH_I64VECTOR {
+		return I64VectorToGo(ptr)
+	} else if class == C.CFISH_F64VECTOR {
+		return F64VectorToGo(ptr)
 	} else {
 		// Don't convert to a native Go type, but wrap in a Go struct.
 		return WRAPAny(unsafe.Pointer(C.cfish_incref(unsafe.Pointer(ptr))))
@@ -580,6 +675,55 @@ func VectorToGo(ptr unsafe.Pointer) []interface{} {
 	return slice
 }
 
+func numVectorCheckSize(size C.size_t) int {
+	if size > C.size_t(maxInt) {
+		panic(fmt.Sprintf("Overflow: %d > %d", size, maxInt))
+	}
+	return int(size)
+}
+
+func I32VectorToGo(ptr unsafe.Pointer) []int32 {
+	vec := (*C.cfish_I32Vector)(ptr)
+	if vec == nil {
+		return nil
+	}
+	size := numVectorCheckSize(C.CFISH_I32Vec_Get_Size(vec))
+	slice := make([]int32, size)
+	if size > 0 {
+		C.memcpy(unsafe.Pointer(&slice[0]),
+			unsafe.Pointer(C.CFISH_I32Vec_Get_Ptr(vec)), C.size_t(size*4))
+	}
+	return slice
+}
+
+func I64VectorToGo(ptr unsafe.Pointer) []int64 {
+	vec := (*C.cfish_I64Vector)(ptr)
+	if vec == nil {
+		return nil
+	}
+	size := numVectorCheckSize(C.CFISH_I64Vec_Get_Size(vec))
+	slice := make([]int64, size)
+	if size > 0 {
+		C.memcpy(unsafe.Pointer(&slice[0]),
+			unsafe.Pointer(C.CFISH_I64Vec_Get_Ptr(vec)), C.size_t(size*8))
+	}
+	return slice
+}
+
+func F64VectorToGo(ptr unsafe.Pointer) []float64 {
+	vec := (*C.cfish_F64Vector)(ptr)
+	if vec == nil {
+		return nil
+	}
+	size := numVectorCheckSize(C.CFISH_F64Vec_Get_Size(vec))
+	slice := make([]float64, size)
+	if size > 0 {
+		C.memcpy(unsafe.Pointer(&slice[0]),
+			unsafe.Pointer(C.CFISH_F64Vec_Get_Ptr(vec)), C.size_t(size*8))
+	}
+	return slice
+}
+
 func HashToGo(ptr unsafe.Pointer) map[string]interface{} {
 	hash := (*C.cfish_Hash)(ptr)
 	if hash == nil {
@@ -35,9 +35,11 @@
 #include "Clownfish/Hash.h"
 #include "Clownfish/Method.h"
 #include "Clownfish/Num.h"
+#include "Clownfish/NumVector.h"
 #include "Clownfish/Obj.h"
 #include "Clownfish/String.h"
 #include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/Trace.h"
 #include "Clownfish/Vector.h"
 
 /* These symbols must be assigned real values during Go initialization,
@@ -91,6 +93,9 @@ cfish_inc_refcount(void *vself) {
         else if (SI_immortal(klass)) {
             return self;
         }
+        else if (klass == CFISH_INTEGER && cfish_Int_is_cached(self)) {
+            return self;
+        }
     }
 
     self->refcount++;
@@ -102,7 +107,9 @@ cfish_dec_refcount(void *vself) {
     cfish_Obj *self = (Obj*)vself;
     cfish_Class *klass = self->klass;
     if (klass->flags & CFISH_fREFCOUNTSPECIAL) {
-        if (SI_immortal(klass)) {
+        if (SI_immortal(klass)
+            || (klass == CFISH_INTEGER && cfish_Int_is_cached(self))
+           ) {
             return self->refcount;
         }
     }
@@ -138,6 +145,7 @@ Class_Make_Obj_IMP(Class *self) {
     Obj *obj = (Obj*)Memory_wrapped_calloc(self->obj_alloc_size, 1);
     obj->klass = self;
     obj->refcount = 1;
+    CENSUS_NEW_OBJ(self);
     return obj;
 }
 
@@ -227,6 +235,7 @@ Err_set_error(Err *error) {
 
 void
 Err_do_throw(Err *error) {
+    TRACE_INSTANT("Err", "throw", 0);
     GoCfish_PanicErr(error);
 }
 
@@ -301,6 +310,27 @@ Int_To_Host_IMP(Integer *self, void *vcache) {
     return super_to_host(self, vcache);
 }
 
+void*
+I32Vec_To_Host_IMP(I32Vector *self, void *vcache) {
+    I32Vec_To_Host_t super_to_host
+        = SUPER_METHOD_PTR(I32VECTOR, CFISH_I32Vec_To_Host);
+    return super_to_host(self, vcache);
+}
+
+void*
+I64Vec_To_Host_IMP(I64Vector *self, void *vcache) {
+    I64Vec_To_Host_t super_to_host
+        = SUPER_METHOD_PTR(I64VECTOR, CFISH_I64Vec_To_Host);
+    return super_to_host(self, vcache);
+}
+
+void*
+F64Vec_To_Host_IMP(F64Vector *self, void *vcache) {
+    F64Vec_To_Host_t super_to_host
+        = SUPER_METHOD_PTR(F64VECTOR, CFISH_F64Vec_To_Host);
+    return super_to_host(self, vcache);
+}
+
 void*
 Bool_To_Host_IMP(Boolean *self, void *vcache) {
     Bool_To_Host_t super_to_host
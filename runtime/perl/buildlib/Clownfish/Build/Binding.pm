@@ -33,10 +33,15 @@ sub bind_all {
     $class->bind_err;
     $class->bind_hash;
     $class->bind_hashiterator;
+    $class->bind_inthash;
+    $class->bind_inthashiterator;
     $class->bind_float;
     $class->bind_integer;
     $class->bind_obj;
     $class->bind_vector;
+    $class->bind_i32vector;
+    $class->bind_i64vector;
+    $class->bind_f64vector;
     $class->bind_class;
 }
 
@@ -561,6 +566,48 @@ END_XS_CODE
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_inthash {
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $hash = Clownfish::IntHash->new;
+    $hash->store($id, $value);
+    my $value = $hash->fetch($id);
+    my @ids = unpack('q*', $hash->keys);
+END_SYNOPSIS
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor();
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        class_name => "Clownfish::IntHash",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
+sub bind_inthashiterator {
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $iter = Clownfish::IntHashIterator->new($hash);
+    while ($iter->next) {
+        my $key   = $iter->get_key;
+        my $value = $iter->get_value;
+    }
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $iter = Clownfish::IntHashIterator->new($hash);
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( sample => $constructor );
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        class_name => "Clownfish::IntHashIterator",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_float {
     my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
     my $synopsis = <<'END_SYNOPSIS';
@@ -874,11 +921,72 @@ END_XS_CODE
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_i32vector {
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $vector = Clownfish::I32Vector->new;
+    $vector->push($value);
+    $vector->sort;
+    my $value = $vector->fetch($tick);
+END_SYNOPSIS
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor();
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        class_name => "Clownfish::I32Vector",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
+sub bind_i64vector {
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $vector = Clownfish::I64Vector->new;
+    $vector->push($value);
+    $vector->sort;
+    my $value = $vector->fetch($tick);
+END_SYNOPSIS
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor();
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        class_name => "Clownfish::I64Vector",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
+sub bind_f64vector {
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $vector = Clownfish::F64Vector->new;
+    $vector->push($value);
+    $vector->sort;
+    my $value = $vector->fetch($tick);
+END_SYNOPSIS
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor();
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        class_name => "Clownfish::F64Vector",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_class {
     my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
     my $synopsis = <<'END_SYNOPSIS';
     my $class = Clownfish::Class->fetch_class('Foo::Bar');
     my $subclass = Clownfish::Class->singleton('Foo::Bar::Jr', $class);
+
+    Clownfish::Class->enable_census( report_leaks => 1 );
+    my $stats = $class->get_stats;   # allocated, freed, live, live_bytes
+    my $dump  = Clownfish::Class->census_dump;
 END_SYNOPSIS
     my $fetch_class_sample = <<'END_CONSTRUCTOR';
     my $class = Clownfish::Class->fetch_class($class_name);
@@ -931,6 +1039,66 @@ CODE:
     RETVAL = (SV*)CFISH_Class_To_Host(singleton, NULL);
 }
 OUTPUT: RETVAL
+
+void
+enable_census(unused_sv, ...)
+    SV *unused_sv;
+PPCODE:
+{
+    static const XSBind_ParamSpec param_specs[1] = {
+        XSBIND_PARAM("report_leaks", false),
+    };
+    int32_t locations[1];
+    bool report_leaks = false;
+    CFISH_UNUSED_VAR(unused_sv);
+    XSBind_locate_args(aTHX_ &(ST(0)), 1, items, param_specs, locations, 1);
+    if (locations[0] < items) {
+        report_leaks = XSBind_sv_true(aTHX_ ST(locations[0]));
+    }
+    cfish_Class_enable_census(report_leaks);
+}
+
+SV*
+census_dump(unused_sv)
+    SV *unused_sv;
+CODE:
+{
+    cfish_Hash *dump = cfish_Class_census_dump();
+    CFISH_UNUSED_VAR(unused_sv);
+    RETVAL = XSBind_cfish_to_perl(aTHX_ (cfish_Obj*)dump);
+    CFISH_DECREF(dump);
+}
+OUTPUT: RETVAL
+
+int64_t
+report_leaks(unused_sv)
+    SV *unused_sv;
+CODE:
+    CFISH_UNUSED_VAR(unused_sv);
+    RETVAL = cfish_Class_report_leaks();
+OUTPUT: RETVAL
+
+SV*
+get_stats(self)
+    cfish_Class *self;
+CODE:
+{
+    cfish_ClassStats stats;
+    cfish_Hash *hash;
+    cfish_Class_get_stats(self, &stats);
+    hash = cfish_Hash_new(4);
+    CFISH_Hash_Store_Utf8(hash, "allocated", 9,
+                          (cfish_Obj*)cfish_Int_new(stats.num_allocated));
+    CFISH_Hash_Store_Utf8(hash, "freed", 5,
+                          (cfish_Obj*)cfish_Int_new(stats.num_freed));
+    CFISH_Hash_Store_Utf8(hash, "live", 4,
+                          (cfish_Obj*)cfish_Int_new(stats.num_live));
+    CFISH_Hash_Store_Utf8(hash, "live_bytes", 10,
+                          (cfish_Obj*)cfish_Int_new(stats.live_bytes));
+    RETVAL = XSBind_cfish_to_perl(aTHX_ (cfish_Obj*)hash);
+    CFISH_DECREF(hash);
+}
+OUTPUT: RETVAL
 END_XS_CODE
 
     my $binding = Clownfish::CFC::Binding::Perl::Class->new(
@@ -23,7 +23,7 @@ sub oodle { }
 
 package main;
 
-use Test::More tests => 5;
+use Test::More tests => 8;
 
 my $stringified;
 my $storage = Clownfish::Hash->new;
@@ -52,3 +52,13 @@ is( $resurrected->get_class_name,
 my $methods = Clownfish::Class::_fresh_host_methods('MyObj');
 is_deeply( $methods->to_perl, ['oodle'], "fresh_host_methods" );
 
+Clownfish::Class->enable_census;
+my $vec_class = Clownfish::Class->fetch_class('Clownfish::Vector');
+my $before = $vec_class->get_stats;
+is_deeply( [ sort keys %$before ], [qw( allocated freed live live_bytes )],
+    "get_stats" );
+my $census_vec = Clownfish::Vector->new;
+is( $vec_class->get_stats->{allocated}, $before->{allocated} + 1,
+    "census counts new objects" );
+my $dump = Clownfish::Class->census_dump;
+ok( $dump->{'Clownfish::Vector'}{live} >= 1, "census_dump" );
@@ -30,10 +30,12 @@
 #include "Clownfish/HashIterator.h"
 #include "Clownfish/Method.h"
 #include "Clownfish/Num.h"
+#include "Clownfish/NumVector.h"
 #include "Clownfish/PtrHash.h"
 #include "Clownfish/TestHarness/TestUtils.h"
 #include "Clownfish/Util/Atomic.h"
 #include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/Trace.h"
 
 #define XSBIND_REFCOUNT_FLAG   1
 #define XSBIND_REFCOUNT_SHIFT  1
@@ -570,6 +572,15 @@ SI_immortal(cfish_Class *klass) {
     return false;
 }
 
+// Cached Integers are shared like the immortal classes, but other Integers
+// are refcounted as usual.
+static CFISH_INLINE bool
+SI_immortal_obj(cfish_Obj *self) {
+    cfish_Class *klass = self->klass;
+    return SI_immortal(klass)
+           || (klass == CFISH_INTEGER && cfish_Int_is_cached(self));
+}
+
 static CFISH_INLINE bool
 SI_is_string_type(cfish_Class *klass) {
     if (klass == CFISH_STRING) {
@@ -597,7 +608,7 @@ S_lazy_init_host_obj(pTHX_ cfish_Obj *self, bool increment) {
     SvREFCNT(inner_obj) += excess;
 
     // Overwrite refcount with host object.
-    if (SI_immortal(klass)) {
+    if (SI_immortal_obj(self)) {
         SvSHARE(inner_obj);
         if (!cfish_Atomic_cas_ptr((void**)&self->ref, old_ref.host_obj,
                                   inner_obj)) {
@@ -649,7 +660,7 @@ cfish_inc_refcount(void *vself) {
                 return (cfish_Obj*)cfish_Str_new_from_trusted_utf8(utf8, size);
             }
         }
-        else if (SI_immortal(klass)) {
+        else if (SI_immortal_obj(self)) {
             return self;
         }
     }
@@ -672,7 +683,7 @@ cfish_dec_refcount(void *vself) {
 
     cfish_Class *klass = self->klass;
     if (klass->flags & CFISH_fREFCOUNTSPECIAL) {
-        if (SI_immortal(klass)) {
+        if (SI_immortal_obj(self)) {
             return 1;
         }
     }
@@ -763,6 +774,7 @@ CFISH_Class_Make_Obj_IMP(cfish_Class *self) {
         = (cfish_Obj*)cfish_Memory_wrapped_calloc(self->obj_alloc_size, 1);
     obj->klass = self;
     obj->ref.count = (1 << XSBIND_REFCOUNT_SHIFT) | XSBIND_REFCOUNT_FLAG;
+    CFISH_CENSUS_NEW_OBJ(self);
     return obj;
 }
 
@@ -912,6 +924,7 @@ void
 cfish_Err_do_throw(cfish_Err *err) {
     dTHX;
     dSP;
+    CFISH_TRACE_INSTANT("Err", "throw", 0);
     SV *error_sv = (SV*)CFISH_Err_To_Host(err, NULL);
     CFISH_DECREF(err);
     ENTER;
@@ -1178,6 +1191,35 @@ CFISH_Bool_To_Host_IMP(cfish_Boolean *self, void *vcache) {
     return newSViv((IV)self->value);
 }
 
+/*************************** Clownfish::NumVector ***************************/
+
+// Numeric vectors are converted to packed strings in native byte order,
+// suitable for `unpack` with the templates "l*", "q*" and "d*".
+
+void*
+CFISH_I32Vec_To_Host_IMP(cfish_I32Vector *self, void *vcache) {
+    CFISH_UNUSED_VAR(vcache);
+    dTHX;
+    return newSVpvn((char*)CFISH_I32Vec_Get_Ptr(self),
+                    CFISH_I32Vec_Get_Size(self) * sizeof(int32_t));
+}
+
+void*
+CFISH_I64Vec_To_Host_IMP(cfish_I64Vector *self, void *vcache) {
+    CFISH_UNUSED_VAR(vcache);
+    dTHX;
+    return newSVpvn((char*)CFISH_I64Vec_Get_Ptr(self),
+                    CFISH_I64Vec_Get_Size(self) * sizeof(int64_t));
+}
+
+void*
+CFISH_F64Vec_To_Host_IMP(cfish_F64Vector *self, void *vcache) {
+    CFISH_UNUSED_VAR(vcache);
+    dTHX;
+    return newSVpvn((char*)CFISH_F64Vec_Get_Ptr(self),
+                    CFISH_F64Vec_Get_Size(self) * sizeof(double));
+}
+
 /********************* Clownfish::TestHarness::TestUtils ********************/
 
 
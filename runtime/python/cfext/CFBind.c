@@ -34,10 +34,12 @@
 #include "Clownfish/HashIterator.h"
 #include "Clownfish/Method.h"
 #include "Clownfish/Num.h"
+#include "Clownfish/NumVector.h"
 #include "Clownfish/String.h"
 #include "Clownfish/TestHarness/TestUtils.h"
 #include "Clownfish/Util/Atomic.h"
 #include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/Trace.h"
 #include "Clownfish/Vector.h"
 
 static bool Err_initialized;
@@ -947,6 +949,7 @@ CFISH_Class_Make_Obj_IMP(cfish_Class *self) {
     PyTypeObject *py_type = S_get_cached_py_type(self);
     cfish_Obj *obj = (cfish_Obj*)py_type->tp_alloc(py_type, 0);
     obj->klass = self;
+    CFISH_CENSUS_NEW_OBJ(self);
     return obj;
 }
 
@@ -1048,6 +1051,7 @@ cfish_Err_set_error(cfish_Err *error) {
 
 void
 cfish_Err_do_throw(cfish_Err *error) {
+    CFISH_TRACE_INSTANT("Err", "throw", 0);
     if (current_env) {
         thrown_error = error;
         longjmp(*current_env, 1);
@@ -1194,6 +1198,44 @@ CFISH_Int_To_Host_IMP(cfish_Integer *self, void *vcache) {
     return PyLong_FromLongLong(num);
 }
 
+// Convert packed numbers to a memoryview supporting the buffer protocol,
+// cast to the struct module format `format`.
+static PyObject*
+S_packed_to_py(const void *ptr, size_t size, const char *format) {
+    PyObject *bytes = PyBytes_FromStringAndSize((const char*)ptr, size);
+    if (!bytes) { return NULL; }
+    PyObject *view = PyMemoryView_FromObject(bytes);
+    Py_DECREF(bytes);
+    if (!view) { return NULL; }
+    PyObject *cast = PyObject_CallMethod(view, "cast", "s", format);
+    Py_DECREF(view);
+    return cast;
+}
+
+void*
+CFISH_I32Vec_To_Host_IMP(cfish_I32Vector *self, void *vcache) {
+    CFISH_UNUSED_VAR(vcache);
+    return S_packed_to_py(CFISH_I32Vec_Get_Ptr(self),
+                          CFISH_I32Vec_Get_Size(self) * sizeof(int32_t),
+                          "i");
+}
+
+void*
+CFISH_I64Vec_To_Host_IMP(cfish_I64Vector *self, void *vcache) {
+    CFISH_UNUSED_VAR(vcache);
+    return S_packed_to_py(CFISH_I64Vec_Get_Ptr(self),
+                          CFISH_I64Vec_Get_Size(self) * sizeof(int64_t),
+                          "q");
+}
+
+void*
+CFISH_F64Vec_To_Host_IMP(cfish_F64Vector *self, void *vcache) {
+    CFISH_UNUSED_VAR(vcache);
+    return S_packed_to_py(CFISH_F64Vec_Get_Ptr(self),
+                          CFISH_F64Vec_Get_Size(self) * sizeof(double),
+                          "d");
+}
+
 void*
 CFISH_Bool_To_Host_IMP(cfish_Boolean *self, void *vcache) {
     CFISH_UNUSED_VAR(vcache);
@@ -19,26 +19,39 @@
 
 #include "Clownfish/Test.h"
 
+#include "Clownfish/TestHarness/BenchBatch.h"
 #include "Clownfish/TestHarness/TestBatch.h"
 #include "Clownfish/TestHarness/TestSuite.h"
+#include "Clownfish/Vector.h"
 
+#include "Clownfish/Test/BenchCore.h"
 #include "Clownfish/Test/TestBlob.h"
 #include "Clownfish/Test/TestBoolean.h"
 #include "Clownfish/Test/TestByteBuf.h"
 #include "Clownfish/Test/TestString.h"
 #include "Clownfish/Test/TestCharBuf.h"
 #include "Clownfish/Test/TestClass.h"
+#include "Clownfish/Test/TestConcurrency.h"
 #include "Clownfish/Test/TestErr.h"
 #include "Clownfish/Test/TestHash.h"
 #include "Clownfish/Test/TestHashIterator.h"
+#include "Clownfish/Test/TestIntHash.h"
 #include "Clownfish/Test/TestLockFreeRegistry.h"
 #include "Clownfish/Test/TestMethod.h"
 #include "Clownfish/Test/TestNum.h"
+#include "Clownfish/Test/TestNumVector.h"
 #include "Clownfish/Test/TestObj.h"
 #include "Clownfish/Test/TestPtrHash.h"
 #include "Clownfish/Test/TestVector.h"
 #include "Clownfish/Test/Util/TestAtomic.h"
 #include "Clownfish/Test/Util/TestMemory.h"
+#include "Clownfish/Test/Util/TestChannel.h"
+#include "Clownfish/Test/Util/TestStreams.h"
+#include "Clownfish/Test/Util/TestFreezer.h"
+#include "Clownfish/Test/Util/TestJson.h"
+#include "Clownfish/Test/Util/TestSortUtils.h"
+#include "Clownfish/Test/Util/TestThreadPool.h"
+#include "Clownfish/Test/Util/TestTrace.h"
 
 TestSuite*
 Test_create_test_suite() {
@@ -49,6 +62,7 @@ Test_create_test_suite() {
     TestSuite_Add_Batch(suite, (TestBatch*)TestVector_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestHash_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestHashIterator_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestIntHash_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestObj_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestErr_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestBlob_new());
@@ -57,12 +71,29 @@ Test_create_test_suite() {
     TestSuite_Add_Batch(suite, (TestBatch*)TestCB_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestBoolean_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestNum_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestNumVec_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestAtomic_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestLFReg_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestMemory_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestSortUtils_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestThreadPool_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestChannel_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestStreams_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestFreezer_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestJson_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestTrace_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestPtrHash_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestConcurrency_new());
 
     return suite;
 }
 
+Vector*
+Test_create_bench_batches() {
+    Vector *batches = Vec_new(0);
+
+    Vec_Push(batches, (Obj*)BenchCore_new());
+
+    return batches;
+}
 
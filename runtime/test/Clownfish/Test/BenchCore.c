@@ -0,0 +1,420 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#define CFISH_USE_SHORT_NAMES
+#define TESTCFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Test/BenchCore.h"
+
+#include "Clownfish/CharBuf.h"
+#include "Clownfish/Boolean.h"
+#include "Clownfish/Class.h"
+#include "Clownfish/Hash.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Vector.h"
+#include "Clownfish/TestHarness/BenchRunner.h"
+#include "Clownfish/TestHarness/TestUtils.h"
+#include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/SortUtils.h"
+
+#define NUM_KEYS  1000
+#define NUM_ELEMS 1000
+
+// Large enough that the entries and keys of the Hash don't fit into the
+// last-level cache.
+#define NUM_BIG_KEYS (1 << 21)
+#define BATCH_SIZE   64
+
+typedef struct {
+    String   **keys;
+    String   **misses;
+    Hash      *hash;
+    String   **big_keys;
+    size_t    *big_hash_sums;
+    Hash      *big_hash;
+    Obj      **values;
+    Vector    *vec;
+    CharBuf   *buf;
+    String    *haystack;
+    String    *needle;
+    uint64_t  *randoms;
+    uint64_t  *elems;
+    uint64_t  *scratch;
+    Class    **classes;
+    String   **class_names;
+    size_t     num_classes;
+} BenchData;
+
+BenchCore*
+BenchCore_new() {
+    return (BenchCore*)Class_Make_Obj(BENCHCORE);
+}
+
+/******************************** Hash ********************************/
+
+static void
+S_hash_fetch(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        Hash_Fetch(data->hash, data->keys[i % NUM_KEYS]);
+    }
+}
+
+static void
+S_hash_fetch_miss(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        Hash_Fetch(data->hash, data->misses[i % NUM_KEYS]);
+    }
+}
+
+static void
+S_hash_fetch_many(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i += BATCH_SIZE) {
+        size_t num_keys = num_ops - i < BATCH_SIZE
+                          ? (size_t)(num_ops - i)
+                          : BATCH_SIZE;
+        size_t offset   = (size_t)(i % (NUM_KEYS - BATCH_SIZE));
+        Hash_Fetch_Many(data->hash, data->keys + offset, num_keys,
+                        data->values);
+    }
+}
+
+// The big benchmarks measure single keys, so that looped Fetch and
+// Fetch_Many can be compared directly.
+
+static void
+S_hash_fetch_big(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        Hash_Fetch(data->big_hash, data->big_keys[i % NUM_BIG_KEYS]);
+    }
+}
+
+static void
+S_hash_fetch_hashed_big(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        size_t tick = (size_t)(i % NUM_BIG_KEYS);
+        Hash_Fetch_Many_Hashed(data->big_hash, data->big_keys + tick,
+                               data->big_hash_sums + tick, 1, data->values);
+    }
+}
+
+static void
+S_hash_fetch_many_big(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i += BATCH_SIZE) {
+        size_t num_keys = num_ops - i < BATCH_SIZE
+                          ? (size_t)(num_ops - i)
+                          : BATCH_SIZE;
+        size_t offset   = (size_t)(i % NUM_BIG_KEYS);
+        Hash_Fetch_Many(data->big_hash, data->big_keys + offset, num_keys,
+                        data->values);
+    }
+}
+
+static void
+S_hash_fetch_many_hashed_big(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i += BATCH_SIZE) {
+        size_t num_keys = num_ops - i < BATCH_SIZE
+                          ? (size_t)(num_ops - i)
+                          : BATCH_SIZE;
+        size_t offset   = (size_t)(i % NUM_BIG_KEYS);
+        Hash_Fetch_Many_Hashed(data->big_hash, data->big_keys + offset,
+                               data->big_hash_sums + offset, num_keys,
+                               data->values);
+    }
+}
+
+static void
+S_hash_build(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        Hash *hash = Hash_new(0);
+        for (size_t j = 0; j < NUM_KEYS; j++) {
+            Hash_Store(hash, data->keys[j], NULL);
+        }
+        DECREF(hash);
+    }
+}
+
+/******************************* String *******************************/
+
+static void
+S_str_newf(void *context, uint64_t num_ops) {
+    UNUSED_VAR(context);
+    for (uint64_t i = 0; i < num_ops; i++) {
+        String *string = Str_newf("key-%u64", i);
+        DECREF(string);
+    }
+}
+
+static void
+S_str_equals(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        size_t tick = i % NUM_KEYS;
+        Str_Equals(data->keys[tick], (Obj*)data->misses[tick]);
+    }
+}
+
+static void
+S_str_hash_sum(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        Str_Hash_Sum(data->keys[i % NUM_KEYS]);
+    }
+}
+
+static void
+S_str_find(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        Str_Find(data->haystack, data->needle);
+    }
+}
+
+/******************************* Vector *******************************/
+
+static void
+S_vec_push(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        Vector *vec = Vec_new(0);
+        for (size_t j = 0; j < NUM_ELEMS; j++) {
+            Vec_Push(vec, INCREF(data->keys[j]));
+        }
+        DECREF(vec);
+    }
+}
+
+static void
+S_vec_fetch(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        Vec_Fetch(data->vec, i % NUM_ELEMS);
+    }
+}
+
+/******************************* CharBuf ******************************/
+
+static void
+S_cb_cat_utf8(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        if (i % 1024 == 0) {
+            CB_Clear(data->buf);
+        }
+        CB_Cat_Utf8(data->buf, "sixteen bytes!!\n", 16);
+    }
+}
+
+static void
+S_cb_catf(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        if (i % 1024 == 0) {
+            CB_Clear(data->buf);
+        }
+        CB_catf(data->buf, "%o=%i64;", data->keys[i % NUM_KEYS], (int64_t)i);
+    }
+}
+
+/******************************** Sort ********************************/
+
+static int
+S_compare_u64(void *context, const void *va, const void *vb) {
+    UNUSED_VAR(context);
+    uint64_t a = *(const uint64_t*)va;
+    uint64_t b = *(const uint64_t*)vb;
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static void
+S_sort_quicksort(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        memcpy(data->elems, data->randoms, NUM_ELEMS * sizeof(uint64_t));
+        Sort_quicksort(data->elems, NUM_ELEMS, sizeof(uint64_t),
+                       S_compare_u64, NULL);
+    }
+}
+
+static void
+S_sort_mergesort(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        memcpy(data->elems, data->randoms, NUM_ELEMS * sizeof(uint64_t));
+        Sort_mergesort(data->elems, data->scratch, NUM_ELEMS,
+                       sizeof(uint64_t), S_compare_u64, NULL);
+    }
+}
+
+static void
+S_sort_radixsort(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        memcpy(data->elems, data->randoms, NUM_ELEMS * sizeof(uint64_t));
+        Sort_radixsort_u64(data->elems, data->scratch, NUM_ELEMS, NULL);
+    }
+}
+
+/****************************** Bootstrap *****************************/
+
+static void
+S_class_fetch(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        Class_fetch_class(data->class_names[i % data->num_classes]);
+    }
+}
+
+static void
+S_class_singleton(void *context, uint64_t num_ops) {
+    BenchData *data = (BenchData*)context;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        size_t tick = i % data->num_classes;
+        Class_singleton(data->class_names[tick], data->classes[tick]);
+    }
+}
+
+/**********************************************************************/
+
+static void
+S_init_data(BenchData *data) {
+    data->keys   = (String**)MALLOCATE(NUM_KEYS * sizeof(String*));
+    data->misses = (String**)MALLOCATE(NUM_KEYS * sizeof(String*));
+    data->hash   = Hash_new(0);
+    data->vec    = Vec_new(NUM_ELEMS);
+    for (size_t i = 0; i < NUM_KEYS; i++) {
+        data->keys[i]   = Str_newf("key-%u64", (uint64_t)i);
+        data->misses[i] = Str_newf("key-%u64", (uint64_t)(i + NUM_KEYS));
+        Hash_Store(data->hash, data->keys[i], INCREF(data->keys[i]));
+        Vec_Push(data->vec, INCREF(data->keys[i]));
+    }
+
+    data->big_keys
+        = (String**)MALLOCATE(NUM_BIG_KEYS * sizeof(String*));
+    data->big_hash_sums
+        = (size_t*)MALLOCATE(NUM_BIG_KEYS * sizeof(size_t));
+    data->big_hash = Hash_new(NUM_BIG_KEYS);
+    data->values   = (Obj**)MALLOCATE(BATCH_SIZE * sizeof(Obj*));
+    for (size_t i = 0; i < NUM_BIG_KEYS; i++) {
+        String *key = Str_newf("key-%u64", (uint64_t)i);
+        Hash_Store(data->big_hash, key, (Obj*)CFISH_TRUE);
+        data->big_keys[i]      = key;
+        data->big_hash_sums[i] = Str_Hash_Sum(key);
+    }
+
+    data->buf = CB_new(0);
+
+    CharBuf *haystack = CB_new(0);
+    for (size_t i = 0; i < 100; i++) {
+        CB_Cat_Utf8(haystack, "a quick brown fox ", 18);
+    }
+    CB_Cat_Utf8(haystack, "jumps over the lazy dog", 23);
+    data->haystack = CB_Yield_String(haystack);
+    DECREF(haystack);
+    data->needle = Str_newf("lazy dog");
+
+    data->randoms = TestUtils_random_u64s(NULL, NUM_ELEMS, 0, UINT64_MAX);
+    data->elems   = (uint64_t*)MALLOCATE(NUM_ELEMS * sizeof(uint64_t));
+    data->scratch = (uint64_t*)MALLOCATE(NUM_ELEMS * sizeof(uint64_t));
+
+    // Subclasses of Obj with a parent, the way Class_singleton is called
+    // for host subclasses.
+    Class *classes[] = { STRING, HASH, VECTOR, CHARBUF, FLOAT, INTEGER };
+    data->num_classes = sizeof(classes) / sizeof(classes[0]);
+    data->classes     = (Class**)MALLOCATE(sizeof(classes));
+    data->class_names
+        = (String**)MALLOCATE(data->num_classes * sizeof(String*));
+    for (size_t i = 0; i < data->num_classes; i++) {
+        data->classes[i]     = Class_Get_Parent(classes[i]);
+        data->class_names[i] = Str_Clone(Class_Get_Name(classes[i]));
+    }
+}
+
+static void
+S_destroy_data(BenchData *data) {
+    for (size_t i = 0; i < NUM_KEYS; i++) {
+        DECREF(data->keys[i]);
+        DECREF(data->misses[i]);
+    }
+    FREEMEM(data->keys);
+    FREEMEM(data->misses);
+    DECREF(data->hash);
+    for (size_t i = 0; i < NUM_BIG_KEYS; i++) {
+        DECREF(data->big_keys[i]);
+    }
+    FREEMEM(data->big_keys);
+    FREEMEM(data->big_hash_sums);
+    DECREF(data->big_hash);
+    FREEMEM(data->values);
+    DECREF(data->vec);
+    DECREF(data->buf);
+    DECREF(data->haystack);
+    DECREF(data->needle);
+    FREEMEM(data->randoms);
+    FREEMEM(data->elems);
+    FREEMEM(data->scratch);
+    for (size_t i = 0; i < data->num_classes; i++) {
+        DECREF(data->class_names[i]);
+    }
+    FREEMEM(data->classes);
+    FREEMEM(data->class_names);
+}
+
+void
+BenchCore_Run_IMP(BenchCore *self, BenchRunner *runner) {
+    UNUSED_VAR(self);
+
+    BenchData data;
+    S_init_data(&data);
+
+    BenchRunner_Bench(runner, "hash_fetch", S_hash_fetch, &data);
+    BenchRunner_Bench(runner, "hash_fetch_miss", S_hash_fetch_miss, &data);
+    BenchRunner_Bench(runner, "hash_fetch_many", S_hash_fetch_many, &data);
+    BenchRunner_Bench(runner, "hash_fetch_big", S_hash_fetch_big, &data);
+    BenchRunner_Bench(runner, "hash_fetch_hashed_big",
+                      S_hash_fetch_hashed_big, &data);
+    BenchRunner_Bench(runner, "hash_fetch_many_big", S_hash_fetch_many_big,
+                      &data);
+    BenchRunner_Bench(runner, "hash_fetch_many_hashed_big",
+                      S_hash_fetch_many_hashed_big, &data);
+    BenchRunner_Bench(runner, "hash_build_1000", S_hash_build, &data);
+    BenchRunner_Bench(runner, "str_newf", S_str_newf, &data);
+    BenchRunner_Bench(runner, "str_equals", S_str_equals, &data);
+    BenchRunner_Bench(runner, "str_hash_sum", S_str_hash_sum, &data);
+    BenchRunner_Bench(runner, "str_find", S_str_find, &data);
+    BenchRunner_Bench(runner, "vec_push_1000", S_vec_push, &data);
+    BenchRunner_Bench(runner, "vec_fetch", S_vec_fetch, &data);
+    BenchRunner_Bench(runner, "cb_cat_utf8", S_cb_cat_utf8, &data);
+    BenchRunner_Bench(runner, "cb_catf", S_cb_catf, &data);
+    BenchRunner_Bench(runner, "sort_quicksort_1000", S_sort_quicksort, &data);
+    BenchRunner_Bench(runner, "sort_mergesort_1000", S_sort_mergesort, &data);
+    BenchRunner_Bench(runner, "sort_radixsort_1000", S_sort_radixsort, &data);
+    BenchRunner_Bench(runner, "class_fetch", S_class_fetch, &data);
+    BenchRunner_Bench(runner, "class_singleton", S_class_singleton, &data);
+
+    S_destroy_data(&data);
+}
+
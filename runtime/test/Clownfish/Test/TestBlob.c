@@ -17,15 +17,20 @@
 #define CFISH_USE_SHORT_NAMES
 #define TESTCFISH_USE_SHORT_NAMES
 
+#include "charmony.h"
+
 #include "Clownfish/Test/TestBlob.h"
 
 #include "Clownfish/Blob.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/String.h"
 #include "Clownfish/Test.h"
 #include "Clownfish/TestHarness/TestBatchRunner.h"
 #include "Clownfish/TestHarness/TestUtils.h"
 #include "Clownfish/Class.h"
 #include "Clownfish/Util/Memory.h"
 
+#include <stdio.h>
 #include <string.h>
 
 TestBlob*
@@ -134,14 +139,128 @@ test_Compare_To(TestBatchRunner *runner) {
     }
 }
 
+typedef struct {
+    int         num_calls;
+    const char *buf;
+    size_t      size;
+} ReleaseContext;
+
+static void
+S_release(void *vcontext, const char *buf, size_t size) {
+    ReleaseContext *context = (ReleaseContext*)vcontext;
+    context->num_calls++;
+    context->buf  = buf;
+    context->size = size;
+}
+
+static void
+test_new_external(TestBatchRunner *runner) {
+    static const char bytes[] = "external";
+    ReleaseContext context = { 0, NULL, 0 };
+    Blob *blob = Blob_new_external(bytes, 8, S_release, &context);
+    TEST_TRUE(runner, Blob_Get_Buf(blob) == bytes && context.num_calls == 0,
+              "new_external wraps buffer");
+    Blob *twin = Blob_new("external", 8);
+    TEST_TRUE(runner, Blob_Equals(twin, (Obj*)blob),
+              "external Blob equals copy");
+    DECREF(twin);
+    DECREF(blob);
+    TEST_TRUE(runner,
+              context.num_calls == 1
+              && context.buf == bytes
+              && context.size == 8,
+              "release called on Destroy");
+}
+
+#define MMAP_TEST_FILE  "_test_blob_mmap.bin"
+#define MMAP_TEST_SIZE  10000
+
+static void
+S_map_missing(void *context) {
+    UNUSED_VAR(context);
+    String *path = SSTR_WRAP_C("_no_such_file.bin");
+    Blob *blob = Blob_new_mmap(path, 0, -1);
+    DECREF(blob);
+}
+
+static void
+S_map_out_of_range(void *context) {
+    Blob *blob = Blob_new_mmap((String*)context, MMAP_TEST_SIZE - 10, 11);
+    DECREF(blob);
+}
+
+static void
+test_new_mmap(TestBatchRunner *runner) {
+#if defined(CHY_HAS_SYS_MMAN_H) || defined(CHY_HAS_WINDOWS_H)
+    char *bytes = (char*)MALLOCATE(MMAP_TEST_SIZE);
+    for (size_t i = 0; i < MMAP_TEST_SIZE; i++) {
+        bytes[i] = (char)(i * 7 % 251);
+    }
+    FILE *file = fopen(MMAP_TEST_FILE, "wb");
+    if (!file
+        || fwrite(bytes, 1, MMAP_TEST_SIZE, file) != MMAP_TEST_SIZE
+        || fclose(file) != 0
+       ) {
+        FREEMEM(bytes);
+        SKIP(runner, 10, "Can't write " MMAP_TEST_FILE);
+        return;
+    }
+    String *path = SSTR_WRAP_C(MMAP_TEST_FILE);
+
+    Blob *blob = Blob_new_mmap(path, 0, -1);
+    TEST_UINT_EQ(runner, Blob_Get_Size(blob), MMAP_TEST_SIZE,
+                 "new_mmap maps whole file");
+    TEST_TRUE(runner, Blob_Equals_Bytes(blob, bytes, MMAP_TEST_SIZE),
+              "mapped content");
+    TEST_TRUE(runner, Blob_Is_Mapped(blob), "Is_Mapped");
+    Blob *copy = Blob_new(bytes, MMAP_TEST_SIZE);
+    TEST_INT_EQ(runner, Blob_Compare_To(copy, (Obj*)blob), 0,
+                "Compare_To with mapped Blob");
+#ifndef CHY_HAS_WINDOWS_H
+    TEST_TRUE(runner, Blob_Advise(blob, BLOB_ADVICE_SEQUENTIAL), "Advise");
+#else
+    SKIP(runner, 1, "Advise not supported");
+#endif
+    TEST_FALSE(runner, Blob_Advise(copy, BLOB_ADVICE_WILLNEED),
+               "Advise fails for Blob which isn't mapped");
+    DECREF(copy);
+    DECREF(blob);
+
+    blob = Blob_new_mmap(path, 4097, 100);
+    TEST_TRUE(runner, Blob_Equals_Bytes(blob, bytes + 4097, 100),
+              "new_mmap with unaligned offset");
+    DECREF(blob);
+
+    blob = Blob_new_mmap(path, MMAP_TEST_SIZE, -1);
+    TEST_TRUE(runner, Blob_Get_Size(blob) == 0 && !Blob_Is_Mapped(blob),
+              "new_mmap with empty range");
+    DECREF(blob);
+
+    Err *error = Err_trap(S_map_out_of_range, path);
+    TEST_TRUE(runner, error != NULL, "new_mmap past EOF throws");
+    DECREF(error);
+
+    error = Err_trap(S_map_missing, NULL);
+    TEST_TRUE(runner, error != NULL, "new_mmap of missing file throws");
+    DECREF(error);
+
+    remove(MMAP_TEST_FILE);
+    FREEMEM(bytes);
+#else
+    SKIP(runner, 10, "mmap not supported");
+#endif
+}
+
 void
 TestBlob_Run_IMP(TestBlob *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 17);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 30);
     test_new_steal(runner);
     test_new_wrap(runner);
     test_Equals(runner);
     test_Clone(runner);
     test_Compare_To(runner);
+    test_new_external(runner);
+    test_new_mmap(runner);
 }
 
 
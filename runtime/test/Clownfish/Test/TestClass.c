@@ -29,10 +29,14 @@
 
 #include "Clownfish/Boolean.h"
 #include "Clownfish/Class.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/Hash.h"
 #include "Clownfish/Method.h"
+#include "Clownfish/Num.h"
 #include "Clownfish/String.h"
 #include "Clownfish/TestHarness/TestBatchRunner.h"
 #include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/ThreadPool.h"
 #include "Clownfish/Vector.h"
 
 TestClass*
@@ -70,6 +74,10 @@ test_bootstrap_idempotence(TestBatchRunner *runner) {
     // Force another bootstrap run.
     cfish_bootstrap_internal(1);
 
+    // The census hangs its counts off a class lazily, which may happen
+    // during the bootstrap run.
+    ((Class*)bool_class_contents)->census = BOOLEAN->census;
+
 #if DEBUG_CLASS_CONTENTS
     printf("Before\n");
     S_memdump(bool_class_contents, bool_class_size);
@@ -121,6 +129,68 @@ test_simple_subclass(TestBatchRunner *runner) {
     DECREF(obj);
 }
 
+static void
+test_singleton_cache(TestBatchRunner *runner) {
+    String *class_name = SSTR_WRAP_C("Clownfish::Test::MyCachedObj");
+    Class *subclass = Class_singleton(class_name, OBJ);
+
+    String *copy = Str_new_from_trusted_utf8("Clownfish::Test::MyCachedObj",
+                                             28);
+    TEST_TRUE(runner, Class_singleton(copy, NULL) == subclass,
+              "singleton returns cached Class for equal name");
+    TEST_TRUE(runner, Class_fetch_class(copy) == subclass,
+              "cached Class is registered");
+    DECREF(copy);
+
+    String *other_name = SSTR_WRAP_C("Clownfish::Test::MyOtherCachedObj");
+    Class *other = Class_singleton(other_name, subclass);
+    TEST_TRUE(runner, other != subclass && Class_Get_Parent(other) == subclass,
+              "singleton distinguishes names");
+}
+
+static void
+test_is_a(TestBatchRunner *runner) {
+    Obj *err = (Obj*)Err_new(Str_newf("test"));
+    TEST_TRUE(runner, Obj_is_a(err, ERR) && Obj_is_a(err, OBJ),
+              "is_a bootstrapped ancestors");
+    TEST_FALSE(runner, Obj_is_a(err, STRING), "is_a unrelated class");
+    TEST_FALSE(runner, Obj_is_a(err, NULL), "is_a NULL class");
+    TEST_FALSE(runner, Obj_is_a(NULL, OBJ), "is_a NULL object");
+    DECREF(err);
+
+    // Deep enough to go past the inline display.
+    Class *chain[10];
+    Class *parent = ERR;
+    for (int i = 0; i < 10; i++) {
+        String *name = Str_newf("Clownfish::Test::Deep%i32", (int32_t)i);
+        chain[i] = Class_singleton(name, parent);
+        parent = chain[i];
+        DECREF(name);
+    }
+    String *sibling_name = SSTR_WRAP_C("Clownfish::Test::DeepSibling");
+    Class  *sibling      = Class_singleton(sibling_name, chain[2]);
+
+    String *deep_sibling_name = SSTR_WRAP_C("Clownfish::Test::DeepSibling2");
+    Class  *deep_sibling      = Class_singleton(deep_sibling_name, chain[7]);
+
+    Obj *deepest = Class_Make_Obj(chain[9]);
+    bool all_ancestors = Obj_is_a(deepest, OBJ) && Obj_is_a(deepest, ERR);
+    for (int i = 0; i < 10; i++) {
+        if (!Obj_is_a(deepest, chain[i])) { all_ancestors = false; }
+    }
+    TEST_TRUE(runner, all_ancestors, "is_a all ancestors of deep subclass");
+    TEST_FALSE(runner, Obj_is_a(deepest, sibling),
+               "is_a sibling at same depth");
+    TEST_FALSE(runner, Obj_is_a(deepest, deep_sibling),
+               "is_a sibling past the inline display");
+    DECREF(deepest);
+
+    Obj *middle = Class_Make_Obj(chain[2]);
+    TEST_FALSE(runner, Obj_is_a(middle, chain[3]), "is_a descendant");
+    TEST_FALSE(runner, Obj_is_a(middle, chain[9]), "is_a deep descendant");
+    DECREF(middle);
+}
+
 static void
 test_add_alias_to_registry(TestBatchRunner *runner) {
     static const char alias[] = "Clownfish::Test::ObjAlias";
@@ -153,12 +223,135 @@ test_Get_Methods(TestBatchRunner *runner) {
     DECREF(methods);
 }
 
+static void
+test_Get_Name(TestBatchRunner *runner) {
+    String *name = Class_Get_Name(BOOLEAN);
+    TEST_TRUE(runner, Str_Equals_Utf8(name, "Clownfish::Boolean", 18),
+              "Get_Name of bootstrapped class");
+    TEST_TRUE(runner, Class_Get_Name(BOOLEAN) == name,
+              "Get_Name returns same String");
+}
+
+static void
+test_census(TestBatchRunner *runner) {
+    String *class_name = SSTR_WRAP_C("Clownfish::Test::MyCensusObj");
+    Class *subclass = Class_singleton(class_name, OBJ);
+    int64_t obj_size = (int64_t)Class_Get_Obj_Alloc_Size(subclass);
+    ClassStats stats;
+
+    Class_enable_census(false);
+    TEST_TRUE(runner, Class_census_enabled, "enable_census");
+
+    Obj *objs[3];
+    for (int i = 0; i < 3; i++) {
+        objs[i] = Class_Make_Obj(subclass);
+    }
+    DECREF(objs[0]);
+    Class_get_stats(subclass, &stats);
+    TEST_TRUE(runner,
+              stats.num_allocated == 3
+              && stats.num_freed == 1
+              && stats.num_live == 2
+              && stats.live_bytes == 2 * obj_size,
+              "get_stats counts objects");
+
+    Hash *dump = Class_census_dump();
+    Hash *entry = (Hash*)Hash_Fetch(dump, class_name);
+    Integer *live = entry ? (Integer*)Hash_Fetch_Utf8(entry, "live", 4) : NULL;
+    TEST_TRUE(runner, live && Int_Get_Value(live) == 2,
+              "census_dump reports live objects");
+    DECREF(dump);
+
+    DECREF(objs[1]);
+    DECREF(objs[2]);
+    Class_get_stats(subclass, &stats);
+    TEST_TRUE(runner, stats.num_live == 0 && stats.live_bytes == 0,
+              "get_stats after destroying all objects");
+
+    Class_census_suspend();
+    Obj *uncounted = Class_Make_Obj(subclass);
+    Class_census_resume();
+    Class_get_stats(subclass, &stats);
+    TEST_TRUE(runner, stats.num_allocated == 3,
+              "objects aren't counted while census is suspended");
+    DECREF(uncounted);
+    Class_get_stats(subclass, &stats);
+    TEST_TRUE(runner, stats.num_live == 0 && stats.live_bytes == 0,
+              "live counts are clamped at zero");
+
+    // Class names live as long as the process and aren't counted.
+    ClassStats strings_before, strings_after;
+    Class_get_stats(STRING, &strings_before);
+    Class_singleton(SSTR_WRAP_C("Clownfish::Test::MyUncountedObj"), OBJ);
+    Class_get_stats(STRING, &strings_after);
+    TEST_TRUE(runner, strings_after.num_live == strings_before.num_live,
+              "class names aren't counted");
+
+    // Buffers owned by objects are included in the byte count.
+    ClassStats before, after;
+    Class_get_stats(VECTOR, &before);
+    Vector *vec = Vec_new(10);
+    Vec_Grow(vec, 100);
+    Class_get_stats(VECTOR, &after);
+    int64_t expected = (int64_t)Class_Get_Obj_Alloc_Size(VECTOR)
+                       + 100 * (int64_t)sizeof(Obj*);
+    TEST_TRUE(runner, after.live_bytes - before.live_bytes == expected,
+              "get_stats counts owned buffers");
+    DECREF(vec);
+    Class_get_stats(VECTOR, &after);
+    TEST_TRUE(runner, after.live_bytes == before.live_bytes,
+              "owned buffers are released");
+}
+
+static void
+S_census_task(void *context) {
+    DECREF(Class_Make_Obj((Class*)context));
+}
+
+static void
+test_census_threads(TestBatchRunner *runner) {
+    String *class_name = SSTR_WRAP_C("Clownfish::Test::MyCensusThreadObj");
+    Class *subclass = Class_singleton(class_name, OBJ);
+    ClassStats stats;
+
+    // Destroying the pool joins the workers, so their counts are merged
+    // when they exit.
+    ThreadPool *pool  = ThreadPool_new(4);
+    TaskGroup  *group = TaskGroup_new(pool, true);
+    for (int i = 0; i < 100; i++) {
+        TaskGroup_Run(group, S_census_task, subclass);
+    }
+    TaskGroup_Join(group);
+    DECREF(group);
+    DECREF(pool);
+
+    Class_get_stats(subclass, &stats);
+    TEST_TRUE(runner,
+              stats.num_allocated == 100
+              && stats.num_freed == 100
+              && stats.num_live == 0,
+              "get_stats includes counts of exited threads");
+}
+
+// The batch bootstraps the Clownfish parcel again, which rewrites the
+// Class objects in place, and enables the heap census.
+bool
+TestClass_Is_Thread_Safe_IMP(TestClass *self) {
+    UNUSED_VAR(self);
+    return false;
+}
+
 void
 TestClass_Run_IMP(TestClass *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 12);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 36);
     test_bootstrap_idempotence(runner);
     test_simple_subclass(runner);
+    test_singleton_cache(runner);
+    test_is_a(runner);
     test_add_alias_to_registry(runner);
     test_Get_Methods(runner);
+    test_Get_Name(runner);
+    test_census(runner);
+    test_census_threads(runner);
 }
 
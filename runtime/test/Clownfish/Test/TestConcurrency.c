@@ -0,0 +1,251 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#define CFISH_USE_SHORT_NAMES
+#define TESTCFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Test/TestConcurrency.h"
+
+#include "Clownfish/CharBuf.h"
+#include "Clownfish/Class.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/Hash.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Vector.h"
+#include "Clownfish/Test.h"
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Clownfish/TestHarness/TestUtils.h"
+#include "Clownfish/Util/Json.h"
+
+#define NUM_THREADS         8
+#define NUM_ITERS           500
+#define NUM_SHARED_CLASSES  16
+#define NUM_PRIVATE_CLASSES 4
+
+typedef struct {
+    uint32_t  id;
+    uint32_t  bad_objects;
+    uint32_t  bad_traps;
+    uint32_t  bad_errors;
+    uint32_t  bad_classes;
+    Class    *shared[NUM_SHARED_CLASSES];
+} ThreadState;
+
+typedef struct {
+    uint32_t id;
+    uint32_t iter;
+} ThrowContext;
+
+TestConcurrency*
+TestConcurrency_new() {
+    return (TestConcurrency*)Class_Make_Obj(TESTCONCURRENCY);
+}
+
+// Build and check a small object graph which only this thread sees.
+static bool
+S_check_objects(uint32_t id, uint32_t iter) {
+    Hash   *hash = Hash_new(0);
+    Vector *vec  = Vec_new(0);
+    for (uint32_t i = 0; i < 16; i++) {
+        String *key = Str_newf("t%u32-i%u32-k%u32", id, iter, i);
+        Hash_Store(hash, key, (Obj*)Int_new(i));
+        Vec_Push(vec, (Obj*)key);
+    }
+
+    bool ok = Hash_Get_Size(hash) == 16;
+    for (uint32_t i = 0; i < 16; i++) {
+        String  *key   = (String*)Vec_Fetch(vec, i);
+        Integer *value = (Integer*)Hash_Fetch(hash, key);
+        if (!value || Int_Get_Value(value) != (int64_t)i) {
+            ok = false;
+        }
+    }
+
+    if (iter % 16 == 0) {
+        String *json = Json_encode((Obj*)hash);
+        Obj *dump = Json_decode(json);
+        if (!Hash_Equals(hash, dump)) {
+            ok = false;
+        }
+        DECREF(dump);
+        DECREF(json);
+    }
+
+    DECREF(vec);
+    DECREF(hash);
+    return ok;
+}
+
+static void
+S_throw(void *context) {
+    ThrowContext *args = (ThrowContext*)context;
+    THROW(ERR, "thread %u32 iter %u32", args->id, args->iter);
+}
+
+// Throw and trap an error.  The message must be the one thrown by this
+// thread.
+static bool
+S_check_trap(uint32_t id, uint32_t iter) {
+    ThrowContext args;
+    args.id   = id;
+    args.iter = iter;
+    Err *err = Err_trap(S_throw, &args);
+    if (!err) {
+        return false;
+    }
+
+    String *expected = Str_newf("thread %u32 iter %u32", id, iter);
+    bool ok = Str_Starts_With(Err_Get_Mess(err), expected);
+    DECREF(expected);
+    DECREF(err);
+    return ok;
+}
+
+// The global error is per thread.
+static bool
+S_check_error(uint32_t id, uint32_t iter) {
+    String *expected = Str_newf("error %u32 %u32", id, iter);
+    Err_set_error(Err_new(Str_Clone(expected)));
+    TestUtils_thread_yield();
+    Err *err = Err_get_error();
+    bool ok = err && Str_Equals(Err_Get_Mess(err), (Obj*)expected);
+    DECREF(expected);
+    return ok;
+}
+
+// Create subclasses concurrently.  Shared names are registered by all
+// threads at once, so only one Class may win for every name.  Private
+// classes inherit from the shared ones.
+static bool
+S_check_classes(ThreadState *state, uint32_t iter) {
+    bool ok = true;
+
+    uint32_t tick = iter % NUM_SHARED_CLASSES;
+    String *name = Str_newf("Clownfish::Test::Concurrent::Shared%u32", tick);
+    Class *klass = Class_singleton(name, OBJ);
+    if (state->shared[tick] == NULL) {
+        state->shared[tick] = klass;
+    }
+    if (klass != state->shared[tick]
+        || Class_fetch_class(name) != klass
+        || Class_Get_Parent(klass) != OBJ
+       ) {
+        ok = false;
+    }
+    DECREF(name);
+
+    uint32_t num    = iter % NUM_PRIVATE_CLASSES;
+    Class   *parent = state->shared[num];
+    name = Str_newf("Clownfish::Test::Concurrent::Thread%u32::Class%u32",
+                    state->id, num);
+    klass = Class_singleton(name, parent);
+    if (!Str_Equals(Class_Get_Name(klass), (Obj*)name)
+        || Class_Get_Parent(klass) != parent
+       ) {
+        ok = false;
+    }
+    Obj *obj = Class_Make_Obj(klass);
+    if (!Obj_is_a(obj, klass) || !Obj_is_a(obj, parent)
+        || !Obj_is_a(obj, OBJ) || Obj_is_a(obj, ERR)
+       ) {
+        ok = false;
+    }
+    DECREF(obj);
+    DECREF(name);
+
+    return ok;
+}
+
+static void
+S_stress(void *arg) {
+    ThreadState *state = (ThreadState*)arg;
+    uint32_t     id    = state->id;
+
+    for (uint32_t iter = 0; iter < NUM_ITERS; iter++) {
+        if (!S_check_objects(id, iter)) {
+            state->bad_objects += 1;
+        }
+        if (!S_check_trap(id, iter)) {
+            state->bad_traps += 1;
+        }
+        if (!S_check_error(id, iter)) {
+            state->bad_errors += 1;
+        }
+        if (!S_check_classes(state, iter)) {
+            state->bad_classes += 1;
+        }
+    }
+
+    Err_set_error(NULL);
+}
+
+static void
+test_stress(TestBatchRunner *runner) {
+    if (!TestUtils_has_threads) {
+        SKIP(runner, 5, "no thread support");
+        return;
+    }
+
+    ThreadState  states[NUM_THREADS];
+    Thread      *threads[NUM_THREADS];
+    void        *runtimes[NUM_THREADS];
+
+    memset(states, 0, sizeof(states));
+    for (uint32_t i = 0; i < NUM_THREADS; i++) {
+        states[i].id = i;
+        runtimes[i]  = TestUtils_clone_host_runtime();
+        threads[i]   = TestUtils_thread_create(S_stress, &states[i],
+                                               runtimes[i]);
+    }
+    for (uint32_t i = 0; i < NUM_THREADS; i++) {
+        TestUtils_thread_join(threads[i]);
+        TestUtils_destroy_host_runtime(runtimes[i]);
+    }
+
+    uint32_t bad_objects = 0;
+    uint32_t bad_traps   = 0;
+    uint32_t bad_errors  = 0;
+    uint32_t bad_classes = 0;
+    uint32_t bad_shared  = 0;
+    for (uint32_t i = 0; i < NUM_THREADS; i++) {
+        bad_objects += states[i].bad_objects;
+        bad_traps   += states[i].bad_traps;
+        bad_errors  += states[i].bad_errors;
+        bad_classes += states[i].bad_classes;
+        for (uint32_t j = 0; j < NUM_SHARED_CLASSES; j++) {
+            if (states[i].shared[j] != states[0].shared[j]) {
+                bad_shared += 1;
+            }
+        }
+    }
+
+    TEST_UINT_EQ(runner, bad_objects, 0, "objects in threads");
+    TEST_UINT_EQ(runner, bad_traps, 0, "trapped errors are per thread");
+    TEST_UINT_EQ(runner, bad_errors, 0, "global error is per thread");
+    TEST_UINT_EQ(runner, bad_classes, 0, "subclasses created in threads");
+    TEST_UINT_EQ(runner, bad_shared, 0,
+                 "concurrent Class_singleton returns one class per name");
+}
+
+void
+TestConcurrency_Run_IMP(TestConcurrency *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 5);
+    test_stress(runner);
+}
+
@@ -82,6 +82,36 @@ test_Add_Frame(TestBatchRunner *runner) {
                   "Add_Frame without func");
         DECREF(error);
     }
+
+    {
+        Err *error = Err_new(Str_newf("alpha"));
+        Err_Add_Frame(error, "a.c", 1, "fa");
+        String *mess = Err_Get_Mess(error);
+        const char *expected = "alpha\n\tfa at a.c line 1\n";
+        TEST_TRUE(runner, Str_Equals_Utf8(mess, expected, strlen(expected)),
+                  "Get_Mess after one frame");
+        for (int i = 2; i <= 5; i++) {
+            Err_Add_Frame(error, "b.c", i, "fb");
+        }
+        mess = Err_Get_Mess(error);
+        expected = "alpha\n"
+                   "\tfa at a.c line 1\n"
+                   "\tfb at b.c line 2\n"
+                   "\tfb at b.c line 3\n"
+                   "\tfb at b.c line 4\n"
+                   "\tfb at b.c line 5\n";
+        TEST_TRUE(runner, Str_Equals_Utf8(mess, expected, strlen(expected)),
+                  "many frames");
+
+        Err_Cat_Mess(error, SSTR_WRAP_C("omega"));
+        Err_Add_Frame(error, "c.c", 6, NULL);
+        String *string = Err_To_String(error);
+        const char *tail = "\tfb at b.c line 5\nomega\n\tat c.c line 6\n";
+        TEST_TRUE(runner, Str_Ends_With_Utf8(string, tail, strlen(tail)),
+                  "Cat_Mess and Add_Frame after frames");
+        DECREF(string);
+        DECREF(error);
+    }
 }
 
 static void
@@ -180,7 +210,7 @@ test_threads(TestBatchRunner *runner) {
 
 void
 TestErr_Run_IMP(TestErr *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 15);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 18);
     test_To_String(runner);
     test_Cat_Mess(runner);
     test_Add_Frame(runner);
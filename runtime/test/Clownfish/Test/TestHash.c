@@ -15,6 +15,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #define CFISH_USE_SHORT_NAMES
@@ -31,6 +32,7 @@
 #include "Clownfish/TestHarness/TestUtils.h"
 #include "Clownfish/Vector.h"
 #include "Clownfish/Class.h"
+#include "Clownfish/Util/Memory.h"
 
 TestHash*
 TestHash_new() {
@@ -308,9 +310,120 @@ test_tombstone_identification(TestBatchRunner *runner) {
     DECREF(hash);
 }
 
+static void
+test_Fetch_Many(TestBatchRunner *runner) {
+    Hash    *hash      = Hash_new(0);
+    size_t   num_keys  = 250; // not a multiple of the group size
+    String **keys      = (String**)MALLOCATE(num_keys * sizeof(String*));
+    size_t  *hash_sums = (size_t*)MALLOCATE(num_keys * sizeof(size_t));
+    Obj    **values    = (Obj**)MALLOCATE(num_keys * sizeof(Obj*));
+
+    // Store the even keys, then delete every fourth to leave tombstones.
+    // Lookups use copies, so that keys must be compared by value.
+    for (size_t i = 0; i < num_keys; i++) {
+        String *key = Str_newf("%u64", (uint64_t)i);
+        if (i % 2 == 0) {
+            Hash_Store(hash, key, (Obj*)Str_newf("val-%u64", (uint64_t)i));
+        }
+        if (i % 4 == 0) {
+            DECREF(Hash_Delete(hash, key));
+        }
+        keys[i]      = Str_Clone(key);
+        hash_sums[i] = Str_Hash_Sum(key);
+        DECREF(key);
+    }
+
+    bool same = true;
+    Hash_Fetch_Many(hash, keys, num_keys, values);
+    for (size_t i = 0; i < num_keys; i++) {
+        if (values[i] != Hash_Fetch(hash, keys[i])) { same = false; }
+    }
+    TEST_TRUE(runner, same, "Fetch_Many agrees with Fetch");
+    TEST_TRUE(runner, values[0] == NULL && values[1] == NULL
+                      && values[2] != NULL,
+              "Fetch_Many returns NULL for missing and deleted keys");
+
+    same = true;
+    memset(values, 0, num_keys * sizeof(Obj*));
+    Hash_Fetch_Many_Hashed(hash, keys, hash_sums, num_keys, values);
+    for (size_t i = 0; i < num_keys; i++) {
+        if (values[i] != Hash_Fetch(hash, keys[i])) { same = false; }
+    }
+    TEST_TRUE(runner, same, "Fetch_Many_Hashed agrees with Fetch");
+
+    values[0] = (Obj*)hash;
+    Hash_Fetch_Many(hash, keys, 0, values);
+    TEST_TRUE(runner, values[0] == (Obj*)hash,
+              "Fetch_Many with no keys doesn't write values");
+
+    for (size_t i = 0; i < num_keys; i++) {
+        DECREF(keys[i]);
+    }
+    FREEMEM(keys);
+    FREEMEM(hash_sums);
+    FREEMEM(values);
+    DECREF(hash);
+}
+
+static void
+test_get_stats(TestBatchRunner *runner) {
+    Hash *hash = Hash_new(0);
+    String *missing = Str_newf("missing");
+    HashStats stats;
+
+    for (int32_t i = 0; i < 100; i++) {
+        String *key = Str_newf("%i32", i);
+        Hash_Store(hash, key, (Obj*)CFISH_TRUE);
+        DECREF(key);
+    }
+    for (int32_t i = 0; i < 100; i++) {
+        String *key = Str_newf("%i32", i);
+        Hash_Fetch(hash, key);
+        DECREF(key);
+    }
+    Hash_Fetch(hash, missing);
+    Hash_Delete_Utf8(hash, "0", 1);
+
+    bool enabled = Hash_get_stats(hash, &stats);
+    TEST_TRUE(runner, enabled == HashStats_enabled(),
+              "get_stats returns whether stats are compiled in");
+    if (enabled) {
+        TEST_TRUE(runner,
+                  HashStats_num_ops(&stats, HASHSTATS_HIT) == 101
+                  && HashStats_num_ops(&stats, HASHSTATS_MISS) == 101
+                  && HashStats_num_ops(&stats, HASHSTATS_INSERT) == 100
+                  && stats.max_probes >= 1
+                  && stats.max_chain >= 1,
+                  "get_stats counts probes");
+        TEST_TRUE(runner,
+                  stats.num_entries == 99
+                  && stats.capacity == Hash_Get_Capacity(hash)
+                  && stats.num_tombstones == 1
+                  && stats.num_resizes == 4,
+                  "get_stats reports load");
+    }
+    else {
+        TEST_TRUE(runner, HashStats_num_ops(&stats, HASHSTATS_HIT) == 0,
+                  "get_stats without stats counts no probes");
+        TEST_TRUE(runner, stats.num_entries == 0 && stats.num_resizes == 0,
+                  "get_stats without stats reports no load");
+    }
+
+    HashStats global;
+    bool global_enabled = HashStats_global(HASHSTATS_HASH, &global);
+    TEST_TRUE(runner,
+              global_enabled == enabled
+              && (!enabled
+                  || HashStats_num_ops(&global, HASHSTATS_HIT) >= 101),
+              "HashStats_global");
+
+    DECREF(missing);
+    DECREF(hash);
+}
+
 void
 TestHash_Run_IMP(TestHash *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 39);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 47);
     srand((unsigned int)time((time_t*)NULL));
     test_Equals(runner);
     test_Store_and_Fetch(runner);
@@ -320,6 +433,8 @@ TestHash_Run_IMP(TestHash *self, TestBatchRunner *runner) {
     test_store_skips_tombstone(runner);
     test_threshold_accounting(runner);
     test_tombstone_identification(runner);
+    test_Fetch_Many(runner);
+    test_get_stats(runner);
 }
 
 
@@ -0,0 +1,235 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define CFISH_USE_SHORT_NAMES
+#define TESTCFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Test/TestIntHash.h"
+
+#include "Clownfish/Err.h"
+#include "Clownfish/IntHash.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/NumVector.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Vector.h"
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Clownfish/Util/Memory.h"
+#include "Clownfish/Class.h"
+
+TestIntHash*
+TestIntHash_new() {
+    return (TestIntHash*)Class_Make_Obj(TESTINTHASH);
+}
+
+static void
+S_store_null(void *context) {
+    IntHash_Store((IntHash*)context, 1, NULL);
+}
+
+static void
+test_Store_and_Fetch(TestBatchRunner *runner) {
+    IntHash *hash = IntHash_new(0);
+    int64_t  keys[] = { 0, 1, -1, INT64_MAX, INT64_MIN };
+    size_t   num_keys = sizeof(keys) / sizeof(keys[0]);
+
+    for (size_t i = 0; i < num_keys; i++) {
+        IntHash_Store(hash, keys[i], (Obj*)Int_new(keys[i]));
+    }
+    TEST_UINT_EQ(runner, IntHash_Get_Size(hash), num_keys, "Store");
+
+    bool ok = true;
+    for (size_t i = 0; i < num_keys; i++) {
+        Integer *value = (Integer*)IntHash_Fetch(hash, keys[i]);
+        if (!value || Int_Get_Value(value) != keys[i]) { ok = false; }
+    }
+    TEST_TRUE(runner, ok, "Fetch extreme keys");
+    TEST_TRUE(runner, IntHash_Fetch(hash, 2) == NULL,
+              "Fetch missing key returns NULL");
+    TEST_TRUE(runner, IntHash_Has_Key(hash, INT64_MIN), "Has_Key");
+    TEST_FALSE(runner, IntHash_Has_Key(hash, 2), "Has_Key for missing key");
+
+    IntHash_Store(hash, -1, (Obj*)Str_newf("minus one"));
+    TEST_UINT_EQ(runner, IntHash_Get_Size(hash), num_keys,
+                 "Store to existing key doesn't change size");
+    TEST_TRUE(runner,
+              Str_Equals_Utf8((String*)IntHash_Fetch(hash, -1), "minus one",
+                              9),
+              "Store replaces value");
+
+    Err *error = Err_trap(S_store_null, hash);
+    TEST_TRUE(runner, error != NULL, "Storing NULL throws");
+    DECREF(error);
+
+    IntHash_Clear(hash);
+    TEST_UINT_EQ(runner, IntHash_Get_Size(hash), 0, "Clear");
+    TEST_TRUE(runner, IntHash_Fetch(hash, 0) == NULL, "Clear removes keys");
+
+    DECREF(hash);
+}
+
+static void
+test_Delete(TestBatchRunner *runner) {
+    // Multiples of a large power of two have few distinct low bits, which
+    // makes for long clusters of colliding keys.
+    IntHash *hash     = IntHash_new(0);
+    size_t   num_keys = 3000;
+    bool    *present  = (bool*)CALLOCATE(num_keys, sizeof(bool));
+
+    for (size_t i = 0; i < num_keys; i++) {
+        IntHash_Store(hash, (int64_t)i << 20, (Obj*)Int_new((int64_t)i));
+        present[i] = true;
+    }
+
+    Obj *deleted = IntHash_Delete(hash, INT64_C(7) << 20);
+    TEST_TRUE(runner, deleted && Int_Get_Value((Integer*)deleted) == 7,
+              "Delete returns the value");
+    DECREF(deleted);
+    present[7] = false;
+    TEST_TRUE(runner, IntHash_Delete(hash, INT64_C(7) << 20) == NULL,
+              "Delete missing key returns NULL");
+
+    // Delete pseudo-random keys, then store some of them again.
+    uint64_t state = 12345;
+    for (size_t round = 0; round < 2; round++) {
+        for (size_t i = 0; i < num_keys; i++) {
+            state = state * UINT64_C(6364136223846793005)
+                    + UINT64_C(1442695040888963407);
+            size_t tick = (size_t)(state >> 33) % num_keys;
+            int64_t key = (int64_t)tick << 20;
+            if (round == 0 && present[tick]) {
+                DECREF(IntHash_Delete(hash, key));
+                present[tick] = false;
+            }
+            else if (round == 1 && !present[tick]) {
+                IntHash_Store(hash, key, (Obj*)Int_new((int64_t)tick));
+                present[tick] = true;
+            }
+        }
+    }
+
+    size_t num_present = 0;
+    bool   ok          = true;
+    for (size_t i = 0; i < num_keys; i++) {
+        Integer *value = (Integer*)IntHash_Fetch(hash, (int64_t)i << 20);
+        if (present[i]) {
+            num_present++;
+            if (!value || Int_Get_Value(value) != (int64_t)i) { ok = false; }
+        }
+        else if (value) {
+            ok = false;
+        }
+    }
+    TEST_TRUE(runner, ok, "All keys found after deletions");
+    TEST_UINT_EQ(runner, IntHash_Get_Size(hash), num_present,
+                 "Size after deletions");
+
+    FREEMEM(present);
+    DECREF(hash);
+}
+
+static void
+test_Keys_Values_Equals(TestBatchRunner *runner) {
+    IntHash *hash  = IntHash_new(0);
+    IntHash *other = IntHash_new(100);
+
+    for (int64_t i = 0; i < 100; i++) {
+        IntHash_Store(hash, -i, (Obj*)Int_new(i));
+        IntHash_Store(other, -(99 - i), (Obj*)Int_new(99 - i));
+    }
+
+    I64Vector *keys   = IntHash_Keys(hash);
+    Vector    *values = IntHash_Values(hash);
+    int64_t    key_sum   = 0;
+    int64_t    value_sum = 0;
+    for (size_t i = 0; i < I64Vec_Get_Size(keys); i++) {
+        key_sum += I64Vec_Fetch(keys, i);
+    }
+    for (size_t i = 0; i < Vec_Get_Size(values); i++) {
+        value_sum += Int_Get_Value((Integer*)Vec_Fetch(values, i));
+    }
+    TEST_UINT_EQ(runner, I64Vec_Get_Size(keys), 100, "Keys");
+    TEST_TRUE(runner, key_sum == -4950 && value_sum == 4950,
+              "Keys and Values");
+
+    TEST_TRUE(runner, IntHash_Equals(hash, (Obj*)other), "Equals");
+    IntHash_Store(other, -5, (Obj*)Int_new(6));
+    TEST_FALSE(runner, IntHash_Equals(hash, (Obj*)other),
+               "Equals compares values");
+
+    DECREF(keys);
+    DECREF(values);
+    DECREF(other);
+    DECREF(hash);
+}
+
+static void
+S_invoke_Next(void *context) {
+    IntHashIter_Next((IntHashIterator*)context);
+}
+
+static void
+S_invoke_Get_Key(void *context) {
+    IntHashIter_Get_Key((IntHashIterator*)context);
+}
+
+static void
+test_iterator(TestBatchRunner *runner) {
+    IntHash *hash = IntHash_new(0);
+    for (int64_t i = 1; i <= 500; i++) {
+        IntHash_Store(hash, i, (Obj*)Int_new(i * 2));
+    }
+
+    IntHashIterator *iter = IntHashIter_new(hash);
+    Err *error = Err_trap(S_invoke_Get_Key, iter);
+    TEST_TRUE(runner, error != NULL, "Get_Key before Next throws");
+    DECREF(error);
+
+    size_t  count = 0;
+    int64_t sum   = 0;
+    bool    ok    = true;
+    while (IntHashIter_Next(iter)) {
+        int64_t  key   = IntHashIter_Get_Key(iter);
+        Integer *value = (Integer*)IntHashIter_Get_Value(iter);
+        if (Int_Get_Value(value) != key * 2) { ok = false; }
+        // Replacing values is allowed.
+        IntHash_Store(hash, key, (Obj*)Int_new(key));
+        sum += key;
+        count++;
+    }
+    TEST_TRUE(runner, ok && count == 500 && sum == 125250,
+              "Iterate over all pairs");
+    TEST_FALSE(runner, IntHashIter_Next(iter), "Iterator stays exhausted");
+    DECREF(iter);
+
+    iter = IntHashIter_new(hash);
+    IntHashIter_Next(iter);
+    DECREF(IntHash_Delete(hash, IntHashIter_Get_Key(iter)));
+    error = Err_trap(S_invoke_Next, iter);
+    TEST_TRUE(runner, error != NULL, "Deleting during iteration throws");
+    DECREF(error);
+    DECREF(iter);
+
+    DECREF(hash);
+}
+
+void
+TestIntHash_Run_IMP(TestIntHash *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 22);
+    test_Store_and_Fetch(runner);
+    test_Delete(runner);
+    test_Keys_Values_Equals(runner);
+    test_iterator(runner);
+}
@@ -76,6 +76,42 @@ test_all(TestBatchRunner *runner) {
     LFReg_destroy(registry);
 }
 
+static void
+test_get_stats(TestBatchRunner *runner) {
+    LockFreeRegistry *registry = LFReg_new(1);
+    String *foo = Str_newf("foo");
+    String *bar = Str_newf("bar");
+    String *baz = Str_newf("baz");
+    HashStats stats;
+
+    LFReg_register(registry, foo, (Obj*)foo);
+    LFReg_register(registry, bar, (Obj*)bar);
+    LFReg_register(registry, foo, (Obj*)foo);
+    LFReg_fetch(registry, bar);
+    LFReg_fetch(registry, baz);
+
+    if (LFReg_get_stats(registry, &stats)) {
+        TEST_TRUE(runner,
+                  HashStats_num_ops(&stats, HASHSTATS_HIT) == 2
+                  && HashStats_num_ops(&stats, HASHSTATS_MISS) == 1
+                  && HashStats_num_ops(&stats, HASHSTATS_INSERT) == 2
+                  && stats.probes[HASHSTATS_MISS][2] == 1
+                  && stats.num_entries == 2
+                  && stats.max_chain == 2
+                  && stats.capacity == 1,
+                  "get_stats");
+    }
+    else {
+        TEST_TRUE(runner, !HashStats_enabled() && stats.num_entries == 0,
+                  "get_stats without stats");
+    }
+
+    DECREF(baz);
+    DECREF(bar);
+    DECREF(foo);
+    LFReg_destroy(registry);
+}
+
 static void
 S_register_many(void *varg) {
     ThreadArgs *args = (ThreadArgs*)varg;
@@ -160,8 +196,9 @@ test_threads(TestBatchRunner *runner) {
 
 void
 TestLFReg_Run_IMP(TestLockFreeRegistry *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 7);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 8);
     test_all(runner);
+    test_get_stats(runner);
     test_threads(runner);
 }
 
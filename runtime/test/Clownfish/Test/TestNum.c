@@ -266,13 +266,62 @@ test_Clone(TestBatchRunner *runner) {
     DECREF(f64);
 }
 
+static void
+test_cache(TestBatchRunner *runner) {
+#if CFISH_INT_CACHE_MAX >= CFISH_INT_CACHE_MIN
+    Integer *zero  = Int_new(0);
+    Integer *zero2 = Int_new(0);
+    TEST_TRUE(runner, zero == zero2, "Small Integers are shared");
+    TEST_TRUE(runner, Int_is_cached((Obj*)zero), "is_cached");
+    DECREF(zero);
+    DECREF(zero2);
+    Integer *zero3 = Int_new(0);
+    TEST_TRUE(runner,
+              Int_is_cached((Obj*)zero3) && Int_Get_Value(zero3) == 0,
+              "Cached Integer survives the release of all references");
+    DECREF(zero3);
+
+    Integer *min  = Int_new(CFISH_INT_CACHE_MIN);
+    Integer *min2 = Int_new(CFISH_INT_CACHE_MIN);
+    Integer *max  = Int_new(CFISH_INT_CACHE_MAX);
+    Integer *max2 = Int_new(CFISH_INT_CACHE_MAX);
+    TEST_TRUE(runner, min == min2 && max == max2,
+              "Cache covers both ends of its range");
+    DECREF(min);
+    DECREF(min2);
+    DECREF(max);
+    DECREF(max2);
+#else
+    SKIP(runner, 4, "Integer cache disabled");
+#endif
+
+    Integer *big  = Int_new((int64_t)CFISH_INT_CACHE_MAX + 1);
+    Integer *big2 = Int_new((int64_t)CFISH_INT_CACHE_MAX + 1);
+    TEST_TRUE(runner, big != big2, "Large Integers aren't shared");
+    TEST_FALSE(runner, Int_is_cached((Obj*)big), "!is_cached");
+    TEST_TRUE(runner, Int_Equals(big, (Obj*)big2), "Equals");
+    DECREF(big);
+    DECREF(big2);
+
+    // Integers created with init aren't cached even if their value is.
+    Integer *fresh = Int_init((Integer*)Class_Make_Obj(INTEGER), 1);
+    Integer *one   = Int_new(1);
+    TEST_FALSE(runner, Int_is_cached((Obj*)fresh),
+               "Integer created with init isn't cached");
+    TEST_TRUE(runner, Int_Equals(fresh, (Obj*)one),
+              "Cached and uncached Integers compare equal");
+    DECREF(one);
+    DECREF(fresh);
+}
+
 void
 TestNum_Run_IMP(TestNum *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 82);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 91);
     test_To_String(runner);
     test_accessors(runner);
     test_Equals_and_Compare_To(runner);
     test_Clone(runner);
+    test_cache(runner);
 }
 
 
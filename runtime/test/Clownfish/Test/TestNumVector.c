@@ -0,0 +1,254 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define CFISH_USE_SHORT_NAMES
+#define TESTCFISH_USE_SHORT_NAMES
+
+#include <math.h>
+
+#include "charmony.h"
+
+#include "Clownfish/Test/TestNumVector.h"
+
+#include "Clownfish/Err.h"
+#include "Clownfish/NumVector.h"
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Clownfish/Util/ThreadPool.h"
+#include "Clownfish/Class.h"
+
+TestNumVector*
+TestNumVec_new() {
+    return (TestNumVector*)Class_Make_Obj(TESTNUMVECTOR);
+}
+
+static void
+test_Push_Fetch_Store(TestBatchRunner *runner) {
+    I64Vector *vec = I64Vec_new(0);
+
+    for (int64_t i = 0; i < 100; i++) {
+        I64Vec_Push(vec, i * INT64_C(1000000000));
+    }
+    TEST_UINT_EQ(runner, I64Vec_Get_Size(vec), 100, "Push grows size");
+    TEST_TRUE(runner, I64Vec_Fetch(vec, 99) == INT64_C(99000000000),
+              "Fetch");
+
+    I64Vec_Store(vec, 109, -1);
+    TEST_UINT_EQ(runner, I64Vec_Get_Size(vec), 110, "Store past end grows");
+    TEST_TRUE(runner, I64Vec_Fetch(vec, 105) == 0, "Store zero-fills gap");
+    TEST_TRUE(runner, I64Vec_Fetch(vec, 109) == -1, "Store");
+
+    I64Vec_Resize(vec, 10);
+    TEST_UINT_EQ(runner, I64Vec_Get_Size(vec), 10, "Resize smaller");
+    I64Vec_Resize(vec, 20);
+    TEST_TRUE(runner, I64Vec_Fetch(vec, 15) == 0, "Resize zero-fills");
+
+    I64Vec_Clear(vec);
+    TEST_UINT_EQ(runner, I64Vec_Get_Size(vec), 0, "Clear");
+
+    DECREF(vec);
+}
+
+static void
+S_fetch_out_of_bounds(void *context) {
+    I32Vec_Fetch((I32Vector*)context, 3);
+}
+
+static void
+test_Fetch_out_of_bounds(TestBatchRunner *runner) {
+    I32Vector *vec = I32Vec_new(3);
+    I32Vec_Resize(vec, 3);
+    Err *error = Err_trap(S_fetch_out_of_bounds, vec);
+    TEST_TRUE(runner, error != NULL, "Fetch out of bounds throws");
+    DECREF(error);
+    DECREF(vec);
+}
+
+static void
+test_new_from_array_and_Slice(TestBatchRunner *runner) {
+    int32_t values[] = { 5, 4, 3, 2, 1 };
+    I32Vector *vec = I32Vec_new_from_array(values, 5);
+    TEST_UINT_EQ(runner, I32Vec_Get_Size(vec), 5, "new_from_array size");
+    TEST_INT_EQ(runner, I32Vec_Fetch(vec, 1), 4, "new_from_array copies");
+
+    I32Vector *slice = I32Vec_Slice(vec, 3, 10);
+    TEST_UINT_EQ(runner, I32Vec_Get_Size(slice), 2, "Slice truncates");
+    TEST_INT_EQ(runner, I32Vec_Fetch(slice, 0), 2, "Slice offset");
+    DECREF(slice);
+
+    slice = I32Vec_Slice(vec, 5, 1);
+    TEST_UINT_EQ(runner, I32Vec_Get_Size(slice), 0, "Slice out of bounds");
+    DECREF(slice);
+
+    I32Vector *clone = I32Vec_Clone(vec);
+    TEST_TRUE(runner, I32Vec_Equals(vec, (Obj*)clone), "Clone and Equals");
+    I32Vec_Store(clone, 0, 6);
+    TEST_FALSE(runner, I32Vec_Equals(vec, (Obj*)clone),
+               "Equals detects differing values");
+    DECREF(clone);
+
+    DECREF(vec);
+}
+
+static void
+test_Sort(TestBatchRunner *runner) {
+    int64_t i64_values[] = { 3, INT64_MIN, -7, INT64_MAX, 0, 3 };
+    int64_t i64_wanted[] = { INT64_MIN, -7, 0, 3, 3, INT64_MAX };
+    I64Vector *i64_vec    = I64Vec_new_from_array(i64_values, 6);
+    I64Vector *i64_sorted = I64Vec_new_from_array(i64_wanted, 6);
+    I64Vec_Sort(i64_vec);
+    TEST_TRUE(runner, I64Vec_Equals(i64_vec, (Obj*)i64_sorted),
+              "Sort I64Vector");
+    DECREF(i64_vec);
+    DECREF(i64_sorted);
+
+    double f64_values[] = { 2.5, NAN, -1.0, HUGE_VAL, -HUGE_VAL, 0.0 };
+    F64Vector *f64_vec = F64Vec_new_from_array(f64_values, 6);
+    F64Vec_Sort(f64_vec);
+    TEST_TRUE(runner, F64Vec_Fetch(f64_vec, 0) == -HUGE_VAL
+                      && F64Vec_Fetch(f64_vec, 1) == -1.0
+                      && F64Vec_Fetch(f64_vec, 4) == HUGE_VAL,
+              "Sort F64Vector");
+    double last = F64Vec_Fetch(f64_vec, 5);
+    TEST_TRUE(runner, last != last, "Sort F64Vector puts NaN last");
+    DECREF(f64_vec);
+
+    // Long enough to take the radix sort path.
+    I32Vector *i32_vec = I32Vec_new(1000);
+    for (int32_t i = 0; i < 1000; i++) {
+        I32Vec_Push(i32_vec, (i * 7919) % 1009 - 500);
+    }
+    I32Vec_Sort(i32_vec);
+    bool sorted = true;
+    for (size_t i = 1; i < 1000; i++) {
+        if (I32Vec_Fetch(i32_vec, i - 1) > I32Vec_Fetch(i32_vec, i)) {
+            sorted = false;
+        }
+    }
+    TEST_TRUE(runner, sorted, "Sort long I32Vector");
+    DECREF(i32_vec);
+}
+
+// Both sort paths must produce the same total order: negative zero before
+// positive zero, NaNs of either sign last.
+static void
+S_test_F64_total_order(TestBatchRunner *runner, size_t size) {
+    static const double values[] = { 0.0, -0.0, NAN, -1.5, -NAN, 2.0 };
+    const size_t num_values = sizeof(values) / sizeof(values[0]);
+    F64Vector *vec = F64Vec_new(size);
+    for (size_t i = 0; i < size; i++) {
+        F64Vec_Push(vec, values[i % num_values]);
+    }
+    F64Vec_Sort(vec);
+
+    size_t num_nans = (size / num_values) * 2
+                      + (size % num_values > 2)
+                      + (size % num_values > 4);
+    size_t num_numbers = size - num_nans;
+    bool ordered = true;
+    for (size_t i = 1; i < num_numbers; i++) {
+        double prev = F64Vec_Fetch(vec, i - 1);
+        double cur  = F64Vec_Fetch(vec, i);
+        if (prev > cur || (prev == cur && signbit(prev) < signbit(cur))) {
+            ordered = false;
+        }
+    }
+    TEST_TRUE(runner, ordered, "Sort %u doubles puts -0.0 before 0.0",
+              (unsigned)size);
+
+    bool nans_last = true;
+    for (size_t i = 0; i < size; i++) {
+        double value = F64Vec_Fetch(vec, i);
+        if ((value != value) != (i >= num_numbers)) { nans_last = false; }
+    }
+    TEST_TRUE(runner, nans_last, "Sort %u doubles puts NaNs last",
+              (unsigned)size);
+
+    DECREF(vec);
+}
+
+static void
+test_Sort_F64_total_order(TestBatchRunner *runner) {
+    // Below and above the radix sort threshold.
+    S_test_F64_total_order(runner, 12);
+    S_test_F64_total_order(runner, 1000);
+}
+
+static void
+test_F64_Equals(TestBatchRunner *runner) {
+    double values[] = { 1.0, NAN, 0.0 };
+    F64Vector *vec   = F64Vec_new_from_array(values, 3);
+    F64Vector *clone = F64Vec_Clone(vec);
+    TEST_TRUE(runner, F64Vec_Equals(vec, (Obj*)clone),
+              "F64Vector with NaN Equals its clone");
+    F64Vec_Store(clone, 2, -0.0);
+    TEST_FALSE(runner, F64Vec_Equals(vec, (Obj*)clone),
+               "Equals tells -0.0 from 0.0");
+    DECREF(clone);
+    DECREF(vec);
+}
+
+static void
+test_Sort_Parallel(TestBatchRunner *runner) {
+    // Large enough for the radix sort to run in parallel.
+    const size_t size = 100000;
+    ThreadPool *pool = ThreadPool_new(3);
+    I32Vector *i32_serial = I32Vec_new(size);
+    I64Vector *i64_serial = I64Vec_new(size);
+    F64Vector *f64_serial = F64Vec_new(size);
+    for (size_t i = 0; i < size; i++) {
+        int64_t value = (int64_t)((i * 7919) % 50021) - 25000;
+        I32Vec_Push(i32_serial, (int32_t)value);
+        I64Vec_Push(i64_serial, value * INT64_C(1000000007));
+        F64Vec_Push(f64_serial, value == 0 ? -0.0 : value / 7.0);
+    }
+    I32Vector *i32_parallel = I32Vec_Clone(i32_serial);
+    I64Vector *i64_parallel = I64Vec_Clone(i64_serial);
+    F64Vector *f64_parallel = F64Vec_Clone(f64_serial);
+
+    I32Vec_Sort(i32_serial);
+    I32Vec_Sort_Parallel(i32_parallel, pool);
+    TEST_TRUE(runner, I32Vec_Equals(i32_parallel, (Obj*)i32_serial),
+              "Sort_Parallel I32Vector matches Sort");
+    I64Vec_Sort(i64_serial);
+    I64Vec_Sort_Parallel(i64_parallel, pool);
+    TEST_TRUE(runner, I64Vec_Equals(i64_parallel, (Obj*)i64_serial),
+              "Sort_Parallel I64Vector matches Sort");
+    F64Vec_Sort(f64_serial);
+    F64Vec_Sort_Parallel(f64_parallel, pool);
+    TEST_TRUE(runner, F64Vec_Equals(f64_parallel, (Obj*)f64_serial),
+              "Sort_Parallel F64Vector matches Sort");
+
+    DECREF(i32_serial);
+    DECREF(i64_serial);
+    DECREF(f64_serial);
+    DECREF(i32_parallel);
+    DECREF(i64_parallel);
+    DECREF(f64_parallel);
+    DECREF(pool);
+}
+
+void
+TestNumVec_Run_IMP(TestNumVector *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 29);
+    test_Push_Fetch_Store(runner);
+    test_Fetch_out_of_bounds(runner);
+    test_new_from_array_and_Slice(runner);
+    test_Sort(runner);
+    test_Sort_F64_total_order(runner);
+    test_F64_Equals(runner);
+    test_Sort_Parallel(runner);
+}
+
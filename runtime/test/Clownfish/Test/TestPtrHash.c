@@ -97,12 +97,44 @@ test_stress(TestBatchRunner *runner) {
     PtrHash_Destroy(hash);
 }
 
+static void
+test_Get_Stats(TestBatchRunner *runner) {
+    PtrHash *hash = PtrHash_new(0);
+    char dummy[101];
+    HashStats stats;
+
+    for (int i = 0; i < 100; i++) {
+        PtrHash_Store(hash, &dummy[i], &dummy[i]);
+    }
+    for (int i = 0; i < 100; i++) {
+        PtrHash_Fetch(hash, &dummy[i]);
+    }
+    PtrHash_Fetch(hash, &dummy[100]);
+
+    if (PtrHash_Get_Stats(hash, &stats)) {
+        TEST_TRUE(runner,
+                  HashStats_num_ops(&stats, HASHSTATS_HIT) == 100
+                  && HashStats_num_ops(&stats, HASHSTATS_MISS) == 1
+                  && HashStats_num_ops(&stats, HASHSTATS_INSERT) == 100
+                  && stats.num_entries == 100
+                  && stats.num_resizes > 0,
+                  "Get_Stats");
+    }
+    else {
+        TEST_TRUE(runner, !HashStats_enabled() && stats.num_entries == 0,
+                  "Get_Stats without stats");
+    }
+
+    PtrHash_Destroy(hash);
+}
+
 void
 TestPtrHash_Run_IMP(TestPtrHash *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 4);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 5);
     srand((unsigned int)time(NULL));
     test_Store_and_Fetch(runner);
     test_stress(runner);
+    test_Get_Stats(runner);
 }
 
 
@@ -16,6 +16,7 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 
 #define C_CFISH_VECTOR
 #define CFISH_USE_SHORT_NAMES
@@ -26,12 +27,14 @@
 #include "Clownfish/Test/TestVector.h"
 
 #include "Clownfish/String.h"
+#include "Clownfish/Blob.h"
 #include "Clownfish/Boolean.h"
 #include "Clownfish/Err.h"
 #include "Clownfish/Num.h"
 #include "Clownfish/Test.h"
 #include "Clownfish/TestHarness/TestBatchRunner.h"
 #include "Clownfish/TestHarness/TestUtils.h"
+#include "Clownfish/Util/ThreadPool.h"
 #include "Clownfish/Vector.h"
 #include "Clownfish/Class.h"
 
@@ -527,6 +530,144 @@ test_Sort(TestBatchRunner *runner) {
     DECREF(wanted);
 }
 
+// Check that `sorted` is in order and that elements which compare as equal
+// appear in the same order as in `orig`.
+static bool
+S_sorted_and_stable(Vector *sorted, Vector *orig) {
+    size_t size = Vec_Get_Size(sorted);
+    size_t prev_tick = 0;
+    for (size_t i = 0; i < size; i++) {
+        Obj *elem = Vec_Fetch(sorted, i);
+        size_t tick = 0;
+        while (Vec_Fetch(orig, tick) != elem) { tick++; }
+        if (i > 0) {
+            int32_t comparison
+                = Obj_Compare_To(Vec_Fetch(sorted, i - 1), elem);
+            if (comparison > 0)                         { return false; }
+            if (comparison == 0 && prev_tick > tick)    { return false; }
+        }
+        prev_tick = tick;
+    }
+    return true;
+}
+
+static void
+S_test_sort_stable(TestBatchRunner *runner, Vector *vec, const char *name) {
+    Vector *sorted = Vec_Clone(vec);
+    Vec_Sort(sorted);
+    TEST_TRUE(runner, S_sorted_and_stable(sorted, vec), "Sort %s is stable",
+              name);
+    DECREF(sorted);
+}
+
+static void
+test_Sort_homogeneous(TestBatchRunner *runner) {
+    Vector *strings       = Vec_new(200);
+    Vector *short_strings = Vec_new(20);
+    Vector *blobs         = Vec_new(200);
+    Vector *integers      = Vec_new(200);
+    Vector *floats        = Vec_new(200);
+
+    for (int i = 0; i < 200; i++) {
+        int value = (i * 7919) % 37 - 18;
+        String *string = Str_newf("%i32 with a long common suffix",
+                                  (int32_t)value);
+        Vec_Push(strings, (Obj*)string);
+        if (i < 20) {
+            Vec_Push(short_strings, INCREF(string));
+        }
+        Vec_Push(blobs, (Obj*)Blob_new(Str_Get_Ptr8(string),
+                                       Str_Get_Size(string) - i % 3));
+        Vec_Push(integers, (Obj*)Int_new(value));
+        Vec_Push(floats, (Obj*)Float_new(value / 4.0));
+    }
+    Vec_Store(integers, 0, (Obj*)Int_new(INT64_MIN));
+    Vec_Store(integers, 1, (Obj*)Int_new(INT64_MAX));
+    Vec_Store(floats, 0, (Obj*)Float_new(-0.0));
+    Vec_Store(floats, 1, (Obj*)Float_new(-HUGE_VAL));
+
+    S_test_sort_stable(runner, strings, "Strings");
+    S_test_sort_stable(runner, short_strings, "short Vector of Strings");
+    S_test_sort_stable(runner, blobs, "Blobs");
+    S_test_sort_stable(runner, integers, "Integers");
+    S_test_sort_stable(runner, floats, "Floats");
+
+    DECREF(strings);
+    DECREF(short_strings);
+    DECREF(blobs);
+    DECREF(integers);
+    DECREF(floats);
+}
+
+// Sort a large Vector with and without a pool.  Both sorts are stable, so
+// they must produce the same order of element pointers.
+static void
+S_test_sort_parallel(TestBatchRunner *runner, Vector *vec, ThreadPool *pool,
+                     const char *name) {
+    Vector *serial   = Vec_Clone(vec);
+    Vector *parallel = Vec_Clone(vec);
+    Vec_Sort(serial);
+    Vec_Sort_Parallel(parallel, pool);
+    bool same = true;
+    for (size_t i = 0, max = Vec_Get_Size(vec); i < max; i++) {
+        if (Vec_Fetch(serial, i) != Vec_Fetch(parallel, i)) { same = false; }
+    }
+    TEST_TRUE(runner, same, "Sort_Parallel %s", name);
+    DECREF(serial);
+    DECREF(parallel);
+}
+
+static void
+test_Sort_Parallel(TestBatchRunner *runner) {
+    // Large enough for the radix sort to run in parallel.
+    const size_t size = 100000;
+    ThreadPool *pool = ThreadPool_new(3);
+    Vector *integers = Vec_new(size);
+    Vector *strings  = Vec_new(size);
+    for (size_t i = 0; i < size; i++) {
+        int64_t value = (int64_t)((i * 7919) % 50021) - 25000;
+        Vec_Push(integers, (Obj*)Int_new(value));
+        Vec_Push(strings, (Obj*)Str_newf("key %i64", value / 3));
+    }
+
+    S_test_sort_parallel(runner, integers, pool, "Integers");
+    S_test_sort_parallel(runner, strings, pool, "Strings");
+
+    DECREF(integers);
+    DECREF(strings);
+    DECREF(pool);
+}
+
+static int
+S_reverse_compare(void *context, const void *va, const void *vb) {
+    Obj *a = *(Obj**)va;
+    Obj *b = *(Obj**)vb;
+    int *num_calls = (int*)context;
+    (*num_calls)++;
+    return -Obj_Compare_To(a, b);
+}
+
+static void
+test_Sort_By(TestBatchRunner *runner) {
+    Vector *vec = Vec_new(10);
+    int num_calls = 0;
+
+    for (int i = 0; i < 10; i++) {
+        Vec_Push(vec, (Obj*)Int_new(i));
+    }
+    Vec_Sort_By(vec, S_reverse_compare, &num_calls);
+
+    bool reversed = true;
+    for (int i = 0; i < 10; i++) {
+        int64_t value = Int_Get_Value((Integer*)Vec_Fetch(vec, (size_t)i));
+        if (value != 9 - i) { reversed = false; }
+    }
+    TEST_TRUE(runner, reversed, "Sort_By with custom compare");
+    TEST_TRUE(runner, num_calls > 0, "Sort_By passes context");
+
+    DECREF(vec);
+}
+
 static void
 test_Grow(TestBatchRunner *runner) {
     Vector *array = Vec_new(500);
@@ -553,7 +694,7 @@ test_Grow(TestBatchRunner *runner) {
 
 void
 TestVector_Run_IMP(TestVector *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 62);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 71);
     test_Equals(runner);
     test_Store_Fetch(runner);
     test_Push_Pop_Insert(runner);
@@ -566,6 +707,9 @@ TestVector_Run_IMP(TestVector *self, TestBatchRunner *runner) {
     test_Clone(runner);
     test_exceptions(runner);
     test_Sort(runner);
+    test_Sort_homogeneous(runner);
+    test_Sort_Parallel(runner);
+    test_Sort_By(runner);
     test_Grow(runner);
 }
 
@@ -56,10 +56,19 @@ test_cas_ptr(TestBatchRunner *runner) {
     TEST_TRUE(runner, target == bar_pointer, "cas_ptr sets target");
 }
 
+static void
+test_load_ptr(TestBatchRunner *runner) {
+    int   foo    = 1;
+    int  *target = &foo;
+
+    TEST_TRUE(runner, Atomic_load_ptr((void**)&target) == &foo, "load_ptr");
+}
+
 void
 TestAtomic_Run_IMP(TestAtomic *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 6);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 7);
     test_cas_ptr(runner);
+    test_load_ptr(runner);
 }
 
 
@@ -0,0 +1,260 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define CFISH_USE_SHORT_NAMES
+#define TESTCFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Test/Util/TestChannel.h"
+
+#include "Clownfish/Num.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Test.h"
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Clownfish/TestHarness/TestUtils.h"
+#include "Clownfish/Util/Channel.h"
+#include "Clownfish/Class.h"
+
+#define NUM_PRODUCERS 3
+#define NUM_CONSUMERS 3
+#define NUM_PER_PRODUCER 10000
+
+TestChannel*
+TestChannel_new() {
+    return (TestChannel*)Class_Make_Obj(TESTCHANNEL);
+}
+
+static void
+test_capacity(TestBatchRunner *runner) {
+    Channel *chan = Chan_new(5);
+    TEST_UINT_EQ(runner, Chan_Get_Capacity(chan), 8,
+                 "capacity is rounded up to a power of two");
+    DECREF(chan);
+
+    chan = Chan_new(0);
+    TEST_UINT_EQ(runner, Chan_Get_Capacity(chan), 2, "minimum capacity");
+    DECREF(chan);
+}
+
+static void
+test_Try_Push_and_Try_Pop(TestBatchRunner *runner) {
+    Channel *chan = Chan_new(4);
+    bool success = true;
+
+    // Go around the ring buffer a few times.
+    for (int64_t lap = 0; lap < 3; lap++) {
+        for (int64_t i = 0; i < 4; i++) {
+            if (!Chan_Try_Push(chan, (Obj*)Int_new(lap * 4 + i))) {
+                success = false;
+            }
+        }
+        Integer *extra = Int_new(-1);
+        if (Chan_Try_Push(chan, (Obj*)extra)) { success = false; }
+        DECREF(extra);
+        if (Chan_Get_Size(chan) != 4) { success = false; }
+        for (int64_t i = 0; i < 4; i++) {
+            Integer *value = (Integer*)Chan_Try_Pop(chan);
+            if (!value || Int_Get_Value(value) != lap * 4 + i) {
+                success = false;
+            }
+            DECREF(value);
+        }
+    }
+    TEST_TRUE(runner, success, "Try_Push and Try_Pop are FIFO, fail when full");
+    TEST_TRUE(runner, Chan_Try_Pop(chan) == NULL, "Try_Pop on empty channel");
+    TEST_UINT_EQ(runner, Chan_Get_Size(chan), 0, "Get_Size of empty channel");
+
+    Integer *value = Int_new(42);
+    TEST_TRUE(runner, Chan_Push(chan, (Obj*)value), "Push");
+    Integer *popped = (Integer*)Chan_Pop(chan);
+    TEST_TRUE(runner, popped == value, "Pop transfers the same object");
+    TEST_INT_EQ(runner, CFISH_REFCOUNT_NN(popped), 1,
+                 "Push and Pop don't touch the refcount");
+    DECREF(popped);
+
+    DECREF(chan);
+}
+
+static void
+test_batches(TestBatchRunner *runner) {
+    Channel *chan = Chan_new(8);
+    Obj *elems[8];
+    bool success = true;
+
+    // Start in the middle of the ring buffer, so batches wrap around.
+    for (int64_t i = 0; i < 5; i++) {
+        Chan_Push(chan, (Obj*)Int_new(i));
+    }
+    for (int64_t i = 0; i < 5; i++) {
+        DECREF(Chan_Pop(chan));
+    }
+
+    for (int64_t i = 0; i < 8; i++) {
+        elems[i] = (Obj*)Int_new(i);
+    }
+    size_t pushed = Chan_Push_Batch(chan, elems, 8);
+    TEST_UINT_EQ(runner, pushed, 8, "Push_Batch");
+
+    size_t popped = Chan_Pop_Batch(chan, elems, 3);
+    popped += Chan_Pop_Batch(chan, elems + popped, 8);
+    TEST_UINT_EQ(runner, popped, 8, "Pop_Batch");
+    for (size_t i = 0; i < popped; i++) {
+        if (Int_Get_Value((Integer*)elems[i]) != (int64_t)i) {
+            success = false;
+        }
+        DECREF(elems[i]);
+    }
+    TEST_TRUE(runner, success, "batches keep order across wraparound");
+
+    DECREF(chan);
+}
+
+static void
+test_Close(TestBatchRunner *runner) {
+    Channel *chan = Chan_new(4);
+    Chan_Push(chan, (Obj*)Int_new(1));
+    Chan_Push(chan, (Obj*)Int_new(2));
+    Chan_Close(chan);
+    TEST_TRUE(runner, Chan_Is_Closed(chan), "Is_Closed");
+
+    String *string = Str_newf("rejected");
+    TEST_FALSE(runner, Chan_Try_Push(chan, (Obj*)string),
+               "Try_Push fails after Close");
+    TEST_FALSE(runner, Chan_Push(chan, INCREF(string)),
+               "Push fails after Close");
+    TEST_INT_EQ(runner, CFISH_REFCOUNT_NN(string), 1,
+                 "failed Push decrefs element");
+    DECREF(string);
+
+    Obj *elems[4];
+    size_t popped = Chan_Pop_Batch(chan, elems, 4);
+    TEST_UINT_EQ(runner, popped, 2, "Pop_Batch drains closed channel");
+    for (size_t i = 0; i < popped; i++) {
+        DECREF(elems[i]);
+    }
+    TEST_TRUE(runner, Chan_Pop(chan) == NULL,
+              "Pop returns NULL on closed, empty channel");
+    TEST_UINT_EQ(runner, Chan_Pop_Batch(chan, elems, 4), 0,
+                 "Pop_Batch returns 0 on closed, empty channel");
+
+    // Remaining elements are released by Destroy.
+    Channel *other = Chan_new(4);
+    Chan_Push(other, (Obj*)Str_newf("left over"));
+    DECREF(other);
+
+    DECREF(chan);
+}
+
+typedef struct {
+    Channel  *chan;
+    int64_t   offset;
+    int64_t   sum;
+    int64_t   count;
+} ChanWorker;
+
+static void
+S_produce(void *arg) {
+    ChanWorker *worker = (ChanWorker*)arg;
+    Obj *batch[16];
+    int64_t i = 0;
+    // Mix single and batch pushes.
+    while (i < NUM_PER_PRODUCER) {
+        if (i % 3 == 0 || NUM_PER_PRODUCER - i < 16) {
+            Chan_Push(worker->chan, (Obj*)Int_new(worker->offset + i));
+            i++;
+        }
+        else {
+            for (int j = 0; j < 16; j++) {
+                batch[j] = (Obj*)Int_new(worker->offset + i + j);
+            }
+            Chan_Push_Batch(worker->chan, batch, 16);
+            i += 16;
+        }
+    }
+}
+
+static void
+S_consume(void *arg) {
+    ChanWorker *worker = (ChanWorker*)arg;
+    Obj *batch[7];
+    while (true) {
+        size_t num = Chan_Pop_Batch(worker->chan, batch, 7);
+        if (num == 0) { break; }
+        for (size_t i = 0; i < num; i++) {
+            worker->sum += Int_Get_Value((Integer*)batch[i]);
+            worker->count++;
+            DECREF(batch[i]);
+        }
+    }
+}
+
+static void
+test_threads(TestBatchRunner *runner) {
+    if (!TestUtils_has_threads) {
+        SKIP(runner, 2, "no thread support");
+        return;
+    }
+
+    // A small capacity makes both producers and consumers wait.
+    Channel    *chan = Chan_new(16);
+    ChanWorker  producers[NUM_PRODUCERS];
+    ChanWorker  consumers[NUM_CONSUMERS];
+    Thread     *producer_threads[NUM_PRODUCERS];
+    Thread     *consumer_threads[NUM_CONSUMERS];
+
+    for (int i = 0; i < NUM_CONSUMERS; i++) {
+        consumers[i].chan  = chan;
+        consumers[i].sum   = 0;
+        consumers[i].count = 0;
+        consumer_threads[i] = TestUtils_thread_create(S_consume,
+                                                      consumers + i, NULL);
+    }
+    for (int i = 0; i < NUM_PRODUCERS; i++) {
+        producers[i].chan   = chan;
+        producers[i].offset = (int64_t)i * NUM_PER_PRODUCER;
+        producer_threads[i] = TestUtils_thread_create(S_produce,
+                                                      producers + i, NULL);
+    }
+    for (int i = 0; i < NUM_PRODUCERS; i++) {
+        TestUtils_thread_join(producer_threads[i]);
+    }
+    Chan_Close(chan);
+
+    int64_t sum   = 0;
+    int64_t count = 0;
+    for (int i = 0; i < NUM_CONSUMERS; i++) {
+        TestUtils_thread_join(consumer_threads[i]);
+        sum   += consumers[i].sum;
+        count += consumers[i].count;
+    }
+
+    int64_t total = (int64_t)NUM_PRODUCERS * NUM_PER_PRODUCER;
+    TEST_INT_EQ(runner, count, total, "all elements consumed once");
+    TEST_INT_EQ(runner, sum, total * (total - 1) / 2,
+                "consumed elements have the right values");
+
+    DECREF(chan);
+}
+
+void
+TestChannel_Run_IMP(TestChannel *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 20);
+    test_capacity(runner);
+    test_Try_Push_and_Try_Pop(runner);
+    test_batches(runner);
+    test_Close(runner);
+    test_threads(runner);
+}
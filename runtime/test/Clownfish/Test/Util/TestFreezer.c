@@ -0,0 +1,252 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#define CFISH_USE_SHORT_NAMES
+#define TESTCFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Test/Util/TestFreezer.h"
+
+#include "Clownfish/Blob.h"
+#include "Clownfish/Boolean.h"
+#include "Clownfish/ByteBuf.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/Hash.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Test.h"
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Clownfish/TestHarness/TestUtils.h"
+#include "Clownfish/Util/Freezer.h"
+#include "Clownfish/Vector.h"
+#include "Clownfish/Class.h"
+
+TestFreezer*
+TestFreezer_new() {
+    return (TestFreezer*)Class_Make_Obj(TESTFREEZER);
+}
+
+static Hash*
+S_make_tree() {
+    Hash *tree = Hash_new(0);
+    Hash_Store_Utf8(tree, "short", 5, (Obj*)Str_newf("foo"));
+    Hash_Store_Utf8(tree, "long", 4, (Obj*)TestUtils_random_string(100));
+    Hash_Store_Utf8(tree, "empty", 5, (Obj*)Str_newf(""));
+    Hash_Store_Utf8(tree, "float", 5, (Obj*)Float_new(-2.5e-300));
+    Hash_Store_Utf8(tree, "true", 4, (Obj*)CFISH_TRUE);
+    Hash_Store_Utf8(tree, "false", 5, (Obj*)CFISH_FALSE);
+    Hash_Store_Utf8(tree, "blob", 4, (Obj*)Blob_new("a\0b", 3));
+    Hash_Store_Utf8(tree, "empty_hash", 10, (Obj*)Hash_new(0));
+
+    static const int64_t ints[] = {
+        0, 1, 127, 128, -1, -64, 1000000, INT64_MIN, INT64_MAX
+    };
+    Vector *vector = Vec_new(0);
+    for (size_t i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+        Vec_Push(vector, (Obj*)Int_new(ints[i]));
+    }
+    Vec_Push(vector, NULL);
+    Vec_Push(vector, (Obj*)Vec_new(0));
+    Hash_Store_Utf8(tree, "ints", 4, (Obj*)vector);
+
+    Vector *big_vector = Vec_new(0);
+    Hash   *big_hash   = Hash_new(0);
+    for (int i = 0; i < 100; i++) {
+        Vec_Push(big_vector, (Obj*)Int_new(i * 1000));
+        String *key = Str_newf("key%i32", (int32_t)i);
+        Hash_Store(big_hash, key, (Obj*)Str_newf("value%i32", (int32_t)i));
+        DECREF(key);
+    }
+    Vec_Push(big_vector, (Obj*)big_hash);
+    Hash_Store_Utf8(tree, "big", 3, (Obj*)big_vector);
+
+    return tree;
+}
+
+static void
+test_round_trip(TestBatchRunner *runner) {
+    Hash *tree = S_make_tree();
+    Blob *frozen = ObjFreezer_freeze_to_blob((Obj*)tree);
+
+    Obj *thawed = ObjFreezer_thaw(frozen, true);
+    TEST_TRUE(runner, Hash_Equals(tree, thawed), "round trip, zero-copy");
+    DECREF(thawed);
+
+    thawed = ObjFreezer_thaw(frozen, false);
+    TEST_TRUE(runner, Hash_Equals(tree, thawed), "round trip, copying");
+    DECREF(thawed);
+
+    ByteBuf *buf = BB_new_bytes("xyz", 3);
+    ObjFreezer_freeze((Obj*)tree, buf);
+    thawed = ObjFreezer_thaw_bytes(BB_Get_Buf(buf) + 3, BB_Get_Size(buf) - 3);
+    TEST_TRUE(runner, Hash_Equals(tree, thawed), "freeze appends to ByteBuf");
+    DECREF(thawed);
+    DECREF(buf);
+
+    DECREF(frozen);
+    frozen = ObjFreezer_freeze_to_blob(NULL);
+    TEST_TRUE(runner, ObjFreezer_thaw(frozen, true) == NULL, "NULL");
+    DECREF(frozen);
+
+    DECREF(tree);
+}
+
+static bool
+S_points_into(const char *ptr, Blob *blob) {
+    const char *buf = Blob_Get_Buf(blob);
+    return ptr >= buf && ptr < buf + Blob_Get_Size(blob);
+}
+
+static void
+test_zero_copy(TestBatchRunner *runner) {
+    String *string = TestUtils_random_string(50);
+    Blob   *frozen = ObjFreezer_freeze_to_blob((Obj*)string);
+
+    String *thawed = (String*)ObjFreezer_thaw(frozen, true);
+    TEST_TRUE(runner, S_points_into(Str_Get_Ptr8(thawed), frozen),
+              "zero-copy String points into input");
+    String *copied = (String*)ObjFreezer_thaw(frozen, false);
+    TEST_FALSE(runner, S_points_into(Str_Get_Ptr8(copied), frozen),
+               "copied String doesn't point into input");
+    DECREF(copied);
+
+    DECREF(frozen);
+    TEST_TRUE(runner, Str_Equals(thawed, (Obj*)string),
+              "String keeps input alive");
+    String *substring = Str_SubString(thawed, 10, 20);
+    String *expected  = Str_SubString(string, 10, 20);
+    DECREF(thawed);
+    TEST_TRUE(runner, Str_Equals(substring, (Obj*)expected),
+              "substring keeps input alive");
+    DECREF(expected);
+    DECREF(substring);
+    DECREF(string);
+
+    Blob *blob = Blob_new("\xFF\x00\x01", 3);
+    frozen = ObjFreezer_freeze_to_blob((Obj*)blob);
+    Blob *thawed_blob = (Blob*)ObjFreezer_thaw(frozen, true);
+    TEST_TRUE(runner, S_points_into(Blob_Get_Buf(thawed_blob), frozen),
+              "zero-copy Blob points into input");
+    DECREF(frozen);
+    TEST_TRUE(runner, Blob_Equals(thawed_blob, (Obj*)blob),
+              "Blob keeps input alive");
+    DECREF(thawed_blob);
+    DECREF(blob);
+}
+
+static void
+test_encoding(TestBatchRunner *runner) {
+    Hash *hash = Hash_new(0);
+    Hash_Store_Utf8(hash, "a", 1, (Obj*)Int_new(1));
+    Blob *frozen = ObjFreezer_freeze_to_blob((Obj*)hash);
+    TEST_TRUE(runner, Blob_Equals_Bytes(frozen, "CFz\x01\xB1\x81" "a\x01", 8),
+              "encoding of small Hash");
+    DECREF(frozen);
+    DECREF(hash);
+
+    Integer *integer = Int_new(-3);
+    frozen = ObjFreezer_freeze_to_blob((Obj*)integer);
+    TEST_TRUE(runner, Blob_Equals_Bytes(frozen, "CFz\x01\xC4\x05", 6),
+              "encoding of negative Integer");
+    DECREF(frozen);
+    DECREF(integer);
+}
+
+typedef struct {
+    const char *bytes;
+    size_t      size;
+} ThawContext;
+
+static void
+S_thaw(void *vcontext) {
+    ThawContext *context = (ThawContext*)vcontext;
+    Obj *obj = ObjFreezer_thaw_bytes(context->bytes, context->size);
+    DECREF(obj);
+}
+
+static void
+S_freeze(void *context) {
+    Blob *blob = ObjFreezer_freeze_to_blob((Obj*)context);
+    DECREF(blob);
+}
+
+typedef struct {
+    Obj     *obj;
+    ByteBuf *target;
+} FreezeContext;
+
+static void
+S_freeze_into(void *vcontext) {
+    FreezeContext *context = (FreezeContext*)vcontext;
+    ObjFreezer_freeze(context->obj, context->target);
+}
+
+static void
+S_check_thaw_error(TestBatchRunner *runner, const char *bytes, size_t size,
+                   const char *test_name) {
+    ThawContext context = { bytes, size };
+    Err *error = Err_trap(S_thaw, &context);
+    TEST_TRUE(runner, error != NULL, "%s", test_name);
+    DECREF(error);
+}
+
+static void
+test_errors(TestBatchRunner *runner) {
+    S_check_thaw_error(runner, "CFy\x01\xC0", 5, "bad magic");
+    S_check_thaw_error(runner, "CFz\x02\xC0", 5, "unsupported version");
+    S_check_thaw_error(runner, "CFz\x01\xA2\x01", 6, "truncated input");
+    S_check_thaw_error(runner, "CFz\x01\xC0\xC0", 6, "trailing garbage");
+    S_check_thaw_error(runner, "CFz\x01\xC1", 5, "unknown tag");
+    S_check_thaw_error(runner, "CFz\x01\x82\xC3\x28", 7, "invalid UTF-8");
+    S_check_thaw_error(runner, "CFz\x01\xC8\xFF\xFF\xFF\xFF\x0F\xC0", 11,
+                       "Vector size exceeds input");
+    S_check_thaw_error(runner, "CFz\x01\xB1\x01\x01", 7, "non-String key");
+
+    Err *error = Err_trap(S_freeze, STRING);
+    TEST_TRUE(runner, error != NULL, "freezing unsupported class throws");
+    DECREF(error);
+
+    Vector *deep = Vec_new(1);
+    Vector *vector = deep;
+    for (int i = 0; i < 2000; i++) {
+        Vector *inner = Vec_new(1);
+        Vec_Push(vector, (Obj*)inner);
+        vector = inner;
+    }
+    error = Err_trap(S_freeze, deep);
+    TEST_TRUE(runner, error != NULL, "freezing deeply nested data throws");
+    DECREF(error);
+
+    ByteBuf *target = BB_new_bytes("prefix", 6);
+    FreezeContext context = { (Obj*)deep, target };
+    error = Err_trap(S_freeze_into, &context);
+    TEST_TRUE(runner, error != NULL && BB_Equals_Bytes(target, "prefix", 6),
+              "failed freeze leaves target unchanged");
+    DECREF(error);
+    DECREF(target);
+    DECREF(deep);
+}
+
+void
+TestFreezer_Run_IMP(TestFreezer *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 23);
+    test_round_trip(runner);
+    test_zero_copy(runner);
+    test_encoding(runner);
+    test_errors(runner);
+}
+
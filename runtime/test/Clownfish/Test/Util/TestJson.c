@@ -0,0 +1,370 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <locale.h>
+#include <math.h>
+#include <string.h>
+
+#define CFISH_USE_SHORT_NAMES
+#define TESTCFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Test/Util/TestJson.h"
+
+#include "Clownfish/Boolean.h"
+#include "Clownfish/CharBuf.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/Hash.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Test.h"
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Clownfish/TestHarness/TestUtils.h"
+#include "Clownfish/Util/Json.h"
+#include "Clownfish/Vector.h"
+#include "Clownfish/Class.h"
+
+TestJson*
+TestJson_new() {
+    return (TestJson*)Class_Make_Obj(TESTJSON);
+}
+
+static Hash*
+S_make_tree() {
+    Hash *tree = Hash_new(0);
+    Hash_Store_Utf8(tree, "short", 5, (Obj*)Str_newf("foo"));
+    Hash_Store_Utf8(tree, "long", 4, (Obj*)TestUtils_random_string(100));
+    Hash_Store_Utf8(tree, "escapes", 7,
+                    (Obj*)Str_newf("\"\\/\b\f\n\r\t\x01\x1F"));
+    Hash_Store_Utf8(tree, "empty", 5, (Obj*)Str_newf(""));
+    Hash_Store_Utf8(tree, "float", 5, (Obj*)Float_new(-2.5e-300));
+    Hash_Store_Utf8(tree, "third", 5, (Obj*)Float_new(1.0 / 3.0));
+    Hash_Store_Utf8(tree, "true", 4, (Obj*)CFISH_TRUE);
+    Hash_Store_Utf8(tree, "false", 5, (Obj*)CFISH_FALSE);
+    Hash_Store_Utf8(tree, "empty_hash", 10, (Obj*)Hash_new(0));
+    Hash_Store_Utf8(tree, "key with \"quotes\"", 17, (Obj*)Int_new(7));
+
+    static const int64_t ints[] = {
+        0, 1, -1, 1000000, INT64_MIN, INT64_MAX
+    };
+    Vector *vector = Vec_new(0);
+    for (size_t i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+        Vec_Push(vector, (Obj*)Int_new(ints[i]));
+    }
+    Vec_Push(vector, NULL);
+    Vec_Push(vector, (Obj*)Vec_new(0));
+    Hash_Store_Utf8(tree, "ints", 4, (Obj*)vector);
+
+    Vector *big_vector = Vec_new(0);
+    Hash   *big_hash   = Hash_new(0);
+    for (int i = 0; i < 100; i++) {
+        Vec_Push(big_vector, (Obj*)Int_new(i * 1000));
+        String *key = Str_newf("key%i32", (int32_t)i);
+        Hash_Store(big_hash, key, (Obj*)Str_newf("value%i32", (int32_t)i));
+        DECREF(key);
+    }
+    Vec_Push(big_vector, (Obj*)big_hash);
+    Hash_Store_Utf8(tree, "big", 3, (Obj*)big_vector);
+
+    return tree;
+}
+
+static void
+test_round_trip(TestBatchRunner *runner) {
+    Hash   *tree    = S_make_tree();
+    String *json    = Json_encode((Obj*)tree);
+    Obj    *decoded = Json_decode(json);
+    TEST_TRUE(runner, Hash_Equals(tree, decoded), "round trip");
+    DECREF(decoded);
+
+    CharBuf *buf = CB_new(0);
+    CB_Cat_Trusted_Utf8(buf, "xyz", 3);
+    Json_encode_into((Obj*)tree, buf);
+    String *appended = CB_Yield_String(buf);
+    TEST_TRUE(runner, Str_Starts_With_Utf8(appended, "xyz", 3)
+                      && Str_Ends_With(appended, json),
+              "encode_into appends to CharBuf");
+    DECREF(appended);
+    DECREF(buf);
+
+    DECREF(json);
+    DECREF(tree);
+
+    json = Json_encode(NULL);
+    TEST_TRUE(runner, Str_Equals_Utf8(json, "null", 4), "encode NULL");
+    DECREF(json);
+}
+
+static void
+S_check_encoding(TestBatchRunner *runner, Obj *obj, const char *expected,
+                 const char *test_name) {
+    String *json = Json_encode(obj);
+    TEST_TRUE(runner, Str_Equals_Utf8(json, expected, strlen(expected)),
+              "%s", test_name);
+    DECREF(json);
+    DECREF(obj);
+}
+
+static void
+test_encoding(TestBatchRunner *runner) {
+    Vector *vector = Vec_new(0);
+    Vec_Push(vector, (Obj*)Int_new(1));
+    Vec_Push(vector, (Obj*)Int_new(-20));
+    Vec_Push(vector, (Obj*)CFISH_TRUE);
+    Vec_Push(vector, (Obj*)CFISH_FALSE);
+    Vec_Push(vector, NULL);
+    Vec_Push(vector, (Obj*)Str_newf("a\"\\\n\x01\xC3\xA9"));
+    Hash *hash = Hash_new(0);
+    Hash_Store_Utf8(hash, "a", 1, (Obj*)vector);
+    S_check_encoding(runner, (Obj*)hash,
+                     "{\"a\":[1,-20,true,false,null,\"a\\\"\\\\\\n\\u0001"
+                     "\xC3\xA9\"]}",
+                     "compact encoding");
+
+    S_check_encoding(runner, (Obj*)Float_new(1.0), "1.0",
+                     "integral Float keeps decimal point");
+    S_check_encoding(runner, (Obj*)Float_new(0.1), "0.1",
+                     "Float uses shortest round-trip representation");
+    S_check_encoding(runner, (Obj*)Float_new(1e300), "1e+300",
+                     "Float with exponent");
+}
+
+static bool
+S_decodes_to_int(const char *json, int64_t expected) {
+    String  *string  = Str_new_from_utf8(json, strlen(json));
+    Obj     *decoded = Json_decode(string);
+    bool     result  = decoded
+                       && Obj_get_class(decoded) == INTEGER
+                       && Int_Get_Value((Integer*)decoded) == expected;
+    DECREF(decoded);
+    DECREF(string);
+    return result;
+}
+
+static bool
+S_decodes_to_float(const char *json, double expected) {
+    Obj  *decoded = Json_decode_utf8(json, strlen(json));
+    bool  result  = decoded
+                    && Obj_get_class(decoded) == FLOAT
+                    && Float_Get_Value((Float*)decoded) == expected;
+    DECREF(decoded);
+    return result;
+}
+
+static void
+test_decoding(TestBatchRunner *runner) {
+    TEST_TRUE(runner, S_decodes_to_int(" -42 ", -42), "Integer");
+    TEST_TRUE(runner, S_decodes_to_int("-9223372036854775808", INT64_MIN),
+              "INT64_MIN");
+    TEST_TRUE(runner, S_decodes_to_int("9223372036854775807", INT64_MAX),
+              "INT64_MAX");
+    TEST_TRUE(runner, S_decodes_to_float("9223372036854775808",
+                                         9223372036854775808.0),
+              "too large for Integer");
+    TEST_TRUE(runner, S_decodes_to_float("1.5", 1.5), "Float");
+    TEST_TRUE(runner, S_decodes_to_float("-2E-2", -0.02),
+              "Float with exponent");
+
+    const char *json = "\"\\u00e9\\ud83d\\ude00\\/\"";
+    String *string = (String*)Json_decode_utf8(json, strlen(json));
+    TEST_TRUE(runner, Str_Equals_Utf8(string, "\xC3\xA9\xF0\x9F\x98\x80/", 7),
+              "\\u escapes and surrogate pairs");
+    DECREF(string);
+
+    json = "{ \"a\" : 1 , \"a\\u0062\" : [ ] , \"a\" : { } }";
+    Hash *hash = (Hash*)Json_decode_utf8(json, strlen(json));
+    TEST_TRUE(runner, Hash_Get_Size(hash) == 2
+                      && Obj_is_a(Hash_Fetch_Utf8(hash, "a", 1), HASH)
+                      && Obj_is_a(Hash_Fetch_Utf8(hash, "ab", 2), VECTOR),
+              "whitespace, escaped keys and duplicate keys");
+    DECREF(hash);
+
+    CharBuf *buf = CB_new(0);
+    CB_Cat_Trusted_Utf8(buf, "[\"[,]\"", 6);
+    for (int i = 0; i < 1000; i++) {
+        CB_catf(buf, ",[%i32]", (int32_t)i);
+    }
+    CB_Cat_Trusted_Utf8(buf, "]", 1);
+    String *big_json = CB_Yield_String(buf);
+    Vector *vector   = (Vector*)Json_decode(big_json);
+    TEST_TRUE(runner, Vec_Get_Size(vector) == 1001
+                      && Vec_Get_Capacity(vector) == 1001,
+              "Vector is presized");
+    Vector *last = (Vector*)Vec_Fetch(vector, 1000);
+    TEST_TRUE(runner, Vec_Get_Size(last) == 1
+                      && Vec_Get_Capacity(last) == 1
+                      && Int_Get_Value((Integer*)Vec_Fetch(last, 0)) == 999,
+              "nested Vectors are presized");
+    DECREF(vector);
+    DECREF(big_json);
+    DECREF(buf);
+}
+
+typedef struct {
+    const char *json;
+    size_t      size;
+} DecodeContext;
+
+static void
+S_decode(void *vcontext) {
+    DecodeContext *context = (DecodeContext*)vcontext;
+    Obj *obj = Json_decode_utf8(context->json, context->size);
+    DECREF(obj);
+}
+
+static void
+S_encode(void *context) {
+    String *json = Json_encode((Obj*)context);
+    DECREF(json);
+}
+
+typedef struct {
+    Obj     *obj;
+    CharBuf *target;
+} EncodeIntoContext;
+
+static void
+S_encode_into(void *vcontext) {
+    EncodeIntoContext *context = (EncodeIntoContext*)vcontext;
+    Json_encode_into(context->obj, context->target);
+}
+
+static bool
+S_decode_fails(const char *json, size_t size) {
+    DecodeContext context = { json, size };
+    Err *error = Err_trap(S_decode, &context);
+    bool result = error != NULL;
+    DECREF(error);
+    return result;
+}
+
+static void
+test_errors(TestBatchRunner *runner) {
+    static const char *const invalid[] = {
+        "", "   ", "[1,]", "[1 2]", "{\"a\" 1}", "{1:2}", "{\"a\":1,}",
+        "\"abc", "\"\\x\"", "\"\\u12\"", "\"\\ud800\"", "\"\\udc00\"",
+        "\"a\x01\"", "01", "1.", "1e", "-", "+1", ".5", "tru", "nul",
+        "[", "{", "]", "1 2", "[1]]", "NaN"
+    };
+    size_t num_invalid = sizeof(invalid) / sizeof(invalid[0]);
+    size_t num_thrown  = 0;
+    for (size_t i = 0; i < num_invalid; i++) {
+        if (S_decode_fails(invalid[i], strlen(invalid[i]))) {
+            num_thrown++;
+        }
+    }
+    TEST_UINT_EQ(runner, num_thrown, num_invalid, "invalid JSON throws");
+
+    TEST_TRUE(runner, S_decode_fails("\"\xC3\x28\"", 4),
+              "invalid UTF-8 throws");
+
+    char deep_json[2001];
+    memset(deep_json, '[', 2000);
+    TEST_TRUE(runner, S_decode_fails(deep_json, 2000),
+              "decoding deeply nested data throws");
+    memset(deep_json + 1000, ']', 1000);
+    TEST_FALSE(runner, S_decode_fails(deep_json, 2000),
+               "1000 nested arrays are allowed");
+
+    Err *error = Err_trap(S_encode, STRING);
+    TEST_TRUE(runner, error != NULL, "encoding unsupported class throws");
+    DECREF(error);
+
+    Float *nan = Float_new(NAN);
+    error = Err_trap(S_encode, nan);
+    TEST_TRUE(runner, error != NULL, "encoding NaN throws");
+    DECREF(error);
+    DECREF(nan);
+
+    Vector *deep = Vec_new(1);
+    Vector *vector = deep;
+    for (int i = 0; i < 2000; i++) {
+        Vector *inner = Vec_new(1);
+        Vec_Push(vector, (Obj*)inner);
+        vector = inner;
+    }
+    error = Err_trap(S_encode, deep);
+    TEST_TRUE(runner, error != NULL, "encoding deeply nested data throws");
+    DECREF(error);
+    DECREF(deep);
+
+    Vector *partial = Vec_new(2);
+    Vec_Push(partial, (Obj*)Str_newf("ok"));
+    Vec_Push(partial, (Obj*)Float_new(NAN));
+    EncodeIntoContext context;
+    context.obj    = (Obj*)partial;
+    context.target = CB_new(0);
+    CB_Cat_Trusted_Utf8(context.target, "xyz", 3);
+    error = Err_trap(S_encode_into, &context);
+    String *left = CB_To_String(context.target);
+    TEST_TRUE(runner, error != NULL && Str_Equals_Utf8(left, "xyz", 3),
+              "failed encode_into leaves target unchanged");
+    DECREF(left);
+    DECREF(error);
+    DECREF(context.target);
+    DECREF(partial);
+}
+
+// JSON numbers must not depend on the decimal point of the current locale.
+// Only the calling thread switches to a locale which uses a comma, if one
+// is installed.
+static void
+test_locale(TestBatchRunner *runner) {
+#ifdef LC_NUMERIC_MASK
+    static const char *const names[] = {
+        "de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "fr_FR.utf8",
+        "fr_FR", NULL
+    };
+    locale_t comma_locale = (locale_t)0;
+    for (int i = 0; names[i] != NULL && comma_locale == (locale_t)0; i++) {
+        comma_locale = newlocale(LC_NUMERIC_MASK, names[i], (locale_t)0);
+    }
+    if (comma_locale == (locale_t)0) {
+        SKIP(runner, 2, "No locale with a decimal comma installed");
+        return;
+    }
+    locale_t orig_locale = uselocale(comma_locale);
+
+    Float  *num  = Float_new(-1.25);
+    String *json = Json_encode((Obj*)num);
+    TEST_TRUE(runner, Str_Equals_Utf8(json, "-1.25", 5),
+              "encode Float with decimal comma locale");
+    DECREF(json);
+    DECREF(num);
+
+    Obj *decoded = Json_decode_utf8("[2.5e1]", 7);
+    Obj *elem    = Vec_Fetch((Vector*)decoded, 0);
+    TEST_TRUE(runner, Obj_is_a(elem, FLOAT)
+                      && Float_Get_Value((Float*)elem) == 25.0,
+              "decode Float with decimal comma locale");
+    DECREF(decoded);
+
+    uselocale(orig_locale);
+    freelocale(comma_locale);
+#else
+    SKIP(runner, 2, "Thread-local locales not supported");
+#endif
+}
+
+void
+TestJson_Run_IMP(TestJson *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 27);
+    test_round_trip(runner);
+    test_encoding(runner);
+    test_decoding(runner);
+    test_errors(runner);
+    test_locale(runner);
+}
+
@@ -108,12 +108,66 @@ test_oversize__rounding(TestBatchRunner *runner) {
     PASS(runner, "Round allocations up to the size of a pointer");
 }
 
+typedef struct {
+    uint64_t num_allocs;
+    uint64_t num_bytes;
+} AllocCounts;
+
+static void
+S_count_alloc(void *context, size_t size) {
+    AllocCounts *counts = (AllocCounts*)context;
+    counts->num_allocs += 1;
+    counts->num_bytes  += size;
+}
+
+static void
+test_alloc_hook(TestBatchRunner *runner) {
+    AllocCounts counts = { 0, 0 };
+
+    Memory_set_alloc_hook(S_count_alloc, &counts);
+    void *ptr = MALLOCATE(10);
+    ptr = REALLOCATE(ptr, 30);
+    void *other = CALLOCATE(4, 5);
+    Memory_set_alloc_hook(NULL, NULL);
+
+    TEST_UINT_EQ(runner, counts.num_allocs, 3, "alloc hook counts calls");
+    TEST_UINT_EQ(runner, counts.num_bytes, 60, "alloc hook gets sizes");
+
+    FREEMEM(ptr);
+    FREEMEM(other);
+    ptr = MALLOCATE(10);
+    FREEMEM(ptr);
+    TEST_UINT_EQ(runner, counts.num_allocs, 3, "alloc hook can be removed");
+
+    AllocCounts other_counts = { 0, 0 };
+    Memory_set_alloc_hook(S_count_alloc, &other_counts);
+    Memory_set_alloc_hook(S_count_alloc, &counts);
+    ptr = MALLOCATE(10);
+    Memory_set_alloc_hook(S_count_alloc, &other_counts);
+    FREEMEM(ptr);
+    ptr = MALLOCATE(10);
+    Memory_set_alloc_hook(NULL, NULL);
+    FREEMEM(ptr);
+    TEST_UINT_EQ(runner, counts.num_allocs, 4,
+                 "alloc hook context is replaced");
+    TEST_UINT_EQ(runner, other_counts.num_allocs, 1,
+                 "alloc hook can be reinstalled");
+}
+
+// The batch installs the process-wide allocation hook.
+bool
+TestMemory_Is_Thread_Safe_IMP(TestMemory *self) {
+    UNUSED_VAR(self);
+    return false;
+}
+
 void
 TestMemory_Run_IMP(TestMemory *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 30);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 35);
     test_oversize__growth_rate(runner);
     test_oversize__ceiling(runner);
     test_oversize__rounding(runner);
+    test_alloc_hook(runner);
 }
 
 
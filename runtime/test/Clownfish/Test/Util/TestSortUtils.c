@@ -0,0 +1,517 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#define CFISH_USE_SHORT_NAMES
+#define TESTCFISH_USE_SHORT_NAMES
+
+#include "charmony.h"
+
+#include "Clownfish/Test/Util/TestSortUtils.h"
+
+#include "Clownfish/Err.h"
+#include "Clownfish/Test.h"
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Clownfish/TestHarness/TestUtils.h"
+#include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/SortUtils.h"
+#include "Clownfish/Util/ThreadPool.h"
+#include "Clownfish/Class.h"
+
+#define NUM_ELEMS 1000
+
+enum {
+    PATTERN_RANDOM,
+    PATTERN_SORTED,
+    PATTERN_REVERSED,
+    PATTERN_FEW_UNIQUE,
+    PATTERN_ORGAN_PIPE,
+    PATTERN_ALL_EQUAL,
+    NUM_PATTERNS
+};
+
+static const char *pattern_names[NUM_PATTERNS] = {
+    "random", "sorted", "reversed", "few unique", "organ pipe", "all equal"
+};
+
+TestSortUtils*
+TestSortUtils_new() {
+    return (TestSortUtils*)Class_Make_Obj(TESTSORTUTILS);
+}
+
+// Elements start with a 32-bit key, followed by a 32-bit sequence number if
+// there is room.  Only the key is compared.
+static int
+S_compare_keys(void *context, const void *va, const void *vb) {
+    uint32_t a, b;
+    memcpy(&a, va, sizeof(uint32_t));
+    memcpy(&b, vb, sizeof(uint32_t));
+    UNUSED_VAR(context);
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static uint32_t
+S_key(size_t i, size_t num_elems, int pattern) {
+    switch (pattern) {
+        case PATTERN_RANDOM:
+            return (uint32_t)TestUtils_random_u64();
+        case PATTERN_SORTED:
+            return (uint32_t)i;
+        case PATTERN_REVERSED:
+            return (uint32_t)(num_elems - i);
+        case PATTERN_FEW_UNIQUE:
+            return (uint32_t)(TestUtils_random_u64() % 4);
+        case PATTERN_ORGAN_PIPE:
+            return (uint32_t)(i < num_elems / 2 ? i : num_elems - i);
+        default:
+            return 7;
+    }
+}
+
+static void
+S_fill(uint8_t *elems, size_t num_elems, size_t width, int pattern) {
+    memset(elems, 0, num_elems * width);
+    for (size_t i = 0; i < num_elems; i++) {
+        uint32_t key = S_key(i, num_elems, pattern);
+        uint32_t seq = (uint32_t)i;
+        memcpy(elems + i * width, &key, sizeof(uint32_t));
+        if (width >= 8) {
+            memcpy(elems + i * width + 4, &seq, sizeof(uint32_t));
+        }
+    }
+}
+
+// Verify that `elems` is sorted and holds the same keys as `orig`.  If
+// `stable` is true and the elements carry sequence numbers, also verify that
+// equal keys kept their original order.
+static bool
+S_check(uint8_t *elems, uint8_t *orig, size_t num_elems, size_t width,
+        bool stable) {
+    uint64_t sum      = 0;
+    uint64_t orig_sum = 0;
+
+    for (size_t i = 0; i < num_elems; i++) {
+        uint32_t key, orig_key;
+        memcpy(&key, elems + i * width, sizeof(uint32_t));
+        memcpy(&orig_key, orig + i * width, sizeof(uint32_t));
+        sum      += key;
+        orig_sum += orig_key;
+
+        if (i == 0) { continue; }
+
+        int comparison = S_compare_keys(NULL, elems + (i - 1) * width,
+                                        elems + i * width);
+        if (comparison > 0) { return false; }
+        if (comparison == 0 && stable && width >= 8) {
+            uint32_t prev_seq, seq;
+            memcpy(&prev_seq, elems + (i - 1) * width + 4, sizeof(uint32_t));
+            memcpy(&seq, elems + i * width + 4, sizeof(uint32_t));
+            if (prev_seq > seq) { return false; }
+        }
+    }
+
+    return sum == orig_sum;
+}
+
+static void
+test_sort(TestBatchRunner *runner, size_t width, int pattern, bool stable) {
+    static const size_t sizes[] = { 0, 1, 2, 3, 7, 23, 24, 25, 64, 65, 129,
+                                    NUM_ELEMS };
+    const size_t num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+    uint8_t *elems   = (uint8_t*)MALLOCATE(NUM_ELEMS * width);
+    uint8_t *orig    = (uint8_t*)MALLOCATE(NUM_ELEMS * width);
+    uint8_t *scratch = (uint8_t*)MALLOCATE(NUM_ELEMS * width);
+    bool     success = true;
+
+    for (size_t i = 0; i < num_sizes; i++) {
+        size_t num_elems = sizes[i];
+        S_fill(orig, num_elems, width, pattern);
+        memcpy(elems, orig, num_elems * width);
+        if (stable) {
+            Sort_mergesort(elems, scratch, num_elems, width, S_compare_keys,
+                           NULL);
+        }
+        else {
+            Sort_quicksort(elems, num_elems, width, S_compare_keys, NULL);
+        }
+        if (!S_check(elems, orig, num_elems, width, stable)) {
+            success = false;
+        }
+    }
+
+    TEST_TRUE(runner, success, "%s, width %u, %s input",
+              stable ? "mergesort" : "quicksort", (unsigned)width,
+              pattern_names[pattern]);
+
+    FREEMEM(elems);
+    FREEMEM(orig);
+    FREEMEM(scratch);
+}
+
+static void
+S_mergesort_zero_width(void *context) {
+    uint32_t elems[2] = { 2, 1 };
+    uint32_t scratch[2];
+    Sort_mergesort(elems, scratch, 2, 0, S_compare_keys, context);
+}
+
+static void
+S_quicksort_zero_width(void *context) {
+    uint32_t elems[2] = { 2, 1 };
+    Sort_quicksort(elems, 2, 0, S_compare_keys, context);
+}
+
+static int
+S_compare_u32(void *context, const void *va, const void *vb) {
+    uint32_t a = *(uint32_t*)va;
+    uint32_t b = *(uint32_t*)vb;
+    UNUSED_VAR(context);
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static int
+S_compare_i32(void *context, const void *va, const void *vb) {
+    int32_t a = *(int32_t*)va;
+    int32_t b = *(int32_t*)vb;
+    UNUSED_VAR(context);
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static int
+S_compare_u64(void *context, const void *va, const void *vb) {
+    uint64_t a = *(uint64_t*)va;
+    uint64_t b = *(uint64_t*)vb;
+    UNUSED_VAR(context);
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static int
+S_compare_i64(void *context, const void *va, const void *vb) {
+    int64_t a = *(int64_t*)va;
+    int64_t b = *(int64_t*)vb;
+    UNUSED_VAR(context);
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static void
+test_radixsort_ints(TestBatchRunner *runner) {
+    static const size_t sizes[] = { 0, 1, 2, 100, NUM_ELEMS };
+    const size_t num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+    int64_t  *values   = (int64_t*)MALLOCATE(NUM_ELEMS * sizeof(int64_t));
+    uint64_t *elems    = (uint64_t*)MALLOCATE(NUM_ELEMS * sizeof(uint64_t));
+    uint64_t *wanted   = (uint64_t*)MALLOCATE(NUM_ELEMS * sizeof(uint64_t));
+    uint64_t *scratch  = (uint64_t*)MALLOCATE(NUM_ELEMS * sizeof(uint64_t));
+    bool success_u32 = true;
+    bool success_i32 = true;
+    bool success_u64 = true;
+    bool success_i64 = true;
+
+    for (size_t i = 0; i < num_sizes; i++) {
+        size_t num_elems = sizes[i];
+        TestUtils_random_i64s(values, num_elems, INT64_MIN, INT64_MAX);
+
+        uint32_t *elems32  = (uint32_t*)elems;
+        uint32_t *wanted32 = (uint32_t*)wanted;
+        for (size_t j = 0; j < num_elems; j++) {
+            elems32[j] = (uint32_t)values[j];
+        }
+        memcpy(wanted32, elems32, num_elems * sizeof(uint32_t));
+        Sort_quicksort(wanted32, num_elems, 4, S_compare_u32, NULL);
+        Sort_radixsort_u32(elems32, (uint32_t*)scratch, num_elems, NULL);
+        if (memcmp(elems32, wanted32, num_elems * sizeof(uint32_t)) != 0) {
+            success_u32 = false;
+        }
+
+        for (size_t j = 0; j < num_elems; j++) {
+            elems32[j] = (uint32_t)values[j];
+        }
+        memcpy(wanted32, elems32, num_elems * sizeof(uint32_t));
+        Sort_quicksort(wanted32, num_elems, 4, S_compare_i32, NULL);
+        Sort_radixsort_i32((int32_t*)elems32, (int32_t*)scratch, num_elems,
+                           NULL);
+        if (memcmp(elems32, wanted32, num_elems * sizeof(uint32_t)) != 0) {
+            success_i32 = false;
+        }
+
+        memcpy(elems, values, num_elems * sizeof(uint64_t));
+        memcpy(wanted, values, num_elems * sizeof(uint64_t));
+        Sort_quicksort(wanted, num_elems, 8, S_compare_u64, NULL);
+        Sort_radixsort_u64(elems, scratch, num_elems, NULL);
+        if (memcmp(elems, wanted, num_elems * sizeof(uint64_t)) != 0) {
+            success_u64 = false;
+        }
+
+        memcpy(elems, values, num_elems * sizeof(uint64_t));
+        memcpy(wanted, values, num_elems * sizeof(uint64_t));
+        Sort_quicksort(wanted, num_elems, 8, S_compare_i64, NULL);
+        Sort_radixsort_i64((int64_t*)elems, (int64_t*)scratch, num_elems,
+                           NULL);
+        if (memcmp(elems, wanted, num_elems * sizeof(uint64_t)) != 0) {
+            success_i64 = false;
+        }
+    }
+
+    TEST_TRUE(runner, success_u32, "radixsort_u32");
+    TEST_TRUE(runner, success_i32, "radixsort_i32");
+    TEST_TRUE(runner, success_u64, "radixsort_u64");
+    TEST_TRUE(runner, success_i64, "radixsort_i64");
+
+    FREEMEM(values);
+    FREEMEM(elems);
+    FREEMEM(wanted);
+    FREEMEM(scratch);
+}
+
+static void
+test_radixsort_f64(TestBatchRunner *runner) {
+    const double zero = 0.0;
+    double *elems   = (double*)MALLOCATE(NUM_ELEMS * sizeof(double));
+    double *scratch = (double*)MALLOCATE(NUM_ELEMS * sizeof(double));
+    size_t  num_nans = 0;
+    bool    success  = true;
+
+    TestUtils_random_f64s(elems, NUM_ELEMS);
+    for (size_t i = 0; i < NUM_ELEMS; i++) {
+        switch (i % 10) {
+            case 0: elems[i] = -elems[i] * 1e10; break;
+            case 1: elems[i] = zero / zero; num_nans++; break;
+            case 2: elems[i] = -1.0 / zero; break;
+            case 3: elems[i] = 1.0 / zero; break;
+            case 4: elems[i] = -zero; break;
+            default: break;
+        }
+    }
+
+    Sort_radixsort_f64(elems, scratch, NUM_ELEMS, NULL);
+
+    size_t num_numbers = NUM_ELEMS - num_nans;
+    for (size_t i = 0; i < NUM_ELEMS; i++) {
+        if (i < num_numbers) {
+            if (elems[i] != elems[i]) { success = false; }
+            if (i > 0 && elems[i - 1] > elems[i]) { success = false; }
+        }
+        else if (elems[i] == elems[i]) {
+            success = false;
+        }
+    }
+    TEST_TRUE(runner, success, "radixsort_f64");
+
+    FREEMEM(elems);
+    FREEMEM(scratch);
+}
+
+static void
+test_radixsort_keyed(TestBatchRunner *runner) {
+    const size_t width = 16;
+    uint8_t *elems   = (uint8_t*)MALLOCATE(NUM_ELEMS * width);
+    uint8_t *scratch = (uint8_t*)MALLOCATE(NUM_ELEMS * width);
+    bool     success = true;
+
+    for (size_t i = 0; i < NUM_ELEMS; i++) {
+        uint64_t key = TestUtils_random_u64() % 10 << 40;
+        uint64_t seq = i;
+        memcpy(elems + i * width, &key, sizeof(uint64_t));
+        memcpy(elems + i * width + 8, &seq, sizeof(uint64_t));
+    }
+
+    Sort_radixsort_keyed(elems, scratch, NUM_ELEMS, width, NULL);
+
+    for (size_t i = 1; i < NUM_ELEMS; i++) {
+        uint64_t prev[2], cur[2];
+        memcpy(prev, elems + (i - 1) * width, sizeof(prev));
+        memcpy(cur, elems + i * width, sizeof(cur));
+        if (prev[0] > cur[0] || (prev[0] == cur[0] && prev[1] > cur[1])) {
+            success = false;
+        }
+    }
+    TEST_TRUE(runner, success, "radixsort_keyed is sorted and stable");
+
+    FREEMEM(elems);
+    FREEMEM(scratch);
+}
+
+static void
+S_radixsort_keyed_bad_width(void *context) {
+    uint32_t elems[2] = { 2, 1 };
+    uint32_t scratch[2];
+    UNUSED_VAR(context);
+    Sort_radixsort_keyed(elems, scratch, 2, 4, NULL);
+}
+
+static int
+S_compare_byte_keys(const SortByteKey *a, const SortByteKey *b) {
+    size_t min_size = a->size < b->size ? a->size : b->size;
+    int comparison = memcmp(a->ptr, b->ptr, min_size);
+    if (comparison != 0) { return comparison; }
+    return a->size < b->size ? -1 : a->size > b->size ? 1 : 0;
+}
+
+static bool
+S_byte_keys_sorted_and_stable(SortByteKey *keys, size_t num_keys) {
+    for (size_t i = 1; i < num_keys; i++) {
+        int comparison = S_compare_byte_keys(keys + i - 1, keys + i);
+        if (comparison > 0) { return false; }
+        if (comparison == 0
+            && (uintptr_t)keys[i - 1].value > (uintptr_t)keys[i].value
+           ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void
+test_radixsort_bytes(TestBatchRunner *runner) {
+    const size_t max_len = 12;
+    const size_t prefix_len = 200;
+    uint8_t *buf = (uint8_t*)MALLOCATE(NUM_ELEMS * (prefix_len + max_len));
+    SortByteKey *keys
+        = (SortByteKey*)MALLOCATE(NUM_ELEMS * sizeof(SortByteKey));
+    SortByteKey *scratch
+        = (SortByteKey*)MALLOCATE(NUM_ELEMS * sizeof(SortByteKey));
+
+    // Short keys over a two-letter alphabet, with many duplicates and keys
+    // which are prefixes of other keys.
+    for (size_t i = 0; i < NUM_ELEMS; i++) {
+        uint8_t *ptr  = buf + i * max_len;
+        size_t   size = (size_t)(TestUtils_random_u64() % (max_len + 1));
+        for (size_t j = 0; j < size; j++) {
+            ptr[j] = TestUtils_random_u64() % 2 ? 'a' : 'b';
+        }
+        keys[i].ptr   = ptr;
+        keys[i].size  = size;
+        keys[i].value = (void*)(uintptr_t)i;
+    }
+    Sort_radixsort_bytes(keys, scratch, NUM_ELEMS);
+    TEST_TRUE(runner, S_byte_keys_sorted_and_stable(keys, NUM_ELEMS),
+              "radixsort_bytes is sorted and stable");
+
+    // Long common prefixes and bytes outside ASCII.
+    for (size_t i = 0; i < NUM_ELEMS; i++) {
+        uint8_t *ptr  = buf + i * (prefix_len + max_len);
+        size_t   size = prefix_len + (size_t)(TestUtils_random_u64() % 3);
+        memset(ptr, 0xE9, prefix_len);
+        for (size_t j = prefix_len; j < size; j++) {
+            ptr[j] = (uint8_t)TestUtils_random_u64();
+        }
+        keys[i].ptr   = ptr;
+        keys[i].size  = size;
+        keys[i].value = (void*)(uintptr_t)i;
+    }
+    Sort_radixsort_bytes(keys, scratch, NUM_ELEMS);
+    TEST_TRUE(runner, S_byte_keys_sorted_and_stable(keys, NUM_ELEMS),
+              "radixsort_bytes with long common prefixes");
+
+    FREEMEM(buf);
+    FREEMEM(keys);
+    FREEMEM(scratch);
+}
+
+#define PARALLEL_NUM_ELEMS 200000
+
+static void
+test_parallel_sort(TestBatchRunner *runner) {
+    uint8_t *elems   = (uint8_t*)MALLOCATE(PARALLEL_NUM_ELEMS * 16);
+    uint8_t *orig    = (uint8_t*)MALLOCATE(PARALLEL_NUM_ELEMS * 16);
+    uint8_t *scratch = (uint8_t*)MALLOCATE(PARALLEL_NUM_ELEMS * 16);
+    ThreadPool *pool2 = ThreadPool_new(2);
+    ThreadPool *pool3 = ThreadPool_new(3);
+
+    // An odd number of threads leaves an unpaired run in the first merge
+    // round.
+    S_fill(orig, PARALLEL_NUM_ELEMS, 8, PATTERN_FEW_UNIQUE);
+    memcpy(elems, orig, PARALLEL_NUM_ELEMS * 8);
+    Sort_parallel_mergesort(elems, scratch, PARALLEL_NUM_ELEMS, 8,
+                            S_compare_keys, NULL, pool2);
+    TEST_TRUE(runner, S_check(elems, orig, PARALLEL_NUM_ELEMS, 8, true),
+              "parallel_mergesort is sorted and stable");
+
+    S_fill(orig, PARALLEL_NUM_ELEMS, 12, PATTERN_RANDOM);
+    memcpy(elems, orig, PARALLEL_NUM_ELEMS * 12);
+    Sort_parallel_mergesort(elems, scratch, PARALLEL_NUM_ELEMS, 12,
+                            S_compare_keys, NULL, pool3);
+    TEST_TRUE(runner, S_check(elems, orig, PARALLEL_NUM_ELEMS, 12, true),
+              "parallel_mergesort with odd width");
+
+    uint64_t *keys = (uint64_t*)elems;
+    uint64_t *wanted = (uint64_t*)orig;
+    TestUtils_random_u64s(keys, PARALLEL_NUM_ELEMS, 0, UINT64_MAX);
+    memcpy(wanted, keys, PARALLEL_NUM_ELEMS * sizeof(uint64_t));
+    Sort_quicksort(wanted, PARALLEL_NUM_ELEMS, 8, S_compare_u64, NULL);
+    Sort_radixsort_u64(keys, (uint64_t*)scratch, PARALLEL_NUM_ELEMS, pool3);
+    TEST_TRUE(runner,
+              memcmp(keys, wanted, PARALLEL_NUM_ELEMS * sizeof(uint64_t))
+              == 0,
+              "radixsort_u64 with multiple threads");
+
+    for (size_t i = 0; i < PARALLEL_NUM_ELEMS; i++) {
+        uint64_t key = TestUtils_random_u64() % 3;
+        uint64_t seq = i;
+        memcpy(elems + i * 16, &key, sizeof(uint64_t));
+        memcpy(elems + i * 16 + 8, &seq, sizeof(uint64_t));
+    }
+    Sort_radixsort_keyed(elems, scratch, PARALLEL_NUM_ELEMS, 16, pool3);
+    bool stable = true;
+    for (size_t i = 1; i < PARALLEL_NUM_ELEMS; i++) {
+        uint64_t prev[2], cur[2];
+        memcpy(prev, elems + (i - 1) * 16, sizeof(prev));
+        memcpy(cur, elems + i * 16, sizeof(cur));
+        if (prev[0] > cur[0] || (prev[0] == cur[0] && prev[1] > cur[1])) {
+            stable = false;
+        }
+    }
+    TEST_TRUE(runner, stable,
+              "radixsort_keyed with multiple threads is stable");
+
+    DECREF(pool2);
+    DECREF(pool3);
+    FREEMEM(elems);
+    FREEMEM(orig);
+    FREEMEM(scratch);
+}
+
+static void
+test_invalid_width(TestBatchRunner *runner) {
+    Err *error = Err_trap(S_mergesort_zero_width, NULL);
+    TEST_TRUE(runner, error != NULL, "mergesort throws on zero width");
+    DECREF(error);
+    error = Err_trap(S_quicksort_zero_width, NULL);
+    TEST_TRUE(runner, error != NULL, "quicksort throws on zero width");
+    DECREF(error);
+    error = Err_trap(S_radixsort_keyed_bad_width, NULL);
+    TEST_TRUE(runner, error != NULL, "radixsort_keyed throws on bad width");
+    DECREF(error);
+}
+
+void
+TestSortUtils_Run_IMP(TestSortUtils *self, TestBatchRunner *runner) {
+    static const size_t widths[] = { 4, 8, 16, 12 };
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 63);
+    for (size_t i = 0; i < sizeof(widths) / sizeof(widths[0]); i++) {
+        for (int pattern = 0; pattern < NUM_PATTERNS; pattern++) {
+            test_sort(runner, widths[i], pattern, true);
+            test_sort(runner, widths[i], pattern, false);
+        }
+    }
+    test_radixsort_ints(runner);
+    test_radixsort_f64(runner);
+    test_radixsort_keyed(runner);
+    test_radixsort_bytes(runner);
+    test_parallel_sort(runner);
+    test_invalid_width(runner);
+}
+
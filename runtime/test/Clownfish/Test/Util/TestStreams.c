@@ -0,0 +1,303 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#define CFISH_USE_SHORT_NAMES
+#define TESTCFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Test/Util/TestStreams.h"
+
+#include "Clownfish/Blob.h"
+#include "Clownfish/ByteBuf.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Test.h"
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Clownfish/TestHarness/TestUtils.h"
+#include "Clownfish/Util/BufInStream.h"
+#include "Clownfish/Util/BufOutStream.h"
+#include "Clownfish/Util/Memory.h"
+#include "Clownfish/Class.h"
+
+#define TEST_FILE   "_test_streams.bin"
+#define BIG_SIZE    200000
+
+TestStreams*
+TestStreams_new() {
+    return (TestStreams*)Class_Make_Obj(TESTSTREAMS);
+}
+
+static const uint32_t cu32_values[] = {
+    0, 1, 127, 128, 16383, 16384, 0x7FFFFFFF, UINT32_MAX
+};
+static const int64_t ci64_values[] = {
+    0, -1, 1, -64, 64, INT64_MIN, INT64_MAX
+};
+#define NUM_CU32 (sizeof(cu32_values) / sizeof(cu32_values[0]))
+#define NUM_CI64 (sizeof(ci64_values) / sizeof(ci64_values[0]))
+
+static char*
+S_big_bytes() {
+    char *bytes = (char*)MALLOCATE(BIG_SIZE);
+    for (size_t i = 0; i < BIG_SIZE; i++) {
+        bytes[i] = (char)(i * 31 % 253);
+    }
+    return bytes;
+}
+
+static int64_t
+S_write_file(String *path, const char *big) {
+    BufOutStream *outstream = BufOut_open(path, false);
+    BufOut_Write_U8(outstream, 0xAB);
+    BufOut_Write_U32(outstream, 0xDEADBEEF);
+    BufOut_Write_U64(outstream, UINT64_C(0x0123456789ABCDEF));
+    BufOut_Write_F64(outstream, -1.5);
+    for (size_t i = 0; i < NUM_CU32; i++) {
+        BufOut_Write_CU32(outstream, cu32_values[i]);
+    }
+    BufOut_Write_CU64(outstream, UINT64_MAX);
+    for (size_t i = 0; i < NUM_CI64; i++) {
+        BufOut_Write_CI64(outstream, ci64_values[i]);
+    }
+    String *string = Str_newf("na\xC3\xAFve %i32", (int32_t)42);
+    BufOut_Write_String(outstream, string);
+    DECREF(string);
+    BufOut_Write_Bytes(outstream, big, BIG_SIZE);
+    BufOut_Write_U32(outstream, 7);
+    int64_t len = BufOut_Tell(outstream);
+    BufOut_Close(outstream);
+    DECREF(outstream);
+    return len;
+}
+
+static void
+S_check_contents(TestBatchRunner *runner, BufInStream *instream,
+                 const char *big, int64_t len, const char *label) {
+    TEST_INT_EQ(runner, BufIn_Length(instream), len, "Length (%s)",
+                label);
+    TEST_TRUE(runner,
+              BufIn_Read_U8(instream) == 0xAB
+              && BufIn_Read_U32(instream) == 0xDEADBEEF
+              && BufIn_Read_U64(instream) == UINT64_C(0x0123456789ABCDEF)
+              && BufIn_Read_F64(instream) == -1.5,
+              "fixed-width values (%s)", label);
+
+    bool cu32_ok = true;
+    for (size_t i = 0; i < NUM_CU32; i++) {
+        if (BufIn_Read_CU32(instream) != cu32_values[i]) {
+            cu32_ok = false;
+        }
+    }
+    TEST_TRUE(runner, cu32_ok, "Read_CU32 (%s)", label);
+    TEST_TRUE(runner, BufIn_Read_CU64(instream) == UINT64_MAX,
+              "Read_CU64 (%s)", label);
+
+    bool ci64_ok = true;
+    for (size_t i = 0; i < NUM_CI64; i++) {
+        if (BufIn_Read_CI64(instream) != ci64_values[i]) {
+            ci64_ok = false;
+        }
+    }
+    TEST_TRUE(runner, ci64_ok, "Read_CI64 (%s)", label);
+
+    String *string = BufIn_Read_String(instream);
+    TEST_TRUE(runner, Str_Equals_Utf8(string, "na\xC3\xAFve 42", 9),
+              "Read_String (%s)", label);
+    DECREF(string);
+
+    int64_t big_pos = BufIn_Tell(instream);
+    char *got = (char*)MALLOCATE(BIG_SIZE);
+    BufIn_Read_Bytes(instream, got, BIG_SIZE);
+    TEST_TRUE(runner, memcmp(got, big, BIG_SIZE) == 0,
+              "large Read_Bytes (%s)", label);
+    TEST_UINT_EQ(runner, BufIn_Read_U32(instream), 7,
+                 "read after large read (%s)", label);
+    TEST_INT_EQ(runner, BufIn_Tell(instream), len, "Tell (%s)", label);
+
+    BufIn_Seek(instream, big_pos + 150000);
+    BufIn_Read_Bytes(instream, got, 100);
+    bool seek_ok = memcmp(got, big + 150000, 100) == 0;
+    BufIn_Seek(instream, 0);
+    seek_ok = seek_ok && BufIn_Read_U8(instream) == 0xAB;
+    BufIn_Seek(instream, big_pos + 10);
+    seek_ok = seek_ok && BufIn_Read_U8(instream) == (uint8_t)big[10];
+    TEST_TRUE(runner, seek_ok, "Seek (%s)", label);
+    FREEMEM(got);
+
+    ByteBuf *bb = BB_new_bytes("foo", 3);
+    BufIn_Seek(instream, big_pos);
+    BufIn_Read_Into(instream, bb, 5);
+    BufIn_Read_Into(instream, bb, BIG_SIZE - 5);
+    TEST_TRUE(runner,
+              BB_Get_Size(bb) == BIG_SIZE + 3
+              && memcmp(BB_Get_Buf(bb), "foo", 3) == 0
+              && memcmp(BB_Get_Buf(bb) + 3, big, BIG_SIZE) == 0,
+              "Read_Into (%s)", label);
+    DECREF(bb);
+}
+
+static void
+S_read_past_eof(void *context) {
+    BufInStream *instream = (BufInStream*)context;
+    BufIn_Seek(instream, BufIn_Length(instream) - 2);
+    BufIn_Read_U32(instream);
+}
+
+static void
+S_read_malformed(void *context) {
+    BufIn_Read_CU64((BufInStream*)context);
+}
+
+static void
+S_write_closed(void *context) {
+    BufOut_Write_U8((BufOutStream*)context, 1);
+}
+
+static void
+S_flush(void *context) {
+    BufOut_Flush((BufOutStream*)context);
+}
+
+static void
+test_round_trip(TestBatchRunner *runner) {
+    String *path = SSTR_WRAP_C(TEST_FILE);
+    char *big = S_big_bytes();
+    int64_t len = S_write_file(path, big);
+
+    BufInStream *instream = BufIn_open(path);
+    S_check_contents(runner, instream, big, len, "fd");
+    Err *error = Err_trap(S_read_past_eof, instream);
+    TEST_TRUE(runner, error != NULL, "reading past EOF throws");
+    DECREF(error);
+    BufIn_Close(instream);
+    DECREF(instream);
+
+    instream = BufIn_open_mmap(path);
+    S_check_contents(runner, instream, big, len, "mmap");
+    DECREF(instream);
+
+    BufOutStream *outstream = BufOut_open(path, true);
+    TEST_INT_EQ(runner, BufOut_Tell(outstream), len,
+                "append starts at end of file");
+    BufOut_Write_U8(outstream, 9);
+    BufOut_Close(outstream);
+    error = Err_trap(S_write_closed, outstream);
+    TEST_TRUE(runner, error != NULL, "writing to closed BufOutStream throws");
+    DECREF(error);
+    DECREF(outstream);
+
+    instream = BufIn_open(path);
+    BufIn_Seek(instream, len);
+    TEST_UINT_EQ(runner, BufIn_Read_U8(instream), 9, "appended byte");
+    DECREF(instream);
+
+    // Writes to a read-only file descriptor fail.  Flush reports the
+    // error, but Destroy must not throw.
+    FILE *file = fopen(TEST_FILE, "rb");
+    outstream = BufOut_new_fd(fileno(file), 0);
+    BufOut_Write_U8(outstream, 9);
+    error = Err_trap(S_flush, outstream);
+    TEST_TRUE(runner, error != NULL, "failed write throws");
+    DECREF(error);
+    DECREF(outstream);
+    PASS(runner, "Destroy ignores failed write");
+    fclose(file);
+
+    remove(TEST_FILE);
+    FREEMEM(big);
+}
+
+static void
+S_read_string(void *context) {
+    String *string = BufIn_Read_String((BufInStream*)context);
+    DECREF(string);
+}
+
+static void
+test_Read_String(TestBatchRunner *runner) {
+    String *path = SSTR_WRAP_C(TEST_FILE);
+    char *text = (char*)MALLOCATE(BIG_SIZE);
+    memset(text, 'x', BIG_SIZE);
+    String *big = Str_new_from_trusted_utf8(text, BIG_SIZE);
+    FREEMEM(text);
+
+    BufOutStream *outstream = BufOut_open(path, false);
+    BufOut_Write_String(outstream, SSTR_WRAP_C("short"));
+    BufOut_Write_String(outstream, big);
+    BufOut_Write_U8(outstream, 3);
+    BufOut_Close(outstream);
+    DECREF(outstream);
+
+    BufInStream *instream = BufIn_open(path);
+    String *string = BufIn_Read_String(instream);
+    TEST_TRUE(runner, Str_Equals_Utf8(string, "short", 5),
+              "Read_String from buffer");
+    DECREF(string);
+    string = BufIn_Read_String(instream);
+    TEST_TRUE(runner, Str_Equals(string, (Obj*)big),
+              "Read_String larger than buffer");
+    DECREF(string);
+    TEST_UINT_EQ(runner, BufIn_Read_U8(instream), 3,
+                 "read after large Read_String");
+    DECREF(instream);
+
+    // Truncate the file after opening, so that the large read fails.
+    instream = BufIn_open(path);
+    string = BufIn_Read_String(instream);
+    DECREF(string);
+    FILE *file = fopen(TEST_FILE, "wb");
+    fclose(file);
+    Err *error = Err_trap(S_read_string, instream);
+    TEST_TRUE(runner, error != NULL, "failed large Read_String throws");
+    DECREF(error);
+    DECREF(instream);
+    remove(TEST_FILE);
+
+    Blob *blob = Blob_new("\x02\xC3\x28", 3);
+    instream = BufIn_new_blob(blob);
+    error = Err_trap(S_read_string, instream);
+    TEST_TRUE(runner, error != NULL, "Read_String with invalid UTF-8 throws");
+    DECREF(error);
+    DECREF(instream);
+    DECREF(blob);
+
+    DECREF(big);
+}
+
+static void
+test_blob(TestBatchRunner *runner) {
+    Blob *blob = Blob_new("\x80\x01\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF",
+                          12);
+    BufInStream *instream = BufIn_new_blob(blob);
+    TEST_UINT_EQ(runner, BufIn_Read_CU32(instream), 128,
+                 "Read_CU32 from Blob");
+    Err *error = Err_trap(S_read_malformed, instream);
+    TEST_TRUE(runner, error != NULL, "overlong compressed integer throws");
+    DECREF(error);
+    DECREF(instream);
+    DECREF(blob);
+}
+
+void
+TestStreams_Run_IMP(TestStreams *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 35);
+    test_round_trip(runner);
+    test_Read_String(runner);
+    test_blob(runner);
+}
+
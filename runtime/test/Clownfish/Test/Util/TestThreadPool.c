@@ -0,0 +1,241 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+
+#define CFISH_USE_SHORT_NAMES
+#define TESTCFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Test/Util/TestThreadPool.h"
+
+#include "Clownfish/Err.h"
+#include "Clownfish/String.h"
+#include "Clownfish/Test.h"
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Clownfish/TestHarness/TestUtils.h"
+#include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/ThreadPool.h"
+#include "Clownfish/Class.h"
+
+#define NUM_INDICES 10000
+
+TestThreadPool*
+TestThreadPool_new() {
+    return (TestThreadPool*)Class_Make_Obj(TESTTHREADPOOL);
+}
+
+static void
+S_mark_range(void *context, size_t begin, size_t end) {
+    uint32_t *hits = (uint32_t*)context;
+    for (size_t i = begin; i < end; i++) {
+        hits[i]++;
+    }
+}
+
+static bool
+S_hit_once(uint32_t *hits, size_t begin, size_t end) {
+    for (size_t i = 0; i < NUM_INDICES; i++) {
+        uint32_t expected = i >= begin && i < end ? 1 : 0;
+        if (hits[i] != expected) { return false; }
+    }
+    return true;
+}
+
+static void
+test_Parallel_For(TestBatchRunner *runner, ThreadPool *pool,
+                  bool trap_errors, const char *label) {
+    static const size_t grains[] = { 0, 1, 7, NUM_INDICES };
+    uint32_t *hits = (uint32_t*)MALLOCATE(NUM_INDICES * sizeof(uint32_t));
+
+    for (size_t i = 0; i < sizeof(grains) / sizeof(grains[0]); i++) {
+        memset(hits, 0, NUM_INDICES * sizeof(uint32_t));
+        ThreadPool_Parallel_For(pool, 0, NUM_INDICES, grains[i],
+                                S_mark_range, hits, trap_errors);
+        TEST_TRUE(runner, S_hit_once(hits, 0, NUM_INDICES),
+                  "Parallel_For visits every index once, grain %u, %s",
+                  (unsigned)grains[i], label);
+    }
+
+    memset(hits, 0, NUM_INDICES * sizeof(uint32_t));
+    ThreadPool_Parallel_For(pool, 100, 150, 0, S_mark_range, hits,
+                            trap_errors);
+    ThreadPool_Parallel_For(pool, 200, 200, 0, S_mark_range, hits,
+                            trap_errors);
+    TEST_TRUE(runner, S_hit_once(hits, 100, 150),
+              "Parallel_For with offset and empty range, %s", label);
+
+    FREEMEM(hits);
+}
+
+typedef struct {
+    ThreadPool *pool;
+    uint32_t    n;
+    uint64_t    result;
+} FibContext;
+
+// Compute Fibonacci numbers with one task group per call, so task groups
+// are nested deeply and joined on workers.
+static void
+S_fib(void *context) {
+    FibContext *fib = (FibContext*)context;
+    if (fib->n < 2) {
+        fib->result = fib->n;
+        return;
+    }
+
+    FibContext a = { fib->pool, fib->n - 1, 0 };
+    FibContext b = { fib->pool, fib->n - 2, 0 };
+    TaskGroup *group = TaskGroup_new(fib->pool, false);
+    TaskGroup_Run(group, S_fib, &a);
+    S_fib(&b);
+    TaskGroup_Join(group);
+    DECREF(group);
+    fib->result = a.result + b.result;
+}
+
+static void
+S_increment(void *context) {
+    uint32_t *counter = (uint32_t*)context;
+    (*counter)++;
+}
+
+static void
+test_TaskGroup(TestBatchRunner *runner, ThreadPool *pool, const char *label) {
+    FibContext fib = { pool, 20, 0 };
+    S_fib(&fib);
+    TEST_INT_EQ(runner, fib.result, 6765, "nested task groups, %s", label);
+
+    // Enough tasks to grow the queues.
+    size_t     num_tasks = 1000;
+    uint32_t  *counters  = (uint32_t*)CALLOCATE(num_tasks, sizeof(uint32_t));
+    TaskGroup *group     = TaskGroup_new(pool, false);
+    for (size_t round = 0; round < 2; round++) {
+        for (size_t i = 0; i < num_tasks; i++) {
+            TaskGroup_Run(group, S_increment, counters + i);
+        }
+        TaskGroup_Join(group);
+    }
+    DECREF(group);
+    bool success = true;
+    for (size_t i = 0; i < num_tasks; i++) {
+        if (counters[i] != 2) { success = false; }
+    }
+    TEST_TRUE(runner, success, "TaskGroup runs all tasks and can be reused, %s",
+              label);
+    FREEMEM(counters);
+}
+
+static void
+S_throw_task(void *context) {
+    UNUSED_VAR(context);
+    THROW(ERR, "task failed");
+}
+
+static void
+S_throw_range(void *context, size_t begin, size_t end) {
+    S_mark_range(context, begin, end);
+    if (begin <= 5 && end > 5) {
+        THROW(ERR, "range failed");
+    }
+}
+
+typedef struct {
+    ThreadPool *pool;
+    TaskGroup  *group;
+    uint32_t   *counters;
+} ErrorContext;
+
+static void
+S_run_failing_group(void *context) {
+    ErrorContext *error_context = (ErrorContext*)context;
+    TaskGroup *group    = error_context->group;
+    uint32_t  *counters = error_context->counters;
+    TaskGroup_Run(group, S_increment, counters);
+    TaskGroup_Run(group, S_throw_task, NULL);
+    TaskGroup_Run(group, S_increment, counters + 1);
+    TaskGroup_Join(group);
+}
+
+static void
+S_run_failing_range(void *context) {
+    ErrorContext *error_context = (ErrorContext*)context;
+    ThreadPool_Parallel_For(error_context->pool, 0, 10, 1,
+                            S_throw_range, error_context->counters, true);
+}
+
+// Errors are only trapped on the calling thread, which works with every
+// host, so a pool without workers is used.
+static void
+test_errors(TestBatchRunner *runner) {
+    ThreadPool *pool     = ThreadPool_new(0);
+    uint32_t    counters[NUM_INDICES];
+    ErrorContext context;
+    context.pool     = pool;
+    context.group    = TaskGroup_new(pool, true);
+    context.counters = counters;
+
+    memset(counters, 0, sizeof(counters));
+    Err *error = Err_trap(S_run_failing_group, &context);
+    TEST_TRUE(runner, error != NULL
+              && Str_Contains_Utf8(Err_Get_Mess(error), "task failed", 11),
+              "Join rethrows error of task");
+    TEST_TRUE(runner, counters[0] == 1 && counters[1] == 1,
+              "other tasks run after error");
+    DECREF(error);
+
+    memset(counters, 0, sizeof(counters));
+    error = Err_trap(S_run_failing_range, &context);
+    TEST_TRUE(runner, error != NULL
+              && Str_Contains_Utf8(Err_Get_Mess(error), "range failed", 12),
+              "Parallel_For rethrows error");
+    TEST_TRUE(runner, S_hit_once(counters, 0, 10),
+              "Parallel_For runs other subranges after error");
+    DECREF(error);
+
+    DECREF(context.group);
+    DECREF(pool);
+}
+
+static void
+test_global(TestBatchRunner *runner) {
+    ThreadPool *pool = ThreadPool_global();
+    TEST_TRUE(runner, pool == ThreadPool_global(), "global returns same pool");
+    uint32_t expected = TestUtils_has_threads ? ThreadPool_num_cpus() - 1 : 0;
+    TEST_UINT_EQ(runner, ThreadPool_Get_Num_Threads(pool), expected,
+                 "global pool has one worker less than processors");
+}
+
+void
+TestThreadPool_Run_IMP(TestThreadPool *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 21);
+
+    // Groups on pools with workers don't trap errors, see TaskGroup_new.
+    ThreadPool *pool = ThreadPool_new(3);
+    TEST_UINT_EQ(runner, ThreadPool_Get_Num_Threads(pool),
+                 TestUtils_has_threads ? 3 : 0, "Get_Num_Threads");
+    test_Parallel_For(runner, pool, false, "3 workers");
+    test_TaskGroup(runner, pool, "3 workers");
+    DECREF(pool);
+
+    pool = ThreadPool_new(0);
+    test_Parallel_For(runner, pool, true, "no workers");
+    test_TaskGroup(runner, pool, "no workers");
+    DECREF(pool);
+
+    test_errors(runner);
+    test_global(runner);
+}
@@ -0,0 +1,235 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+
+#define CFISH_USE_SHORT_NAMES
+#define TESTCFISH_USE_SHORT_NAMES
+
+#include "Clownfish/Test/Util/TestTrace.h"
+
+#include "Clownfish/Class.h"
+#include "Clownfish/Err.h"
+#include "Clownfish/Hash.h"
+#include "Clownfish/Num.h"
+#include "Clownfish/String.h"
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Clownfish/TestHarness/TestUtils.h"
+#include "Clownfish/Util/Json.h"
+#include "Clownfish/Util/Memory.h"
+#include "Clownfish/Util/Trace.h"
+#include "Clownfish/Vector.h"
+
+TestTrace*
+TestTrace_new() {
+    return (TestTrace*)Class_Make_Obj(TESTTRACE);
+}
+
+// Return the index of the first event with the given phase and name, or -1.
+static int64_t
+S_find_event(TraceEvent *events, size_t num_events, char phase,
+             const char *name) {
+    for (size_t i = 0; i < num_events; i++) {
+        if (events[i].phase == phase && strcmp(events[i].name, name) == 0) {
+            return (int64_t)i;
+        }
+    }
+    return -1;
+}
+
+static void
+S_throw(void *context) {
+    UNUSED_VAR(context);
+    THROW(ERR, "Traced error");
+}
+
+static void
+test_disabled(TestBatchRunner *runner) {
+    TraceEvent *events;
+    uint32_t   *tids;
+
+    Trace_disable();
+    Trace_clear();
+    TRACE_BEGIN("Test", "disabled");
+    TRACE_END("Test", "disabled");
+    size_t num_events = Trace_collect(&events, &tids);
+    TEST_UINT_EQ(runner, num_events, 0, "nothing is recorded while disabled");
+    FREEMEM(events);
+    FREEMEM(tids);
+}
+
+static void
+test_record(TestBatchRunner *runner) {
+    TraceEvent *events;
+    uint32_t   *tids;
+
+    Trace_clear();
+    Trace_enable(0);
+
+    TRACE_BEGIN("Test", "outer");
+    TRACE_COUNTER("Test", "counter", 42);
+    Hash *hash = Hash_new(0);
+    for (int32_t i = 0; i < 100; i++) {
+        String *key = Str_newf("%i32", i);
+        Hash_Store(hash, key, (Obj*)Int_new(i));
+        DECREF(key);
+    }
+    DECREF(hash);
+    Err *error = Err_trap(S_throw, NULL);
+    DECREF(error);
+    void *big = MALLOCATE(2 * 1024 * 1024);
+    FREEMEM(big);
+    TRACE_END("Test", "outer");
+
+    Trace_disable();
+
+    size_t num_events = Trace_collect(&events, &tids);
+    int64_t begin   = S_find_event(events, num_events, 'B', "outer");
+    int64_t end     = S_find_event(events, num_events, 'E', "outer");
+    int64_t counter = S_find_event(events, num_events, 'C', "counter");
+    TEST_TRUE(runner,
+              begin >= 0 && end > begin && counter > begin
+              && events[counter].value == 42
+              && tids[begin] == tids[end]
+              && events[begin].timestamp <= events[end].timestamp,
+              "begin, end and counter events");
+
+    int64_t rebuild = S_find_event(events, num_events, 'B', "rebuild");
+    TEST_TRUE(runner, rebuild > begin && rebuild < end, "Hash rebuild");
+
+    int64_t thrown = S_find_event(events, num_events, 'i', "throw");
+    TEST_TRUE(runner, thrown > begin && thrown < end, "Err throw");
+
+    int64_t alloc = S_find_event(events, num_events, 'i', "large malloc");
+    TEST_TRUE(runner,
+              alloc > begin && alloc < end
+              && events[alloc].value == 2 * 1024 * 1024,
+              "large allocation");
+
+    String *json = Trace_export_json();
+    Hash *trace = (Hash*)Json_decode(json);
+    Vector *trace_events = trace
+                           ? (Vector*)Hash_Fetch_Utf8(trace, "traceEvents", 11)
+                           : NULL;
+    TEST_TRUE(runner,
+              trace_events
+              && Vec_Get_Size(trace_events) == num_events,
+              "export_json");
+    Hash *first = trace_events ? (Hash*)Vec_Fetch(trace_events, 0) : NULL;
+    String *ph = first ? (String*)Hash_Fetch_Utf8(first, "ph", 2) : NULL;
+    TEST_TRUE(runner,
+              ph && Hash_Fetch_Utf8(first, "ts", 2)
+              && Hash_Fetch_Utf8(first, "tid", 3)
+              && Str_Equals_Utf8(ph, "B", 1),
+              "exported event has phase, timestamp and thread");
+    DECREF(trace);
+    DECREF(json);
+
+    FREEMEM(events);
+    FREEMEM(tids);
+
+    Trace_clear();
+    num_events = Trace_collect(&events, &tids);
+    TEST_UINT_EQ(runner, num_events, 0, "clear");
+    FREEMEM(events);
+    FREEMEM(tids);
+}
+
+static void
+S_record_many(void *context) {
+    UNUSED_VAR(context);
+    for (int64_t i = 0; i < 100; i++) {
+        TRACE_COUNTER("Test", "many", i);
+    }
+}
+
+static void
+S_record_ten(void *context) {
+    UNUSED_VAR(context);
+    for (int64_t i = 0; i < 10; i++) {
+        TRACE_COUNTER("Test", "ten", i);
+    }
+}
+
+static void
+test_wrap_around(TestBatchRunner *runner) {
+    if (!TestUtils_has_threads) {
+        SKIP(runner, 3, "No thread support");
+        return;
+    }
+
+    TraceEvent *events;
+    uint32_t   *tids;
+
+    Trace_clear();
+    Trace_enable(16);
+    Thread *thread = TestUtils_thread_create(S_record_many, NULL, NULL);
+    TestUtils_thread_join(thread);
+    Trace_disable();
+
+    size_t num_events = Trace_collect(&events, &tids);
+    bool   ok         = num_events == 15;
+    for (size_t i = 0; ok && i < num_events; i++) {
+        ok = events[i].value == (int64_t)(85 + i);
+    }
+    TEST_TRUE(runner, ok, "ring keeps the newest events");
+    FREEMEM(events);
+    FREEMEM(tids);
+
+    // The second thread takes over the ring of the first one, which holds
+    // 20 events in total.
+    Trace_clear();
+    Trace_enable(16);
+    for (int i = 0; i < 2; i++) {
+        thread = TestUtils_thread_create(S_record_ten, NULL, NULL);
+        TestUtils_thread_join(thread);
+    }
+    Trace_disable();
+
+    num_events = Trace_collect(&events, &tids);
+    ok = num_events == 15;
+    for (size_t i = 0; ok && i < num_events; i++) {
+        ok = events[i].value == (int64_t)(i < 5 ? i + 5 : i - 5)
+             && tids[i] == tids[i < 5 ? 0 : 5];
+    }
+    TEST_TRUE(runner, ok, "exited thread's ring is reused");
+    TEST_TRUE(runner, ok && tids[0] != tids[5],
+              "events of the exited thread keep its thread number");
+    FREEMEM(events);
+    FREEMEM(tids);
+
+    // Restore the default capacity.
+    Trace_clear();
+    Trace_enable(0);
+    Trace_disable();
+}
+
+// Tracing is enabled and disabled globally.
+bool
+TestTrace_Is_Thread_Safe_IMP(TestTrace *self) {
+    UNUSED_VAR(self);
+    return false;
+}
+
+void
+TestTrace_Run_IMP(TestTrace *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 11);
+    test_disabled(runner);
+    test_record(runner);
+    test_wrap_around(runner);
+}
+